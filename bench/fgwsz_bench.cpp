@@ -0,0 +1,659 @@
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+#include<cstring>   //::std::memcmp ::std::memcpy ::std::memset
+
+#include<chrono>    //::std::chrono
+#include<vector>    //::std::vector
+#include<memory>    //::std::unique_ptr
+#include<format>    //::std::format
+#include<exception> //::std::exception
+#include<string_view>//::std::string_view
+#include<charconv>  //::std::from_chars
+#include<system_error>//::std::errc
+#include<string>    //::std::string
+#include<unordered_map>//::std::unordered_map
+
+#include"fgwsz_cout.h"
+#include"fgwsz_xor.h"
+#include"fgwsz_codec.h"
+#include"fgwsz_checksum.h"
+#include"fgwsz_format.h"
+#include"fgwsz_stream.h"
+#include"fgwsz_packer.h"
+#include"fgwsz_unpacker.h"
+#include"fgwsz_package_reader.h"
+#include"fgwsz_scenario.h"
+
+//============================================================================
+//xor混淆内核,校验和内核和压缩编码微基准测试,核心库内存接口的往返测试,
+//以及打包/解包的端到端基准测试
+//============================================================================
+namespace{
+//终端打印帮助信息
+void help(void){
+    ::fgwsz::cout<<
+R"(Usages:
+    Micro benchmarks     : (no arguments)
+    End-to-end benchmarks: --e2e [<options>]
+Options:
+    --dir <path>      : directory of the generated data (default: fgwsz-bench-data)
+    --scale <N>       : shrink the data N times (default: 1, the full size)
+    --scenario <name> : run only this scenario: tiny, medium, large or deep
+    --json <path>     : write the results as JSON
+    -j <threads>      : threads of the parallel operations (default: 0, all)
+)";
+}
+//解析无符号整数参数值
+template<typename NumberType_>
+bool parse_number(::std::string_view value,NumberType_& number){
+    auto result=::std::from_chars(
+        value.data()
+        ,value.data()+value.size()
+        ,number
+    );
+    return ::std::errc{}==result.ec&&value.data()+value.size()==result.ptr;
+}
+//解析端到端基准测试的参数,参数不合法时返回false
+bool parse_arguments(
+    int argc
+    ,char* argv[]
+    ,bool& end_to_end
+    ,::fgwsz::ScenarioOptions& options
+){
+    for(int index=1;index<argc;++index){
+        ::std::string_view argument=argv[index];
+        if("--e2e"==argument){
+            end_to_end=true;
+        }else if(index+1>=argc){
+            return false;
+        }else if("--dir"==argument){
+            options.data_path=argv[++index];
+        }else if("--scale"==argument){
+            if(!::parse_number(argv[++index],options.scale)
+                ||0==options.scale
+            ){
+                return false;
+            }
+        }else if("--scenario"==argument){
+            options.names.push_back(argv[++index]);
+        }else if("--json"==argument){
+            options.json_path=argv[++index];
+        }else if("-j"==argument){
+            if(!::parse_number(argv[++index],options.thread_count)){
+                return false;
+            }
+        }else{
+            return false;
+        }
+    }
+    return end_to_end||1==argc;
+}
+//使用确定性的伪随机数据填充内存块
+void fill(::std::uint8_t* data,::std::uint64_t bytes){
+    ::std::uint64_t state=0x9E3779B97F4A7C15ull;
+    for(::std::uint64_t index=0;index<bytes;++index){
+        state^=state<<13;
+        state^=state>>7;
+        state^=state<<17;
+        data[index]=static_cast<::std::uint8_t>(state);
+    }
+}
+//校验内核结果与逐字节结果一致(覆盖各种长度和未对齐的起始地址)
+bool check(::fgwsz::XorKernel const& kernel){
+    constexpr ::std::uint64_t max_bytes=1024;
+    auto expect=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    auto actual=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    auto source=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    ::fill(source.get(),max_bytes+64);
+    for(::std::uint64_t offset=0;offset<64;offset+=7){
+        for(::std::uint64_t bytes=0;bytes<=max_bytes;bytes+=13){
+            ::fill(expect.get(),max_bytes+64);
+            ::fill(actual.get(),max_bytes+64);
+            for(::std::uint64_t index=0;index<bytes;++index){
+                expect[offset+index]^=0xA5;
+            }
+            kernel.function(actual.get()+offset,bytes,0xA5);
+            if(0!=::std::memcmp(expect.get(),actual.get(),max_bytes+64)){
+                return false;
+            }
+            //混淆拷贝:从另一块相同的数据拷贝过来,结果应与原地混淆一致
+            ::fill(actual.get(),max_bytes+64);
+            kernel.copy_function(
+                actual.get()+offset
+                ,source.get()+offset
+                ,bytes
+                ,0xA5
+            );
+            if(0!=::std::memcmp(expect.get(),actual.get(),max_bytes+64)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+//逐位计算的CRC32C(反射多项式0x82F63B78),作为校验和内核的参考结果
+::std::uint32_t reference_crc32c(
+    ::std::uint32_t crc
+    ,::std::uint8_t const* data
+    ,::std::uint64_t bytes
+){
+    crc=~crc;
+    for(::std::uint64_t index=0;index<bytes;++index){
+        crc^=data[index];
+        for(int bit=0;bit<8;++bit){
+            crc=(crc>>1)^(0x82F63B78u&(0u-(crc&1u)));
+        }
+    }
+    return ~crc;
+}
+//校验校验和内核与逐位计算的结果一致,融合混淆的结果与key_xor一致,
+//并检查校验和的合并与移动
+bool check(::fgwsz::Crc32cKernel const& kernel){
+    constexpr ::std::uint64_t max_bytes=20000;
+    auto source=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    auto expect=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    auto actual=::std::make_unique<::std::uint8_t[]>(max_bytes+64);
+    ::fill(source.get(),max_bytes+64);
+    for(::std::uint64_t offset=0;offset<64;offset+=13){
+        for(::std::uint64_t bytes=0;bytes<=max_bytes;bytes=bytes*5/4+1){
+            ::std::uint8_t const* data=source.get()+offset;
+            ::std::uint32_t const crc=::reference_crc32c(0x1234u,data,bytes);
+            if(crc!=kernel.function(data,bytes,0x1234u)){
+                return false;
+            }
+            //解包:先计算校验和再混淆
+            ::std::memcpy(expect.get(),data,bytes);
+            ::fgwsz::key_xor(expect.get(),bytes,0xA5);
+            if(crc!=kernel.function_xor(actual.get(),data,bytes,0xA5,0x1234u)
+                ||0!=::std::memcmp(expect.get(),actual.get(),bytes)
+            ){
+                return false;
+            }
+            //打包:先混淆再计算混淆结果的校验和
+            ::std::memcpy(actual.get(),data,bytes);
+            if(::reference_crc32c(0x1234u,expect.get(),bytes)
+                    !=kernel.xor_function(
+                        actual.get(),actual.get(),bytes,0xA5,0x1234u
+                    )
+                ||0!=::std::memcmp(expect.get(),actual.get(),bytes)
+            ){
+                return false;
+            }
+            //合并:前后两段的校验和合并之后等于整体的校验和
+            ::std::uint64_t const split=bytes/3;
+            if(::reference_crc32c(0,data,bytes)!=::fgwsz::crc32c_combine(
+                    ::reference_crc32c(0,data,split)
+                    ,::reference_crc32c(0,data+split,bytes-split)
+                    ,bytes-split
+                )
+            ){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+//测量校验和内核的吞吐量(只计算校验和,以及解包时的融合混淆),返回GB/s
+void measure(
+    ::fgwsz::Crc32cKernel const& kernel
+    ,::std::uint8_t* data
+    ,::std::uint64_t bytes
+    ,double& checksum_speed
+    ,double& fused_speed
+){
+    using clock=::std::chrono::steady_clock;
+    ::std::uint64_t const rounds=
+        (2ull*1024*1024*1024/bytes)>1?(2ull*1024*1024*1024/bytes):1;
+    volatile ::std::uint32_t sink=0;
+    double best_checksum=0.0;
+    double best_fused=0.0;
+    for(int repeat=0;repeat<3;++repeat){
+        auto start=clock::now();
+        for(::std::uint64_t round=0;round<rounds;++round){
+            sink=kernel.function(data,bytes,sink);
+        }
+        double seconds=::std::chrono::duration<double>(
+            clock::now()-start
+        ).count();
+        if(0==repeat||seconds<best_checksum){
+            best_checksum=seconds;
+        }
+        start=clock::now();
+        for(::std::uint64_t round=0;round<rounds;++round){
+            sink=kernel.function_xor(data,data,bytes,0x5A,sink);
+        }
+        seconds=::std::chrono::duration<double>(clock::now()-start).count();
+        if(0==repeat||seconds<best_fused){
+            best_fused=seconds;
+        }
+    }
+    double const total_bytes=static_cast<double>(bytes)
+        *static_cast<double>(rounds);
+    checksum_speed=total_bytes/best_checksum/1e9;
+    fused_speed=total_bytes/best_fused/1e9;
+}
+//使用确定性的伪随机单词填充内存块(模拟文本内容)
+void fill_text(::std::uint8_t* data,::std::uint64_t bytes){
+    static char const* const words[]={
+        "the ","package ","file ","content ","key ","index ","offset "
+        ,"bytes ","path ","return ","if(","){\n","::std::uint64_t ","this->"
+        ,"0x00","//","\n    ","FGWSZ_THROW_WHAT(","unpack_","pack_"
+    };
+    ::std::uint64_t state=0x9E3779B97F4A7C15ull;
+    ::std::uint64_t index=0;
+    while(index<bytes){
+        state^=state<<13;
+        state^=state>>7;
+        state^=state<<17;
+        for(char const* word=words[state%(sizeof(words)/sizeof(words[0]))]
+            ;'\0'!=*word&&index<bytes
+            ;++word
+        ){
+            data[index++]=static_cast<::std::uint8_t>(*word);
+        }
+    }
+}
+//校验压缩编码的往返结果,并检查损坏的压缩数据能被检测到而不会越界访问
+bool check(::fgwsz::Codec const& codec){
+    constexpr ::std::uint64_t max_bytes=64*1024;
+    auto source=::std::make_unique<::std::uint8_t[]>(max_bytes);
+    auto packed=::std::make_unique<::std::uint8_t[]>(max_bytes);
+    auto unpacked=::std::make_unique<::std::uint8_t[]>(max_bytes);
+    for(int kind=0;kind<3;++kind){
+        if(0==kind){
+            ::fill(source.get(),max_bytes);
+        }else if(1==kind){
+            ::fill_text(source.get(),max_bytes);
+        }else{
+            ::std::memset(source.get(),'a',max_bytes);
+        }
+        for(::std::uint64_t bytes=0;bytes<=max_bytes;bytes=bytes*3+1){
+            ::std::uint64_t const packed_bytes=codec.compress(
+                packed.get(),max_bytes,source.get(),bytes
+            );
+            //不可压缩的内容允许返回0
+            if(0==packed_bytes){
+                if(0!=kind&&bytes>=1024){
+                    return false;
+                }
+                continue;
+            }
+            if(!codec.decompress(
+                    unpacked.get(),bytes,packed.get(),packed_bytes
+                )
+                ||0!=::std::memcmp(source.get(),unpacked.get(),bytes)
+            ){
+                return false;
+            }
+            //截断和错误的解压大小必须失败
+            if(codec.decompress(
+                    unpacked.get(),bytes,packed.get(),packed_bytes-1
+                )
+                ||codec.decompress(
+                    unpacked.get(),bytes+1,packed.get(),packed_bytes
+                )
+            ){
+                return false;
+            }
+            //随机改写的数据不能导致越界访问(结果可以成功也可以失败)
+            for(::std::uint64_t index=0;index<packed_bytes;index+=7){
+                packed[index]^=0x5A;
+                codec.decompress(
+                    unpacked.get(),bytes,packed.get(),packed_bytes
+                );
+                packed[index]^=0x5A;
+            }
+        }
+    }
+    return true;
+}
+//测量压缩编码按帧压缩和解压的吞吐量,返回GB/s(按原始内容大小计算)
+void measure(
+    ::fgwsz::Codec const& codec
+    ,::std::uint8_t const* data
+    ,::std::uint64_t bytes
+    ,double& compress_speed
+    ,double& decompress_speed
+    ,double& ratio
+){
+    using clock=::std::chrono::steady_clock;
+    constexpr ::std::uint64_t frame_bytes=1024*1024;
+    ::std::uint64_t const frame_count=bytes/frame_bytes;
+    auto packed=::std::make_unique<::std::uint8_t[]>(bytes);
+    auto unpacked=::std::make_unique<::std::uint8_t[]>(frame_bytes);
+    ::std::vector<::std::uint64_t> packed_bytes(frame_count);
+    double best_compress=0.0;
+    double best_decompress=0.0;
+    for(int repeat=0;repeat<3;++repeat){
+        auto start=clock::now();
+        for(::std::uint64_t frame=0;frame<frame_count;++frame){
+            packed_bytes[frame]=codec.compress(
+                packed.get()+frame*frame_bytes
+                ,frame_bytes
+                ,data+frame*frame_bytes
+                ,frame_bytes
+            );
+        }
+        double seconds=::std::chrono::duration<double>(
+            clock::now()-start
+        ).count();
+        if(0==repeat||seconds<best_compress){
+            best_compress=seconds;
+        }
+        start=clock::now();
+        for(::std::uint64_t frame=0;frame<frame_count;++frame){
+            if(0!=packed_bytes[frame]){
+                codec.decompress(
+                    unpacked.get()
+                    ,frame_bytes
+                    ,packed.get()+frame*frame_bytes
+                    ,packed_bytes[frame]
+                );
+            }
+        }
+        seconds=::std::chrono::duration<double>(clock::now()-start).count();
+        if(0==repeat||seconds<best_decompress){
+            best_decompress=seconds;
+        }
+    }
+    ::std::uint64_t total_bytes=0;
+    for(auto frame_bytes_packed:packed_bytes){
+        total_bytes+=0==frame_bytes_packed?frame_bytes:frame_bytes_packed;
+    }
+    compress_speed=static_cast<double>(bytes)/best_compress/1e9;
+    decompress_speed=static_cast<double>(bytes)/best_decompress/1e9;
+    ratio=static_cast<double>(bytes)/static_cast<double>(total_bytes);
+}
+//核心库内存接口的往返测试:pack_memory把data中的多段内容打包到写入回调,
+//再通过读取回调的Unpacker解包到回调,以及通过内存中的PackageReader读取
+//(read_all和部分读取),所有内容都与原始内容相同时返回true,
+//同时测量每一步的吞吐量,返回GB/s(按原始内容大小计算)
+bool check_library(
+    ::std::uint8_t codec
+    ,::std::uint8_t const* data
+    ,::std::uint64_t bytes
+    ,double& pack_speed
+    ,double& unpack_speed
+    ,double& read_speed
+){
+    using clock=::std::chrono::steady_clock;
+    //空文件,不足一块,恰好一帧,跨帧和一半数据大小的文件,起始位置互不对齐
+    struct Slice{
+        ::std::string path;
+        ::std::uint64_t offset;
+        ::std::uint64_t bytes;
+    };
+    ::std::vector<::std::uint64_t> const sizes={
+        0,1,4095,1024*1024,1024*1024+1,3*1024*1024+7,bytes/2
+    };
+    ::std::vector<Slice> slices;
+    ::std::uint64_t total_bytes=0;
+    for(::std::size_t index=0;index<sizes.size();++index){
+        slices.push_back({
+            ::std::format("memory/{}.bin",index)
+            ,index*4099
+            ,sizes[index]
+        });
+        total_bytes+=sizes[index];
+    }
+    auto same=[data](Slice const& slice,::std::string const& content){
+        return content.size()==slice.bytes
+            &&0==::std::memcmp(content.data(),data+slice.offset,slice.bytes);
+    };
+    //打包到写入回调
+    ::std::string package;
+    auto start=clock::now();
+    {
+        ::fgwsz::Packer packer(
+            [&package](void const* src,::std::uint64_t count){
+                package.append(static_cast<char const*>(src),count);
+            }
+        );
+        packer.set_codec(codec);
+        for(auto const& slice:slices){
+            packer.pack_memory(slice.path,data+slice.offset,slice.bytes);
+        }
+        packer.pack_index();
+    }
+    pack_speed=static_cast<double>(total_bytes)/::std::chrono::duration<double>(
+        clock::now()-start
+    ).count()/1e9;
+    //从读取回调解包到回调
+    ::std::unordered_map<::std::string,::std::string> files;
+    start=clock::now();
+    {
+        ::std::uint64_t position=0;
+        ::fgwsz::Unpacker unpacker(
+            [&package,&position](void* ptr,::std::uint64_t count){
+                if(count>package.size()-position){
+                    count=package.size()-position;
+                }
+                ::std::memcpy(ptr,package.data()+position,count);
+                position+=count;
+                return count;
+            }
+        );
+        unpacker.unpack_package([&files](::fgwsz::Header const& header){
+            auto& content=files[header.relative_path_string];
+            content.clear();
+            return ::fgwsz::WriteFunction(
+                [&content](void const* src,::std::uint64_t count){
+                    content.append(static_cast<char const*>(src),count);
+                }
+            );
+        });
+    }
+    unpack_speed=static_cast<double>(total_bytes)
+        /::std::chrono::duration<double>(clock::now()-start).count()/1e9;
+    if(files.size()!=slices.size()){
+        return false;
+    }
+    for(auto const& slice:slices){
+        if(!same(slice,files[slice.path])){
+            return false;
+        }
+    }
+    //随机访问读取器:读取全部内容(同时校验)和中间的一段内容
+    ::fgwsz::PackageReader reader(package.data(),package.size());
+    start=clock::now();
+    for(auto const& slice:slices){
+        if(!same(slice,reader.read_all(slice.path))){
+            return false;
+        }
+    }
+    read_speed=static_cast<double>(total_bytes)/::std::chrono::duration<double>(
+        clock::now()-start
+    ).count()/1e9;
+    for(auto const& slice:slices){
+        auto const file=reader.open(slice.path);
+        Slice const middle={
+            slice.path
+            ,slice.offset+slice.bytes/3
+            ,slice.bytes/3
+        };
+        if(file.size()!=slice.bytes
+            ||!same(middle,file.read(slice.bytes/3,slice.bytes/3))
+        ){
+            return false;
+        }
+    }
+    return true;
+}
+//测量内核吞吐量,返回GB/s
+double measure(
+    ::fgwsz::XorKernel const& kernel
+    ,::std::uint8_t* data
+    ,::std::uint64_t bytes
+){
+    using clock=::std::chrono::steady_clock;
+    //预热
+    kernel.function(data,bytes,0x5A);
+    //至少处理4GB数据且至少3轮,取最快一轮
+    ::std::uint64_t const rounds=
+        (4ull*1024*1024*1024/bytes)>3?(4ull*1024*1024*1024/bytes):3;
+    double best_seconds=0.0;
+    for(int repeat=0;repeat<3;++repeat){
+        auto start=clock::now();
+        for(::std::uint64_t round=0;round<rounds/3+1;++round){
+            kernel.function(data,bytes,0x5A);
+        }
+        double seconds=::std::chrono::duration<double>(
+            clock::now()-start
+        ).count()/static_cast<double>(rounds/3+1);
+        if(0==repeat||seconds<best_seconds){
+            best_seconds=seconds;
+        }
+    }
+    return static_cast<double>(bytes)/best_seconds/1e9;
+}
+}//namespace
+
+int main(int argc,char* argv[]){
+    bool end_to_end=false;
+    ::fgwsz::ScenarioOptions options={"fgwsz-bench-data",1,0,{},{}};
+    if(!::parse_arguments(argc,argv,end_to_end,options)){
+        ::help();
+        return -1;
+    }
+    try{
+        if(end_to_end){
+            ::fgwsz::run_scenarios(options);
+            return 0;
+        }
+        //1MB:打包/解包使用的块大小(缓存内),256MB:内存带宽
+        ::std::vector<::std::uint64_t> const sizes={
+            1024ull*1024
+            ,256ull*1024*1024
+        };
+        auto data=::std::make_unique<::std::uint8_t[]>(sizes.back());
+        ::fill(data.get(),sizes.back());
+        ::fgwsz::cout<<::std::format(
+            "selected kernel: {}\n",::fgwsz::key_xor_kernel_name()
+        );
+        for(auto const& kernel : ::fgwsz::key_xor_kernels()){
+            if(!kernel.supported){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} unsupported\n",kernel.name
+                );
+                continue;
+            }
+            if(!::check(kernel)){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} FAILED correctness check\n",kernel.name
+                );
+                return -1;
+            }
+            for(auto bytes:sizes){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} {:>6} KB: {:>8.2f} GB/s\n"
+                    ,kernel.name
+                    ,bytes/1024
+                    ,::measure(kernel,data.get(),bytes)
+                );
+            }
+        }
+        //校验和内核:只计算校验和,以及计算校验和的同时解码xor混淆
+        ::fgwsz::cout<<::std::format(
+            "selected checksum kernel: {}\n",::fgwsz::crc32c_kernel_name()
+        );
+        for(auto const& kernel : ::fgwsz::crc32c_kernels()){
+            if(!kernel.supported){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} unsupported\n",kernel.name
+                );
+                continue;
+            }
+            if(!::check(kernel)){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} FAILED correctness check\n",kernel.name
+                );
+                return -1;
+            }
+            for(auto bytes:sizes){
+                double checksum_speed=0.0;
+                double fused_speed=0.0;
+                ::measure(
+                    kernel
+                    ,data.get()
+                    ,bytes
+                    ,checksum_speed
+                    ,fused_speed
+                );
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} {:>6} KB: crc32c {:>6.2f} GB/s"
+                    ", crc32c+xor {:>6.2f} GB/s\n"
+                    ,kernel.name
+                    ,bytes/1024
+                    ,checksum_speed
+                    ,fused_speed
+                );
+            }
+        }
+        //压缩编码:64MB模拟文本内容,按1MB的帧压缩和解压
+        constexpr ::std::uint64_t text_bytes=64ull*1024*1024;
+        ::fill_text(data.get(),text_bytes);
+        for(auto const& codec : ::fgwsz::codecs()){
+            if(!::check(codec)){
+                ::fgwsz::cout<<::std::format(
+                    "{:<8} FAILED correctness check\n",codec.name
+                );
+                return -1;
+            }
+            double compress_speed=0.0;
+            double decompress_speed=0.0;
+            double ratio=0.0;
+            ::measure(
+                codec
+                ,data.get()
+                ,text_bytes
+                ,compress_speed
+                ,decompress_speed
+                ,ratio
+            );
+            ::fgwsz::cout<<::std::format(
+                "{:<8} text ratio {:>5.2f}: compress {:>6.2f} GB/s"
+                ", decompress {:>6.2f} GB/s\n"
+                ,codec.name
+                ,ratio
+                ,compress_speed
+                ,decompress_speed
+            );
+        }
+        //核心库内存接口:不压缩和每种压缩编码分别往返一次
+        ::std::vector<::fgwsz::Codec> library_codecs={
+            {"none",::fgwsz::codec_none,nullptr,nullptr}
+        };
+        for(auto const& codec : ::fgwsz::codecs()){
+            library_codecs.push_back(codec);
+        }
+        for(auto const& codec:library_codecs){
+            double pack_speed=0.0;
+            double unpack_speed=0.0;
+            double read_speed=0.0;
+            if(!::check_library(
+                codec.id
+                ,data.get()
+                ,text_bytes
+                ,pack_speed
+                ,unpack_speed
+                ,read_speed
+            )){
+                ::fgwsz::cout<<::std::format(
+                    "library {:<8} FAILED round trip\n",codec.name
+                );
+                return -1;
+            }
+            ::fgwsz::cout<<::std::format(
+                "library {:<8} pack {:>6.2f} GB/s"
+                ", unpack {:>6.2f} GB/s, read_all {:>6.2f} GB/s\n"
+                ,codec.name
+                ,pack_speed
+                ,unpack_speed
+                ,read_speed
+            );
+        }
+    }catch(::std::exception const& e){
+        ::fgwsz::cout<<e.what()<<'\n';
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,569 @@
+#include"fgwsz_scenario.h"
+
+#include<cstdint>       //::std::uint8_t ::std::int64_t ::std::uint64_t
+#include<cstddef>       //::std::size_t
+
+#include<string>        //::std::string ::std::getline ::std::stoll
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<vector>        //::std::vector
+#include<memory>        //::std::unique_ptr ::std::make_unique
+#include<chrono>        //::std::chrono
+#include<format>        //::std::format
+#include<fstream>       //::std::ifstream ::std::ofstream
+#include<functional>    //::std::function
+#include<algorithm>     //::std::find
+#include<utility>       //::std::move
+
+#if defined(__linux__)
+#include<linux/perf_event.h>   //::perf_event_attr PERF_TYPE_TRACEPOINT
+#include<sys/syscall.h>         //SYS_perf_event_open
+#include<unistd.h>              //::syscall ::read ::close
+#endif
+
+#include"fgwsz_cout.h"
+#include"fgwsz_except.h"
+#include"fgwsz_file.h"
+#include"fgwsz_packer.h"
+#include"fgwsz_unpacker.h"
+#include"fgwsz_parallel.h"
+#include"fgwsz_xor.h"
+#include"fgwsz_checksum.h"
+#include"fgwsz_uring.h"
+
+namespace fgwsz{
+namespace detail{
+//确定性的伪随机数生成器(xorshift64),相同规模生成的测试数据总是相同
+class ScenarioRandom{
+public:
+    ScenarioRandom(::std::uint64_t seed)noexcept:state_(seed){}
+    ::std::uint64_t next(void)noexcept{
+        this->state_^=this->state_<<13;
+        this->state_^=this->state_>>7;
+        this->state_^=this->state_<<17;
+        return this->state_;
+    }
+    //[min,max]范围内的随机数
+    ::std::uint64_t next(::std::uint64_t min,::std::uint64_t max)noexcept{
+        return min+this->next()%(max-min+1);
+    }
+private:
+    ::std::uint64_t state_;
+};
+//文件内容池:文件内容是从池中随机位置开始的片段
+//文本池模拟源代码和日志(可压缩),随机池模拟已压缩的内容(不可压缩)
+constexpr ::std::uint64_t pool_bytes=4*1024*1024;//4MB
+class ContentPool{
+public:
+    ContentPool(void){
+        static char const* const words[]={
+            "the ","package ","file ","content ","key ","index ","offset "
+            ,"bytes ","path ","return ","if(","){\n","::std::uint64_t "
+            ,"this->","0x00","//","\n    ","FGWSZ_THROW_WHAT(","unpack_"
+            ,"pack_"
+        };
+        this->text_=::std::make_unique<char[]>(2*pool_bytes);
+        this->random_=::std::make_unique<char[]>(2*pool_bytes);
+        ::fgwsz::detail::ScenarioRandom random(0x9E3779B97F4A7C15ull);
+        for(::std::uint64_t index=0;index<2*pool_bytes;){
+            for(char const* word=
+                    words[random.next()%(sizeof(words)/sizeof(words[0]))]
+                ;'\0'!=*word&&index<2*pool_bytes
+                ;++word
+            ){
+                this->text_[index++]=*word;
+            }
+        }
+        for(::std::uint64_t index=0;index<2*pool_bytes;++index){
+            this->random_[index]=static_cast<char>(random.next());
+        }
+    }
+    //从池中取出最多pool_bytes字节的片段
+    char const* text(::fgwsz::detail::ScenarioRandom& random)const noexcept{
+        return this->text_.get()+random.next()%pool_bytes;
+    }
+    char const* random(::fgwsz::detail::ScenarioRandom& random)const noexcept{
+        return this->random_.get()+random.next()%pool_bytes;
+    }
+private:
+    ::std::unique_ptr<char[]> text_;
+    ::std::unique_ptr<char[]> random_;
+};
+//生成一个文件:compressible为false时文本片段和随机片段交替出现
+void generate_file(
+    ::std::filesystem::path const& file_path
+    ,::std::uint64_t bytes
+    ,bool compressible
+    ,::fgwsz::detail::ContentPool const& pool
+    ,::fgwsz::detail::ScenarioRandom& random
+){
+    ::fgwsz::File file(file_path,::fgwsz::FileMode::write_truncate);
+    bool text=true;
+    for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+        ::std::uint64_t const slice_bytes=
+            (bytes-count_bytes)<::fgwsz::detail::pool_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::pool_bytes;
+        file.write(text?pool.text(random):pool.random(random),slice_bytes);
+        text=compressible||!text;
+        count_bytes+=slice_bytes;
+    }
+    file.close();
+}
+//场景:测试数据的生成方式
+struct Scenario{
+    char const* name;
+    char const* description;
+    //在指定目录下生成测试数据(规模缩小scale倍)
+    ::std::function<void(
+        ::std::filesystem::path const& dir_path
+        ,::std::uint64_t scale
+        ,::fgwsz::detail::ContentPool const& pool
+    )> generate;
+};
+//规模缩小之后至少为1
+::std::uint64_t scaled(::std::uint64_t count,::std::uint64_t scale){
+    return count/scale>0?count/scale:1;
+}
+::std::vector<::fgwsz::detail::Scenario> scenarios(void){
+    return {
+        {
+            "tiny"
+            ,"1M files of 0~256 bytes, 1000 files per directory"
+            ,[](auto const& dir_path,auto scale,auto const& pool){
+                ::fgwsz::detail::ScenarioRandom random(1);
+                ::std::uint64_t const count=
+                    ::fgwsz::detail::scaled(1000000,scale);
+                for(::std::uint64_t index=0;index<count;++index){
+                    auto sub_dir_path=dir_path
+                        /::std::format("d{:04}",index/1000);
+                    if(0==index%1000){
+                        ::std::filesystem::create_directories(sub_dir_path);
+                    }
+                    ::fgwsz::detail::generate_file(
+                        sub_dir_path/::std::format("f{:07}.txt",index)
+                        ,random.next(0,256)
+                        ,true
+                        ,pool
+                        ,random
+                    );
+                }
+            }
+        }
+        ,{
+            "medium"
+            ,"10k files of 64KB~1MB, 100 files per directory"
+            ,[](auto const& dir_path,auto scale,auto const& pool){
+                ::fgwsz::detail::ScenarioRandom random(2);
+                ::std::uint64_t const count=
+                    ::fgwsz::detail::scaled(10000,scale);
+                for(::std::uint64_t index=0;index<count;++index){
+                    auto sub_dir_path=dir_path
+                        /::std::format("d{:03}",index/100);
+                    if(0==index%100){
+                        ::std::filesystem::create_directories(sub_dir_path);
+                    }
+                    ::fgwsz::detail::generate_file(
+                        sub_dir_path/::std::format("f{:05}.bin",index)
+                        ,random.next(64*1024,1024*1024)
+                        ,0!=index%4
+                        ,pool
+                        ,random
+                    );
+                }
+            }
+        }
+        ,{
+            "large"
+            ,"3 files of 2GB, half compressible"
+            ,[](auto const& dir_path,auto scale,auto const& pool){
+                ::fgwsz::detail::ScenarioRandom random(3);
+                ::std::filesystem::create_directories(dir_path);
+                for(int index=0;index<3;++index){
+                    ::fgwsz::detail::generate_file(
+                        dir_path/::std::format("f{}.bin",index)
+                        ,::fgwsz::detail::scaled(2048ull*1024*1024,scale)
+                        ,false
+                        ,pool
+                        ,random
+                    );
+                }
+            }
+        }
+        ,{
+            "deep"
+            ,"100 directory chains of depth 100, a 1KB file per directory"
+            ,[](auto const& dir_path,auto scale,auto const& pool){
+                ::fgwsz::detail::ScenarioRandom random(4);
+                ::std::uint64_t const count=::fgwsz::detail::scaled(100,scale);
+                for(::std::uint64_t chain=0;chain<count;++chain){
+                    auto sub_dir_path=dir_path/::std::format("c{:03}",chain);
+                    for(int depth=0;depth<100;++depth){
+                        sub_dir_path/=::std::format("d{:02}",depth);
+                        ::std::filesystem::create_directories(sub_dir_path);
+                        ::fgwsz::detail::generate_file(
+                            sub_dir_path/"f.txt"
+                            ,1024
+                            ,true
+                            ,pool
+                            ,random
+                        );
+                    }
+                }
+            }
+        }
+    };
+}
+//进程(包括之后创建的线程)的系统调用总次数
+//使用raw_syscalls:sys_enter跟踪点的perf计数器,需要挂载tracefs并且有权限,不支持时为-1
+class SyscallCounter{
+public:
+    SyscallCounter(void)noexcept:fd_(-1){
+#if defined(__linux__)
+        for(char const* path:{
+            "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id"
+            ,"/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"
+        }){
+            ::std::uint64_t id=0;
+            if(!(::std::ifstream(path)>>id)){
+                continue;
+            }
+            ::perf_event_attr attr={};
+            attr.type=PERF_TYPE_TRACEPOINT;
+            attr.size=sizeof(attr);
+            attr.config=id;
+            attr.inherit=1;
+            this->fd_=static_cast<int>(::syscall(
+                SYS_perf_event_open,&attr,0,-1,-1,0
+            ));
+            break;
+        }
+#endif
+    }
+    ~SyscallCounter(void){
+#if defined(__linux__)
+        if(this->fd_>=0){
+            ::close(this->fd_);
+        }
+#endif
+    }
+    ::std::int64_t count(void)const noexcept{
+#if defined(__linux__)
+        ::std::uint64_t value=0;
+        if(this->fd_>=0
+            &&sizeof(value)==::read(this->fd_,&value,sizeof(value))
+        ){
+            return static_cast<::std::int64_t>(value);
+        }
+#endif
+        return -1;
+    }
+    SyscallCounter(SyscallCounter const&)noexcept=delete;
+    SyscallCounter& operator=(SyscallCounter const&)noexcept=delete;
+private:
+    int fd_;
+};
+//进程的系统调用次数:total为所有系统调用(跟踪点计数器),
+//read和write只是read/write类系统调用(/proc/self/io,不包括内存映射和io_uring的读写),
+//uring_enter和uring_sqes为io_uring_enter系统调用次数和提交的请求数,不支持时为-1
+struct SyscallCounts{
+    ::std::int64_t total;
+    ::std::int64_t read;
+    ::std::int64_t write;
+    ::std::int64_t uring_enter;
+    ::std::int64_t uring_sqes;
+};
+::fgwsz::detail::SyscallCounts syscall_counts(
+    ::fgwsz::detail::SyscallCounter const& counter
+){
+    auto const uring=::fgwsz::io_uring_counts();
+    ::fgwsz::detail::SyscallCounts counts={
+        counter.count()
+        ,-1
+        ,-1
+        ,static_cast<::std::int64_t>(uring.enters)
+        ,static_cast<::std::int64_t>(uring.submitted)
+    };
+    ::std::ifstream stream("/proc/self/io");
+    ::std::string line;
+    while(::std::getline(stream,line)){
+        ::std::string_view view=line;
+        if(view.starts_with("syscr: ")){
+            counts.read=::std::stoll(line.substr(7));
+        }else if(view.starts_with("syscw: ")){
+            counts.write=::std::stoll(line.substr(7));
+        }
+    }
+    return counts;
+}
+//重置进程的内存峰值(/proc/self/clear_refs),不支持时返回false
+bool reset_peak_rss(void){
+    ::std::ofstream stream("/proc/self/clear_refs");
+    stream<<"5";
+    stream.flush();
+    return static_cast<bool>(stream);
+}
+//进程的内存峰值(/proc/self/status的VmHWM,KB),不支持时为-1
+::std::int64_t peak_rss_kb(void){
+    ::std::ifstream stream("/proc/self/status");
+    ::std::string line;
+    while(::std::getline(stream,line)){
+        if(::std::string_view(line).starts_with("VmHWM:")){
+            return ::std::stoll(line.substr(6));
+        }
+    }
+    return -1;
+}
+//一个操作的测量结果
+struct Measurement{
+    char const* name;
+    double seconds;
+    ::fgwsz::detail::SyscallCounts syscalls;
+    ::std::int64_t peak_rss_kb;
+};
+::fgwsz::detail::Measurement measure(
+    char const* name
+    ,::std::function<void(void)> const& operation
+){
+    using clock=::std::chrono::steady_clock;
+    ::fgwsz::detail::SyscallCounter const counter;
+    bool const peak_reset=::fgwsz::detail::reset_peak_rss();
+    auto const before=::fgwsz::detail::syscall_counts(counter);
+    auto const start=clock::now();
+    operation();
+    double const seconds=
+        ::std::chrono::duration<double>(clock::now()-start).count();
+    auto const after=::fgwsz::detail::syscall_counts(counter);
+    ::fgwsz::detail::Measurement measurement={
+        name
+        ,seconds
+        ,{-1,-1,-1,after.uring_enter-before.uring_enter
+            ,after.uring_sqes-before.uring_sqes}
+        ,peak_reset?::fgwsz::detail::peak_rss_kb():-1
+    };
+    if(before.total>=0&&after.total>=0){
+        measurement.syscalls.total=after.total-before.total;
+    }
+    if(before.read>=0&&after.read>=0){
+        measurement.syscalls.read=after.read-before.read;
+    }
+    if(before.write>=0&&after.write>=0){
+        measurement.syscalls.write=after.write-before.write;
+    }
+    return measurement;
+}
+//场景的测量结果
+struct ScenarioResult{
+    char const* name;
+    ::std::uint64_t files;
+    ::std::uint64_t bytes;
+    ::std::uint64_t package_bytes;
+    ::std::vector<::fgwsz::detail::Measurement> measurements;
+};
+//不支持的计数在JSON中为null
+::std::string json_number(::std::int64_t value){
+    return value<0?::std::string("null")
+        : ::std::to_string(value);
+}
+::std::string to_json(
+    ::fgwsz::ScenarioOptions const& options
+    ,::std::size_t thread_count
+    ,::std::vector<::fgwsz::detail::ScenarioResult> const& results
+){
+    ::std::string json=::std::format(
+        "{{\n"
+        "  \"scale\": {},\n"
+        "  \"threads\": {},\n"
+        "  \"xor_kernel\": \"{}\",\n"
+        "  \"checksum_kernel\": \"{}\",\n"
+        "  \"scenarios\": ["
+        ,options.scale
+        ,thread_count
+        ,::fgwsz::key_xor_kernel_name()
+        ,::fgwsz::crc32c_kernel_name()
+    );
+    for(::std::size_t index=0;index<results.size();++index){
+        auto const& result=results[index];
+        json+=::std::format(
+            "{}\n"
+            "    {{\n"
+            "      \"name\": \"{}\",\n"
+            "      \"files\": {},\n"
+            "      \"bytes\": {},\n"
+            "      \"package_bytes\": {},\n"
+            "      \"operations\": ["
+            ,0==index?"":","
+            ,result.name
+            ,result.files
+            ,result.bytes
+            ,result.package_bytes
+        );
+        for(::std::size_t op=0;op<result.measurements.size();++op){
+            auto const& measurement=result.measurements[op];
+            json+=::std::format(
+                "{}\n"
+                "        {{\"name\": \"{}\", \"seconds\": {:.6f}"
+                ", \"mb_per_second\": {:.2f}, \"files_per_second\": {:.1f}"
+                ", \"syscalls\": {}"
+                ", \"read_syscalls\": {}, \"write_syscalls\": {}"
+                ", \"uring_enters\": {}, \"uring_sqes\": {}"
+                ", \"peak_rss_kb\": {}}}"
+                ,0==op?"":","
+                ,measurement.name
+                ,measurement.seconds
+                ,static_cast<double>(result.bytes)/1e6/measurement.seconds
+                ,static_cast<double>(result.files)/measurement.seconds
+                ,::fgwsz::detail::json_number(measurement.syscalls.total)
+                ,::fgwsz::detail::json_number(measurement.syscalls.read)
+                ,::fgwsz::detail::json_number(measurement.syscalls.write)
+                ,::fgwsz::detail::json_number(measurement.syscalls.uring_enter)
+                ,::fgwsz::detail::json_number(measurement.syscalls.uring_sqes)
+                ,::fgwsz::detail::json_number(measurement.peak_rss_kb)
+            );
+        }
+        json+="\n      ]\n    }";
+    }
+    json+="\n  ]\n}\n";
+    return json;
+}
+}//namespace fgwsz::detail
+void run_scenarios(::fgwsz::ScenarioOptions const& options){
+    ::std::size_t const thread_count=0==options.thread_count
+        ?::fgwsz::default_thread_count():options.thread_count;
+    ::std::unique_ptr<::fgwsz::detail::ContentPool> pool;
+    ::std::vector<::fgwsz::detail::ScenarioResult> results;
+    ::fgwsz::cout<<::std::format(
+        "scale 1/{}, {} threads, data: {}\n"
+        ,options.scale
+        ,thread_count
+        ,options.data_path.generic_string()
+    );
+    for(auto const& scenario : ::fgwsz::detail::scenarios()){
+        if(!options.names.empty()
+            &&options.names.end()==::std::find(
+                options.names.begin()
+                ,options.names.end()
+                ,scenario.name
+            )
+        ){
+            continue;
+        }
+        //测试数据生成完成之后写入标记文件(记录规模),相同规模时直接复用
+        auto const dir_path=options.data_path/scenario.name;
+        auto const marker_path=options.data_path
+            /(::std::string(scenario.name)+".done");
+        ::std::string const marker=::std::to_string(options.scale);
+        ::std::string existing_marker;
+        ::std::ifstream(marker_path)>>existing_marker;
+        if(marker!=existing_marker){
+            ::fgwsz::cout<<::std::format(
+                "generating {}: {}\n",scenario.name,scenario.description
+            );
+            ::fgwsz::cout.flush();
+            ::std::filesystem::remove(marker_path);
+            ::std::filesystem::remove_all(dir_path);
+            if(nullptr==pool){
+                pool=::std::make_unique<::fgwsz::detail::ContentPool>();
+            }
+            scenario.generate(dir_path,options.scale,*pool);
+            ::std::ofstream(marker_path)<<marker;
+        }
+        ::fgwsz::detail::ScenarioResult result={
+            scenario.name,0,0,0,{}
+        };
+        for(auto const& item
+            : ::std::filesystem::recursive_directory_iterator(dir_path)
+        ){
+            if(item.is_regular_file()){
+                ++result.files;
+                result.bytes+=item.file_size();
+            }
+        }
+        auto const package_path=options.data_path
+            /(::std::string(scenario.name)+".fgwsz");
+        auto const output_path=options.data_path
+            /(::std::string(scenario.name)+".out");
+        ::std::filesystem::remove_all(output_path);
+        auto pack=[&](::std::size_t threads,::std::uint8_t codec){
+            //之前的Packer析构时把包设置为只读,非root用户不能覆盖只读的包
+            ::std::filesystem::remove(package_path);
+            ::fgwsz::Packer packer(package_path);
+            packer.set_thread_count(threads);
+            packer.set_codec(codec);
+            packer.pack_paths({dir_path});
+            packer.pack_index();
+        };
+        auto unpack=[&](::std::size_t threads){
+            ::fgwsz::Unpacker unpacker(package_path);
+            unpacker.set_thread_count(threads);
+            unpacker.unpack_package(output_path);
+        };
+        //依次测量:打包,列表,解包,压缩打包和解包(后一个操作使用前一个操作生成的包)
+        auto& measurements=result.measurements;
+        measurements.push_back(::fgwsz::detail::measure("pack",[&](void){
+            pack(1,::fgwsz::codec_none);
+        }));
+        measurements.push_back(
+            ::fgwsz::detail::measure("pack_parallel",[&](void){
+                pack(thread_count,::fgwsz::codec_none);
+            })
+        );
+        result.package_bytes=::std::filesystem::file_size(package_path);
+        measurements.push_back(::fgwsz::detail::measure("list",[&](void){
+            ::fgwsz::Unpacker unpacker(package_path);
+            if(unpacker.entries().size()!=result.files){
+                FGWSZ_THROW_WHAT(
+                    "package file count mismatch: "
+                    +package_path.generic_string()
+                );
+            }
+        }));
+        measurements.push_back(::fgwsz::detail::measure("unpack",[&](void){
+            unpack(1);
+        }));
+        ::std::filesystem::remove_all(output_path);
+        measurements.push_back(
+            ::fgwsz::detail::measure("unpack_parallel",[&](void){
+                unpack(thread_count);
+            })
+        );
+        ::std::filesystem::remove_all(output_path);
+        measurements.push_back(::fgwsz::detail::measure("pack_lz",[&](void){
+            pack(thread_count,::fgwsz::codec_lz);
+        }));
+        measurements.push_back(::fgwsz::detail::measure("unpack_lz",[&](void){
+            unpack(thread_count);
+        }));
+        ::std::filesystem::remove_all(output_path);
+        ::std::filesystem::remove(package_path);
+        for(auto const& measurement:measurements){
+            ::fgwsz::cout<<::std::format(
+                "{:<8} {:<16} {:>9.3f} s {:>10.2f} MB/s {:>12.1f} files/s"
+                "  syscalls {:>9} (read {:>9} write {:>9})"
+                "  uring enter {:>9} sqe {:>9}  peak rss {:>9} KB\n"
+                ,scenario.name
+                ,measurement.name
+                ,measurement.seconds
+                ,static_cast<double>(result.bytes)/1e6/measurement.seconds
+                ,static_cast<double>(result.files)/measurement.seconds
+                ,::fgwsz::detail::json_number(measurement.syscalls.total)
+                ,::fgwsz::detail::json_number(measurement.syscalls.read)
+                ,::fgwsz::detail::json_number(measurement.syscalls.write)
+                ,::fgwsz::detail::json_number(measurement.syscalls.uring_enter)
+                ,::fgwsz::detail::json_number(measurement.syscalls.uring_sqes)
+                ,::fgwsz::detail::json_number(measurement.peak_rss_kb)
+            );
+        }
+        ::fgwsz::cout.flush();
+        results.push_back(::std::move(result));
+    }
+    if(!options.json_path.empty()){
+        ::std::ofstream stream(options.json_path,::std::ios::binary);
+        stream<<::fgwsz::detail::to_json(options,thread_count,results);
+        if(!stream){
+            FGWSZ_THROW_WHAT(
+                "failed to write json: "+options.json_path.generic_string()
+            );
+        }
+    }
+}
+}//namespace fgwsz
@@ -0,0 +1,35 @@
+#ifndef FGWSZ_SCENARIO_H
+#define FGWSZ_SCENARIO_H
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<vector>    //::std::vector
+
+//============================================================================
+//打包/解包/列表的端到端基准测试相关
+//============================================================================
+namespace fgwsz{
+//端到端基准测试的选项
+struct ScenarioOptions{
+    //生成的测试数据,包和解包输出所在的目录
+    //(测试数据生成之后保留,之后以相同规模运行时直接复用)
+    ::std::filesystem::path data_path;
+    //数据规模的缩小倍数(1为完整规模:100万个小文件,1万个中等文件,3个2GB的文件)
+    ::std::uint64_t scale;
+    //多线程操作使用的线程数(0表示使用硬件并发线程数)
+    ::std::size_t thread_count;
+    //只运行指定名称的场景(为空时运行所有场景)
+    ::std::vector<::std::string> names;
+    //JSON结果的输出路径(为空时不输出)
+    ::std::filesystem::path json_path;
+};
+//生成各场景的测试数据,对每个场景依次进行打包,解包和列表操作,
+//打印每个操作的耗时,MB/s,files/s,系统调用次数(read/write类系统调用和io_uring请求分别计数)和内存峰值
+//全部场景完成之后把结果写入JSON文件,便于比较不同版本的构建
+void run_scenarios(::fgwsz::ScenarioOptions const& options);
+}//namespace fgwsz
+
+#endif//FGWSZ_SCENARIO_H
@@ -0,0 +1,443 @@
+#include"fgwsz_checksum.h"
+
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
+#include<cstring>   //::std::memcpy
+
+#include<array>     //::std::array
+#include<vector>    //::std::vector
+
+#include"fgwsz_stats.h"
+
+#if defined(__x86_64__)||defined(_M_X64)
+    #define FGWSZ_CRC32C_X86 1
+    #include<nmmintrin.h>   //SSE4.2 _mm_crc32_u64 _mm_crc32_u8
+    #if defined(_MSC_VER)
+        #include<intrin.h>  //__cpuid
+    #else
+        #include<cpuid.h>   //__cpuid
+    #endif
+#else
+    #define FGWSZ_CRC32C_X86 0
+#endif
+
+//GCC/Clang需要为使用更高指令集的函数单独指定目标,MSVC不需要
+#if FGWSZ_CRC32C_X86&&!defined(_MSC_VER)
+    #define FGWSZ_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+    #define FGWSZ_TARGET_SSE42
+#endif
+
+namespace fgwsz{
+namespace detail{
+//CRC32C(Castagnoli)多项式的反射表示
+inline constexpr ::std::uint32_t crc32c_polynomial=0x82F63B78u;
+//模多项式乘法(反射表示,最高位为x^0)
+inline ::std::uint32_t crc32c_multiply(::std::uint32_t a,::std::uint32_t b){
+    ::std::uint32_t m=1u<<31;
+    ::std::uint32_t p=0;
+    while(0!=m){
+        if(0!=(a&m)){
+            p^=b;
+        }
+        m>>=1;
+        b=(b&1u)?(b>>1)^::fgwsz::detail::crc32c_polynomial:(b>>1);
+    }
+    return p;
+}
+//x^(2^k)模多项式的值(k=0..63)
+inline ::std::array<::std::uint32_t,64> make_crc32c_powers(void){
+    ::std::array<::std::uint32_t,64> powers={};
+    ::std::uint32_t p=1u<<30;//x^1
+    for(auto& power:powers){
+        power=p;
+        p=::fgwsz::detail::crc32c_multiply(p,p);
+    }
+    return powers;
+}
+//查找表在第一次使用时生成(其他翻译单元的静态初始化中也可以使用)
+inline ::std::array<::std::uint32_t,64> const& crc32c_powers(void){
+    static ::std::array<::std::uint32_t,64> const powers=
+        ::fgwsz::detail::make_crc32c_powers();
+    return powers;
+}
+//x^(8*bytes)模多项式的值
+inline ::std::uint32_t crc32c_shift_factor(::std::uint64_t bytes){
+    auto const& powers=::fgwsz::detail::crc32c_powers();
+    ::std::uint32_t p=1u<<31;//x^0
+    //x^(8*bytes)=x^(bytes*2^3),从2^3次幂开始按bytes的二进制位相乘
+    for(::std::size_t k=3;0!=bytes;bytes>>=1,++k){
+        if(0!=(bytes&1u)){
+            p=::fgwsz::detail::crc32c_multiply(
+                powers[k&63]
+                ,p
+            );
+        }
+    }
+    return p;
+}
+//可移植内核使用的8张查找表(每次处理8字节)
+inline ::std::array<::std::array<::std::uint32_t,256>,8> make_crc32c_tables(
+    void
+){
+    ::std::array<::std::array<::std::uint32_t,256>,8> tables={};
+    for(::std::uint32_t index=0;index<256;++index){
+        ::std::uint32_t crc=index;
+        for(int bit=0;bit<8;++bit){
+            crc=(crc&1u)?(crc>>1)^::fgwsz::detail::crc32c_polynomial:(crc>>1);
+        }
+        tables[0][index]=crc;
+    }
+    for(::std::uint32_t index=0;index<256;++index){
+        for(::std::size_t table=1;table<8;++table){
+            tables[table][index]=(tables[table-1][index]>>8)
+                ^tables[0][tables[table-1][index]&0xFFu];
+        }
+    }
+    return tables;
+}
+inline ::std::array<::std::array<::std::uint32_t,256>,8> const& crc32c_tables(
+    void
+){
+    static ::std::array<::std::array<::std::uint32_t,256>,8> const tables=
+        ::fgwsz::detail::make_crc32c_tables();
+    return tables;
+}
+//内核的工作方式
+enum class Crc32cMode{
+    checksum,       //只计算src的校验和
+    xor_checksum,   //dst=src^key,计算dst的校验和
+    checksum_xor    //计算src的校验和,dst=src^key
+};
+//处理一个8字节的字,返回参与校验和计算的字
+template<::fgwsz::detail::Crc32cMode mode_>
+inline ::std::uint64_t crc32c_load_word(
+    ::std::uint8_t* dst
+    ,::std::uint8_t const* src
+    ,::std::uint64_t word_key
+){
+    ::std::uint64_t word=0;
+    ::std::memcpy(&word,src,sizeof(word));
+    if constexpr(::fgwsz::detail::Crc32cMode::checksum!=mode_){
+        ::std::uint64_t const mixed=word^word_key;
+        ::std::memcpy(dst,&mixed,sizeof(mixed));
+        if constexpr(::fgwsz::detail::Crc32cMode::xor_checksum==mode_){
+            word=mixed;
+        }
+    }
+    return word;
+}
+template<::fgwsz::detail::Crc32cMode mode_>
+inline ::std::uint8_t crc32c_load_byte(
+    ::std::uint8_t* dst
+    ,::std::uint8_t const* src
+    ,::std::uint8_t key
+){
+    ::std::uint8_t byte=*src;
+    if constexpr(::fgwsz::detail::Crc32cMode::checksum!=mode_){
+        ::std::uint8_t const mixed=byte^key;
+        *dst=mixed;
+        if constexpr(::fgwsz::detail::Crc32cMode::xor_checksum==mode_){
+            byte=mixed;
+        }
+    }
+    return byte;
+}
+//可移植内核:查找表每次处理8字节
+template<::fgwsz::detail::Crc32cMode mode_>
+::std::uint32_t crc32c_table(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    auto const& tables=::fgwsz::detail::crc32c_tables();
+    //只计算校验和时dst为空,各处写入的位置都不会被使用
+    if constexpr(::fgwsz::detail::Crc32cMode::checksum==mode_){
+        to=const_cast<::std::uint8_t*>(from);
+    }
+    ::std::uint64_t const word_key=
+        static_cast<::std::uint64_t>(key)*0x0101010101010101ull;
+    ::std::uint32_t value=~crc;
+    ::std::uint64_t index=0;
+    for(;index+8<=bytes;index+=8){
+        ::std::uint64_t word=
+            ::fgwsz::detail::crc32c_load_word<mode_>(
+                to+index,from+index,word_key
+            );
+        //按内存顺序取出各字节(与逐字节处理的顺序一致,与字节序无关)
+        ::std::uint8_t b[8];
+        ::std::memcpy(b,&word,sizeof(b));
+        value^=static_cast<::std::uint32_t>(b[0])
+            |(static_cast<::std::uint32_t>(b[1])<<8)
+            |(static_cast<::std::uint32_t>(b[2])<<16)
+            |(static_cast<::std::uint32_t>(b[3])<<24);
+        value=tables[7][value&0xFFu]
+            ^tables[6][(value>>8)&0xFFu]
+            ^tables[5][(value>>16)&0xFFu]
+            ^tables[4][value>>24]
+            ^tables[3][b[4]]
+            ^tables[2][b[5]]
+            ^tables[1][b[6]]
+            ^tables[0][b[7]];
+    }
+    for(;index<bytes;++index){
+        ::std::uint8_t const byte=::fgwsz::detail::crc32c_load_byte<mode_>(
+            to+index,from+index,key
+        );
+        value=(value>>8)^tables[0][(value^byte)&0xFFu];
+    }
+    return ~value;
+}
+#if FGWSZ_CRC32C_X86
+//硬件内核:SSE4.2的crc32指令延迟为3个周期,吞吐为每周期1条,
+//因此把长内容切分为3段同时计算,再通过查找表把前两段的校验和移动到末尾合并
+inline constexpr ::std::uint64_t crc32c_long_bytes=8192;
+inline constexpr ::std::uint64_t crc32c_short_bytes=256;
+//移动校验和的查找表:按校验和的4个字节分别查表
+using Crc32cShiftTable=::std::array<::std::array<::std::uint32_t,256>,4>;
+inline Crc32cShiftTable make_crc32c_shift_table(::std::uint64_t bytes){
+    ::std::uint32_t const factor=::fgwsz::detail::crc32c_shift_factor(bytes);
+    Crc32cShiftTable table={};
+    for(::std::uint32_t index=0;index<256;++index){
+        for(::std::size_t part=0;part<4;++part){
+            table[part][index]=::fgwsz::detail::crc32c_multiply(
+                factor
+                ,index<<(8*part)
+            );
+        }
+    }
+    return table;
+}
+inline Crc32cShiftTable const& crc32c_long_table(void){
+    static Crc32cShiftTable const table=
+        ::fgwsz::detail::make_crc32c_shift_table(
+            ::fgwsz::detail::crc32c_long_bytes
+        );
+    return table;
+}
+inline Crc32cShiftTable const& crc32c_short_table(void){
+    static Crc32cShiftTable const table=
+        ::fgwsz::detail::make_crc32c_shift_table(
+            ::fgwsz::detail::crc32c_short_bytes
+        );
+    return table;
+}
+inline ::std::uint64_t crc32c_shift_by_table(
+    Crc32cShiftTable const& table
+    ,::std::uint64_t crc
+){
+    return table[0][crc&0xFFu]
+        ^table[1][(crc>>8)&0xFFu]
+        ^table[2][(crc>>16)&0xFFu]
+        ^table[3][(crc>>24)&0xFFu];
+}
+//同时计算3段内容的校验和,每段stride字节
+template<::fgwsz::detail::Crc32cMode mode_>
+FGWSZ_TARGET_SSE42
+inline ::std::uint64_t crc32c_sse42_stripes(
+    ::std::uint8_t* to
+    ,::std::uint8_t const* from
+    ,::std::uint64_t stride
+    ,::std::uint64_t word_key
+    ,::std::uint64_t crc0
+    ,Crc32cShiftTable const& table
+){
+    ::std::uint64_t crc1=0;
+    ::std::uint64_t crc2=0;
+    for(::std::uint64_t index=0;index<stride;index+=8){
+        crc0=_mm_crc32_u64(crc0,::fgwsz::detail::crc32c_load_word<mode_>(
+            to+index,from+index,word_key
+        ));
+        crc1=_mm_crc32_u64(crc1,::fgwsz::detail::crc32c_load_word<mode_>(
+            to+stride+index,from+stride+index,word_key
+        ));
+        crc2=_mm_crc32_u64(crc2,::fgwsz::detail::crc32c_load_word<mode_>(
+            to+2*stride+index,from+2*stride+index,word_key
+        ));
+    }
+    crc0=::fgwsz::detail::crc32c_shift_by_table(table,crc0)^crc1;
+    return ::fgwsz::detail::crc32c_shift_by_table(table,crc0)^crc2;
+}
+template<::fgwsz::detail::Crc32cMode mode_>
+FGWSZ_TARGET_SSE42
+::std::uint32_t crc32c_sse42(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    ::std::uint64_t const word_key=
+        static_cast<::std::uint64_t>(key)*0x0101010101010101ull;
+    ::std::uint64_t value=static_cast<::std::uint32_t>(~crc);
+    ::std::uint64_t index=0;
+    //只计算校验和时dst为空,各处写入的位置都不会被使用
+    if constexpr(::fgwsz::detail::Crc32cMode::checksum==mode_){
+        to=const_cast<::std::uint8_t*>(from);
+    }
+    auto const& long_table=::fgwsz::detail::crc32c_long_table();
+    auto const& short_table=::fgwsz::detail::crc32c_short_table();
+    for(;index+3*::fgwsz::detail::crc32c_long_bytes<=bytes
+        ;index+=3*::fgwsz::detail::crc32c_long_bytes
+    ){
+        value=::fgwsz::detail::crc32c_sse42_stripes<mode_>(
+            to+index
+            ,from+index
+            ,::fgwsz::detail::crc32c_long_bytes
+            ,word_key
+            ,value
+            ,long_table
+        );
+    }
+    for(;index+3*::fgwsz::detail::crc32c_short_bytes<=bytes
+        ;index+=3*::fgwsz::detail::crc32c_short_bytes
+    ){
+        value=::fgwsz::detail::crc32c_sse42_stripes<mode_>(
+            to+index
+            ,from+index
+            ,::fgwsz::detail::crc32c_short_bytes
+            ,word_key
+            ,value
+            ,short_table
+        );
+    }
+    for(;index+8<=bytes;index+=8){
+        value=_mm_crc32_u64(value,::fgwsz::detail::crc32c_load_word<mode_>(
+            to+index,from+index,word_key
+        ));
+    }
+    auto value32=static_cast<::std::uint32_t>(value);
+    for(;index<bytes;++index){
+        value32=_mm_crc32_u8(value32,::fgwsz::detail::crc32c_load_byte<mode_>(
+            to+index,from+index,key
+        ));
+    }
+    return ~value32;
+}
+inline bool cpu_supports_sse42(void){
+#if defined(_MSC_VER)
+    int info[4]={};
+    __cpuid(info,1);
+    return 0!=((static_cast<unsigned>(info[2])>>20)&1u);
+#else
+    unsigned int a=0,b=0,c=0,d=0;
+    if(0==__get_cpuid(1,&a,&b,&c,&d)){
+        return false;
+    }
+    return 0!=((c>>20)&1u);
+#endif
+}
+#endif//FGWSZ_CRC32C_X86
+//只计算校验和的内核包装(dst和key不使用)
+template<::std::uint32_t(*kernel_)(
+    void*
+    ,void const*
+    ,::std::uint64_t
+    ,::std::uint8_t
+    ,::std::uint32_t
+)>
+::std::uint32_t crc32c_only(
+    void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint32_t crc
+){
+    return kernel_(nullptr,src,bytes,0,crc);
+}
+inline ::std::vector<::fgwsz::Crc32cKernel> make_crc32c_kernels(void){
+    using Mode=::fgwsz::detail::Crc32cMode;
+    //按性能从低到高排列,最后一个受支持的内核即为默认内核
+    ::std::vector<::fgwsz::Crc32cKernel> kernels;
+    kernels.push_back({
+        "table"
+        ,&::fgwsz::detail::crc32c_only<
+            &::fgwsz::detail::crc32c_table<Mode::checksum>
+        >
+        ,&::fgwsz::detail::crc32c_table<Mode::xor_checksum>
+        ,&::fgwsz::detail::crc32c_table<Mode::checksum_xor>
+        ,true
+    });
+#if FGWSZ_CRC32C_X86
+    kernels.push_back({
+        "sse4.2"
+        ,&::fgwsz::detail::crc32c_only<
+            &::fgwsz::detail::crc32c_sse42<Mode::checksum>
+        >
+        ,&::fgwsz::detail::crc32c_sse42<Mode::xor_checksum>
+        ,&::fgwsz::detail::crc32c_sse42<Mode::checksum_xor>
+        ,::fgwsz::detail::cpu_supports_sse42()
+    });
+#endif
+    return kernels;
+}
+inline ::fgwsz::Crc32cKernel select_crc32c_kernel(void){
+    ::fgwsz::Crc32cKernel selected={};
+    for(auto const& kernel : ::fgwsz::detail::make_crc32c_kernels()){
+        if(kernel.supported){
+            selected=kernel;
+        }
+    }
+    return selected;
+}
+//第一次调用时选择一次内核,之后每次调用只需一次间接跳转
+//(函数内静态变量保证其他翻译单元的静态初始化中调用时内核也已经选择好)
+inline ::fgwsz::Crc32cKernel const& crc32c_kernel(void){
+    static ::fgwsz::Crc32cKernel const kernel=
+        ::fgwsz::detail::select_crc32c_kernel();
+    return kernel;
+}
+}//namespace fgwsz::detail
+
+::std::uint32_t crc32c(
+    ::std::uint32_t crc
+    ,void const* data
+    ,::std::uint64_t bytes
+){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::checksum,bytes);
+    return ::fgwsz::detail::crc32c_kernel().function(data,bytes,crc);
+}
+::std::uint32_t key_xor_crc32c(
+    void* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::key_xor,bytes);
+    return ::fgwsz::detail::crc32c_kernel().xor_function(ptr,ptr,bytes,key,crc);
+}
+::std::uint32_t crc32c_key_xor_copy(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::key_xor,bytes);
+    return ::fgwsz::detail::crc32c_kernel().function_xor(dst,src,bytes,key,crc);
+}
+::std::uint32_t crc32c_shift(::std::uint32_t crc,::std::uint64_t bytes){
+    return ::fgwsz::detail::crc32c_multiply(
+        ::fgwsz::detail::crc32c_shift_factor(bytes)
+        ,crc
+    );
+}
+::std::uint32_t crc32c_combine(
+    ::std::uint32_t crc1
+    ,::std::uint32_t crc2
+    ,::std::uint64_t bytes2
+){
+    return ::fgwsz::crc32c_shift(crc1,bytes2)^crc2;
+}
+char const* crc32c_kernel_name(void){
+    return ::fgwsz::detail::crc32c_kernel().name;
+}
+::std::vector<::fgwsz::Crc32cKernel> crc32c_kernels(void){
+    return ::fgwsz::detail::make_crc32c_kernels();
+}
+
+}//namespace fgwsz
@@ -0,0 +1,74 @@
+#ifndef FGWSZ_CHECKSUM_H
+#define FGWSZ_CHECKSUM_H
+
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+
+#include<vector>    //::std::vector
+
+//============================================================================
+//文件项校验和(CRC32C)相关
+//============================================================================
+namespace fgwsz{
+//校验和内核函数类型:计算src的校验和
+using Crc32cFunction=::std::uint32_t(*)(
+    void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint32_t crc
+);
+//校验和混淆内核函数类型:使用单字节密钥对src进行xor混淆并写入dst,同时计算校验和
+using Crc32cXorFunction=::std::uint32_t(*)(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+);
+//校验和内核描述信息
+struct Crc32cKernel{
+    char const* name;                   //内核名称
+    Crc32cFunction function;            //只计算校验和
+    Crc32cXorFunction xor_function;     //先混淆,再计算混淆结果的校验和
+    Crc32cXorFunction function_xor;     //先计算src的校验和,再混淆
+    bool supported;                     //当前CPU是否支持该内核
+};
+//计算data的CRC32C校验和,crc为之前内容的校验和(第一段内容为0)
+//(程序启动时根据CPUID选择当前CPU支持的最快内核)
+::std::uint32_t crc32c(
+    ::std::uint32_t crc
+    ,void const* data
+    ,::std::uint64_t bytes
+);
+//使用单字节密钥对内存块进行原地xor混淆,同时计算混淆结果的校验和(打包)
+//与key_xor相同只读取和写入一遍内存
+::std::uint32_t key_xor_crc32c(
+    void* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+);
+//计算src的校验和,同时使用单字节密钥对src进行xor混淆并写入dst(解包)
+//dst和src可以相同,但不能部分重叠
+::std::uint32_t crc32c_key_xor_copy(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+    ,::std::uint32_t crc
+);
+//把一段内容的校验和移动到其后还有bytes字节内容的位置(模CRC32C多项式乘以x^(8*bytes))
+//利用它可以按任意顺序合并多段内容的校验和:
+//整体校验和等于各段校验和分别移动其后所有内容的字节数之后的xor
+::std::uint32_t crc32c_shift(::std::uint32_t crc,::std::uint64_t bytes);
+//合并两段相邻内容的校验和(bytes2为第二段内容的字节数)
+::std::uint32_t crc32c_combine(
+    ::std::uint32_t crc1
+    ,::std::uint32_t crc2
+    ,::std::uint64_t bytes2
+);
+//当前选中的校验和内核名称
+char const* crc32c_kernel_name(void);
+//所有校验和内核(用于基准测试和正确性校验)
+::std::vector<::fgwsz::Crc32cKernel> crc32c_kernels(void);
+}//namespace fgwsz
+
+#endif//FGWSZ_CHECKSUM_H
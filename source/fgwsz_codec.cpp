@@ -0,0 +1,339 @@
+#include"fgwsz_codec.h"
+
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+#include<cstring>   //::std::memcpy ::std::memset
+
+#include<bit>       //::std::endian ::std::countr_zero ::std::countl_zero
+#include<string_view>//::std::string_view
+#include<vector>    //::std::vector
+#include<iterator>  //::std::begin ::std::end
+
+#include"fgwsz_format.h"
+
+namespace fgwsz{
+namespace detail{
+//============================================================================
+//内置LZ编码:LZ77类型的快速字节编码,格式为一系列序列:
+//  [token(1 byte)][literal length扩展][literals][offset(2 bytes)][match length扩展]
+//  token高4位为字面量长度,低4位为匹配长度减4,取值15时后面跟随扩展长度字节
+//  (每个扩展字节累加到长度上,直到遇到不等于255的字节为止)
+//  offset为小端序的匹配距离[1,65535],最后一个序列只有字面量
+//============================================================================
+inline constexpr ::std::uint64_t lz_min_match=4;
+inline constexpr ::std::uint64_t lz_max_offset=65535;
+inline constexpr int lz_max_hash_log=14;
+inline constexpr int lz_min_hash_log=8;
+inline ::std::uint32_t lz_read32(::std::uint8_t const* ptr){
+    ::std::uint32_t value=0;
+    ::std::memcpy(&value,ptr,sizeof(value));
+    return value;
+}
+inline ::std::uint64_t lz_read64(::std::uint8_t const* ptr){
+    ::std::uint64_t value=0;
+    ::std::memcpy(&value,ptr,sizeof(value));
+    return value;
+}
+inline ::std::uint32_t lz_hash(::std::uint32_t value,int hash_log){
+    return (value*2654435761u)>>(32-hash_log);
+}
+//ptr和match处的公共前缀长度(不超过limit)
+inline ::std::uint64_t lz_common_bytes(
+    ::std::uint8_t const* ptr
+    ,::std::uint8_t const* match
+    ,::std::uint8_t const* limit
+){
+    ::std::uint8_t const* const begin=ptr;
+    //按64位字比较,第一个不同的字节由不同位的位置得到
+    while(limit-ptr>=8){
+        ::std::uint64_t const diff=::fgwsz::detail::lz_read64(ptr)
+            ^::fgwsz::detail::lz_read64(match);
+        if(0!=diff){
+            if constexpr(::std::endian::native==::std::endian::little){
+                ptr+=::std::countr_zero(diff)>>3;
+            }else{
+                ptr+=::std::countl_zero(diff)>>3;
+            }
+            return static_cast<::std::uint64_t>(ptr-begin);
+        }
+        ptr+=8;
+        match+=8;
+    }
+    while(ptr<limit&&*ptr==*match){
+        ++ptr;
+        ++match;
+    }
+    return static_cast<::std::uint64_t>(ptr-begin);
+}
+//写入扩展长度
+inline ::std::uint8_t* lz_write_length(
+    ::std::uint8_t* ptr
+    ,::std::uint64_t length
+){
+    while(length>=255){
+        *ptr++=255;
+        length-=255;
+    }
+    *ptr++=static_cast<::std::uint8_t>(length);
+    return ptr;
+}
+//读取扩展长度(累加到length上),输入不完整时返回false
+inline bool lz_read_length(
+    ::std::uint8_t const*& ptr
+    ,::std::uint8_t const* end
+    ,::std::uint64_t& length
+){
+    ::std::uint8_t byte=0;
+    do{
+        if(ptr>=end){
+            return false;
+        }
+        byte=*ptr++;
+        length+=byte;
+    }while(255==byte);
+    return true;
+}
+//写入一个序列(match_bytes为0时只写入字面量),输出空间不足时返回nullptr
+inline ::std::uint8_t* lz_write_sequence(
+    ::std::uint8_t* ptr
+    ,::std::uint8_t const* end
+    ,::std::uint8_t const* literals
+    ,::std::uint64_t literal_bytes
+    ,::std::uint64_t offset
+    ,::std::uint64_t match_bytes
+){
+    //token,扩展长度,字面量和offset所需的最大空间
+    ::std::uint64_t const need=1+(literal_bytes/255+1)+literal_bytes
+        +(0==match_bytes?0:2+(match_bytes/255+1));
+    if(static_cast<::std::uint64_t>(end-ptr)<need){
+        return nullptr;
+    }
+    ::std::uint8_t* token=ptr++;
+    *token=static_cast<::std::uint8_t>((literal_bytes<15?literal_bytes:15)<<4);
+    if(literal_bytes>=15){
+        ptr=::fgwsz::detail::lz_write_length(ptr,literal_bytes-15);
+    }
+    ::std::memcpy(ptr,literals,literal_bytes);
+    ptr+=literal_bytes;
+    if(0==match_bytes){
+        return ptr;
+    }
+    *ptr++=static_cast<::std::uint8_t>(offset);
+    *ptr++=static_cast<::std::uint8_t>(offset>>8);
+    ::std::uint64_t const length=match_bytes-::fgwsz::detail::lz_min_match;
+    *token|=static_cast<::std::uint8_t>(length<15?length:15);
+    if(length>=15){
+        ptr=::fgwsz::detail::lz_write_length(ptr,length-15);
+    }
+    return ptr;
+}
+::std::uint64_t lz_compress(
+    void* dst
+    ,::std::uint64_t capacity
+    ,void const* src
+    ,::std::uint64_t bytes
+){
+    auto const begin=static_cast<::std::uint8_t const*>(src);
+    auto const end=begin+bytes;
+    auto const out_begin=static_cast<::std::uint8_t*>(dst);
+    auto const out_end=out_begin+capacity;
+    ::std::uint8_t* out=out_begin;
+    ::std::uint8_t const* anchor=begin;
+    //哈希表保存4字节序列最近一次出现的位置,小输入使用小哈希表以减少清零开销
+    int hash_log=::fgwsz::detail::lz_min_hash_log;
+    while(hash_log<::fgwsz::detail::lz_max_hash_log
+        &&(::std::uint64_t(1)<<hash_log)<bytes
+    ){
+        ++hash_log;
+    }
+    thread_local ::std::uint32_t table[
+        ::std::uint64_t(1)<<::fgwsz::detail::lz_max_hash_log
+    ];
+    ::std::memset(table,0,sizeof(table[0])<<hash_log);
+    if(bytes>=::fgwsz::detail::lz_min_match){
+        //最后4字节之后不再开始查找匹配,保证4字节读取不越界
+        ::std::uint8_t const* const search_end=
+            end-::fgwsz::detail::lz_min_match;
+        ::std::uint8_t const* ptr=begin;
+        while(ptr<search_end){
+            ::std::uint32_t const value=::fgwsz::detail::lz_read32(ptr);
+            ::std::uint32_t const hash=
+                ::fgwsz::detail::lz_hash(value,hash_log);
+            ::std::uint8_t const* match=begin+table[hash];
+            table[hash]=static_cast<::std::uint32_t>(ptr-begin);
+            if(match>=ptr
+                ||static_cast<::std::uint64_t>(ptr-match)
+                    >::fgwsz::detail::lz_max_offset
+                ||::fgwsz::detail::lz_read32(match)!=value
+            ){
+                //连续找不到匹配时逐渐加大步长,快速跳过不可压缩的内容
+                ptr+=1+((ptr-anchor)>>6);
+                continue;
+            }
+            //向前扩展匹配
+            while(ptr>anchor&&match>begin&&ptr[-1]==match[-1]){
+                --ptr;
+                --match;
+            }
+            ::std::uint64_t const match_bytes=::fgwsz::detail::lz_min_match
+                +::fgwsz::detail::lz_common_bytes(
+                    ptr+::fgwsz::detail::lz_min_match
+                    ,match+::fgwsz::detail::lz_min_match
+                    ,end
+                );
+            out=::fgwsz::detail::lz_write_sequence(
+                out
+                ,out_end
+                ,anchor
+                ,static_cast<::std::uint64_t>(ptr-anchor)
+                ,static_cast<::std::uint64_t>(ptr-match)
+                ,match_bytes
+            );
+            if(nullptr==out){
+                return 0;
+            }
+            ptr+=match_bytes;
+            anchor=ptr;
+            //记录匹配末尾附近的位置,提高后续匹配的命中率
+            if(ptr-begin>=2&&end-ptr>=2){
+                table[::fgwsz::detail::lz_hash(
+                    ::fgwsz::detail::lz_read32(ptr-2)
+                    ,hash_log
+                )]=static_cast<::std::uint32_t>(ptr-2-begin);
+            }
+        }
+    }
+    //剩余的字面量
+    out=::fgwsz::detail::lz_write_sequence(
+        out
+        ,out_end
+        ,anchor
+        ,static_cast<::std::uint64_t>(end-anchor)
+        ,0
+        ,0
+    );
+    if(nullptr==out){
+        return 0;
+    }
+    return static_cast<::std::uint64_t>(out-out_begin);
+}
+bool lz_decompress(
+    void* dst
+    ,::std::uint64_t bytes
+    ,void const* src
+    ,::std::uint64_t src_bytes
+){
+    auto ptr=static_cast<::std::uint8_t const*>(src);
+    auto const end=ptr+src_bytes;
+    auto const out_begin=static_cast<::std::uint8_t*>(dst);
+    auto const out_end=out_begin+bytes;
+    ::std::uint8_t* out=out_begin;
+    while(true){
+        if(ptr>=end){
+            return false;
+        }
+        unsigned const token=*ptr++;
+        //字面量
+        ::std::uint64_t literal_bytes=token>>4;
+        if(15==literal_bytes
+            &&!::fgwsz::detail::lz_read_length(ptr,end,literal_bytes)
+        ){
+            return false;
+        }
+        if(literal_bytes>static_cast<::std::uint64_t>(end-ptr)
+            ||literal_bytes>static_cast<::std::uint64_t>(out_end-out)
+        ){
+            return false;
+        }
+        //短字面量在输入和输出都有余量时按固定16字节拷贝
+        if(literal_bytes<=16&&end-ptr>=16&&out_end-out>=16){
+            ::std::memcpy(out,ptr,16);
+        }else{
+            ::std::memcpy(out,ptr,literal_bytes);
+        }
+        out+=literal_bytes;
+        ptr+=literal_bytes;
+        //最后一个序列只有字面量
+        if(ptr==end){
+            return out==out_end;
+        }
+        //匹配
+        if(end-ptr<2){
+            return false;
+        }
+        ::std::uint64_t const offset=static_cast<::std::uint64_t>(ptr[0])
+            |(static_cast<::std::uint64_t>(ptr[1])<<8);
+        ptr+=2;
+        if(0==offset||offset>static_cast<::std::uint64_t>(out-out_begin)){
+            return false;
+        }
+        ::std::uint64_t match_bytes=token&15;
+        if(15==match_bytes
+            &&!::fgwsz::detail::lz_read_length(ptr,end,match_bytes)
+        ){
+            return false;
+        }
+        match_bytes+=::fgwsz::detail::lz_min_match;
+        if(match_bytes>static_cast<::std::uint64_t>(out_end-out)){
+            return false;
+        }
+        ::std::uint8_t const* match=out-offset;
+        ::std::uint64_t const room=static_cast<::std::uint64_t>(out_end-out);
+        if(offset>=16&&room>=match_bytes+15){
+            //输出有余量时按16字节分段拷贝(允许写入超出匹配末尾,之后会被覆盖)
+            for(::std::uint64_t index=0;index<match_bytes;index+=16){
+                ::std::memcpy(out+index,match+index,16);
+            }
+        }else if(offset>=8&&room>=match_bytes+7){
+            for(::std::uint64_t index=0;index<match_bytes;index+=8){
+                ::std::memcpy(out+index,match+index,8);
+            }
+        }else if(offset>=match_bytes){
+            ::std::memcpy(out,match,match_bytes);
+        }else if(offset>=8){
+            //重叠的匹配按8字节分段拷贝,每一段的源和目标不重叠
+            ::std::uint64_t index=0;
+            for(;index+8<=match_bytes;index+=8){
+                ::std::memcpy(out+index,match+index,8);
+            }
+            for(;index<match_bytes;++index){
+                out[index]=match[index];
+            }
+        }else{
+            for(::std::uint64_t index=0;index<match_bytes;++index){
+                out[index]=match[index];
+            }
+        }
+        out+=match_bytes;
+    }
+}
+//所有压缩编码(编号为0的不压缩不在其中)
+inline constexpr ::fgwsz::Codec codec_table[]={
+    {"lz",::fgwsz::codec_lz
+        ,::fgwsz::detail::lz_compress,::fgwsz::detail::lz_decompress}
+};
+}//namespace fgwsz::detail
+
+::fgwsz::Codec const* find_codec(::std::string_view name){
+    for(auto const& codec: ::fgwsz::detail::codec_table){
+        if(name==codec.name){
+            return &codec;
+        }
+    }
+    return nullptr;
+}
+::fgwsz::Codec const* find_codec(::std::uint8_t id){
+    for(auto const& codec: ::fgwsz::detail::codec_table){
+        if(id==codec.id){
+            return &codec;
+        }
+    }
+    return nullptr;
+}
+::std::vector<::fgwsz::Codec> codecs(void){
+    return ::std::vector<::fgwsz::Codec>(
+        ::std::begin(::fgwsz::detail::codec_table)
+        ,::std::end(::fgwsz::detail::codec_table)
+    );
+}
+
+}//namespace fgwsz
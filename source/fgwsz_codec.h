@@ -0,0 +1,43 @@
+#ifndef FGWSZ_CODEC_H
+#define FGWSZ_CODEC_H
+
+#include<cstdint>   //::std::uint8_t ::std::uint64_t
+
+#include<string_view>//::std::string_view
+#include<vector>    //::std::vector
+
+//============================================================================
+//文件内容压缩编码相关
+//============================================================================
+namespace fgwsz{
+//压缩函数类型:压缩src中的bytes字节到dst中
+//返回压缩后的字节数,压缩结果超过capacity字节时返回0(调用者改为保存原始内容)
+using CompressFunction=::std::uint64_t(*)(
+    void* dst
+    ,::std::uint64_t capacity
+    ,void const* src
+    ,::std::uint64_t bytes
+);
+//解压函数类型:解压src中的src_bytes字节到dst中,解压结果必须恰好为bytes字节
+//压缩数据损坏时返回false(不会越界读取src或越界写入dst)
+using DecompressFunction=bool(*)(
+    void* dst
+    ,::std::uint64_t bytes
+    ,void const* src
+    ,::std::uint64_t src_bytes
+);
+//压缩编码描述信息
+struct Codec{
+    char const* name;               //编码名称(命令行参数使用)
+    ::std::uint8_t id;              //编码编号(写入包内,已有编号不能修改)
+    CompressFunction compress;      //压缩函数(可以被多个线程同时调用)
+    DecompressFunction decompress;  //解压函数(可以被多个线程同时调用)
+};
+//根据名称或者编号查找压缩编码,找不到时返回nullptr
+::fgwsz::Codec const* find_codec(::std::string_view name);
+::fgwsz::Codec const* find_codec(::std::uint8_t id);
+//所有压缩编码(用于基准测试和正确性校验)
+::std::vector<::fgwsz::Codec> codecs(void);
+}//namespace fgwsz
+
+#endif//FGWSZ_CODEC_H
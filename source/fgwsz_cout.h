@@ -2,7 +2,7 @@
 #define FGWSZ_COUT_HPP
 
 #include<ios>       //::std::ios_base
-#include<iostream>  //::std::ostream ::std::cin ::std::cout
+#include<iostream>  //::std::ostream ::std::cin ::std::cout ::std::cerr
 
 //============================================================================
 //终端打印相关
@@ -19,6 +19,8 @@ static bool const std_cout_init=[](void){
 }();
 }//namespace fgwsz::detail
 inline ::std::ostream& cout=::std::cout;
+//标准输出被包内容占用时(打包到"-")使用标准错误打印信息
+inline ::std::ostream& cerr=::std::cerr;
 }//namespace fgwsz
 
 #endif//FGWSZ_COUT_HPP
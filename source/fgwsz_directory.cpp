@@ -0,0 +1,283 @@
+#include"fgwsz_directory.h"
+
+#include<cstddef>       //::std::size_t
+#include<cerrno>        //errno EINTR EEXIST ENOENT
+
+#include<string>        //::std::string
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<system_error>  //::std::system_category ::std::error_code
+
+#if !defined(_WIN32)
+    #include<fcntl.h>       //::open ::openat O_DIRECTORY
+    #include<unistd.h>      //::close ::unlinkat ::linkat
+    #include<sys/stat.h>    //::mkdirat
+#endif
+
+#include"fgwsz_except.h"
+#include"fgwsz_path.h"
+#include"fgwsz_stats.h"
+
+namespace fgwsz{
+
+OutputDirectory::OutputDirectory(::std::filesystem::path const& dir_path)
+    :dir_path_(::std::filesystem::absolute(dir_path))
+    ,dir_path_string_(dir_path_.generic_string())
+{
+    if(this->dir_path_string_.empty()||'/'!=this->dir_path_string_.back()){
+        this->dir_path_string_+='/';
+    }
+#if defined(_WIN32)
+    ::fgwsz::path_assert_is_directory(this->dir_path_);
+#else
+    this->last_dir_handle_=-1;
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::open);
+    do{
+        this->handle_=::open(
+            this->dir_path_.c_str()
+            ,O_RDONLY|O_DIRECTORY|O_CLOEXEC
+        );
+    }while(-1==this->handle_&&EINTR==errno);
+    if(-1==this->handle_){
+        FGWSZ_THROW_WHAT(
+            "failed to open directory: "+this->dir_path_.generic_string()
+            +": "+::std::system_category().message(errno)
+        );
+    }
+#endif
+}
+OutputDirectory::~OutputDirectory(void){
+#if !defined(_WIN32)
+    this->close_directory_handles();
+    ::close(this->handle_);
+#endif
+}
+::std::string OutputDirectory::path_string(
+    ::std::string_view relative_path_string
+)const{
+    ::std::string path_string=this->dir_path_string_;
+    path_string+=relative_path_string;
+    return path_string;
+}
+void OutputDirectory::create_parent_directories(
+    ::std::string const& relative_path_string
+){
+    auto const slash=relative_path_string.rfind('/');
+    if(::std::string::npos!=slash){
+        this->create_directories(
+            ::std::string_view(relative_path_string).substr(0,slash)
+        );
+    }
+}
+void OutputDirectory::create_directories(
+    ::std::string_view relative_dir_path
+){
+    //从最上层开始逐层创建未记录的目录,已经存在的目录视为创建成功
+    for(::std::size_t end=0;end<=relative_dir_path.size();++end){
+        if(end<relative_dir_path.size()&&'/'!=relative_dir_path[end]){
+            continue;
+        }
+        auto const dir_path=relative_dir_path.substr(0,end);
+        if(dir_path.empty()
+            ||this->created_dir_paths_.contains(::std::string(dir_path))
+        ){
+            continue;
+        }
+#if defined(_WIN32)
+        ::fgwsz::try_create_directories(this->dir_path_/dir_path);
+        ::fgwsz::path_assert_is_directory(this->dir_path_/dir_path);
+#else
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::mkdir);
+        if(0!=::mkdirat(this->handle_,::std::string(dir_path).c_str(),0777)
+            &&EEXIST!=errno
+        ){
+            FGWSZ_THROW_WHAT(
+                "failed to create directory: "+this->path_string(dir_path)
+                +": "+::std::system_category().message(errno)
+            );
+        }
+#endif
+        this->created_dir_paths_.emplace(dir_path);
+    }
+}
+#if !defined(_WIN32)
+int OutputDirectory::directory_handle(::std::string_view relative_dir_path){
+    if(relative_dir_path.empty()){
+        return this->handle_;
+    }
+    if(-1!=this->last_dir_handle_&&relative_dir_path==this->last_dir_path_){
+        return this->last_dir_handle_;
+    }
+    ::std::string dir_path(relative_dir_path);
+    auto iter=this->dir_handles_.find(dir_path);
+    if(this->dir_handles_.end()==iter){
+        this->create_directories(relative_dir_path);
+        if(this->dir_handles_.size()>=this->max_dir_handles_){
+            this->close_directory_handles();
+        }
+        int dir_handle=-1;
+        {
+            ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::open);
+            do{
+                dir_handle=::openat(
+                    this->handle_
+                    ,dir_path.c_str()
+                    ,O_RDONLY|O_DIRECTORY|O_CLOEXEC
+                );
+            }while(-1==dir_handle&&EINTR==errno);
+        }
+        if(-1==dir_handle){
+            FGWSZ_THROW_WHAT(
+                "failed to open directory: "+this->path_string(dir_path)
+                +": "+::std::system_category().message(errno)
+            );
+        }
+        iter=this->dir_handles_.emplace(dir_path,dir_handle).first;
+    }
+    this->last_dir_path_=::std::move(dir_path);
+    this->last_dir_handle_=iter->second;
+    return iter->second;
+}
+void OutputDirectory::close_directory_handles(void){
+    for(auto const& [dir_path,dir_handle]:this->dir_handles_){
+        ::close(dir_handle);
+    }
+    this->dir_handles_.clear();
+    this->last_dir_handle_=-1;
+}
+#endif
+void OutputDirectory::add_created_directory(
+    ::std::string_view relative_dir_path
+){
+    this->created_dir_paths_.emplace(relative_dir_path);
+}
+int OutputDirectory::handle(void)const{
+#if defined(_WIN32)
+    FGWSZ_THROW_WHAT("directory handles are not available on this system");
+#else
+    return this->handle_;
+#endif
+}
+int OutputDirectory::parent_handle(
+    ::std::string const& relative_path_string
+    ,::std::size_t& name_offset
+){
+#if defined(_WIN32)
+    (void)relative_path_string;(void)name_offset;
+    FGWSZ_THROW_WHAT("directory handles are not available on this system");
+#else
+    auto const slash=relative_path_string.rfind('/');
+    name_offset=::std::string::npos==slash?0:slash+1;
+    return ::std::string::npos==slash?this->handle_
+        :this->directory_handle(
+            ::std::string_view(relative_path_string).substr(0,slash)
+        );
+#endif
+}
+bool OutputDirectory::parent_handle_evicts(
+    ::std::string const& relative_path_string
+)const{
+#if defined(_WIN32)
+    (void)relative_path_string;
+    return false;
+#else
+    auto const slash=relative_path_string.rfind('/');
+    if(::std::string::npos==slash){
+        return false;
+    }
+    auto const dir_path=
+        ::std::string_view(relative_path_string).substr(0,slash);
+    return (-1==this->last_dir_handle_||dir_path!=this->last_dir_path_)
+        &&!this->dir_handles_.contains(::std::string(dir_path))
+        &&this->dir_handles_.size()>=this->max_dir_handles_;
+#endif
+}
+::fgwsz::File OutputDirectory::create_file(
+    ::std::string const& relative_path_string
+){
+#if defined(_WIN32)
+    this->create_parent_directories(relative_path_string);
+    return ::fgwsz::File(
+        this->dir_path_/relative_path_string
+        ,::fgwsz::FileMode::write_truncate
+    );
+#else
+    //相对于父目录句柄只需要传入文件名
+    ::std::size_t name_offset=0;
+    int const dir_handle=
+        this->parent_handle(relative_path_string,name_offset);
+    ::fgwsz::File file;
+    file.open_at(
+        dir_handle
+        ,relative_path_string.c_str()+name_offset
+        ,this->path_string(relative_path_string)
+        ,::fgwsz::FileMode::write_truncate
+    );
+    return file;
+#endif
+}
+::fgwsz::File OutputDirectory::open_file(
+    ::std::string const& relative_path_string
+    ,::fgwsz::FileMode mode
+)const{
+#if defined(_WIN32)
+    return ::fgwsz::File(this->dir_path_/relative_path_string,mode);
+#else
+    ::fgwsz::File file;
+    file.open_at(
+        this->handle_
+        ,relative_path_string.c_str()
+        ,this->path_string(relative_path_string)
+        ,mode
+    );
+    return file;
+#endif
+}
+void OutputDirectory::remove_file(::std::string const& relative_path_string){
+#if defined(_WIN32)
+    ::std::error_code error;
+    ::std::filesystem::remove(this->dir_path_/relative_path_string,error);
+    if(error){
+        FGWSZ_THROW_WHAT(
+            "failed to remove file: "+this->path_string(relative_path_string)
+            +": "+error.message()
+        );
+    }
+#else
+    if(0!=::unlinkat(this->handle_,relative_path_string.c_str(),0)
+        &&ENOENT!=errno
+    ){
+        FGWSZ_THROW_WHAT(
+            "failed to remove file: "+this->path_string(relative_path_string)
+            +": "+::std::system_category().message(errno)
+        );
+    }
+#endif
+}
+bool OutputDirectory::link_file(
+    ::std::string const& target_path_string
+    ,::std::string const& relative_path_string
+){
+    this->create_parent_directories(relative_path_string);
+    this->remove_file(relative_path_string);
+#if defined(_WIN32)
+    ::std::error_code error;
+    ::std::filesystem::create_hard_link(
+        this->dir_path_/target_path_string
+        ,this->dir_path_/relative_path_string
+        ,error
+    );
+    return !error;
+#else
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::open);
+    return 0==::linkat(
+        this->handle_
+        ,target_path_string.c_str()
+        ,this->handle_
+        ,relative_path_string.c_str()
+        ,0
+    );
+#endif
+}
+
+}//namespace fgwsz
@@ -0,0 +1,86 @@
+#ifndef FGWSZ_DIRECTORY_H
+#define FGWSZ_DIRECTORY_H
+
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<string_view>//::std::string_view
+#include<filesystem>//::std::filesystem
+#include<unordered_map>//::std::unordered_map
+#include<unordered_set>//::std::unordered_set
+
+#include"fgwsz_file.h"
+
+//============================================================================
+//解包输出目录相关
+//============================================================================
+namespace fgwsz{
+//解包的输出目录:记录已经创建(或者已经存在)的子目录,缓存打开的子目录句柄,
+//相对于目录句柄创建子目录(mkdirat)和文件(openat),
+//同一目录下的文件只需要一次打开文件的系统调用,不再检查和解析完整路径
+//(Windows上没有openat,只记录已创建的子目录,按完整路径打开文件)
+class OutputDirectory{
+public:
+    //输出目录必须已经存在
+    explicit OutputDirectory(::std::filesystem::path const& dir_path);
+    ~OutputDirectory(void);
+    //创建相对路径的所有父目录(已创建的目录直接跳过)
+    void create_parent_directories(::std::string const& relative_path_string);
+    //创建所有父目录之后以清空的方式打开文件(相对于缓存的父目录句柄打开)
+    ::fgwsz::File create_file(::std::string const& relative_path_string);
+    //打开父目录已经存在的文件(相对于输出目录的句柄打开,可以被多个线程同时调用)
+    ::fgwsz::File open_file(
+        ::std::string const& relative_path_string
+        ,::fgwsz::FileMode mode
+    )const;
+    //删除父目录已经存在的文件(文件不存在时忽略)
+    void remove_file(::std::string const& relative_path_string);
+    //记录调用者已经创建(或者已经存在)的子目录(例如io_uring批量创建的目录)
+    void add_created_directory(::std::string_view relative_dir_path);
+    //相对于目录句柄提交异步请求(例如io_uring)时使用的目录句柄
+    //(Windows上没有openat,调用时抛出异常)
+    //输出目录的句柄
+    int handle(void)const;
+    //创建所有父目录之后返回缓存的父目录句柄,name_offset为文件名在相对路径中的位置
+    int parent_handle(
+        ::std::string const& relative_path_string
+        ,::std::size_t& name_offset
+    );
+    //取得父目录句柄时是否需要先关闭所有缓存的目录句柄
+    //(使用这些句柄的异步请求必须在此之前完成)
+    bool parent_handle_evicts(::std::string const& relative_path_string)const;
+    //创建所有父目录之后把文件创建为已有文件target_path_string的硬链接
+    //(已经存在的文件先删除),文件系统不支持硬链接时返回false
+    bool link_file(
+        ::std::string const& target_path_string
+        ,::std::string const& relative_path_string
+    );
+    //禁止拷贝
+    OutputDirectory(OutputDirectory const&)noexcept=delete;
+    OutputDirectory& operator=(OutputDirectory const&)noexcept=delete;
+private:
+    //文件的完整路径字符串(用于抛出异常时的信息显示)
+    ::std::string path_string(::std::string_view relative_path_string)const;
+    //创建相对路径为relative_dir_path的子目录及其所有父目录
+    void create_directories(::std::string_view relative_dir_path);
+    ::std::filesystem::path dir_path_;
+    ::std::string dir_path_string_;
+    //已经创建(或者已经存在)的子目录的相对路径
+    ::std::unordered_set<::std::string> created_dir_paths_;
+#if !defined(_WIN32)
+    //打开相对路径为relative_dir_path的子目录(必要时先创建),返回缓存的目录句柄
+    int directory_handle(::std::string_view relative_dir_path);
+    void close_directory_handles(void);
+    //缓存的子目录句柄数量上限(达到上限时全部关闭,之后按需重新打开)
+    static constexpr ::std::size_t max_dir_handles_=256;
+    //输出目录的句柄
+    int handle_;
+    //缓存的子目录句柄和最近一次使用的子目录(同一目录下的文件通常连续出现)
+    ::std::unordered_map<::std::string,int> dir_handles_;
+    ::std::string last_dir_path_;
+    int last_dir_handle_;
+#endif
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_DIRECTORY_H
@@ -0,0 +1,703 @@
+#include"fgwsz_file.h"
+
+#include<cstdint>       //::std::uint64_t
+#include<cerrno>        //errno EINTR EXDEV EINVAL ENOSYS EOPNOTSUPP EBADF ENXIO
+
+#include<string>        //::std::string
+#include<filesystem>    //::std::filesystem
+#include<system_error>  //::std::system_category
+#include<utility>       //::std::exchange ::std::move
+#include<vector>        //::std::vector
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include<windows.h>
+#else
+    #include<fcntl.h>       //::open ::openat ::fcntl ::fallocate
+                            //::posix_fadvise ::sync_file_range O_DIRECT
+    #include<unistd.h>      //::read ::pread ::write ::pwrite ::close ::lseek
+                            //::copy_file_range STDIN_FILENO STDOUT_FILENO
+                            //SEEK_DATA SEEK_HOLE
+    #include<sys/stat.h>    //::fstat
+#endif
+
+#include"fgwsz_except.h"
+#include"fgwsz_stats.h"
+
+namespace fgwsz{
+namespace detail{
+//操作系统最近一次错误的描述信息
+inline ::std::string last_error_message(void){
+#if defined(_WIN32)
+    return ::std::system_category().message(
+        static_cast<int>(::GetLastError())
+    );
+#else
+    return ::std::system_category().message(errno);
+#endif
+}
+//无效的文件句柄
+#if defined(_WIN32)
+inline ::fgwsz::File::NativeHandle const invalid_handle=INVALID_HANDLE_VALUE;
+#else
+inline constexpr ::fgwsz::File::NativeHandle invalid_handle=-1;
+#endif
+#if !defined(_WIN32)
+//打开方式对应的open标志
+inline int open_flags(::fgwsz::FileMode mode){
+    if(::fgwsz::FileMode::write==mode){
+        return O_WRONLY|O_CREAT|O_CLOEXEC;
+    }
+    if(::fgwsz::FileMode::write_truncate==mode){
+        return O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC;
+    }
+    return O_RDONLY|O_CLOEXEC;
+}
+#endif
+//单次系统调用的最大读写字节数
+inline constexpr ::std::uint64_t max_io_bytes=0x40000000;//1GB
+//复制标准输入或标准输出的句柄
+inline ::fgwsz::File::NativeHandle duplicate_standard_handle(bool input){
+#if defined(_WIN32)
+    HANDLE handle=INVALID_HANDLE_VALUE;
+    if(!::DuplicateHandle(
+        ::GetCurrentProcess()
+        ,::GetStdHandle(input?STD_INPUT_HANDLE:STD_OUTPUT_HANDLE)
+        ,::GetCurrentProcess()
+        ,&handle
+        ,0
+        ,FALSE
+        ,DUPLICATE_SAME_ACCESS
+    )){
+        return INVALID_HANDLE_VALUE;
+    }
+    return handle;
+#else
+    return ::fcntl(input?STDIN_FILENO:STDOUT_FILENO,F_DUPFD_CLOEXEC,0);
+#endif
+}
+}//namespace fgwsz::detail
+
+File::File(void)noexcept
+    :handle_(::fgwsz::detail::invalid_handle)
+{}
+File::File(::std::filesystem::path const& path,::fgwsz::FileMode mode)
+    :handle_(::fgwsz::detail::invalid_handle)
+{
+    this->open(path,mode);
+}
+File File::standard_input(void){
+    File file;
+    file.path_string_="<stdin>";
+    file.handle_=::fgwsz::detail::duplicate_standard_handle(true);
+    if(!file.is_open()){
+        FGWSZ_THROW_WHAT(
+            "failed to open file: "+file.path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    return file;
+}
+File File::standard_output(void){
+    File file;
+    file.path_string_="<stdout>";
+    file.handle_=::fgwsz::detail::duplicate_standard_handle(false);
+    if(!file.is_open()){
+        FGWSZ_THROW_WHAT(
+            "failed to open file: "+file.path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    return file;
+}
+File::~File(void){
+    if(this->is_open()){
+#if defined(_WIN32)
+        ::CloseHandle(this->handle_);
+#else
+        ::close(this->handle_);
+#endif
+    }
+}
+File::File(File&& other)noexcept
+    :handle_(::std::exchange(other.handle_,::fgwsz::detail::invalid_handle))
+    ,path_string_(::std::move(other.path_string_))
+{}
+File& File::operator=(File&& other)noexcept{
+    if(this!=&other){
+        if(this->is_open()){
+#if defined(_WIN32)
+            ::CloseHandle(this->handle_);
+#else
+            ::close(this->handle_);
+#endif
+        }
+        this->handle_=
+            ::std::exchange(other.handle_,::fgwsz::detail::invalid_handle);
+        this->path_string_=::std::move(other.path_string_);
+    }
+    return *this;
+}
+void File::open(::std::filesystem::path const& path,::fgwsz::FileMode mode){
+    if(this->is_open()){
+        this->close();
+    }
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::open);
+    this->path_string_=path.generic_string();
+#if defined(_WIN32)
+    DWORD access=GENERIC_READ;
+    DWORD disposition=OPEN_EXISTING;
+    if(::fgwsz::FileMode::write==mode){
+        access=GENERIC_WRITE;
+        disposition=OPEN_ALWAYS;
+    }else if(::fgwsz::FileMode::write_truncate==mode){
+        access=GENERIC_WRITE;
+        disposition=CREATE_ALWAYS;
+    }
+    this->handle_=::CreateFileW(
+        path.c_str()
+        ,access
+        ,FILE_SHARE_READ|FILE_SHARE_WRITE
+        ,nullptr
+        ,disposition
+        ,FILE_ATTRIBUTE_NORMAL
+        ,nullptr
+    );
+#else
+    int const flags=::fgwsz::detail::open_flags(mode);
+    do{
+        this->handle_=::open(path.c_str(),flags,0666);
+    }while(-1==this->handle_&&EINTR==errno);
+#endif
+    if(!this->is_open()){
+        FGWSZ_THROW_WHAT(
+            "failed to open file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+}
+#if !defined(_WIN32)
+void File::open_at(
+    NativeHandle dir_handle
+    ,char const* relative_path
+    ,::std::string path_string
+    ,::fgwsz::FileMode mode
+){
+    if(this->is_open()){
+        this->close();
+    }
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::open);
+    this->path_string_=::std::move(path_string);
+    int const flags=::fgwsz::detail::open_flags(mode);
+    do{
+        this->handle_=::openat(dir_handle,relative_path,flags,0666);
+    }while(-1==this->handle_&&EINTR==errno);
+    if(!this->is_open()){
+        FGWSZ_THROW_WHAT(
+            "failed to open file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+}
+#endif
+void File::close(void){
+    if(!this->is_open()){
+        return;
+    }
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::close);
+    auto handle=::std::exchange(this->handle_,::fgwsz::detail::invalid_handle);
+#if defined(_WIN32)
+    bool const failed=!::CloseHandle(handle);
+#else
+    bool const failed=0!=::close(handle);
+#endif
+    if(failed){
+        FGWSZ_THROW_WHAT(
+            "failed to close file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+}
+bool File::is_open(void)const noexcept{
+    return ::fgwsz::detail::invalid_handle!=this->handle_;
+}
+::std::uint64_t File::size(void)const{
+#if defined(_WIN32)
+    LARGE_INTEGER size={};
+    if(!::GetFileSizeEx(this->handle_,&size)){
+        FGWSZ_THROW_WHAT(
+            "failed to get file size: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    return static_cast<::std::uint64_t>(size.QuadPart);
+#else
+    struct stat status={};
+    if(0!=::fstat(this->handle_,&status)){
+        FGWSZ_THROW_WHAT(
+            "failed to get file size: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    return static_cast<::std::uint64_t>(status.st_size);
+#endif
+}
+void File::resize(::std::uint64_t bytes){
+#if defined(_WIN32)
+    FILE_END_OF_FILE_INFO info={};
+    info.EndOfFile.QuadPart=static_cast<LONGLONG>(bytes);
+    bool const failed=!::SetFileInformationByHandle(
+        this->handle_,FileEndOfFileInfo,&info,sizeof(info)
+    );
+#else
+    int result=0;
+    do{
+        result=::ftruncate(this->handle_,static_cast<off_t>(bytes));
+    }while(-1==result&&EINTR==errno);
+    bool const failed=0!=result;
+#endif
+    if(failed){
+        FGWSZ_THROW_WHAT(
+            "failed to resize file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+}
+void File::preallocate(::std::uint64_t bytes)noexcept{
+    ::fgwsz::File::preallocate(this->handle_,bytes);
+}
+void File::preallocate(NativeHandle handle,::std::uint64_t bytes)noexcept{
+    //预分配只是优化,失败时(文件系统不支持或者空间不足)由之后的写入报告错误
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::write);
+#if defined(_WIN32)
+    FILE_ALLOCATION_INFO info={};
+    info.AllocationSize.QuadPart=static_cast<LONGLONG>(bytes);
+    (void)::SetFileInformationByHandle(
+        handle,FileAllocationInfo,&info,sizeof(info)
+    );
+#elif defined(__linux__)
+    int result=0;
+    do{
+        result=::fallocate(
+            handle
+            ,FALLOC_FL_KEEP_SIZE
+            ,0
+            ,static_cast<off_t>(bytes)
+        );
+    }while(-1==result&&EINTR==errno);
+#else
+    (void)handle;(void)bytes;
+#endif
+}
+bool File::set_direct(bool direct)noexcept{
+#if defined(__linux__)&&defined(O_DIRECT)
+    int const flags=::fcntl(this->handle_,F_GETFL);
+    if(-1==flags){
+        return false;
+    }
+    int const direct_flags=direct?(flags|O_DIRECT):(flags&~O_DIRECT);
+    //文件系统不支持直接I/O时设置失败(EINVAL)
+    return direct_flags==flags
+        ||-1!=::fcntl(this->handle_,F_SETFL,direct_flags);
+#elif defined(F_NOCACHE)
+    return -1!=::fcntl(this->handle_,F_NOCACHE,direct?1:0);
+#else
+    return !direct;
+#endif
+}
+void File::drop_cache(
+    ::std::uint64_t offset
+    ,::std::uint64_t bytes
+)const noexcept{
+    //丢弃页缓存只是优化,失败时忽略
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::flush);
+#if defined(__linux__)
+    //脏页写回之前不能被丢弃
+    (void)::sync_file_range(
+        this->handle_
+        ,static_cast<off_t>(offset)
+        ,static_cast<off_t>(bytes)
+        ,SYNC_FILE_RANGE_WAIT_BEFORE
+            |SYNC_FILE_RANGE_WRITE
+            |SYNC_FILE_RANGE_WAIT_AFTER
+    );
+#endif
+#if defined(POSIX_FADV_DONTNEED)
+    (void)::posix_fadvise(
+        this->handle_
+        ,static_cast<off_t>(offset)
+        ,static_cast<off_t>(bytes)
+        ,POSIX_FADV_DONTNEED
+    );
+#else
+    (void)offset;(void)bytes;
+#endif
+}
+::std::uint64_t File::drop_cache_behind(
+    ::std::uint64_t offset
+    ,::std::uint64_t end
+)const noexcept{
+    ::std::uint64_t const window_end=
+        end/::fgwsz::File::cache_window_bytes*::fgwsz::File::cache_window_bytes;
+    if(window_end<=offset){
+        return offset;
+    }
+    this->drop_cache(offset,window_end-offset);
+    return window_end;
+}
+void File::start_writeback(
+    ::std::uint64_t offset
+    ,::std::uint64_t bytes
+)const noexcept{
+#if defined(__linux__)
+    if(bytes>0){
+        (void)::sync_file_range(
+            this->handle_
+            ,static_cast<off_t>(offset)
+            ,static_cast<off_t>(bytes)
+            ,SYNC_FILE_RANGE_WRITE
+        );
+    }
+#else
+    (void)offset;(void)bytes;
+#endif
+}
+::std::vector<::fgwsz::FileExtent> File::data_extents(void){
+    ::std::uint64_t const size=this->size();
+    ::std::vector<::fgwsz::FileExtent> extents;
+#if defined(SEEK_DATA)&&defined(SEEK_HOLE)
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
+    off_t const position=::lseek(this->handle_,0,SEEK_CUR);
+    auto fail=[this](void){
+        FGWSZ_THROW_WHAT(
+            "failed to find file data: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    };
+    ::std::uint64_t offset=0;
+    while(offset<size){
+        off_t const data=
+            ::lseek(this->handle_,static_cast<off_t>(offset),SEEK_DATA);
+        if(static_cast<off_t>(-1)==data){
+            //之后都是空洞
+            if(ENXIO==errno){
+                break;
+            }
+            //文件系统不支持查找空洞
+            if(EINVAL==errno||EOPNOTSUPP==errno){
+                extents.assign(1,::fgwsz::FileExtent{0,size});
+                break;
+            }
+            fail();
+        }
+        off_t const hole=::lseek(this->handle_,data,SEEK_HOLE);
+        if(static_cast<off_t>(-1)==hole){
+            fail();
+        }
+        ::std::uint64_t const end=static_cast<::std::uint64_t>(hole)<size
+            ?static_cast<::std::uint64_t>(hole):size;
+        if(static_cast<::std::uint64_t>(data)>=end){
+            break;
+        }
+        extents.push_back({static_cast<::std::uint64_t>(data)
+            ,end-static_cast<::std::uint64_t>(data)});
+        offset=end;
+    }
+    if(static_cast<off_t>(-1)!=position){
+        ::lseek(this->handle_,position,SEEK_SET);
+    }
+#else
+    if(size>0){
+        extents.push_back({0,size});
+    }
+#endif
+    return extents;
+}
+::std::uint64_t File::read(void* ptr,::std::uint64_t bytes){
+    auto data=reinterpret_cast<char*>(ptr);
+    ::std::uint64_t count_bytes=0;
+    while(count_bytes<bytes){
+        ::std::uint64_t const read_bytes=
+            this->read_some(data+count_bytes,bytes-count_bytes);
+        //到达文件末尾
+        if(0==read_bytes){
+            break;
+        }
+        count_bytes+=read_bytes;
+    }
+    return count_bytes;
+}
+::std::uint64_t File::read_some(void* ptr,::std::uint64_t bytes){
+    ::std::uint64_t const request=
+        bytes<::fgwsz::detail::max_io_bytes
+        ?bytes: ::fgwsz::detail::max_io_bytes;
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::read);
+#if defined(_WIN32)
+    DWORD done=0;
+    if(!::ReadFile(
+        this->handle_,ptr,static_cast<DWORD>(request),&done,nullptr
+    )){
+        //管道的写入端关闭时视为到达文件末尾
+        if(ERROR_BROKEN_PIPE==::GetLastError()){
+            return 0;
+        }
+        FGWSZ_THROW_WHAT(
+            "file read error: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    timer.set_bytes(done);
+    return done;
+#else
+    while(true){
+        auto const result=::read(this->handle_,ptr,request);
+        if(-1==result){
+            if(EINTR==errno){
+                continue;
+            }
+            FGWSZ_THROW_WHAT(
+                "file read error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        timer.set_bytes(static_cast<::std::uint64_t>(result));
+        return static_cast<::std::uint64_t>(result);
+    }
+#endif
+}
+::std::uint64_t File::read_at(
+    void* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+)const{
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::read);
+    auto data=reinterpret_cast<char*>(ptr);
+    ::std::uint64_t count_bytes=0;
+    while(count_bytes<bytes){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::max_io_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::max_io_bytes;
+        ::std::uint64_t const position=offset+count_bytes;
+#if defined(_WIN32)
+        OVERLAPPED overlapped={};
+        overlapped.Offset=static_cast<DWORD>(position);
+        overlapped.OffsetHigh=static_cast<DWORD>(position>>32);
+        DWORD done=0;
+        if(!::ReadFile(
+            this->handle_,data+count_bytes,static_cast<DWORD>(request)
+            ,&done,&overlapped
+        )){
+            if(ERROR_HANDLE_EOF==::GetLastError()){
+                break;
+            }
+            FGWSZ_THROW_WHAT(
+                "file read error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        ::std::uint64_t const read_bytes=done;
+#else
+        auto const result=::pread(
+            this->handle_,data+count_bytes,request
+            ,static_cast<off_t>(position)
+        );
+        if(-1==result){
+            if(EINTR==errno){
+                continue;
+            }
+            FGWSZ_THROW_WHAT(
+                "file read error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        ::std::uint64_t const read_bytes=static_cast<::std::uint64_t>(result);
+#endif
+        //到达文件末尾
+        if(0==read_bytes){
+            break;
+        }
+        count_bytes+=read_bytes;
+    }
+    timer.set_bytes(count_bytes);
+    return count_bytes;
+}
+void File::write(void const* src,::std::uint64_t bytes){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::write,bytes);
+    auto data=reinterpret_cast<char const*>(src);
+    ::std::uint64_t count_bytes=0;
+    while(count_bytes<bytes){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::max_io_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::max_io_bytes;
+#if defined(_WIN32)
+        DWORD done=0;
+        if(!::WriteFile(
+            this->handle_,data+count_bytes,static_cast<DWORD>(request)
+            ,&done,nullptr
+        )){
+            FGWSZ_THROW_WHAT(
+                "file write error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        count_bytes+=done;
+#else
+        auto const result=::write(this->handle_,data+count_bytes,request);
+        if(-1==result){
+            if(EINTR==errno){
+                continue;
+            }
+            FGWSZ_THROW_WHAT(
+                "file write error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        count_bytes+=static_cast<::std::uint64_t>(result);
+#endif
+    }
+}
+void File::write_at(
+    void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::write,bytes);
+    auto data=reinterpret_cast<char const*>(src);
+    ::std::uint64_t count_bytes=0;
+    while(count_bytes<bytes){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::max_io_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::max_io_bytes;
+        ::std::uint64_t const position=offset+count_bytes;
+#if defined(_WIN32)
+        OVERLAPPED overlapped={};
+        overlapped.Offset=static_cast<DWORD>(position);
+        overlapped.OffsetHigh=static_cast<DWORD>(position>>32);
+        DWORD done=0;
+        if(!::WriteFile(
+            this->handle_,data+count_bytes,static_cast<DWORD>(request)
+            ,&done,&overlapped
+        )){
+            FGWSZ_THROW_WHAT(
+                "file write error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        count_bytes+=done;
+#else
+        auto const result=::pwrite(
+            this->handle_,data+count_bytes,request
+            ,static_cast<off_t>(position)
+        );
+        if(-1==result){
+            if(EINTR==errno){
+                continue;
+            }
+            FGWSZ_THROW_WHAT(
+                "file write error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        count_bytes+=static_cast<::std::uint64_t>(result);
+#endif
+    }
+}
+::std::uint64_t File::copy_from(
+    File const& src
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+){
+    ::std::uint64_t count_bytes=0;
+#if !defined(_WIN32)
+    while(count_bytes<bytes){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::max_io_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::max_io_bytes;
+        off_t src_offset=static_cast<off_t>(offset+count_bytes);
+        auto const result=::copy_file_range(
+            src.handle_,&src_offset,this->handle_,nullptr,request,0
+        );
+        if(-1==result){
+            if(EINTR==errno){
+                continue;
+            }
+            //不支持内核复制时由调用者改为读取和写入
+            if(EXDEV==errno||EINVAL==errno||ENOSYS==errno
+                ||EOPNOTSUPP==errno||EBADF==errno
+            ){
+                break;
+            }
+            FGWSZ_THROW_WHAT(
+                "file write error: "+this->path_string_
+                +": "+::fgwsz::detail::last_error_message()
+            );
+        }
+        //到达src的末尾
+        if(0==result){
+            break;
+        }
+        count_bytes+=static_cast<::std::uint64_t>(result);
+    }
+#else
+    (void)src;
+    (void)bytes;
+    (void)offset;
+#endif
+    return count_bytes;
+}
+void File::seek(::std::uint64_t offset){
+#if defined(_WIN32)
+    LARGE_INTEGER position={};
+    position.QuadPart=static_cast<LONGLONG>(offset);
+    bool const failed=
+        !::SetFilePointerEx(this->handle_,position,nullptr,FILE_BEGIN);
+#else
+    bool const failed=static_cast<off_t>(-1)
+        ==::lseek(this->handle_,static_cast<off_t>(offset),SEEK_SET);
+#endif
+    if(failed){
+        FGWSZ_THROW_WHAT(
+            "failed to seek file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+}
+::std::uint64_t File::skip(::std::uint64_t bytes){
+#if defined(_WIN32)
+    LARGE_INTEGER distance={};
+    distance.QuadPart=static_cast<LONGLONG>(bytes);
+    LARGE_INTEGER position={};
+    bool const failed=
+        !::SetFilePointerEx(this->handle_,distance,&position,FILE_CURRENT);
+    ::std::uint64_t const offset=static_cast<::std::uint64_t>(position.QuadPart);
+#else
+    off_t const position=
+        ::lseek(this->handle_,static_cast<off_t>(bytes),SEEK_CUR);
+    bool const failed=static_cast<off_t>(-1)==position;
+    ::std::uint64_t const offset=static_cast<::std::uint64_t>(position);
+#endif
+    if(failed){
+        FGWSZ_THROW_WHAT(
+            "failed to seek file: "+this->path_string_
+            +": "+::fgwsz::detail::last_error_message()
+        );
+    }
+    return offset;
+}
+bool File::is_seekable(void)const noexcept{
+#if defined(_WIN32)
+    return FILE_TYPE_DISK==::GetFileType(this->handle_);
+#else
+    return static_cast<off_t>(-1)!=::lseek(this->handle_,0,SEEK_CUR);
+#endif
+}
+::std::string const& File::path_string(void)const noexcept{
+    return this->path_string_;
+}
+File::NativeHandle File::native_handle(void)const noexcept{
+    return this->handle_;
+}
+
+}//namespace fgwsz
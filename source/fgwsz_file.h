@@ -0,0 +1,132 @@
+#ifndef FGWSZ_FILE_H
+#define FGWSZ_FILE_H
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<vector>    //::std::vector
+
+//============================================================================
+//文件读写相关(基于操作系统文件句柄,支持多线程按位置读写)
+//============================================================================
+namespace fgwsz{
+//文件打开方式
+enum class FileMode{
+    read,           //只读
+    write,          //只写,文件不存在时创建,保留已有内容
+    write_truncate  //只写,文件不存在时创建,清空已有内容
+};
+//文件中保存数据的一段范围(稀疏文件的空洞之外的部分)
+struct FileExtent{
+    ::std::uint64_t offset;
+    ::std::uint64_t bytes;
+};
+class File{
+public:
+#if defined(_WIN32)
+    using NativeHandle=void*;
+#else
+    using NativeHandle=int;
+#endif
+    //生命周期
+    File(void)noexcept;
+    File(::std::filesystem::path const& path,::fgwsz::FileMode mode);
+    ~File(void);
+    File(File&& other)noexcept;
+    File& operator=(File&& other)noexcept;
+    //复制标准输入和标准输出的句柄(关闭复制的句柄不影响标准输入和标准输出)
+    static File standard_input(void);
+    static File standard_output(void);
+    //打开和关闭
+    void open(::std::filesystem::path const& path,::fgwsz::FileMode mode);
+#if !defined(_WIN32)
+    //打开相对于目录句柄dir_handle的文件(openat),不需要解析和检查完整路径
+    //path_string只用于抛出异常时的信息显示
+    void open_at(
+        NativeHandle dir_handle
+        ,char const* relative_path
+        ,::std::string path_string
+        ,::fgwsz::FileMode mode
+    );
+#endif
+    void close(void);
+    bool is_open(void)const noexcept;
+    //文件大小
+    ::std::uint64_t size(void)const;
+    //修改文件大小
+    void resize(::std::uint64_t bytes);
+    //为文件的前bytes字节预分配磁盘空间,不改变文件大小(fallocate)
+    //分块写入大文件之前调用以减少碎片,文件系统不支持时忽略
+    void preallocate(::std::uint64_t bytes)noexcept;
+    static void preallocate(NativeHandle handle,::std::uint64_t bytes)noexcept;
+    //直接I/O(O_DIRECT)时读写的内存地址,文件位置和字节数的对齐字节数
+    static constexpr ::std::size_t direct_alignment=4096;
+    //切换为绕过页缓存的直接I/O(direct为true)或者恢复缓冲I/O,返回是否切换成功
+    //文件系统不支持直接I/O时返回false(Windows只能在打开时指定,不能切换)
+    bool set_direct(bool direct)noexcept;
+    //先等待[offset,offset+bytes)范围内的脏页写回,再丢弃这个范围的页缓存
+    //(bytes为0表示到文件末尾),不影响文件内容,不支持时忽略
+    void drop_cache(::std::uint64_t offset,::std::uint64_t bytes)const noexcept;
+    //按窗口丢弃页缓存的窗口字节数:页缓存的大页按自身大小对齐,
+    //只丢弃完整的窗口时大页不会跨越丢弃范围的边界而被留下
+    static constexpr ::std::uint64_t cache_window_bytes=4*1024*1024;//4MB
+    //顺序读写时丢弃[offset,end)范围内完整窗口的页缓存,返回下次丢弃的起始位置
+    ::std::uint64_t drop_cache_behind(
+        ::std::uint64_t offset
+        ,::std::uint64_t end
+    )const noexcept;
+    //开始写回[offset,offset+bytes)范围内的脏页,不等待写回完成
+    void start_writeback(
+        ::std::uint64_t offset
+        ,::std::uint64_t bytes
+    )const noexcept;
+    //文件中保存数据的范围(SEEK_DATA/SEEK_HOLE),按位置排列,不包含空洞
+    //文件系统不支持查找空洞时整个文件作为一段数据,调用之后当前位置不变
+    ::std::vector<::fgwsz::FileExtent> data_extents(void);
+    //从当前位置顺序读取,返回实际读取的字节数(小于bytes时说明到达文件末尾)
+    ::std::uint64_t read(void* ptr,::std::uint64_t bytes);
+    //从当前位置读取一次,返回实际读取的字节数(管道中可能少于bytes,为0时说明到达文件末尾)
+    ::std::uint64_t read_some(void* ptr,::std::uint64_t bytes);
+    //从指定位置读取,不改变当前位置,可以被多个线程同时调用
+    ::std::uint64_t read_at(
+        void* ptr
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+    )const;
+    //从当前位置顺序写入全部字节
+    void write(void const* src,::std::uint64_t bytes);
+    //向指定位置写入全部字节,不改变当前位置,可以被多个线程同时调用
+    void write_at(
+        void const* src
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+    );
+    //从src的指定位置复制bytes字节到当前位置,由内核完成复制(不经过用户态缓冲区)
+    //返回实际复制的字节数,不支持内核复制(例如跨文件系统或管道)时提前返回
+    ::std::uint64_t copy_from(
+        File const& src
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+    );
+    //修改当前位置(只能用于可以定位的文件)
+    void seek(::std::uint64_t offset);
+    //当前位置向后移动bytes字节(写入时跳过的部分成为空洞),返回新的当前位置
+    ::std::uint64_t skip(::std::uint64_t bytes);
+    //是否可以定位(普通文件可以,管道和终端不可以)
+    bool is_seekable(void)const noexcept;
+    //文件路径字符串(用于抛出异常时的信息显示)
+    ::std::string const& path_string(void)const noexcept;
+    //操作系统文件句柄
+    NativeHandle native_handle(void)const noexcept;
+    //禁止拷贝
+    File(File const&)noexcept=delete;
+    File& operator=(File const&)noexcept=delete;
+private:
+    NativeHandle handle_;
+    ::std::string path_string_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_FILE_H
@@ -0,0 +1,98 @@
+#ifndef FGWSZ_FORMAT_H
+#define FGWSZ_FORMAT_H
+
+#include<cstdint>   //::std::uint8_t ::std::int64_t ::std::uint64_t
+
+//============================================================================
+//包格式常量相关
+//============================================================================
+namespace fgwsz{
+//文件项的key取值范围为[1,255],因此文件项不会以0x00开头
+//以0x00开头的字节序列为控制序列:[0x00][控制类型(1 byte)]
+inline constexpr ::std::uint8_t control_byte=0x00;
+//控制类型:记录区结束(其后为索引区)
+inline constexpr ::std::uint8_t control_end_of_records=0x00;
+//控制类型:压缩文件项
+//  [0x00][0x01][key(1 byte)][relative path bytes(8 bytes)][relative path]
+//  [codec(1 byte)][original bytes(8 bytes)][frame 1]...[frame N]
+//除控制序列外都使用key进行xor混淆,original bytes为解码之后的文件内容大小
+//包含空洞的稀疏文件也保存为压缩文件项,不压缩时codec为codec_none(只有原始帧和空洞帧)
+inline constexpr ::std::uint8_t control_compressed_record=0x01;
+//控制类型:带校验和的文件项(可以与压缩文件项组合,0x03为带校验和的压缩文件项)
+//  [0x00][0x02][key(1 byte)]...[content][checksum(4 bytes)]
+//checksum为控制序列之后到content结束的所有字节(包内保存的形式)的CRC32C,
+//使用key进行xor混淆,不含checksum的文件项结构与之前相同
+inline constexpr ::std::uint8_t control_checksum_record=0x02;
+//控制类型:引用文件项(只能与带校验和的文件项组合,即0x06)
+//  [0x00][0x06][key(1 byte)][relative path bytes(8 bytes)][relative path]
+//  [reference offset(8 bytes)][original bytes(8 bytes)][checksum(4 bytes)]
+//包内不保存内容,解码之后的内容与位于reference offset处的文件项相同
+//(被引用的文件项在引用文件项之前,且不是引用文件项),
+//original bytes为被引用文件项解码之后的内容大小,checksum为控制序列之后到original bytes
+//结束的所有字节的CRC32C,除控制序列外都使用key进行xor混淆
+inline constexpr ::std::uint8_t control_reference_record=0x04;
+//控制类型:分片头(不是文件项,只能位于包的起始位置)
+//  [0x00][0x08][key(1 byte)][shard index(8 bytes)][shard count(8 bytes)]
+//分片打包时每个分片包以分片头开始,shard index为分片序号,shard count为分片数
+//(shard index小于shard count),除控制序列外都使用key进行xor混淆
+inline constexpr ::std::uint8_t control_shard_head=0x08;
+//分片头的字节数
+inline constexpr ::std::uint64_t shard_head_bytes=19;
+//控制序列的字节数
+inline constexpr ::std::uint64_t control_bytes=2;
+//相对路径的最大字节数(解包时据此检查损坏的relative path bytes)
+inline constexpr ::std::uint64_t max_relative_path_bytes=64*1024;//64KB
+//校验和的字节数
+inline constexpr ::std::uint64_t checksum_bytes=4;
+//压缩文件项的内容由帧组成,除最后一帧外,每一帧解码之后都是frame_bytes字节
+//帧结构:[frame head(4 bytes)][frame data]
+//frame head的最高位为1时frame data为原始内容,否则为压缩内容,
+//低31位为frame data的字节数(压缩内容总是少于解码之后的字节数)
+//frame head为0(没有frame data)的帧为空洞帧,解码之后全部为0(稀疏文件的空洞)
+inline constexpr ::std::uint64_t frame_bytes=1024*1024;//1MB
+inline constexpr ::std::uint64_t frame_head_bytes=4;
+inline constexpr ::std::uint32_t frame_raw_flag=0x80000000u;
+//压缩编码编号(写入包内,已有编号不能修改)
+inline constexpr ::std::uint8_t codec_none=0;
+inline constexpr ::std::uint8_t codec_lz=1;
+//索引区结构:
+//  [0x00][0x00][index key(1 byte)][entry count(8 bytes)]
+//  [index entry 1]...[index entry N]
+//  [source count(8 bytes)][source 1]...[source N]
+//  [index offset(8 bytes)][index magic(8 bytes)]
+//索引项结构:
+//  [record offset(8 bytes)][key(1 byte)]
+//  [relative path bytes(8 bytes)][relative path][content bytes(8 bytes)]
+//以控制序列开头的文件项的索引项在key之前插入[0x00][控制类型(1 byte)],
+//压缩文件项在控制类型之后再插入[codec(1 byte)][original bytes(8 bytes)],
+//引用文件项在控制类型之后再插入[reference offset(8 bytes)][original bytes(8 bytes)],
+//content bytes为文件项内容在包内的字节数(压缩文件项为所有帧的总大小,不含checksum)
+//引用文件项的content bytes为0
+//源文件信息结构(与索引项一一对应,没有源文件信息的索引区在entry N之后直接结束):
+//  [source write time(8 bytes)][source bytes(8 bytes)]
+//source write time为打包时源文件的修改时间(纳秒),source bytes为源文件字节数,
+//没有源文件(例如内存中的内容)时source write time为source_write_time_unknown
+//除尾部的index offset和index magic外,索引区内容都使用index key进行xor混淆
+//没有源文件信息时的source write time
+inline constexpr ::std::int64_t source_write_time_unknown=
+    static_cast<::std::int64_t>(0x8000000000000000ull);
+//索引区尾部魔数
+inline constexpr char index_magic[8]={'F','G','W','S','Z','I','D','X'};
+//索引区尾部大小:[index offset(8 bytes)][index magic(8 bytes)]
+inline constexpr ::std::uint64_t index_trailer_bytes=16;
+//索引区头部大小:[0x00][0x00][index key(1 byte)][entry count(8 bytes)]
+inline constexpr ::std::uint64_t index_head_bytes=11;
+//文件头中除relative path之外的固定部分大小:
+//[key(1 byte)][relative path bytes(8 bytes)][content bytes(8 bytes)]
+inline constexpr ::std::uint64_t header_fixed_bytes=17;
+//压缩文件项的文件头中除relative path之外的固定部分大小:
+//[0x00][0x01][key(1 byte)][relative path bytes(8 bytes)]
+//[codec(1 byte)][original bytes(8 bytes)]
+inline constexpr ::std::uint64_t compressed_header_fixed_bytes=20;
+//引用文件项的文件头中除relative path之外的固定部分大小:
+//[0x00][0x06][key(1 byte)][relative path bytes(8 bytes)]
+//[reference offset(8 bytes)][original bytes(8 bytes)]
+inline constexpr ::std::uint64_t reference_header_fixed_bytes=27;
+}//namespace fgwsz
+
+#endif//FGWSZ_FORMAT_H
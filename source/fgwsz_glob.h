@@ -0,0 +1,191 @@
+#ifndef FGWSZ_GLOB_H
+#define FGWSZ_GLOB_H
+
+#include<cstddef>       //::std::size_t
+
+#include<string>        //::std::string
+#include<string_view>   //::std::string_view
+#include<vector>        //::std::vector
+
+#include"fgwsz_except.h"
+
+//============================================================================
+//路径匹配相关
+//============================================================================
+namespace fgwsz{
+namespace detail{
+//匹配字符集合[abc] [a-z] [!a-z],成功时class_end指向']'之后的位置
+inline bool glob_match_class(
+    ::std::string_view pattern
+    ,::std::size_t class_begin
+    ,char ch
+    ,::std::size_t& class_end
+){
+    ::std::size_t index=class_begin+1;
+    bool negate=false;
+    if(index<pattern.size()&&('!'==pattern[index]||'^'==pattern[index])){
+        negate=true;
+        ++index;
+    }
+    bool matched=false;
+    bool first=true;
+    for(;index<pattern.size();++index){
+        if(']'==pattern[index]&&!first){
+            class_end=index+1;
+            return (matched!=negate)&&'/'!=ch;
+        }
+        first=false;
+        if(index+2<pattern.size()
+            &&'-'==pattern[index+1]
+            &&']'!=pattern[index+2]
+        ){
+            if(pattern[index]<=ch&&ch<=pattern[index+2]){
+                matched=true;
+            }
+            index+=2;
+        }else if(pattern[index]==ch){
+            matched=true;
+        }
+    }
+    //没有闭合的'[',当作普通字符处理
+    class_end=class_begin+1;
+    return '['==ch;
+}
+//通配符匹配的递归实现,memo记录已经计算过的(模式位置,文本位置)的匹配结果
+//memo取值:0未计算,1不匹配,2匹配
+inline bool glob_match(
+    ::std::string_view pattern
+    ,::std::size_t p
+    ,::std::string_view text
+    ,::std::size_t t
+    ,::std::vector<char>& memo
+){
+    if(pattern.size()==p){
+        return text.size()==t;
+    }
+    char& result=memo[p*(text.size()+1)+t];
+    if(0!=result){
+        return 2==result;
+    }
+    bool matched=false;
+    if('*'==pattern[p]){
+        bool const cross=p+1<pattern.size()&&'*'==pattern[p+1];
+        ::std::size_t const pattern_next=p+(cross?2:1);
+        //"**/"可以匹配零层目录
+        if(cross
+            &&pattern_next<pattern.size()
+            &&'/'==pattern[pattern_next]
+            &&::fgwsz::detail::glob_match(
+                pattern,pattern_next+1,text,t,memo
+            )
+        ){
+            matched=true;
+        }else if(::fgwsz::detail::glob_match(
+            pattern,pattern_next,text,t,memo
+        )){//匹配零个字符
+            matched=true;
+        }else if(t<text.size()&&(cross||'/'!=text[t])){//匹配一个字符
+            matched=::fgwsz::detail::glob_match(pattern,p,text,t+1,memo);
+        }
+    }else if(t<text.size()){
+        ::std::size_t pattern_next=p+1;
+        bool current=false;
+        if('?'==pattern[p]){
+            current='/'!=text[t];
+        }else if('['==pattern[p]){
+            current=::fgwsz::detail::glob_match_class(
+                pattern,p,text[t],pattern_next
+            );
+        }else{
+            current=pattern[p]==text[t];
+        }
+        matched=current&&::fgwsz::detail::glob_match(
+            pattern,pattern_next,text,t+1,memo
+        );
+    }
+    result=matched?2:1;
+    return matched;
+}
+}//namespace fgwsz::detail
+//检查字符串是否包含通配符
+inline bool is_glob_pattern(::std::string_view pattern){
+    return ::std::string_view::npos!=pattern.find_first_of("*?[");
+}
+//通配符匹配(使用'/'作为路径分隔符):
+//  *   匹配除'/'之外的任意个字符
+//  **  匹配包括'/'在内的任意个字符
+//  ?   匹配除'/'之外的单个字符
+//  [ ] 匹配字符集合中的单个字符,[!...]或[^...]表示取反
+inline bool glob_match(::std::string_view pattern,::std::string_view text){
+    ::std::vector<char> memo((pattern.size()+1)*(text.size()+1),0);
+    return ::fgwsz::detail::glob_match(pattern,0,text,0,memo);
+}
+//检查包内相对路径是否匹配给定的模式:
+//模式匹配相对路径本身,或者匹配相对路径的某一级父目录(即匹配该目录下的所有文件)
+inline bool path_match(
+    ::std::string_view pattern
+    ,::std::string_view relative_path
+){
+    //忽略模式尾部的'/'
+    while(pattern.size()>1&&'/'==pattern.back()){
+        pattern.remove_suffix(1);
+    }
+    bool const is_glob=::fgwsz::is_glob_pattern(pattern);
+    ::std::size_t end=0;
+    while(true){
+        end=relative_path.find('/',end);
+        ::std::string_view const prefix=relative_path.substr(0,end);
+        if(is_glob
+            ?::fgwsz::glob_match(pattern,prefix)
+            :pattern==prefix
+        ){
+            return true;
+        }
+        if(::std::string_view::npos==end){
+            return false;
+        }
+        ++end;
+    }
+}
+//按模式过滤包内相对路径,并记录每个模式是否匹配到了文件
+//没有模式时匹配所有相对路径
+class PathFilter{
+public:
+    explicit PathFilter(::std::vector<::std::string> const& patterns)
+        :patterns_(patterns)
+        ,pattern_matched_(patterns.size(),false)
+    {}
+    bool match(::std::string_view relative_path){
+        if(this->patterns_.empty()){
+            return true;
+        }
+        bool matched=false;
+        for(::std::size_t index=0;index<this->patterns_.size();++index){
+            if(::fgwsz::path_match(this->patterns_[index],relative_path)){
+                this->pattern_matched_[index]=true;
+                matched=true;
+            }
+        }
+        return matched;
+    }
+    //每个模式是否匹配到了文件
+    ::std::vector<bool> const& matched(void)const noexcept{
+        return this->pattern_matched_;
+    }
+    //报告没有匹配到任何文件的模式
+    void assert_all_matched(void)const{
+        for(::std::size_t index=0;index<this->patterns_.size();++index){
+            if(!this->pattern_matched_[index]){
+                FGWSZ_THROW_WHAT(
+                    "pattern matches nothing: "+this->patterns_[index]
+                );
+            }
+        }
+    }
+private:
+    ::std::vector<::std::string> const& patterns_;
+    ::std::vector<bool> pattern_matched_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_GLOB_H
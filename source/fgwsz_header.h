@@ -1,18 +1,48 @@
 #ifndef FGWSZ_HEADER_H
 #define FGWSZ_HEADER_H
 
-#include<cstdint>   //::std::uint8_t ::std::uint64_t
+#include<cstdint>   //::std::uint8_t ::std::int64_t ::std::uint64_t
 
 #include<string>    //::std::string
 
+#include"fgwsz_format.h"
+
 namespace fgwsz{
 
 struct Header{
     ::std::uint8_t key;
     ::std::uint64_t relative_path_bytes;
     ::std::string relative_path_string;
-    ::std::uint64_t content_bytes;
+    ::std::uint64_t content_bytes;  //文件内容在包内的字节数
+    ::std::uint8_t codec;           //压缩编码编号(不压缩时为codec_none)
+    bool framed;                    //文件内容是否由帧组成(压缩文件项)
+    ::std::uint64_t original_bytes; //解码之后的文件内容字节数
+    bool has_checksum;              //文件内容之后是否有校验和
+    bool reference;                 //是否为引用文件项(包内不保存内容)
+    ::std::uint64_t reference_offset;//被引用的文件项的起始位置(引用文件项)
+};
+
+//包内文件项(文件头信息及其在包内的位置)
+struct Entry{
+    ::std::uint64_t record_offset;  //文件项起始位置(key所在位置)
+    ::std::uint64_t content_offset; //文件内容起始位置
+    ::fgwsz::Header header;         //主机序且已解码的文件头信息
+    //打包时源文件的修改时间(纳秒)和字节数,只记录在索引区中
+    //(内存中的内容和不含源文件信息的包的文件项没有源文件信息)
+    bool has_source;
+    ::std::int64_t source_write_time;
+    ::std::uint64_t source_bytes;
 };
+//文件项中参与校验和计算的起始位置(控制序列之后)
+inline ::std::uint64_t checksum_offset(::fgwsz::Entry const& entry){
+    return entry.header.has_checksum
+        ?entry.record_offset+::fgwsz::control_bytes:entry.record_offset;
+}
+//文件项的结束位置(包含文件内容之后的校验和)
+inline ::std::uint64_t record_end(::fgwsz::Entry const& entry){
+    return entry.content_offset+entry.header.content_bytes
+        +(entry.header.has_checksum?::fgwsz::checksum_bytes:0);
+}
 
 }//namespace fgwsz
 
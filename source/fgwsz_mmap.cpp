@@ -0,0 +1,222 @@
+#include"fgwsz_mmap.h"
+
+#include<cstdint>   //::std::uint64_t SIZE_MAX
+#include<cstddef>   //::std::size_t
+#include<cerrno>    //errno EINTR
+
+#include<filesystem>//::std::filesystem
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include<windows.h>
+#else
+    #include<fcntl.h>       //::open
+    #include<unistd.h>      //::close ::sysconf
+    #include<sys/stat.h>    //::fstat
+    #include<sys/mman.h>    //::mmap ::munmap ::madvise
+#endif
+
+namespace fgwsz{
+namespace detail{
+//内存页大小
+inline ::std::uint64_t page_bytes(void)noexcept{
+#if defined(_WIN32)
+    SYSTEM_INFO info={};
+    ::GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    static ::std::uint64_t const bytes=
+        static_cast<::std::uint64_t>(::sysconf(_SC_PAGESIZE));
+    return bytes;
+#endif
+}
+}//namespace fgwsz::detail
+
+MappedFile::MappedFile(void)noexcept
+    :data_(nullptr)
+    ,size_(0)
+    ,owned_(false)
+{}
+MappedFile::~MappedFile(void){
+    this->unmap();
+}
+bool MappedFile::map(::std::filesystem::path const& path){
+    this->unmap();
+#if defined(_WIN32)
+    HANDLE file=::CreateFileW(
+        path.c_str()
+        ,GENERIC_READ
+        ,FILE_SHARE_READ
+        ,nullptr
+        ,OPEN_EXISTING
+        ,FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN
+        ,nullptr
+    );
+    if(INVALID_HANDLE_VALUE==file){
+        return false;
+    }
+    bool const mapped=this->map_handle(file);
+    ::CloseHandle(file);
+#else
+    int fd=-1;
+    do{
+        fd=::open(path.c_str(),O_RDONLY|O_CLOEXEC);
+    }while(-1==fd&&EINTR==errno);
+    if(-1==fd){
+        return false;
+    }
+    bool const mapped=this->map_handle(fd);
+    //映射建立之后不再需要文件描述符
+    ::close(fd);
+#endif
+    return mapped;
+}
+bool MappedFile::map(::fgwsz::File const& file){
+    this->unmap();
+    return file.is_open()&&this->map_handle(file.native_handle());
+}
+bool MappedFile::map_handle(::fgwsz::File::NativeHandle handle){
+#if defined(_WIN32)
+    LARGE_INTEGER size={};
+    if(!::GetFileSizeEx(handle,&size)
+        ||size.QuadPart<=0
+        ||static_cast<::std::uint64_t>(size.QuadPart)>SIZE_MAX
+    ){
+        return false;
+    }
+    HANDLE mapping=::CreateFileMappingW(
+        handle,nullptr,PAGE_READONLY,0,0,nullptr
+    );
+    if(nullptr==mapping){
+        return false;
+    }
+    void* data=::MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+    //映射视图会保持映射对象的引用
+    ::CloseHandle(mapping);
+    if(nullptr==data){
+        return false;
+    }
+    this->data_=static_cast<char*>(data);
+    this->size_=static_cast<::std::uint64_t>(size.QuadPart);
+#else
+    struct stat status={};
+    if(0!=::fstat(handle,&status)
+        ||!S_ISREG(status.st_mode)
+        ||status.st_size<=0
+        ||static_cast<::std::uint64_t>(status.st_size)>SIZE_MAX
+    ){
+        return false;
+    }
+    void* data=::mmap(
+        nullptr
+        ,static_cast<::std::size_t>(status.st_size)
+        ,PROT_READ
+        ,MAP_PRIVATE
+        ,handle
+        ,0
+    );
+    if(MAP_FAILED==data){
+        return false;
+    }
+    this->data_=static_cast<char*>(data);
+    this->size_=static_cast<::std::uint64_t>(status.st_size);
+#endif
+    this->owned_=true;
+    return true;
+}
+void MappedFile::wrap(void const* data,::std::uint64_t size)noexcept{
+    this->unmap();
+    //空内存也视为已关联(指向一个静态的空字符)
+    static char const empty='\0';
+    this->data_=const_cast<char*>(
+        nullptr==data?&empty:static_cast<char const*>(data)
+    );
+    this->size_=size;
+    this->owned_=false;
+}
+void MappedFile::unmap(void)noexcept{
+    if(!this->is_mapped()){
+        return;
+    }
+    if(this->owned_){
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->data_);
+#else
+        ::munmap(this->data_,static_cast<::std::size_t>(this->size_));
+#endif
+    }
+    this->data_=nullptr;
+    this->size_=0;
+    this->owned_=false;
+}
+bool MappedFile::is_mapped(void)const noexcept{
+    return nullptr!=this->data_;
+}
+bool MappedFile::is_owned(void)const noexcept{
+    return this->owned_;
+}
+char const* MappedFile::data(void)const noexcept{
+    return this->data_;
+}
+::std::uint64_t MappedFile::size(void)const noexcept{
+    return this->size_;
+}
+void MappedFile::advise_sequential(void)noexcept{
+    if(!this->owned_){
+        return;
+    }
+#if !defined(_WIN32)
+    //建议失败不影响正确性,忽略返回值
+    ::madvise(
+        this->data_
+        ,static_cast<::std::size_t>(this->size_)
+        ,MADV_SEQUENTIAL
+    );
+#endif
+}
+void MappedFile::advise_random(void)noexcept{
+    if(!this->owned_){
+        return;
+    }
+#if !defined(_WIN32)
+    //建议失败不影响正确性,忽略返回值
+    ::madvise(
+        this->data_
+        ,static_cast<::std::size_t>(this->size_)
+        ,MADV_RANDOM
+    );
+#endif
+}
+void MappedFile::release(::std::uint64_t begin,::std::uint64_t end)noexcept{
+    if(!this->owned_){
+        return;
+    }
+    if(end>this->size_){
+        end=this->size_;
+    }
+    //只释放完整位于范围内的页面,不影响范围两端与其他数据共用的页面
+    ::std::uint64_t const page=::fgwsz::detail::page_bytes();
+    begin=(begin+page-1)/page*page;
+    end=end/page*page;
+    if(begin>=end){
+        return;
+    }
+#if defined(_WIN32)
+    //对未锁定的页面调用VirtualUnlock会将其移出进程工作集
+    ::VirtualUnlock(
+        this->data_+begin
+        ,static_cast<::std::size_t>(end-begin)
+    );
+#else
+    //只读的私有文件映射释放之后,再次访问时从页缓存重新映射
+    ::madvise(
+        this->data_+begin
+        ,static_cast<::std::size_t>(end-begin)
+        ,MADV_DONTNEED
+    );
+#endif
+}
+
+}//namespace fgwsz
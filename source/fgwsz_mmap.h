@@ -0,0 +1,58 @@
+#ifndef FGWSZ_MMAP_H
+#define FGWSZ_MMAP_H
+
+#include<cstdint>   //::std::uint64_t
+
+#include<filesystem>//::std::filesystem
+
+#include"fgwsz_file.h"
+
+//============================================================================
+//只读内存映射相关
+//============================================================================
+namespace fgwsz{
+//只读映射整个文件,读取时直接访问映射内存,不需要读取系统调用和内核拷贝
+class MappedFile{
+public:
+    //释放页面的窗口大小(顺序读取时每读完一个窗口释放一次)
+    static constexpr ::std::uint64_t release_window_bytes=64*1024*1024;//64MB
+    //生命周期
+    MappedFile(void)noexcept;
+    ~MappedFile(void);
+    //映射文件(已映射的文件会先被解除映射)
+    //文件无法映射时(不是普通文件,空文件,超出地址空间等)返回false,
+    //此时调用者应改用流式读取
+    bool map(::std::filesystem::path const& path);
+    //映射已经打开的文件(映射之后文件可以被关闭)
+    bool map(::fgwsz::File const& file);
+    //关联调用者提供的内存(不复制,内存在使用期间必须保持有效)
+    //关联的内存不会被解除映射,也不会被提示和释放页面
+    void wrap(void const* data,::std::uint64_t size)noexcept;
+    //解除映射
+    void unmap(void)noexcept;
+    bool is_mapped(void)const noexcept;
+    //是否由这个对象映射文件(关联调用者提供的内存时为false)
+    bool is_owned(void)const noexcept;
+    //映射内存的起始地址和字节数
+    char const* data(void)const noexcept;
+    ::std::uint64_t size(void)const noexcept;
+    //提示操作系统之后按顺序访问映射内存(加大预读,尽早回收已读页面)
+    void advise_sequential(void)noexcept;
+    //提示操作系统之后随机访问映射内存(不预读,覆盖之前的顺序访问提示)
+    void advise_random(void)noexcept;
+    //释放[begin,end)范围内完整的页面,限制长时间顺序读取时的常驻内存
+    //释放后仍然可以访问,再次访问时重新从页缓存映射
+    void release(::std::uint64_t begin,::std::uint64_t end)noexcept;
+    //禁止拷贝
+    MappedFile(MappedFile const&)noexcept=delete;
+    MappedFile& operator=(MappedFile const&)noexcept=delete;
+private:
+    bool map_handle(::fgwsz::File::NativeHandle handle);
+    char* data_;
+    ::std::uint64_t size_;
+    //是否由这个对象建立映射(关联的内存为false)
+    bool owned_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_MMAP_H
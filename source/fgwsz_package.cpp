@@ -1,27 +1,249 @@
+#include<cstddef>       //::std::size_t
+#include<cstdint>       //::std::uint32_t ::std::uint64_t
+
 #include<string_view>   //::std::string_view
 #include<exception>     //::std::exception
 #include<vector>        //::std::vector
+#include<string>        //::std::string
 #include<filesystem>    //::std::filesystem
+#include<charconv>      //::std::from_chars
+#include<system_error>  //::std::errc
+#include<ostream>       //::std::ostream
+#include<optional>      //::std::optional
+#include<limits>        //::std::numeric_limits
 
 #include"fgwsz_cout.h"
 #include"fgwsz_except.h"
+#include"fgwsz_path.h"
 #include"fgwsz_packer.h"
 #include"fgwsz_unpacker.h"
+#include"fgwsz_shard.h"
+#include"fgwsz_random.hpp"
+#include"fgwsz_uring.h"
+#include"fgwsz_codec.h"
+#include"fgwsz_format.h"
+#include"fgwsz_stats.h"
+#include"fgwsz_progress.h"
 
 //终端打印帮助信息
 inline void help(void){
     ::fgwsz::cout<<
 R"(Usages:
-    Pack  : -c <output-package-path> <input-path-1> [<input-path-2> ...]
-    Unpack: -x <input-package-path> <output-directory-path>
+    Pack  : -c <output-package-path> [<options>] <input-path-1> [<input-path-2> ...]
+    Append: -a <package-path> [<options>] <input-path-1> [<input-path-2> ...]
+    Unpack: -x <input-package-path> <output-directory-path> [<options>] [<pattern-1> ...]
+    Merge : -m <output-package-path> [<options>] <input-package-1> [<input-package-2> ...]
     List  : -l <input-package-path>
+    Verify: -t <input-package-path> [-j <threads>]
+    The package path "-" means stdout (pack) or stdin (unpack/list/verify)
+    Append takes the pack options and adds files after the last file item
+    Merge copies the file items of the input packages without decoding them
+    Verify checks the checksums of all file items with all hardware threads
+Options:
+    --no-index     : (pack/merge) don't append the index to the package
+    --seed <seed>  : (pack) seed the random keys, for reproducible packages
+    --memory <MB>  : (pack) memory limit of the blocks read ahead (threads or uring)
+    --codec <name> : (pack) compress file contents: none (default) or lz
+    --base <path>  : (pack) copy files whose mtime and size match those recorded in the index
+                     of a previous package (a package without index repacks every file)
+    --dedup        : (pack) store files identical to an earlier packed file as references
+                     (appending also matches the file items already in the package)
+    --hardlink     : (unpack) hard link duplicate files to their first copy instead of copying
+    --duplicates <policy>
+                   : (merge) duplicate relative paths: last (default), first or error
+    --shards <N>   : (pack/unpack) split the files into N size-balanced packages <name>.0<ext>
+                     ... <name>.N-1<ext> packed or unpacked by N threads at the same time
+                     (unpack/verify of a missing <name><ext> reads N from <name>.0<ext>)
+    -j <threads>   : (pack/unpack) number of threads, 0 means all hardware threads
+    --io <backend> : (pack/unpack) I/O backend of one thread: auto, sync or uring
+    --direct       : (pack/unpack/verify) bypass the page cache: O_DIRECT for the package
+                     and files of 4 MB or more, or dropping the cache behind (no uring)
+    --stats[=json] : (all) print phase timings and counters to stderr at exit
+    --progress     : (pack/unpack) print percent, MB/s, files/s and ETA to stderr every second
+                     (--progress=json prints a JSON line every second)
 Examples:
     Pack a file and directory: -c 0.fgwsz README.md source
+    Pack without index       : -c 0.fgwsz --no-index README.md source
+    Pack with 8 threads      : -c 0.fgwsz -j 8 README.md source
+    Pack with compression    : -c 0.fgwsz --codec lz README.md source
+    Append files to a package: -a 0.fgwsz CHANGELOG.md logs
+    Merge packages           : -m 2.fgwsz 0.fgwsz 1.fgwsz
+    Merge keeping first files: -m 2.fgwsz --duplicates first 0.fgwsz 1.fgwsz
+    Repack changed files only: -c 1.fgwsz --base 0.fgwsz README.md source
+    Pack identical files once: -c 0.fgwsz --dedup README.md source
+    Pack into 4 packages     : -c 0.fgwsz --shards 4 README.md source
     Unpack                   : -x 0.fgwsz output
+    Unpack with 8 threads    : -x 0.fgwsz output -j 8
+    Unpack without caching   : -x 0.fgwsz output --direct
+    Unpack duplicates linked : -x 0.fgwsz output --hardlink
+    Unpack 4 packages        : -x 0.fgwsz output --shards 4
+    Verify all packages      : -t 0.fgwsz (after packing with --shards)
+    Unpack matching files    : -x 0.fgwsz output source/fgwsz_*.h README.md
     List package contents    : -l 0.fgwsz
+    Unpack with phase timings: -x 0.fgwsz output --stats
+    Pack with progress       : -c 0.fgwsz --progress README.md source
+    Verify package checksums : -t 0.fgwsz
+    Pack and unpack by a pipe: -c - source | -x - output
+    List from stdin          : -l - < 0.fgwsz
 )";
 }
 
+//模式参数之后的命令行参数
+struct Arguments{
+    ::std::vector<::std::string_view> positionals;//位置参数
+    bool pack_index=true;           //是否在包尾部写入索引区
+    ::std::size_t thread_count=1;   //线程数
+    bool has_thread_count=false;    //是否指定了线程数
+    bool has_seed=false;            //是否指定了随机数种子
+    ::std::uint32_t seed=0;         //随机数种子
+    ::std::uint64_t memory_bytes=0; //多线程打包的内存上限
+    ::fgwsz::IoBackend io_backend=::fgwsz::IoBackend::automatic;//I/O后端
+    bool direct_io=false;           //读写时是否绕过页缓存
+    ::std::uint8_t codec=::fgwsz::codec_none;//压缩编码
+    ::std::string_view base;        //增量打包的基准包路径(为空时不使用基准包)
+    bool dedup=false;               //打包时是否把内容相同的文件保存为引用文件项
+    bool hardlink=false;            //解包时引用文件项是否硬链接到被引用的文件
+    ::std::size_t shard_count=0;    //分片包的个数(0表示不分片)
+    //合并包时相对路径重复的文件项的处理方式
+    ::fgwsz::DuplicatePolicy duplicates=::fgwsz::DuplicatePolicy::keep_last;
+    bool stats=false;               //是否在退出时打印分阶段统计信息
+    bool stats_json=false;          //是否以JSON格式打印统计信息
+    bool progress=false;            //是否定时打印打包/解包进度
+    bool progress_json=false;       //是否以JSON行格式打印进度
+};
+
+//退出main时打印分阶段统计信息(出错返回时也打印)
+struct StatsPrinter{
+    bool enabled;
+    bool json;
+    ~StatsPrinter(void){
+        if(!this->enabled){
+            return;
+        }
+        //析构时无法报告错误,打印失败时忽略
+        try{
+            ::fgwsz::stats_print(::fgwsz::cerr,this->json);
+        }catch(...){}
+    }
+};
+
+//解析无符号整数参数值
+template<typename NumberType_>
+inline bool parse_number(::std::string_view value,NumberType_& number){
+    auto result=::std::from_chars(
+        value.data()
+        ,value.data()+value.size()
+        ,number
+    );
+    return ::std::errc{}==result.ec&&value.data()+value.size()==result.ptr;
+}
+
+//解析模式参数之后的命令行参数,参数不合法时返回false
+inline bool parse_arguments(int argc,char* argv[],::Arguments& arguments){
+    for(int index=2;index<argc;++index){
+        ::std::string_view argument=argv[index];
+        if("--no-index"==argument){
+            arguments.pack_index=false;
+        }else if("-j"==argument){
+            if(index+1>=argc
+                ||!::parse_number(argv[++index],arguments.thread_count)
+            ){
+                return false;
+            }
+            arguments.has_thread_count=true;
+        }else if("--seed"==argument){
+            if(index+1>=argc||!::parse_number(argv[++index],arguments.seed)){
+                return false;
+            }
+            arguments.has_seed=true;
+        }else if("--memory"==argument){
+            if(index+1>=argc
+                ||!::parse_number(argv[++index],arguments.memory_bytes)
+            ){
+                return false;
+            }
+            //以MB为单位,转换为字节数时不能溢出
+            if(arguments.memory_bytes
+                >::std::numeric_limits<::std::uint64_t>::max()/(1024*1024)
+            ){
+                FGWSZ_THROW_WHAT(
+                    "memory limit is too large: "+::std::string(argv[index])
+                );
+            }
+            arguments.memory_bytes*=1024*1024;
+        }else if("--io"==argument){
+            if(index+1>=argc){
+                return false;
+            }
+            ::std::string_view value=argv[++index];
+            if("auto"==value){
+                arguments.io_backend=::fgwsz::IoBackend::automatic;
+            }else if("sync"==value){
+                arguments.io_backend=::fgwsz::IoBackend::sync;
+            }else if("uring"==value){
+                arguments.io_backend=::fgwsz::IoBackend::uring;
+            }else{
+                return false;
+            }
+        }else if("--direct"==argument){
+            arguments.direct_io=true;
+        }else if("--dedup"==argument){
+            arguments.dedup=true;
+        }else if("--hardlink"==argument){
+            arguments.hardlink=true;
+        }else if("--duplicates"==argument){
+            if(index+1>=argc){
+                return false;
+            }
+            ::std::string_view value=argv[++index];
+            if("last"==value){
+                arguments.duplicates=::fgwsz::DuplicatePolicy::keep_last;
+            }else if("first"==value){
+                arguments.duplicates=::fgwsz::DuplicatePolicy::keep_first;
+            }else if("error"==value){
+                arguments.duplicates=::fgwsz::DuplicatePolicy::error;
+            }else{
+                return false;
+            }
+        }else if("--shards"==argument){
+            if(index+1>=argc
+                ||!::parse_number(argv[++index],arguments.shard_count)
+                ||0==arguments.shard_count
+            ){
+                return false;
+            }
+        }else if("--codec"==argument){
+            if(index+1>=argc){
+                return false;
+            }
+            ::std::string_view value=argv[++index];
+            if("none"==value){
+                arguments.codec=::fgwsz::codec_none;
+            }else if(auto const* codec=::fgwsz::find_codec(value)
+                ;nullptr!=codec
+            ){
+                arguments.codec=codec->id;
+            }else{
+                return false;
+            }
+        }else if("--base"==argument){
+            if(index+1>=argc){
+                return false;
+            }
+            arguments.base=argv[++index];
+        }else if("--stats"==argument||"--stats=json"==argument){
+            arguments.stats=true;
+            arguments.stats_json="--stats=json"==argument;
+        }else if("--progress"==argument||"--progress=json"==argument){
+            arguments.progress=true;
+            arguments.progress_json="--progress=json"==argument;
+        }else{
+            arguments.positionals.push_back(argument);
+        }
+    }
+    return true;
+}
+
 int main(int argc,char* argv[]){
     //输入参数太少
     if(argc<3){
@@ -29,19 +251,51 @@ int main(int argc,char* argv[]){
         return -1;
     }
     ::std::string_view option=argv[1];
+    ::Arguments arguments;
+    //参数值超出范围时抛出异常(打印到标准错误,标准输出可能是包内容)
     try{
-        if("-c"==option&&argc>=4){//打包模式
-            ::std::vector<::std::filesystem::path> paths;
-            paths.reserve(argc-3);
-            for(int index=3;index<argc;++index){
-                paths.emplace_back(argv[index]);
-            }
+        if(!::parse_arguments(argc,argv,arguments)){
+            ::help();
+            return -1;
+        }
+    }catch(::std::exception const& e){
+        ::fgwsz::cerr<<e.what()<<'\n';
+        return -1;
+    }
+    auto const& positionals=arguments.positionals;
+    //统计在创建任何工作线程之前开启
+    if(arguments.stats){
+        ::fgwsz::stats_enable();
+    }
+    ::StatsPrinter const stats_printer={arguments.stats,arguments.stats_json};
+    //进度报告线程在打包/解包结束(包括出错)时打印最后一次进度并退出
+    ::std::optional<::fgwsz::ProgressReporter> progress_reporter;
+    if(arguments.progress
+        &&("-c"==option||"-a"==option||"-m"==option||"-x"==option)
+    ){
+        progress_reporter.emplace(::fgwsz::cerr,arguments.progress_json);
+    }
+    //打包到标准输出时,信息打印到标准错误,避免混入包内容
+    ::std::ostream& message=
+        (("-c"==option||"-m"==option)
+            &&!positionals.empty()
+            &&::fgwsz::is_stream_path(positionals[0])
+        )?::fgwsz::cerr
+        : ::fgwsz::cout;
+    try{
+        if(("-c"==option||"-a"==option)
+            &&positionals.size()>=2
+        ){//打包模式和追加模式
+            ::std::vector<::std::filesystem::path> paths(
+                positionals.begin()+1
+                ,positionals.end()
+            );
             //遍历输入路径,打印所有不存在的路径信息
             bool has_next=true;
             for(auto const& path:paths){
                 if(!::std::filesystem::exists(path)){
                     has_next=false;
-                    ::fgwsz::cout<<::fgwsz::what(
+                    message<<::fgwsz::what(
                         "path doesn't exist: "+path.generic_string()
                     )<<'\n';
                 }
@@ -49,20 +303,153 @@ int main(int argc,char* argv[]){
             if(!has_next){
                 return -1;
             }
-            ::fgwsz::Packer packer(argv[2]);
+            //分片包只能新建
+            if(arguments.shard_count>0&&"-a"==option){
+                ::help();
+                return -1;
+            }
+            //基准包不能是正在写入的包(覆盖方式打开时基准包会被清空)
+            ::std::vector<::std::filesystem::path> package_paths;
+            if(arguments.shard_count>0){
+                for(::std::size_t index=0;index<arguments.shard_count;++index){
+                    package_paths.push_back(
+                        ::fgwsz::shard_path(positionals[0],index)
+                    );
+                }
+            }else{
+                package_paths.push_back(positionals[0]);
+            }
+            for(auto const& package_path:package_paths){
+                if(!arguments.base.empty()
+                    &&::std::filesystem::exists(package_path)
+                    &&::std::filesystem::exists(arguments.base)
+                    &&::std::filesystem::equivalent(package_path,arguments.base)
+                ){
+                    message<<::fgwsz::what(
+                        "base package is the output package: "
+                        +::std::string(arguments.base)
+                    )<<'\n';
+                    return -1;
+                }
+            }
+            if(arguments.has_seed){
+                ::fgwsz::random_seed(arguments.seed);
+            }
+            auto const configure=[&arguments](::fgwsz::Packer& packer){
+                packer.set_thread_count(arguments.thread_count);
+                packer.set_memory_bytes(arguments.memory_bytes);
+                packer.set_io_backend(arguments.io_backend);
+                packer.set_direct_io(arguments.direct_io);
+                packer.set_codec(arguments.codec);
+                packer.set_dedup(arguments.dedup);
+                if(!arguments.base.empty()){
+                    packer.set_base(arguments.base);
+                }
+            };
+            if(arguments.shard_count>0){
+                ::fgwsz::pack_shards(
+                    positionals[0]
+                    ,paths
+                    ,arguments.shard_count
+                    ,configure
+                    ,arguments.pack_index
+                );
+                return 0;
+            }
+            ::fgwsz::Packer packer(
+                positionals[0]
+                ,"-a"==option
+                    ?::fgwsz::PackMode::append
+                    : ::fgwsz::PackMode::create
+            );
+            configure(packer);
             packer.pack_paths(paths);
-        }else if("-x"==option&&4==argc){//解包模式
-            ::fgwsz::Unpacker unpacker(argv[2]);
-            unpacker.unpack_package(argv[3]);
-        }else if("-l"==option&&3==argc){//列表模式
-            ::fgwsz::Unpacker unpacker(argv[2]);
+            if(arguments.pack_index){
+                packer.pack_index();
+            }
+        }else if("-m"==option&&positionals.size()>=2){//合并模式
+            ::std::vector<::std::filesystem::path> package_paths(
+                positionals.begin()+1
+                ,positionals.end()
+            );
+            //输入的包必须存在,且不能是正在写入的包(覆盖方式打开时会被清空)
+            for(auto const& package_path:package_paths){
+                if(!::std::filesystem::exists(package_path)){
+                    message<<::fgwsz::what(
+                        "path doesn't exist: "+package_path.generic_string()
+                    )<<'\n';
+                    return -1;
+                }
+                if(::std::filesystem::exists(positionals[0])
+                    &&::std::filesystem::equivalent(positionals[0],package_path)
+                ){
+                    message<<::fgwsz::what(
+                        "merged package is the output package: "
+                        +package_path.generic_string()
+                    )<<'\n';
+                    return -1;
+                }
+            }
+            ::fgwsz::Packer packer(positionals[0]);
+            packer.set_direct_io(arguments.direct_io);
+            packer.pack_packages(package_paths,arguments.duplicates);
+            if(arguments.pack_index){
+                packer.pack_index();
+            }
+        }else if("-x"==option&&positionals.size()>=2){//解包模式
+            //可选的路径模式(通配符或目录前缀),只解包匹配的文件
+            ::std::vector<::std::string> patterns(
+                positionals.begin()+2
+                ,positionals.end()
+            );
+            auto const configure=[&arguments](::fgwsz::Unpacker& unpacker){
+                unpacker.set_thread_count(arguments.thread_count);
+                unpacker.set_io_backend(arguments.io_backend);
+                unpacker.set_direct_io(arguments.direct_io);
+                unpacker.set_hardlink(arguments.hardlink);
+            };
+            //指定了分片数,或者包路径不存在而第0个分片包存在时分片解包
+            //(未指定分片数时从第0个分片包读取)
+            if(arguments.shard_count>0||::fgwsz::is_sharded(positionals[0])){
+                ::fgwsz::unpack_shards(
+                    positionals[0]
+                    ,positionals[1]
+                    ,arguments.shard_count
+                    ,patterns
+                    ,configure
+                );
+                return 0;
+            }
+            ::fgwsz::Unpacker unpacker(positionals[0]);
+            configure(unpacker);
+            unpacker.unpack_package(positionals[1],patterns);
+        }else if("-l"==option&&1==positionals.size()){//列表模式
+            ::fgwsz::Unpacker unpacker(positionals[0]);
             unpacker.list_package();
+        }else if("-t"==option&&1==positionals.size()){//校验模式
+            //校验只读取包,未指定线程数时使用硬件并发线程数
+            auto const configure=[&arguments](::fgwsz::Unpacker& unpacker){
+                unpacker.set_thread_count(
+                    arguments.has_thread_count?arguments.thread_count:0
+                );
+                unpacker.set_direct_io(arguments.direct_io);
+            };
+            //包路径不存在而第0个分片包存在时依次校验所有分片包
+            if(::fgwsz::is_sharded(positionals[0])){
+                return ::fgwsz::verify_shards(positionals[0],0,configure)
+                    ?0:-1;
+            }
+            ::fgwsz::Unpacker unpacker(positionals[0]);
+            configure(unpacker);
+            if(!unpacker.verify_package()){
+                return -1;
+            }
         }else{
             ::help();
             return -1;
         }
     }catch(::std::exception const& e){
-        ::fgwsz::cout<<e.what()<<'\n';
+        message<<e.what()<<'\n';
         return -1;
     }
     return 0;
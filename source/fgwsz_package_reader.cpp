@@ -0,0 +1,428 @@
+#include"fgwsz_package_reader.h"
+
+#include<cstdint>   //::std::uint32_t ::std::uint64_t
+#include<cstring>   //::std::memcpy
+
+#include<string>        //::std::string
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<vector>        //::std::vector
+#include<memory>        //::std::make_shared ::std::make_unique
+#include<mutex>         //::std::mutex ::std::lock_guard
+#include<utility>       //::std::move
+
+#include"fgwsz_endian.hpp"
+#include"fgwsz_except.h"
+#include"fgwsz_xor.h"
+#include"fgwsz_codec.h"
+#include"fgwsz_checksum.h"
+
+namespace fgwsz{
+
+PackageFile::PackageFile(
+    ::fgwsz::PackageReader const& reader
+    ,::fgwsz::Entry const& entry
+)noexcept
+    :reader_(&reader)
+    ,entry_(&entry)
+{}
+::std::uint64_t PackageFile::size(void)const noexcept{
+    return this->entry_->header.original_bytes;
+}
+::std::string const& PackageFile::relative_path_string(void)const noexcept{
+    return this->entry_->header.relative_path_string;
+}
+::fgwsz::Entry const& PackageFile::entry(void)const noexcept{
+    return *(this->entry_);
+}
+::std::uint64_t PackageFile::read(
+    ::std::uint64_t offset
+    ,void* dst
+    ,::std::uint64_t bytes
+)const{
+    return this->reader_->read(*(this->entry_),offset,dst,bytes);
+}
+::std::string PackageFile::read(
+    ::std::uint64_t offset
+    ,::std::uint64_t bytes
+)const{
+    ::std::uint64_t const size=this->size();
+    if(offset>=size){
+        return {};
+    }
+    ::std::string content(bytes<size-offset?bytes:size-offset,'\0');
+    this->reader_->read(
+        *(this->entry_)
+        ,offset
+        ,content.data()
+        ,content.size()
+    );
+    return content;
+}
+::std::string PackageFile::read_all(void)const{
+    return this->reader_->read_all(*(this->entry_));
+}
+
+PackageReader::PackageReader(::std::filesystem::path const& package_path)
+    :unpacker_(package_path)
+{
+    this->init();
+}
+PackageReader::PackageReader(void const* data,::std::uint64_t bytes)
+    :unpacker_(data,bytes)
+{
+    this->init();
+}
+PackageReader::PackageReader(::fgwsz::File&& package)
+    :unpacker_(::std::move(package))
+{
+    this->init();
+}
+void PackageReader::init(void){
+    this->cache_used_bytes_=0;
+    this->cache_hits_=0;
+    this->cache_misses_=0;
+    this->cache_bytes_=::fgwsz::PackageReader::default_cache_bytes;
+    //流式读取的包不能按位置读取
+    if(!this->unpacker_.prepare_random_access()){
+        FGWSZ_THROW_WHAT(
+            "package can't be read at random positions: "
+            +this->unpacker_.package_path_string()
+        );
+    }
+    //读取文件项信息(包含索引区时只读取索引区)
+    this->entries_=&(this->unpacker_.entries());
+    if(nullptr==this->unpacker_.mapped_data()){
+        this->package_.open(
+            this->unpacker_.package_path_string()
+            ,::fgwsz::FileMode::read
+        );
+    }
+    //同一路径出现多次时后出现的文件项覆盖之前的文件项(与解包的结果一致)
+    this->entry_table_.reserve(this->entries_->size());
+    for(auto const& entry:*(this->entries_)){
+        this->entry_table_.insert_or_assign(
+            ::std::string_view(entry.header.relative_path_string)
+            ,&entry
+        );
+    }
+}
+::std::vector<::fgwsz::Entry> const& PackageReader::entries(
+    void
+)const noexcept{
+    return *(this->entries_);
+}
+::fgwsz::Entry const* PackageReader::find(
+    ::std::string_view relative_path
+)const{
+    auto const iter=this->entry_table_.find(relative_path);
+    return this->entry_table_.end()==iter?nullptr:iter->second;
+}
+bool PackageReader::contains(::std::string_view relative_path)const{
+    return nullptr!=this->find(relative_path);
+}
+::fgwsz::PackageFile PackageReader::open(
+    ::std::string_view relative_path
+)const{
+    auto const entry=this->find(relative_path);
+    if(nullptr==entry){
+        FGWSZ_THROW_WHAT(
+            "file doesn't exist in package: "+::std::string(relative_path)
+        );
+    }
+    return ::fgwsz::PackageFile(*this,*entry);
+}
+::std::uint64_t PackageReader::read(
+    ::fgwsz::Entry const& reference
+    ,::std::uint64_t offset
+    ,void* dst
+    ,::std::uint64_t bytes
+)const{
+    //引用文件项读取被引用的文件项的内容(同一内容共享解码帧缓存)
+    auto const& entry=this->unpacker_.resolve_entry(reference);
+    ::std::uint64_t const size=entry.header.original_bytes;
+    if(offset>=size||0==bytes){
+        return 0;
+    }
+    if(bytes>size-offset){
+        bytes=size-offset;
+    }
+    if(!entry.header.framed){
+        this->read_stored(entry,offset,static_cast<char*>(dst),bytes);
+    }else{
+        this->read_frames(entry,offset,static_cast<char*>(dst),bytes);
+    }
+    return bytes;
+}
+void PackageReader::read_stored(
+    ::fgwsz::Entry const& entry
+    ,::std::uint64_t offset
+    ,char* dst
+    ,::std::uint64_t bytes
+)const{
+    //原始内容直接从包内的对应位置解码到调用者的缓冲区
+    //(单字节密钥的xor混淆与位置无关,可以从任意位置开始解码)
+    ::std::uint64_t const position=entry.content_offset+offset;
+    if(nullptr!=this->unpacker_.mapped_data()){
+        //文件项的范围在生成文件项信息时已经检查过
+        ::fgwsz::key_xor_copy(
+            dst
+            ,this->unpacker_.mapped_data()+position
+            ,bytes
+            ,entry.header.key
+        );
+        return;
+    }
+    this->unpacker_.read_records_at(dst,bytes,position,this->package_);
+    ::fgwsz::key_xor(dst,bytes,entry.header.key);
+}
+PackageReader::FrameOffsets PackageReader::frame_offsets(
+    ::fgwsz::Entry const& entry
+)const{
+    {
+        ::std::lock_guard<::std::mutex> lock(this->frame_offsets_mutex_);
+        auto const iter=this->frame_offsets_.find(&entry);
+        if(this->frame_offsets_.end()!=iter){
+            return iter->second;
+        }
+    }
+    //只读取各帧的帧头,得到每一帧在包内的位置(不在锁内读取包)
+    ::std::uint64_t const end=entry.content_offset+entry.header.content_bytes;
+    auto offsets=::std::make_shared<::std::vector<::std::uint64_t>>();
+    offsets->reserve(static_cast<::std::size_t>(
+        (entry.header.original_bytes+::fgwsz::frame_bytes-1)
+        /::fgwsz::frame_bytes
+    ));
+    ::std::uint64_t position=entry.content_offset;
+    for(::std::uint64_t count_bytes=0
+        ;count_bytes<entry.header.original_bytes
+        ;count_bytes+=::fgwsz::frame_bytes
+    ){
+        ::std::uint64_t const bytes=
+            (entry.header.original_bytes-count_bytes)<::fgwsz::frame_bytes
+            ?(entry.header.original_bytes-count_bytes): ::fgwsz::frame_bytes;
+        ::std::uint32_t head=0;
+        if(position>end||end-position<sizeof(head)){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "
+                +entry.header.relative_path_string
+            );
+        }
+        this->unpacker_.read_records_at(
+            &head
+            ,sizeof(head)
+            ,position
+            ,this->package_
+        );
+        ::fgwsz::key_xor(&head,sizeof(head),entry.header.key);
+        ::std::uint64_t data_bytes=0;
+        bool raw=false;
+        if(!::fgwsz::Unpacker::parse_frame_head(
+            ::fgwsz::net_to_host(head)
+            ,bytes
+            ,data_bytes
+            ,raw
+        )){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "
+                +entry.header.relative_path_string
+            );
+        }
+        offsets->push_back(position);
+        position+=sizeof(head)+data_bytes;
+    }
+    if(position!=end){
+        FGWSZ_THROW_WHAT(
+            "corrupted compressed content: "+entry.header.relative_path_string
+        );
+    }
+    //多个线程同时生成同一文件项的帧位置表时保留先登记的结果
+    ::std::lock_guard<::std::mutex> lock(this->frame_offsets_mutex_);
+    return this->frame_offsets_.try_emplace(
+        &entry
+        ,::std::move(offsets)
+    ).first->second;
+}
+PackageReader::Frame PackageReader::decode_frame(
+    ::fgwsz::Entry const& entry
+    ,FrameOffsets const& offsets
+    ,::std::uint64_t frame_index
+)const{
+    ::std::uint64_t const key=(*offsets)[frame_index];
+    {
+        ::std::lock_guard<::std::mutex> lock(this->cache_mutex_);
+        auto const iter=this->cache_items_.find(key);
+        if(this->cache_items_.end()!=iter){
+            //移动到链表头部(最近使用)
+            this->cache_list_.splice(
+                this->cache_list_.begin()
+                ,this->cache_list_
+                ,iter->second
+            );
+            ++(this->cache_hits_);
+            return iter->second->second;
+        }
+        ++(this->cache_misses_);
+    }
+    //未命中时在锁外解码,多个线程可以同时解码不同的帧
+    ::std::uint64_t const count_bytes=frame_index*::fgwsz::frame_bytes;
+    ::std::uint64_t const bytes=
+        (entry.header.original_bytes-count_bytes)<::fgwsz::frame_bytes
+        ?(entry.header.original_bytes-count_bytes): ::fgwsz::frame_bytes;
+    auto frame=::std::make_shared<::std::string>(bytes,'\0');
+    auto scratch=::std::make_unique<char[]>(bytes);
+    ::std::uint32_t checksum=0;
+    this->unpacker_.decode_frame_at(
+        entry.header
+        ,key
+        ,bytes
+        ,this->package_
+        ,frame->data()
+        ,scratch.get()
+        ,checksum
+    );
+    Frame result=::std::move(frame);
+    ::std::lock_guard<::std::mutex> lock(this->cache_mutex_);
+    if(bytes>this->cache_bytes_){
+        return result;
+    }
+    //其他线程已经缓存了同一帧时使用缓存中的帧
+    auto const [iter,inserted]=this->cache_items_.try_emplace(key);
+    if(!inserted){
+        return iter->second->second;
+    }
+    this->cache_list_.emplace_front(key,result);
+    iter->second=this->cache_list_.begin();
+    this->cache_used_bytes_+=bytes;
+    this->evict_frames();
+    return result;
+}
+void PackageReader::evict_frames(void)const{
+    //调用者持有cache_mutex_
+    while(this->cache_used_bytes_>this->cache_bytes_
+        &&!this->cache_list_.empty()
+    ){
+        auto const& [key,frame]=this->cache_list_.back();
+        this->cache_used_bytes_-=frame->size();
+        this->cache_items_.erase(key);
+        this->cache_list_.pop_back();
+    }
+}
+void PackageReader::read_frames(
+    ::fgwsz::Entry const& entry
+    ,::std::uint64_t offset
+    ,char* dst
+    ,::std::uint64_t bytes
+)const{
+    //只解码与请求范围重叠的帧
+    auto const offsets=this->frame_offsets(entry);
+    while(bytes>0){
+        ::std::uint64_t const frame_index=offset/::fgwsz::frame_bytes;
+        ::std::uint64_t const frame_offset=offset% ::fgwsz::frame_bytes;
+        auto const frame=this->decode_frame(entry,offsets,frame_index);
+        ::std::uint64_t const count=
+            (frame->size()-frame_offset)<bytes
+            ?(frame->size()-frame_offset):bytes;
+        ::std::memcpy(dst,frame->data()+frame_offset,count);
+        dst+=count;
+        offset+=count;
+        bytes-=count;
+    }
+}
+::std::string PackageReader::read_all(::fgwsz::Entry const& reference)const{
+    //引用文件项校验自身的文件头之后读取被引用的文件项
+    if(reference.header.reference
+        &&this->unpacker_.header_checksum(reference,this->package_)
+            !=this->unpacker_.stored_checksum(reference,this->package_)
+    ){
+        FGWSZ_THROW_WHAT(
+            "checksum mismatch: "+reference.header.relative_path_string
+        );
+    }
+    auto const& entry=this->unpacker_.resolve_entry(reference);
+    ::std::uint64_t const size=entry.header.original_bytes;
+    ::std::string content(size,'\0');
+    ::std::uint32_t checksum=0;
+    if(!entry.header.framed){
+        if(nullptr!=this->unpacker_.mapped_data()){
+            checksum=::fgwsz::crc32c_key_xor_copy(
+                content.data()
+                ,this->unpacker_.mapped_data()+entry.content_offset
+                ,size
+                ,entry.header.key
+                ,checksum
+            );
+        }else{
+            this->unpacker_.read_records_at(
+                content.data()
+                ,size
+                ,entry.content_offset
+                ,this->package_
+            );
+            checksum=::fgwsz::crc32c_key_xor_copy(
+                content.data()
+                ,content.data()
+                ,size
+                ,entry.header.key
+                ,checksum
+            );
+        }
+    }else{
+        //按顺序解码所有帧,同时计算整个文件内容的校验和
+        auto scratch=::std::make_unique<char[]>(::fgwsz::frame_bytes);
+        ::std::uint64_t position=entry.content_offset;
+        for(::std::uint64_t count_bytes=0
+            ;count_bytes<size
+            ;count_bytes+=::fgwsz::frame_bytes
+        ){
+            ::std::uint64_t const bytes=
+                (size-count_bytes)<::fgwsz::frame_bytes
+                ?(size-count_bytes): ::fgwsz::frame_bytes;
+            position+=this->unpacker_.decode_frame_at(
+                entry.header
+                ,position
+                ,bytes
+                ,this->package_
+                ,content.data()+count_bytes
+                ,scratch.get()
+                ,checksum
+            );
+        }
+        if(position!=entry.content_offset+entry.header.content_bytes){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "
+                +entry.header.relative_path_string
+            );
+        }
+    }
+    if(entry.header.has_checksum
+        &&(::fgwsz::crc32c_shift(
+            this->unpacker_.header_checksum(entry,this->package_)
+            ,entry.header.content_bytes
+        )^checksum)
+            !=this->unpacker_.stored_checksum(entry,this->package_)
+    ){
+        FGWSZ_THROW_WHAT(
+            "checksum mismatch: "+entry.header.relative_path_string
+        );
+    }
+    return content;
+}
+::std::string PackageReader::read_all(::std::string_view relative_path)const{
+    return this->open(relative_path).read_all();
+}
+void PackageReader::set_cache_bytes(::std::uint64_t cache_bytes){
+    ::std::lock_guard<::std::mutex> lock(this->cache_mutex_);
+    this->cache_bytes_=cache_bytes;
+    this->evict_frames();
+}
+::std::uint64_t PackageReader::cache_hits(void)const{
+    ::std::lock_guard<::std::mutex> lock(this->cache_mutex_);
+    return this->cache_hits_;
+}
+::std::uint64_t PackageReader::cache_misses(void)const{
+    ::std::lock_guard<::std::mutex> lock(this->cache_mutex_);
+    return this->cache_misses_;
+}
+
+}//namespace fgwsz
@@ -0,0 +1,146 @@
+#ifndef FGWSZ_PACKAGE_READER_H
+#define FGWSZ_PACKAGE_READER_H
+
+#include<cstdint>       //::std::uint64_t
+#include<cstddef>       //::std::size_t
+
+#include<string>        //::std::string
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<vector>        //::std::vector
+#include<unordered_map> //::std::unordered_map
+#include<list>          //::std::list
+#include<memory>        //::std::shared_ptr
+#include<mutex>         //::std::mutex
+#include<utility>       //::std::pair
+
+#include"fgwsz_header.h"
+#include"fgwsz_file.h"
+#include"fgwsz_unpacker.h"
+
+//============================================================================
+//随机访问包内文件相关(把包当作只读文件系统使用)
+//============================================================================
+namespace fgwsz{
+
+class PackageReader;
+
+//包内的一个文件(轻量句柄,在PackageReader销毁之前有效)
+class PackageFile{
+public:
+    PackageFile(
+        ::fgwsz::PackageReader const& reader
+        ,::fgwsz::Entry const& entry
+    )noexcept;
+    //文件内容解码之后的字节数
+    ::std::uint64_t size(void)const noexcept;
+    //包内的相对路径
+    ::std::string const& relative_path_string(void)const noexcept;
+    //文件项信息
+    ::fgwsz::Entry const& entry(void)const noexcept;
+    //从文件内容的offset位置开始读取最多bytes字节到dst,返回实际读取的字节数
+    //(offset不小于文件大小时返回0)
+    ::std::uint64_t read(
+        ::std::uint64_t offset
+        ,void* dst
+        ,::std::uint64_t bytes
+    )const;
+    ::std::string read(::std::uint64_t offset,::std::uint64_t bytes)const;
+    //读取全部内容(带校验和的文件项同时校验整个文件)
+    ::std::string read_all(void)const;
+private:
+    ::fgwsz::PackageReader const* reader_;
+    ::fgwsz::Entry const* entry_;
+};
+
+//打开一次包之后按相对路径随机读取包内的文件,只解码请求的字节范围:
+//原始内容直接从包内的对应位置解码到调用者的缓冲区,
+//压缩内容按帧解码,最近使用的解码帧保存在有字节上限的LRU缓存中
+//打开之后的所有读取操作可以被多个线程同时调用
+//包必须能够内存映射或者按位置读取(不支持标准输入,管道和读取回调)
+class PackageReader{
+public:
+    //默认的解码帧缓存字节上限
+    static constexpr ::std::uint64_t default_cache_bytes=64*1024*1024;
+    explicit PackageReader(::std::filesystem::path const& package_path);
+    //从内存中的包读取(内存在PackageReader销毁之前必须保持有效)
+    PackageReader(void const* data,::std::uint64_t bytes);
+    //从已经打开的普通文件读取(文件被内存映射)
+    explicit PackageReader(::fgwsz::File&& package);
+    //包内所有文件项信息
+    ::std::vector<::fgwsz::Entry> const& entries(void)const noexcept;
+    //根据相对路径查找文件项(同一路径出现多次时返回最后一次出现的文件项)
+    //不存在时返回nullptr
+    ::fgwsz::Entry const* find(::std::string_view relative_path)const;
+    bool contains(::std::string_view relative_path)const;
+    //打开包内的文件,不存在时抛出异常
+    ::fgwsz::PackageFile open(::std::string_view relative_path)const;
+    //从文件项内容的offset位置开始读取最多bytes字节到dst,返回实际读取的字节数
+    //(引用文件项读取被引用的文件项的内容)
+    ::std::uint64_t read(
+        ::fgwsz::Entry const& entry
+        ,::std::uint64_t offset
+        ,void* dst
+        ,::std::uint64_t bytes
+    )const;
+    //读取文件的全部内容(带校验和的文件项同时校验整个文件,不经过缓存)
+    ::std::string read_all(::fgwsz::Entry const& entry)const;
+    ::std::string read_all(::std::string_view relative_path)const;
+    //设置解码帧缓存的字节上限(0表示不缓存),超出上限时淘汰最久未使用的帧
+    void set_cache_bytes(::std::uint64_t cache_bytes);
+    //缓存命中和未命中(解码)的帧数
+    ::std::uint64_t cache_hits(void)const;
+    ::std::uint64_t cache_misses(void)const;
+    //禁止拷贝
+    PackageReader(PackageReader const&)noexcept=delete;
+    PackageReader& operator=(PackageReader const&)noexcept=delete;
+private:
+    //解码之后的一帧(多个读取者共享,淘汰之后由最后一个读取者释放)
+    using Frame=::std::shared_ptr<::std::string const>;
+    //压缩文件项各帧(帧头)在包内的位置
+    using FrameOffsets=::std::shared_ptr<::std::vector<::std::uint64_t> const>;
+    void init(void);
+    FrameOffsets frame_offsets(::fgwsz::Entry const& entry)const;
+    Frame decode_frame(
+        ::fgwsz::Entry const& entry
+        ,FrameOffsets const& offsets
+        ,::std::uint64_t frame_index
+    )const;
+    void read_stored(
+        ::fgwsz::Entry const& entry
+        ,::std::uint64_t offset
+        ,char* dst
+        ,::std::uint64_t bytes
+    )const;
+    void read_frames(
+        ::fgwsz::Entry const& entry
+        ,::std::uint64_t offset
+        ,char* dst
+        ,::std::uint64_t bytes
+    )const;
+    void evict_frames(void)const;
+    ::fgwsz::Unpacker unpacker_;
+    //包文件没有被映射时各线程共享同一个包文件句柄按位置读取
+    ::fgwsz::File package_;
+    ::std::vector<::fgwsz::Entry> const* entries_;
+    ::std::unordered_map<::std::string_view,::fgwsz::Entry const*> entry_table_;
+    //压缩文件项的帧位置表(第一次读取该文件项时扫描帧头生成)
+    mutable ::std::mutex frame_offsets_mutex_;
+    mutable ::std::unordered_map<::fgwsz::Entry const*,FrameOffsets>
+        frame_offsets_;
+    //解码帧的LRU缓存:链表头部为最近使用的帧,以帧在包内的位置为键
+    mutable ::std::mutex cache_mutex_;
+    mutable ::std::list<::std::pair<::std::uint64_t,Frame>> cache_list_;
+    mutable ::std::unordered_map<
+        ::std::uint64_t
+        ,::std::list<::std::pair<::std::uint64_t,Frame>>::iterator
+    > cache_items_;
+    mutable ::std::uint64_t cache_used_bytes_;
+    mutable ::std::uint64_t cache_hits_;
+    mutable ::std::uint64_t cache_misses_;
+    ::std::uint64_t cache_bytes_;
+};
+
+}//namespace fgwsz
+
+#endif//FGWSZ_PACKAGE_READER_H
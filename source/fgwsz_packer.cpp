@@ -1,42 +1,292 @@
 #include"fgwsz_packer.h"
 
 #include<cstdint>   //::std::uint8_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
+#include<cstring>   //::std::memcpy ::std::memcmp
 
 #include<string>    //::std::string
+#include<string_view>//::std::string_view
 #include<filesystem>//::std::filesystem
-#include<fstream>   //::std::ofstream ::std::ifstream
+#include<utility>   //::std::swap ::std::move ::std::pair
+#include<format>    //::std::format
 #include<vector>    //::std::vector
+#include<memory>    //::std::unique_ptr ::std::make_unique
+#include<unordered_map>//::std::unordered_map
+#include<mutex>     //::std::mutex ::std::lock_guard ::std::unique_lock
+#include<condition_variable>//::std::condition_variable
+#include<thread>    //::std::thread
+#include<exception> //::std::exception_ptr ::std::current_exception
+                    //::std::rethrow_exception ::std::uncaught_exceptions
 
 #include"fgwsz_endian.hpp"
 #include"fgwsz_except.h"
 #include"fgwsz_path.h"
 #include"fgwsz_random.hpp"
-#include"fgwsz_fstream.h"
+#include"fgwsz_xor.h"
+#include"fgwsz_codec.h"
+#include"fgwsz_checksum.h"
+#include"fgwsz_format.h"
+#include"fgwsz_file.h"
+#include"fgwsz_parallel.h"
+#include"fgwsz_stats.h"
+#include"fgwsz_progress.h"
+#include"fgwsz_unpacker.h"
+#include"fgwsz_package_reader.h"
 
 namespace fgwsz{
 
-Packer::Packer(::std::filesystem::path const& package_path){
-    //检查包路径的父路径是否存在,若不存在则创建父路径
-    ::fgwsz::try_create_directories(::fgwsz::parent_path(package_path));
+namespace detail{
+//去重时读取文件内容的块大小
+inline constexpr ::std::uint64_t dedup_block_bytes=1024*1024;//1MB
+//文件前bytes字节内容的CRC32C(文件内容读取不完整时抛出异常)
+inline ::std::uint32_t file_checksum(
+    ::std::string const& file_path_string
+    ,::std::uint64_t bytes
+    ,char* block
+){
+    ::fgwsz::File file(file_path_string,::fgwsz::FileMode::read);
+    ::std::uint32_t checksum=0;
+    for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::dedup_block_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::dedup_block_bytes;
+        if(request!=file.read(block,request)){
+            FGWSZ_THROW_WHAT("file read incomplete: "+file.path_string());
+        }
+        checksum=::fgwsz::crc32c(checksum,block,request);
+        count_bytes+=request;
+    }
+    return checksum;
+}
+//两个文件的前bytes字节内容是否相同(文件内容读取不完整时抛出异常)
+inline bool same_file_content(
+    ::std::string const& lhs_path_string
+    ,::std::string const& rhs_path_string
+    ,::std::uint64_t bytes
+    ,char* lhs_block
+    ,char* rhs_block
+){
+    ::fgwsz::File lhs(lhs_path_string,::fgwsz::FileMode::read);
+    ::fgwsz::File rhs(rhs_path_string,::fgwsz::FileMode::read);
+    for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::dedup_block_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::dedup_block_bytes;
+        if(request!=lhs.read(lhs_block,request)){
+            FGWSZ_THROW_WHAT("file read incomplete: "+lhs.path_string());
+        }
+        if(request!=rhs.read(rhs_block,request)){
+            FGWSZ_THROW_WHAT("file read incomplete: "+rhs.path_string());
+        }
+        if(0!=::std::memcmp(lhs_block,rhs_block,request)){
+            return false;
+        }
+        count_bytes+=request;
+    }
+    return true;
+}
+//包内文件项解码之后前bytes字节内容的CRC32C
+inline ::std::uint32_t packaged_checksum(
+    ::fgwsz::PackageReader const& reader
+    ,::fgwsz::Entry const& entry
+    ,::std::uint64_t bytes
+    ,char* block
+){
+    ::std::uint32_t checksum=0;
+    for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::dedup_block_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::dedup_block_bytes;
+        if(request!=reader.read(entry,count_bytes,block,request)){
+            FGWSZ_THROW_WHAT(
+                "file item read incomplete: "
+                +entry.header.relative_path_string
+            );
+        }
+        checksum=::fgwsz::crc32c(checksum,block,request);
+        count_bytes+=request;
+    }
+    return checksum;
+}
+//包内文件项解码之后的内容与文件的前bytes字节内容是否相同
+inline bool same_packaged_content(
+    ::fgwsz::PackageReader const& reader
+    ,::fgwsz::Entry const& entry
+    ,::std::string const& file_path_string
+    ,::std::uint64_t bytes
+    ,char* lhs_block
+    ,char* rhs_block
+){
+    ::fgwsz::File file(file_path_string,::fgwsz::FileMode::read);
+    for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<::fgwsz::detail::dedup_block_bytes
+            ?(bytes-count_bytes): ::fgwsz::detail::dedup_block_bytes;
+        if(request!=reader.read(entry,count_bytes,lhs_block,request)){
+            FGWSZ_THROW_WHAT(
+                "file item read incomplete: "
+                +entry.header.relative_path_string
+            );
+        }
+        if(request!=file.read(rhs_block,request)){
+            FGWSZ_THROW_WHAT("file read incomplete: "+file.path_string());
+        }
+        if(0!=::std::memcmp(lhs_block,rhs_block,request)){
+            return false;
+        }
+        count_bytes+=request;
+    }
+    return true;
+}
+}//namespace detail
+
+Packer::Packer(
+    ::std::filesystem::path const& package_path
+    ,::fgwsz::PackMode mode
+){
+    this->init();
+    this->streaming_=::fgwsz::is_stream_path(package_path);
+    if(::fgwsz::PackMode::append==mode){
+        //追加方式打开已有的包文件(不能追加到标准输出)
+        if(this->streaming_){
+            FGWSZ_THROW_WHAT("can't append to a stream package");
+        }
+        this->open_append(package_path);
+    }else if(this->streaming_){
+        //流式写入包到标准输出(包只会顺序写入,不需要定位)
+        this->package_.open(::fgwsz::File::standard_output());
+        this->package_path_string_=this->package_.path_string();
+    }else{
+        //检查包路径的父路径是否存在,若不存在则创建父路径
+        ::fgwsz::try_create_directories(::fgwsz::parent_path(package_path));
+        //检查包路径不为目录路径
+        ::fgwsz::path_assert_is_not_directory(package_path);
+        //初始化包文件路径字符串(用于抛出异常时的信息显示)
+        this->package_path_string_=package_path.generic_string();
+        //覆盖方式打开包输出文件路径(打开失败时抛出异常)
+        this->package_.open(package_path,::fgwsz::FileMode::write_truncate);
+    }
+}
+Packer::Packer(::fgwsz::File&& package){
+    this->init();
+    //已经打开的文件(例如文件描述符)与标准输出相同,只顺序写入
+    this->streaming_=true;
+    this->package_.open(::std::move(package));
+    this->package_path_string_=this->package_.path_string();
+}
+Packer::Packer(::fgwsz::WriteFunction write){
+    this->init();
+    this->streaming_=true;
+    this->package_.open(::std::move(write),"<callback>");
+    this->package_path_string_=this->package_.path_string();
+}
+void Packer::init(void){
+    this->streaming_=false;
+    this->appending_=false;
+    this->checksum_=0;
+    this->append_offset_=0;
+    this->package_count_bytes_=0;
+    this->uncaught_exceptions_=::std::uncaught_exceptions();
+    this->block_=::std::move(::std::make_unique<char[]>(this->block_capacity_));
+    this->index_packed_=false;
+    this->thread_count_=1;
+    this->memory_bytes_=0;
+    this->io_backend_=::fgwsz::IoBackend::automatic;
+    this->direct_io_=false;
+    this->codec_=::fgwsz::codec_none;
+    this->dedup_=false;
+}
+Packer::~Packer(void){
+    //析构时无法报告错误,正常流程中的包内容已经在检查点写入文件
+    try{
+        this->package_.close();
+    }catch(...){}
+    //追加因为异常而中断时,去掉已经写入的新文件项并恢复原来的索引区
+    if(this->appending_
+        &&::std::uncaught_exceptions()>this->uncaught_exceptions_
+    ){
+        try{
+            this->restore_append();
+        }catch(...){}
+    }
+    if(!this->streaming_){
+        this->set_read_only();
+    }
+}
+void Packer::open_append(::std::filesystem::path const& package_path){
+    //检查包路径是否存在
+    ::fgwsz::path_assert_exists(package_path);
     //检查包路径不为目录路径
     ::fgwsz::path_assert_is_not_directory(package_path);
     //初始化包文件路径字符串(用于抛出异常时的信息显示)
     this->package_path_string_=package_path.generic_string();
-    //二进制覆盖方式打开包输出文件路径
-    this->package_.open(package_path,::std::ios::binary|::std::ios::trunc);
-    //包输出文件路径打开失败
-    if(!(this->package_.is_open())){
-        FGWSZ_THROW_WHAT(
-            "failed to open package file: "+this->package_path_string_
-        );
+    //校验已有的包:包含索引区时只读取索引区,否则扫描所有文件头(跳过文件内容)
+    //最后一个文件项的结束位置就是新文件项的写入位置
+    {
+        ::fgwsz::Unpacker unpacker(package_path);
+        this->entries_=unpacker.entries();
+        //分片包的文件项在分片头之后
+        if(unpacker.is_shard()){
+            this->append_offset_=::fgwsz::shard_head_bytes;
+        }
+        for(auto const& entry:this->entries_){
+            ::std::uint64_t end=::fgwsz::record_end(entry);
+            if(end>this->append_offset_){
+                this->append_offset_=end;
+            }
+        }
+        //索引区必须紧接在最后一个文件项之后
+        if(unpacker.has_index()
+            &&unpacker.records_bytes()!=this->append_offset_
+        ){
+            FGWSZ_THROW_WHAT(
+                "package tail is invalid: "+this->package_path_string_
+            );
+        }
     }
-    this->block_=::std::move(::std::make_unique<char[]>(this->block_bytes_));
-}
-Packer::~Packer(void){
-    if(this->package_.is_open()){
-        this->package_.close();
+    //去重时新文件可以引用的已有文件项(引用文件项和过小的文件项除外)
+    for(::std::size_t index=0;index<this->entries_.size();++index){
+        auto const& header=this->entries_[index].header;
+        if(!header.reference&&header.original_bytes>this->dedup_min_bytes_){
+            this->append_dedup_entries_[header.original_bytes].push_back(index);
+        }
+    }
+    //保存最后一个文件项之后的内容(索引区),追加中断时用于恢复
+    {
+        ::fgwsz::File package(package_path,::fgwsz::FileMode::read);
+        this->append_tail_.resize(package.size()-this->append_offset_);
+        if(package.read_at(
+            this->append_tail_.data()
+            ,this->append_tail_.size()
+            ,this->append_offset_
+        )!=this->append_tail_.size()){
+            FGWSZ_THROW_WHAT(
+                "package read incomplete: "+this->package_path_string_
+            );
+        }
     }
-    this->set_read_only();
+    //包文件是只读的,追加期间恢复所有者的写权限(析构时重新设置为只读)
+    ::std::filesystem::permissions(
+        package_path
+        ,::std::filesystem::perms::owner_write
+        ,::std::filesystem::perm_options::add
+    );
+    ::fgwsz::File package(package_path,::fgwsz::FileMode::write);
+    //去掉索引区,从最后一个文件项之后继续写入
+    package.resize(this->append_offset_);
+    package.seek(this->append_offset_);
+    this->package_.open(::std::move(package));
+    this->package_count_bytes_=this->append_offset_;
+    this->appending_=true;
+}
+void Packer::restore_append(void){
+    ::fgwsz::File package(this->package_path_string_,::fgwsz::FileMode::write);
+    package.resize(this->append_offset_);
+    package.write_at(
+        this->append_tail_.data()
+        ,this->append_tail_.size()
+        ,this->append_offset_
+    );
 }
 void Packer::set_read_only(void){
     //移除包文件的所有写权限
@@ -49,35 +299,36 @@ void Packer::set_read_only(void){
     );
 }
 void Packer::package_write(void const* src,::std::uint64_t bytes){
-   ::fgwsz::std_ofstream_write(
-        this->package_
-        ,reinterpret_cast<char const*>(src)
-        ,static_cast<::std::streamsize>(bytes)
-        ,this->package_path_string_
-    );
+    //合并写入,只在缓冲区写满和检查点(打包路径结束,写入索引区)时写入文件
+    this->package_.write(src,bytes);
+    this->package_count_bytes_+=bytes;
 }
-void Packer::key_xor(void* ptr,::std::uint64_t bytes){
-    for(::std::uint64_t index=0;index<bytes;++index){
-        reinterpret_cast<::std::uint8_t*>(ptr)[index]^=this->header_.key;
-    }
+void Packer::record_write(void const* src,::std::uint64_t bytes){
+    //文件头在控制序列之后的部分参与文件项校验和的计算
+    this->checksum_=::fgwsz::crc32c(this->checksum_,src,bytes);
+    this->package_write(src,bytes);
 }
-void Packer::pack_key(void){
-    //MSVC中没有实现特化类型为::std::uint8_t的随机数生成器
-    //因此改为使用更大取值范围的无符号整数类型转到::std::uint8_t
-    this->header_.key=
-        static_cast<::std::uint8_t>(::fgwsz::random<unsigned short>(1,255));
+void Packer::pack_control(::std::uint8_t control){
+    ::std::uint8_t const sequence[2]={::fgwsz::control_byte,control};
+    this->package_write(sequence,sizeof(sequence));
+}
+void Packer::pack_key(::std::uint8_t key){
+    this->header_.key=key;
+    //记录文件项信息(用于生成索引区)
+    this->entry_.header.key=this->header_.key;
     //将key写入包
-    this->package_write(&(this->header_.key),sizeof(this->header_.key));
+    this->record_write(&(this->header_.key),sizeof(this->header_.key));
 }
-void Packer::pack_relative_path(
-    ::std::filesystem::path const& file_path
-    ,::std::filesystem::path const& base_dir_path
-){
-    //根据基准目录路径和文件路径得到归档之后的相对路径
-    auto relative_path=::fgwsz::relative_path(file_path,base_dir_path);
-    //检查文件的相对路径是否安全(不安全情况,存在溢出输出目录的风险)
-    ::fgwsz::path_assert_is_safe_relative_path(relative_path);
-    this->header_.relative_path_string=relative_path.generic_string();
+void Packer::pack_relative_path(::std::string const& relative_path_string){
+    //解包时超过最大字节数的相对路径被视为损坏的文件头
+    if(relative_path_string.size()>::fgwsz::max_relative_path_bytes){
+        FGWSZ_THROW_WHAT("relative path is too long: "+relative_path_string);
+    }
+    this->header_.relative_path_string=relative_path_string;
+    this->entry_.header.relative_path_string=
+        this->header_.relative_path_string;
+    this->entry_.header.relative_path_bytes=
+        this->header_.relative_path_string.size();
     //将relative_path_bytes转换为网络序
     this->header_.relative_path_bytes=::fgwsz::host_to_net(
         static_cast<::std::uint64_t>(
@@ -85,143 +336,1397 @@ void Packer::pack_relative_path(
         )
     );
     //使用key对relative_path_bytes和relative_path_string进行xor混淆
-    this->key_xor(
+    ::fgwsz::key_xor(
         &(this->header_.relative_path_bytes)
         ,sizeof(this->header_.relative_path_bytes)
+        ,this->header_.key
     );
-    this->key_xor(
+    ::fgwsz::key_xor(
         this->header_.relative_path_string.data()
         ,this->header_.relative_path_string.size()
+        ,this->header_.key
     );
     //将relative_path_bytes和relative_path_string写入包
-    this->package_write(
+    this->record_write(
         &(this->header_.relative_path_bytes)
         ,sizeof(this->header_.relative_path_bytes)
     );
-    this->package_write(
+    this->record_write(
         this->header_.relative_path_string.data()
         ,this->header_.relative_path_string.size()
     );
 }
-void Packer::pack_content_bytes(::std::filesystem::path const& file_path){
+void Packer::pack_content_bytes(::std::uint64_t content_bytes){
+    this->entry_.header.content_bytes=content_bytes;
+    this->entry_.header.codec=::fgwsz::codec_none;
+    this->entry_.header.framed=false;
+    this->entry_.header.original_bytes=content_bytes;
+    this->entry_.header.reference=false;
+    this->entry_.header.reference_offset=0;
     //将content_bytes转换为网络序
-    this->content_bytes_=::std::filesystem::file_size(file_path);
-    this->header_.content_bytes=::fgwsz::host_to_net(this->content_bytes_);
+    this->header_.content_bytes=::fgwsz::host_to_net(content_bytes);
     //使用key对content_bytes进行xor混淆
-    this->key_xor(
+    ::fgwsz::key_xor(
         &(this->header_.content_bytes)
         ,sizeof(this->header_.content_bytes)
+        ,this->header_.key
     );
     //将content_bytes写入包
-    this->package_write(
+    this->record_write(
         &(this->header_.content_bytes)
         ,sizeof(this->header_.content_bytes)
     );
 }
-void Packer::pack_header(
-    ::std::filesystem::path const& file_path
-    ,::std::filesystem::path const& base_dir_path
-){
-    this->pack_key();
-    this->pack_relative_path(file_path,base_dir_path);
-    this->pack_content_bytes(file_path);
-}
-void Packer::pack_content(::std::filesystem::path const& file_path){
-    //二进制方式打开文件
-    ::std::ifstream file(file_path,::std::ios::binary);
-    ::std::string file_path_string=file_path.generic_string();
-    //文件打不开时
-    if(!file.is_open()){
-        FGWSZ_THROW_WHAT("failed to open file: "+file_path_string);
-    }
-    //分块读取文件内容
-    ::std::uint64_t count_bytes=0;
-    ::std::uint64_t read_bytes=0;
-    while(count_bytes<this->content_bytes_){
-        //读取文件内容到块中
-        read_bytes=static_cast<::std::uint64_t>(
-            ::fgwsz::std_ifstream_read(
-                file
-                ,this->block_.get()
-                ,static_cast<::std::streamsize>(this->block_bytes_)
-                ,file_path_string
+void Packer::pack_codec(::std::uint8_t codec,::std::uint64_t original_bytes){
+    //压缩文件项的内容字节数在所有帧写入之后才能确定
+    this->entry_.header.content_bytes=0;
+    this->entry_.header.codec=codec;
+    this->entry_.header.framed=true;
+    this->entry_.header.original_bytes=original_bytes;
+    this->entry_.header.reference=false;
+    this->entry_.header.reference_offset=0;
+    //将original_bytes转换为网络序,使用key对codec和original_bytes进行xor混淆
+    char fields[sizeof(codec)+sizeof(original_bytes)];
+    original_bytes=::fgwsz::host_to_net(original_bytes);
+    ::std::memcpy(fields,&codec,sizeof(codec));
+    ::std::memcpy(fields+sizeof(codec),&original_bytes,sizeof(original_bytes));
+    ::fgwsz::key_xor(fields,sizeof(fields),this->header_.key);
+    //将codec和original_bytes写入包
+    this->record_write(fields,sizeof(fields));
+}
+void Packer::pack_checksum(void){
+    //将校验和转换为网络序,使用key进行xor混淆之后写入包
+    ::std::uint32_t checksum=::fgwsz::host_to_net(this->checksum_);
+    ::fgwsz::key_xor(&checksum,sizeof(checksum),this->header_.key);
+    this->package_write(&checksum,sizeof(checksum));
+}
+void Packer::pack_header(Item const& item,bool compressed){
+    //记录文件项信息(用于生成索引区)
+    this->entry_.record_offset=this->package_count_bytes_;
+    this->entry_.header.has_checksum=true;
+    this->entry_.has_source=item.has_source;
+    this->entry_.source_write_time=item.source_write_time;
+    this->entry_.source_bytes=item.source_bytes;
+    this->pack_control(compressed
+        ?(::fgwsz::control_checksum_record
+            |::fgwsz::control_compressed_record)
+        : ::fgwsz::control_checksum_record
+    );
+    this->checksum_=0;
+    this->pack_key(item.key);
+    this->pack_relative_path(item.relative_path_string);
+    if(compressed){
+        this->pack_codec(this->codec_,item.content_bytes);
+    }else{
+        this->pack_content_bytes(item.content_bytes);
+    }
+    this->entry_.content_offset=this->package_count_bytes_;
+}
+Packer::Encoded Packer::encode_unit(
+    Item const& item
+    ,Unit const& unit
+    ,char*& block
+    ,char*& scratch
+)const{
+    //读取单元的内容位于block+frame_head_bytes处,block和scratch都有block_capacity_字节
+    char* content=block+::fgwsz::frame_head_bytes;
+    if(nullptr!=item.base_entry||item.reference){
+        return {content,0,false,0};
+    }
+    //空洞帧只有为0的帧头
+    if(unit.hole){
+        ::std::uint32_t const head=0;
+        ::std::memcpy(block,&head,sizeof(head));
+        return {
+            block
+            ,::fgwsz::frame_head_bytes
+            ,true
+            ,::fgwsz::key_xor_crc32c(
+                block
+                ,::fgwsz::frame_head_bytes
+                ,item.key
+                ,0
             )
+        };
+    }
+    //稀疏文件不论是否压缩都保存为压缩文件项(多于一帧)
+    bool const single_frame=item.content_bytes<=this->block_bytes_;
+    bool const framed=
+        ::fgwsz::codec_none!=this->codec_||item.sparse;
+    if(!framed||0==item.content_bytes){
+        return {
+            content
+            ,unit.bytes
+            ,false
+            ,::fgwsz::key_xor_crc32c(content,unit.bytes,item.key,0)
+        };
+    }
+    //压缩结果必须少于原始内容,单帧的文件项还要抵消压缩文件项多出的文件头和帧头
+    ::std::uint64_t const overhead=single_frame
+        ?::fgwsz::compressed_header_fixed_bytes-::fgwsz::header_fixed_bytes
+            +::fgwsz::frame_head_bytes
+        :1;
+    ::std::uint64_t compressed_bytes=0;
+    if(::fgwsz::codec_none!=this->codec_&&unit.bytes>overhead){
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::compress,unit.bytes);
+        compressed_bytes=::fgwsz::find_codec(this->codec_)->compress(
+            scratch+::fgwsz::frame_head_bytes
+            ,unit.bytes-overhead
+            ,content
+            ,unit.bytes
         );
-        //将内存块中的文件内容信息编码混淆
-        this->key_xor(this->block_.get(),read_bytes);
-        //将内存块中的文件内容信息写入包
-        this->package_write(this->block_.get(),read_bytes);
-        //更新字节计数器
-        count_bytes+=read_bytes;
     }
-    //文件内容读取不完整
-    if(count_bytes!=this->content_bytes_){
-        FGWSZ_THROW_WHAT("file read incomplete: "+file_path_string);
+    ::std::uint32_t head=0;
+    if(compressed_bytes>0){
+        //压缩有效时交换块,压缩结果所在的块作为写入内容
+        head=static_cast<::std::uint32_t>(compressed_bytes);
+        ::std::swap(block,scratch);
+    }else if(single_frame){
+        //不压缩的文件项
+        return {
+            content
+            ,unit.bytes
+            ,false
+            ,::fgwsz::key_xor_crc32c(content,unit.bytes,item.key,0)
+        };
+    }else{
+        //保存原始内容的帧
+        head=::fgwsz::frame_raw_flag|static_cast<::std::uint32_t>(unit.bytes);
     }
+    head=::fgwsz::host_to_net(head);
+    ::std::memcpy(block,&head,sizeof(head));
+    ::std::uint64_t const bytes=::fgwsz::frame_head_bytes
+        +(0==compressed_bytes?unit.bytes:compressed_bytes);
+    return {block,bytes,true,::fgwsz::key_xor_crc32c(block,bytes,item.key,0)};
 }
-void Packer::pack_file(
-    ::std::filesystem::path const& file_path
-    ,::std::filesystem::path const& base_dir_path
+void Packer::pack_unit(
+    Item const& item
+    ,Unit const& unit
+    ,Encoded const& encoded
 ){
-    //输入参数检查阶段
-    ::fgwsz::path_assert_exists(file_path);
-    ::fgwsz::path_assert_is_not_directory(file_path);
-    ::fgwsz::path_assert_is_not_symlink(file_path);
-    ::fgwsz::path_assert_exists(base_dir_path);
-    ::fgwsz::path_assert_is_directory(base_dir_path);
+    //基准包中的文件项和引用文件项只有一个空的读取单元
+    if(nullptr!=item.base_entry){
+        this->pack_base_entry(*item.base_entry);
+        return;
+    }
+    if(item.reference){
+        this->pack_reference(item);
+        return;
+    }
     //文件头信息处理阶段
-    this->pack_header(file_path,base_dir_path);
-    //文件内容信息处理阶段
-    this->pack_content(file_path);
-}
-void Packer::pack_dir(::std::filesystem::path const& dir_path){
-    //检查路径是否存在
-    ::fgwsz::path_assert_exists(dir_path);
-    //检查路径是否指向目录
-    ::fgwsz::path_assert_is_directory(dir_path);
-    //递归遍历所有的子文件进行打包
-    ::std::filesystem::file_status status={};
-    for(::std::filesystem::directory_entry const& dir_entry
-        : ::std::filesystem::recursive_directory_iterator(dir_path)
+    if(0==unit.offset){
+        this->pack_header(item,encoded.compressed);
+    }
+    //文件内容信息处理阶段(读取单元的校验和在编码时与混淆一起计算)
+    this->package_write(encoded.data,encoded.bytes);
+    this->checksum_=::fgwsz::crc32c_combine(
+        this->checksum_
+        ,encoded.checksum
+        ,encoded.bytes
+    );
+    if(encoded.compressed){
+        this->entry_.header.content_bytes+=encoded.bytes;
+    }
+    //校验和与索引信息记录阶段
+    bool const item_packed=unit.offset+unit.bytes==item.content_bytes;
+    if(item_packed){
+        this->pack_checksum();
+        this->entries_.push_back(this->entry_);
+    }
+    ::fgwsz::progress_add(unit.bytes,item_packed?1:0);
+}
+void Packer::pack_base_entry(::fgwsz::Entry const& base_entry){
+    this->pack_copied_entries(this->base_file_,&base_entry,&base_entry+1);
+}
+void Packer::pack_copied_entries(
+    ::fgwsz::File const& source
+    ,::fgwsz::Entry const* first
+    ,::fgwsz::Entry const* last
+){
+    //[first,last)在源包内首尾相接,
+    //整段文件项(文件头和已经混淆的文件内容)一次原样复制,只有其在包内的位置改变
+    ::std::uint64_t const source_offset=first->record_offset;
+    ::std::uint64_t const record_bytes=
+        ::fgwsz::record_end(*(last-1))-source_offset;
+    this->package_.copy_from(source,record_bytes,source_offset);
+    for(auto const* source_entry=first;source_entry!=last;++source_entry){
+        ::fgwsz::Entry entry=*source_entry;
+        entry.record_offset=this->package_count_bytes_
+            +(source_entry->record_offset-source_offset);
+        entry.content_offset=this->package_count_bytes_
+            +(source_entry->content_offset-source_offset);
+        this->entries_.push_back(::std::move(entry));
+        ::fgwsz::progress_add(0,1);
+    }
+    this->package_count_bytes_+=record_bytes;
+}
+void Packer::pack_resolved_entry(
+    ::fgwsz::File const& source
+    ,::fgwsz::Entry const& target
+    ,::fgwsz::Entry const& reference
+){
+    //沿用被引用的文件项的控制类型和key,只重新写入相对路径,
+    //相对路径之后的部分(内容字节数和已经混淆的文件内容)原样复制
+    bool const has_control=target.header.framed||target.header.has_checksum;
+    ::std::uint64_t const path_offset=target.record_offset
+        +(has_control?::fgwsz::control_bytes:0);
+    ::std::uint64_t const tail_offset=path_offset+sizeof(target.header.key)
+        +sizeof(target.header.relative_path_bytes)
+        +target.header.relative_path_bytes;
+    ::std::uint64_t const tail_bytes=::fgwsz::record_end(target)
+        -(target.header.has_checksum?::fgwsz::checksum_bytes:0)
+        -tail_offset;
+    this->entry_=target;
+    this->entry_.record_offset=this->package_count_bytes_;
+    this->entry_.has_source=reference.has_source;
+    this->entry_.source_write_time=reference.source_write_time;
+    this->entry_.source_bytes=reference.source_bytes;
+    if(has_control){
+        this->pack_control(
+            (target.header.framed?::fgwsz::control_compressed_record:0)
+            |(target.header.has_checksum?::fgwsz::control_checksum_record:0)
+        );
+    }
+    this->checksum_=0;
+    this->pack_key(target.header.key);
+    this->pack_relative_path(reference.header.relative_path_string);
+    this->entry_.content_offset=this->package_count_bytes_
+        +(target.content_offset-tail_offset);
+    //不读取文件内容:先从原来的校验和中去掉原来的文件头部分得到尾部的校验和,
+    //再与新的文件头部分的校验和合并
+    ::std::uint32_t tail_checksum=0;
+    if(target.header.has_checksum){
+        ::std::string head;
+        head.resize(tail_offset-path_offset);
+        ::std::uint32_t checksum=0;
+        if(head.size()!=source.read_at(head.data(),head.size(),path_offset)
+            ||sizeof(checksum)!=source.read_at(
+                &checksum
+                ,sizeof(checksum)
+                ,tail_offset+tail_bytes
+            )
+        ){
+            FGWSZ_THROW_WHAT("file read incomplete: "+source.path_string());
+        }
+        ::fgwsz::key_xor(&checksum,sizeof(checksum),target.header.key);
+        tail_checksum=::fgwsz::net_to_host(checksum)
+            ^::fgwsz::crc32c_shift(
+                ::fgwsz::crc32c(0,head.data(),head.size())
+                ,tail_bytes
+            );
+    }
+    this->package_.copy_from(source,tail_bytes,tail_offset);
+    this->package_count_bytes_+=tail_bytes;
+    if(target.header.has_checksum){
+        this->checksum_=::fgwsz::crc32c_combine(
+            this->checksum_
+            ,tail_checksum
+            ,tail_bytes
+        );
+        this->pack_checksum();
+    }
+    this->entries_.push_back(this->entry_);
+    ::fgwsz::progress_add(0,1);
+}
+void Packer::pack_reference(Item const& item){
+    //引用文件项只有文件头和校验和,内容与之前的被引用文件项相同
+    auto const& target=this->entries_[item.reference_index];
+    this->entry_.record_offset=this->package_count_bytes_;
+    this->entry_.header.has_checksum=true;
+    this->entry_.has_source=item.has_source;
+    this->entry_.source_write_time=item.source_write_time;
+    this->entry_.source_bytes=item.source_bytes;
+    this->pack_control(
+        ::fgwsz::control_checksum_record|::fgwsz::control_reference_record
+    );
+    this->checksum_=0;
+    this->pack_key(item.key);
+    this->pack_relative_path(item.relative_path_string);
+    this->entry_.header.content_bytes=0;
+    this->entry_.header.codec=::fgwsz::codec_none;
+    this->entry_.header.framed=false;
+    this->entry_.header.original_bytes=target.header.original_bytes;
+    this->entry_.header.reference=true;
+    this->entry_.header.reference_offset=target.record_offset;
+    //将reference offset和original bytes转换为网络序,使用key进行xor混淆之后写入包
+    ::std::uint64_t fields[2]={
+        ::fgwsz::host_to_net(this->entry_.header.reference_offset)
+        ,::fgwsz::host_to_net(this->entry_.header.original_bytes)
+    };
+    ::fgwsz::key_xor(fields,sizeof(fields),this->header_.key);
+    this->record_write(fields,sizeof(fields));
+    this->entry_.content_offset=this->package_count_bytes_;
+    this->pack_checksum();
+    this->entries_.push_back(this->entry_);
+    ::fgwsz::progress_add(0,1);
+}
+void Packer::pack_content(Item const& item){
+    if(nullptr!=item.base_entry){
+        this->pack_base_entry(*item.base_entry);
+        return;
+    }
+    if(item.reference){
+        this->pack_reference(item);
+        return;
+    }
+    char* block=this->block_.get();
+    char* scratch=this->scratch_.get();
+    //内存中的文件内容分块复制到块中,编码混淆并写入
+    if(nullptr!=item.data){
+        for(auto const& unit:this->make_units({item})){
+            ::std::memcpy(
+                block+::fgwsz::frame_head_bytes
+                ,item.data+unit.offset
+                ,static_cast<::std::size_t>(unit.bytes)
+            );
+            this->pack_unit(
+                item
+                ,unit
+                ,this->encode_unit(item,unit,block,scratch)
+            );
+        }
+        return;
+    }
+    //二进制方式打开文件(打开失败时抛出异常)
+    ::fgwsz::File file(item.file_path_string,::fgwsz::FileMode::read);
+    //绕过页缓存时大文件读取之后按窗口丢弃页缓存
+    bool const drop_cache=this->direct_io_
+        &&item.content_bytes>=this->direct_min_bytes_;
+    ::std::uint64_t cache_offset=0;
+    //分块读取,编码混淆并写入文件内容(稀疏文件跳过空洞,按位置读取数据)
+    for(auto const& unit:this->make_units({item})){
+        if(!unit.hole&&unit.bytes!=(!item.sparse
+            ?file.read(block+::fgwsz::frame_head_bytes,unit.bytes)
+            :file.read_at(
+                block+::fgwsz::frame_head_bytes
+                ,unit.bytes
+                ,unit.offset
+            ))
+        ){
+            //文件内容读取不完整
+            FGWSZ_THROW_WHAT("file read incomplete: "+file.path_string());
+        }
+        if(drop_cache){
+            cache_offset=
+                file.drop_cache_behind(cache_offset,unit.offset+unit.bytes);
+        }
+        this->pack_unit(item,unit,this->encode_unit(item,unit,block,scratch));
+    }
+    if(drop_cache){
+        file.drop_cache(cache_offset,0);
+    }
+}
+Packer::Item Packer::make_item(::fgwsz::WalkedFile&& file){
+    Item item={};
+    item.file_path_string=::std::move(file.path_string);
+    //MSVC中没有实现特化类型为::std::uint8_t的随机数生成器
+    //因此改为使用更大取值范围的无符号整数类型转到::std::uint8_t
+    item.key=
+        static_cast<::std::uint8_t>(::fgwsz::random<unsigned short>(1,255));
+    //相对路径由遍历时的目录名和文件名拼接得到,不包含".."
+    item.relative_path_string=::std::move(file.relative_path_string);
+    item.content_bytes=file.bytes;
+    item.has_source=true;
+    item.source_write_time=file.write_time;
+    item.source_bytes=file.bytes;
+    //修改时间和字节数与打包基准包时记录的源文件信息相同的文件视为内容未改变,
+    //直接复制基准包中的文件项,只生成一个空的读取单元
+    //(引用文件项引用的是基准包内的位置,不能直接复制)
+    if(nullptr!=this->base_){
+        auto const* base_entry=
+            this->base_->find_entry(item.relative_path_string);
+        if(nullptr!=base_entry
+            &&!base_entry->header.reference
+            &&base_entry->has_source
+            &&base_entry->source_write_time==file.write_time
+            &&base_entry->source_bytes==file.bytes
+            &&base_entry->header.original_bytes==item.content_bytes
+        ){
+            item.base_entry=base_entry;
+            item.content_bytes=0;
+        }
+    }
+    //分配的磁盘空间少于文件大小的多帧文件查找空洞,至少有一整帧空洞时按帧保存
+    if(file.sparse
+        &&nullptr==item.base_entry
+        &&item.content_bytes>this->block_bytes_
     ){
-        //检查符号状态(不追踪符号链接)
-        status=dir_entry.symlink_status();
-        //跳过所有子目录
-        if(::std::filesystem::is_directory(status)){
-            continue;
-        }
-        //跳过所有符号链接
-        if(::std::filesystem::is_symlink(status)){
-            continue;
-        }
-        //只对文件进行打包
-        this->pack_file(
-            ::std::filesystem::absolute(dir_entry.path())
-            ,::fgwsz::parent_path(dir_path)
-        );//基准目录路径指向dir_path的父目录,是为了把dir_path本身也打包进去
-    }
-}
-void Packer::pack_path(::std::filesystem::path const& path){
-    //检查路径是否存在
-    ::fgwsz::path_assert_exists(path);
-    //检查路径类型
-    if(::std::filesystem::is_directory(path)){//目录路径
-        this->pack_dir(path);
-    }else{//文件路径
-        //为了避免出现如下情况,扩展path为绝对路径:
-        //path:"file.txt"
-        //  parent_path:"" 
-        //  is_directory(parent_path) is false
-        //path:"./file.txt"
-        //  parent_path:"./"
-        //  is_directory(parent_path) is true
-        this->pack_file(path,::fgwsz::parent_path(path));
+        ::fgwsz::File sparse_file(
+            item.file_path_string
+            ,::fgwsz::FileMode::read
+        );
+        item.data_extents=sparse_file.data_extents();
+        ::std::uint64_t data_end=0;
+        for(auto const& extent:item.data_extents){
+            if(extent.offset/this->block_bytes_
+                >(data_end+this->block_bytes_-1)/this->block_bytes_
+            ){
+                item.sparse=true;
+            }
+            data_end=extent.offset+extent.bytes;
+        }
+        if((item.content_bytes-1)/this->block_bytes_
+            >=(data_end+this->block_bytes_-1)/this->block_bytes_
+        ){
+            item.sparse=true;
+        }
+        if(!item.sparse){
+            item.data_extents.clear();
+        }
+    }
+    return item;
+}
+::fgwsz::Entry const& Packer::append_entry(::std::size_t entry_index){
+    //第一次读取已有文件项时映射追加之前的记录区(新文件项写在其后,不改变这个范围)
+    if(nullptr==this->append_reader_){
+        if(!this->append_mapping_.map(this->package_path_string_)
+            ||this->append_mapping_.size()<this->append_offset_
+        ){
+            FGWSZ_THROW_WHAT(
+                "failed to map package: "+this->package_path_string_
+            );
+        }
+        this->append_reader_=::std::make_unique<::fgwsz::PackageReader>(
+            this->append_mapping_.data()
+            ,this->append_offset_
+        );
+        for(auto const& entry:this->append_reader_->entries()){
+            this->append_entries_.insert_or_assign(entry.record_offset,&entry);
+        }
+    }
+    auto const iter=this->append_entries_.find(
+        this->entries_[entry_index].record_offset
+    );
+    if(this->append_entries_.end()==iter){
+        FGWSZ_THROW_WHAT(
+            "package read incomplete: "+this->package_path_string_
+        );
+    }
+    return *(iter->second);
+}
+void Packer::dedup_items(::std::vector<Item>& items){
+    //按内容字节数预先筛选:只有内容字节数与其他文件相同的文件才需要读取内容
+    auto const dedupable=[this](Item const& item){
+        return nullptr==item.data
+            &&nullptr==item.base_entry
+            &&!item.sparse
+            &&item.content_bytes>this->dedup_min_bytes_;
+    };
+    ::std::unordered_map<::std::uint64_t,::std::size_t> size_counts;
+    for(auto const& item:items){
+        if(dedupable(item)){
+            ++size_counts[item.content_bytes];
+        }
+    }
+    ::std::vector<::std::size_t> candidates;
+    for(::std::size_t index=0;index<items.size();++index){
+        auto const& item=items[index];
+        if(dedupable(item)
+            &&(size_counts[item.content_bytes]>1
+                ||this->dedup_files_.contains(item.content_bytes)
+                ||this->append_dedup_entries_.contains(item.content_bytes))
+        ){
+            candidates.push_back(index);
+        }
+    }
+    //追加时与候选文件内容字节数相同的已有文件项第一次需要比较,先计算其内容的校验和
+    ::std::vector<::std::size_t> seeds;
+    for(auto const index:candidates){
+        auto const iter=
+            this->append_dedup_entries_.find(items[index].content_bytes);
+        if(this->append_dedup_entries_.end()!=iter){
+            seeds.insert(seeds.end(),iter->second.begin(),iter->second.end());
+            this->append_dedup_entries_.erase(iter);
+        }
+    }
+    ::std::vector<::fgwsz::Entry const*> seed_entries;
+    for(auto const entry_index:seeds){
+        seed_entries.push_back(&(this->append_entry(entry_index)));
+    }
+    //多个线程同时计算候选文件和已有文件项内容的校验和
+    ::std::vector<::std::uint32_t> checksums(
+        candidates.size()+seeds.size()
+        ,0
+    );
+    ::std::vector<::std::unique_ptr<char[]>> blocks(this->thread_count_);
+    ::fgwsz::parallel_for(checksums.size(),this->thread_count_,
+        [&](::std::size_t task_index,::std::size_t thread_index){
+            if(nullptr==blocks[thread_index]){
+                blocks[thread_index]=::std::make_unique<char[]>(
+                    ::fgwsz::detail::dedup_block_bytes
+                );
+            }
+            if(task_index>=candidates.size()){
+                auto const& entry=*(seed_entries[task_index-candidates.size()]);
+                checksums[task_index]=::fgwsz::detail::packaged_checksum(
+                    *(this->append_reader_)
+                    ,entry
+                    ,entry.header.original_bytes
+                    ,blocks[thread_index].get()
+                );
+                return;
+            }
+            auto const& item=items[candidates[task_index]];
+            checksums[task_index]=::fgwsz::detail::file_checksum(
+                item.file_path_string
+                ,item.content_bytes
+                ,blocks[thread_index].get()
+            );
+            //绕过页缓存时丢弃大文件读取的页缓存(只是优化,文件无法打开时忽略)
+            if(this->direct_io_&&item.content_bytes>=this->direct_min_bytes_){
+                try{
+                    ::fgwsz::File(
+                        item.file_path_string
+                        ,::fgwsz::FileMode::read
+                    ).drop_cache(0,0);
+                }catch(...){}
+            }
+        }
+    );
+    for(::std::size_t index=0;index<seeds.size();++index){
+        this->dedup_files_[seed_entries[index]->header.original_bytes]
+            .push_back({
+                checksums[candidates.size()+index]
+                ,{}
+                ,seeds[index]
+                ,true
+            });
+    }
+    //按打包顺序查找内容相同的之前的文件(校验和相同时逐字节比较)
+    //每个文件项依次加入entries_,所以第index个文件的文件项位于entries_.size()+index
+    ::std::size_t const entry_index=this->entries_.size();
+    ::std::unique_ptr<char[]> lhs_block;
+    ::std::unique_ptr<char[]> rhs_block;
+    for(::std::size_t index=0;index<candidates.size();++index){
+        auto& item=items[candidates[index]];
+        auto& files=this->dedup_files_[item.content_bytes];
+        for(auto const& file:files){
+            if(file.checksum!=checksums[index]){
+                continue;
+            }
+            if(nullptr==lhs_block){
+                lhs_block=::std::make_unique<char[]>(
+                    ::fgwsz::detail::dedup_block_bytes
+                );
+                rhs_block=::std::make_unique<char[]>(
+                    ::fgwsz::detail::dedup_block_bytes
+                );
+            }
+            if(file.packaged
+                ?::fgwsz::detail::same_packaged_content(
+                    *(this->append_reader_)
+                    ,this->append_entry(file.entry_index)
+                    ,item.file_path_string
+                    ,item.content_bytes
+                    ,lhs_block.get()
+                    ,rhs_block.get()
+                )
+                : ::fgwsz::detail::same_file_content(
+                    file.file_path_string
+                    ,item.file_path_string
+                    ,item.content_bytes
+                    ,lhs_block.get()
+                    ,rhs_block.get()
+                )
+            ){
+                item.reference=true;
+                item.reference_index=file.entry_index;
+                item.content_bytes=0;
+                break;
+            }
+        }
+        if(!item.reference){
+            files.push_back({
+                checksums[index]
+                ,item.file_path_string
+                ,entry_index+candidates[index]
+                ,false
+            });
+        }
+    }
+}
+::std::vector<Packer::Unit> Packer::make_units(
+    ::std::vector<Item> const& items
+)const{
+    //把所有文件内容按输出顺序切分为读取单元,每个单元最多一个块
+    //空文件也对应一个单元,保证其文件头按顺序写入
+    ::std::vector<Unit> units;
+    for(::std::size_t index=0;index<items.size();++index){
+        ::std::uint64_t const content_bytes=items[index].content_bytes;
+        auto const& extents=items[index].data_extents;
+        ::std::size_t extent_index=0;
+        ::std::uint64_t offset=0;
+        do{
+            ::std::uint64_t const bytes=
+                (content_bytes-offset)<this->block_bytes_
+                ?(content_bytes-offset):this->block_bytes_;
+            //稀疏文件中不与任何数据范围重叠的单元为空洞
+            while(extent_index<extents.size()
+                &&extents[extent_index].offset+extents[extent_index].bytes
+                    <=offset
+            ){
+                ++extent_index;
+            }
+            bool const hole=items[index].sparse
+                &&(extent_index==extents.size()
+                    ||extents[extent_index].offset>=offset+bytes);
+            units.push_back({index,offset,bytes,hole});
+            offset+=bytes;
+        }while(offset<content_bytes);
+    }
+    return units;
+}
+::std::size_t Packer::block_count(
+    ::std::size_t default_block_count
+    ,::std::size_t unit_count
+)const{
+    //块池:块的数量决定了内存上限,多于读取单元的块不会被使用
+    ::std::uint64_t const memory_bytes=0==this->memory_bytes_
+        ?default_block_count*this->block_bytes_:this->memory_bytes_;
+    ::std::uint64_t block_count=memory_bytes/this->block_bytes_;
+    if(block_count>unit_count){
+        block_count=unit_count;
+    }
+    return static_cast<::std::size_t>(block_count<2?2:block_count);
+}
+void Packer::pack_items_parallel(::std::vector<Item> const& items){
+    auto const units=this->make_units(items);
+    ::std::size_t const block_count=this->block_count(
+        4*this->thread_count_
+        ,units.size()
+    );
+    //块池和每个读取线程的压缩输出块(压缩时读取线程交换块和压缩输出块)
+    ::std::vector<::std::unique_ptr<char[]>> blocks;
+    ::std::vector<char*> free_blocks;
+    for(::std::size_t index=0;index<block_count;++index){
+        blocks.push_back(::std::make_unique<char[]>(this->block_capacity_));
+        free_blocks.push_back(blocks.back().get());
+    }
+    ::std::vector<char*> scratches(this->thread_count_,nullptr);
+    if(::fgwsz::codec_none!=this->codec_){
+        for(auto& scratch:scratches){
+            blocks.push_back(::std::make_unique<char[]>(this->block_capacity_));
+            scratch=blocks.back().get();
+        }
+    }
+    //已读取完成等待写入的单元
+    //读取线程先取得空闲块再按顺序领取单元,所以未写入的单元编号都位于
+    //[正在等待写入的单元编号,正在等待写入的单元编号+块数量)范围内
+    struct Slot{
+        char* block;
+        Encoded encoded;
+        bool ready;
+    };
+    ::std::vector<Slot> slots(
+        block_count
+        ,Slot{nullptr,Encoded{nullptr,0,false,0},false}
+    );
+    ::std::size_t next_unit_index=0;
+    bool failed=false;
+    ::std::exception_ptr exception=nullptr;
+    ::std::mutex mutex;
+    ::std::condition_variable free_condition;
+    ::std::condition_variable ready_condition;
+    auto fail=[&](::std::exception_ptr current){
+        {
+            ::std::lock_guard<::std::mutex> lock(mutex);
+            if(nullptr==exception){
+                exception=current;
+            }
+            failed=true;
+        }
+        free_condition.notify_all();
+        ready_condition.notify_all();
+    };
+    //读取线程:读取文件内容,压缩并使用文件的key进行xor混淆
+    auto reader=[&](char* scratch){
+        while(true){
+            char* block=nullptr;
+            ::std::size_t unit_index=0;
+            {
+                ::std::unique_lock<::std::mutex> lock(mutex);
+                free_condition.wait(lock,[&](void){
+                    return failed
+                        ||next_unit_index>=units.size()
+                        ||!free_blocks.empty();
+                });
+                if(failed||next_unit_index>=units.size()){
+                    return;
+                }
+                block=free_blocks.back();
+                free_blocks.pop_back();
+                unit_index=next_unit_index++;
+            }
+            Encoded encoded={};
+            try{
+                auto const& unit=units[unit_index];
+                auto const& item=items[unit.item_index];
+                if(unit.bytes>0&&!unit.hole){
+                    ::fgwsz::File file(
+                        item.file_path_string
+                        ,::fgwsz::FileMode::read
+                    );
+                    if(unit.bytes!=file.read_at(
+                        block+::fgwsz::frame_head_bytes
+                        ,unit.bytes
+                        ,unit.offset
+                    )){
+                        FGWSZ_THROW_WHAT(
+                            "file read incomplete: "+file.path_string()
+                        );
+                    }
+                    //绕过页缓存时丢弃这个单元的页缓存
+                    //(跨越单元边界的大页在写入文件的最后一个单元之后丢弃)
+                    if(this->direct_io_
+                        &&item.content_bytes>=this->direct_min_bytes_
+                    ){
+                        file.drop_cache(unit.offset,unit.bytes);
+                    }
+                }
+                encoded=this->encode_unit(item,unit,block,scratch);
+            }catch(...){
+                fail(::std::current_exception());
+                return;
+            }
+            {
+                ::std::lock_guard<::std::mutex> lock(mutex);
+                slots[unit_index%block_count]={block,encoded,true};
+            }
+            ready_condition.notify_one();
+        }
+    };
+    ::std::vector<::std::thread> threads;
+    threads.reserve(this->thread_count_);
+    for(::std::size_t index=0;index<this->thread_count_;++index){
+        threads.emplace_back(reader,scratches[index]);
+    }
+    //写入线程(当前线程):按单元编号顺序写入文件头和文件内容
+    try{
+        for(::std::size_t unit_index=0;unit_index<units.size();++unit_index){
+            char* block=nullptr;
+            Encoded encoded={};
+            {
+                ::std::unique_lock<::std::mutex> lock(mutex);
+                auto& slot=slots[unit_index%block_count];
+                ready_condition.wait(lock,[&](void){
+                    return failed||slot.ready;
+                });
+                if(failed){
+                    break;
+                }
+                block=slot.block;
+                encoded=slot.encoded;
+                slot.ready=false;
+            }
+            auto const& unit=units[unit_index];
+            auto const& item=items[unit.item_index];
+            this->pack_unit(item,unit,encoded);
+            //绕过页缓存时文件的所有单元都已读取,丢弃整个文件剩余的页缓存
+            //(只是优化,文件无法打开时忽略)
+            if(this->direct_io_
+                &&item.content_bytes>=this->direct_min_bytes_
+                &&unit.offset+unit.bytes==item.content_bytes
+            ){
+                try{
+                    ::fgwsz::File(
+                        item.file_path_string
+                        ,::fgwsz::FileMode::read
+                    ).drop_cache(0,0);
+                }catch(...){}
+            }
+            {
+                ::std::lock_guard<::std::mutex> lock(mutex);
+                free_blocks.push_back(block);
+            }
+            free_condition.notify_one();
+        }
+    }catch(...){
+        fail(::std::current_exception());
+    }
+    for(auto& thread:threads){
+        thread.join();
+    }
+    if(nullptr!=exception){
+        ::std::rethrow_exception(exception);
+    }
+}
+void Packer::pack_items_uring(::std::vector<Item> const& items){
+    auto const units=this->make_units(items);
+    //同时进行的读取请求数等于块的数量,读取单元按编号使用块:
+    //未写入的单元编号都位于[正在等待写入的单元编号,正在等待写入的单元编号+块数量)范围内
+    ::std::size_t block_count=this->block_count(32,units.size());
+    if(block_count>4096){
+        block_count=4096;
+    }
+    //压缩时在完成事件中交换块和压缩输出块
+    ::std::vector<::std::unique_ptr<char[]>> buffers;
+    ::std::vector<char*> blocks;
+    for(::std::size_t index=0;index<block_count;++index){
+        buffers.push_back(::std::make_unique<char[]>(this->block_capacity_));
+        blocks.push_back(buffers.back().get());
+    }
+    char* scratch=this->scratch_.get();
+    ::std::vector<bool> ready(block_count,false);
+    ::std::vector<Encoded> encoded(block_count,Encoded{nullptr,0,false,0});
+    //每个文件项第一个读取单元的编号
+    ::std::vector<::std::size_t> first_units(items.size());
+    for(::std::size_t index=units.size();index>0;--index){
+        first_units[units[index-1].item_index]=index-1;
+    }
+    //窗口内的文件最多有块数量个,每个文件同时只有打开或关闭中的一个请求
+    ::fgwsz::IoRing ring;
+    if(!ring.init(static_cast<unsigned>(3*block_count))){
+        FGWSZ_THROW_WHAT("failed to initialize io_uring");
+    }
+    constexpr ::std::uint8_t open_operation=1;
+    constexpr ::std::uint8_t read_operation=2;
+    constexpr ::std::uint8_t close_operation=3;
+    ::std::vector<int> fds(items.size(),-1);
+    auto handle=[&](::fgwsz::IoCompletion const& completion){
+        ::std::size_t const index=
+            static_cast<::std::size_t>(completion.index());
+        if(open_operation==completion.operation()){
+            if(completion.result<0){
+                FGWSZ_THROW_WHAT(
+                    "failed to open file: "+items[index].file_path_string
+                    +": "+::fgwsz::io_error_message(completion.result)
+                );
+            }
+            fds[index]=completion.result;
+        }else if(read_operation==completion.operation()){
+            auto const& unit=units[index];
+            auto const& item=items[unit.item_index];
+            if(completion.result<0){
+                FGWSZ_THROW_WHAT(
+                    "file read error: "+item.file_path_string
+                    +": "+::fgwsz::io_error_message(completion.result)
+                );
+            }
+            if(static_cast<::std::uint64_t>(completion.result)!=unit.bytes){
+                FGWSZ_THROW_WHAT(
+                    "file read incomplete: "+item.file_path_string
+                );
+            }
+            //在其他请求进行的同时压缩和混淆已读取的块
+            encoded[index%block_count]=this->encode_unit(
+                item
+                ,unit
+                ,blocks[index%block_count]
+                ,scratch
+            );
+            ready[index%block_count]=true;
+        }else if(completion.result<0){
+            FGWSZ_THROW_WHAT(
+                "failed to close file: "+items[index].file_path_string
+                +": "+::fgwsz::io_error_message(completion.result)
+            );
+        }
+    };
+    ::fgwsz::IoCompletion completion={};
+    //提交所有请求并等待至少一个请求完成
+    auto wait=[&](void){
+        ring.submit(1);
+        while(ring.peek(completion)){
+            handle(completion);
+        }
+    };
+    //准备请求之前保证队列中有空间
+    auto reserve=[&](void){
+        while(0==ring.space()){
+            wait();
+        }
+    };
+    ::std::size_t next_open_index=0;
+    ::std::size_t next_read_index=0;
+    ::std::size_t next_write_index=0;
+    try{
+        while(next_write_index<units.size()){
+            ::std::size_t const window_end=
+                (units.size()-next_write_index)<block_count
+                ?units.size():next_write_index+block_count;
+            //打开窗口内的文件
+            while(next_open_index<items.size()
+                &&first_units[next_open_index]<window_end
+            ){
+                //基准包中的文件项和引用文件项不需要打开文件
+                if(nullptr!=items[next_open_index].base_entry
+                    ||items[next_open_index].reference
+                ){
+                    ++next_open_index;
+                    continue;
+                }
+                reserve();
+                ring.prepare_openat(
+                    items[next_open_index].file_path_string.c_str()
+                    ,::fgwsz::FileMode::read
+                    ,::fgwsz::io_user_data(open_operation,next_open_index)
+                );
+                ++next_open_index;
+            }
+            //按编号顺序为窗口内已打开文件的读取单元提交读取请求
+            while(next_read_index<window_end){
+                auto const& unit=units[next_read_index];
+                int const fd=fds[unit.item_index];
+                if(fd<0
+                    &&nullptr==items[unit.item_index].base_entry
+                    &&!items[unit.item_index].reference
+                ){
+                    break;
+                }
+                if(0==unit.bytes||unit.hole){
+                    encoded[next_read_index%block_count]=this->encode_unit(
+                        items[unit.item_index]
+                        ,unit
+                        ,blocks[next_read_index%block_count]
+                        ,scratch
+                    );
+                    ready[next_read_index%block_count]=true;
+                }else{
+                    reserve();
+                    ring.prepare_read(
+                        fd
+                        ,blocks[next_read_index%block_count]
+                            +::fgwsz::frame_head_bytes
+                        ,static_cast<::std::uint32_t>(unit.bytes)
+                        ,unit.offset
+                        ,::fgwsz::io_user_data(read_operation,next_read_index)
+                    );
+                }
+                ++next_read_index;
+            }
+            //写入线程(当前线程):按单元编号顺序写入文件头和文件内容
+            bool written=false;
+            while(next_write_index<next_read_index
+                &&ready[next_write_index%block_count]
+            ){
+                auto const& unit=units[next_write_index];
+                auto const& item=items[unit.item_index];
+                this->pack_unit(
+                    item
+                    ,unit
+                    ,encoded[next_write_index%block_count]
+                );
+                ready[next_write_index%block_count]=false;
+                //文件内容已经全部读取,关闭文件
+                if(unit.offset+unit.bytes==item.content_bytes
+                    &&nullptr==item.base_entry
+                    &&!item.reference
+                ){
+                    reserve();
+                    ring.prepare_close(
+                        fds[unit.item_index]
+                        ,::fgwsz::io_user_data(close_operation,unit.item_index)
+                    );
+                    fds[unit.item_index]=-1;
+                }
+                ++next_write_index;
+                written=true;
+            }
+            if(!written){
+                wait();
+            }
+        }
+        //等待所有关闭请求完成
+        while(ring.in_flight()>0){
+            wait();
+        }
+    }catch(...){
+        //等待所有进行中的请求完成之后才能释放块,并关闭已打开的文件
+        try{
+            while(ring.in_flight()>0){
+                ring.submit(1);
+                while(ring.peek(completion)){
+                    if(open_operation==completion.operation()
+                        &&completion.result>=0
+                    ){
+                        fds[completion.index()]=completion.result;
+                    }
+                }
+            }
+            for(::std::size_t index=0;index<fds.size();++index){
+                if(fds[index]>=0){
+                    if(0==ring.space()){
+                        ring.submit(1);
+                        while(ring.peek(completion)){}
+                    }
+                    ring.prepare_close(
+                        fds[index]
+                        ,::fgwsz::io_user_data(close_operation,index)
+                    );
+                }
+            }
+            while(ring.in_flight()>0){
+                ring.submit(1);
+                while(ring.peek(completion)){}
+            }
+        }catch(...){}
+        throw;
     }
 }
 void Packer::pack_paths(::std::vector<::std::filesystem::path> const& paths){
+    if(this->index_packed_){
+        FGWSZ_THROW_WHAT(
+            "package index is already packed: "+this->package_path_string_
+        );
+    }
+    //先按目录读取顺序遍历所有文件,再打包
+    //多线程打包时多个线程并行读取同一层的目录,遍历结果的顺序不变
+    ::std::vector<::fgwsz::WalkedFile> files;
     for(auto const& path:paths){
-        this->pack_path(path);
+        for(auto& file: ::fgwsz::walk_path(path,this->thread_count_)){
+            files.push_back(::std::move(file));
+        }
+    }
+    this->pack_files(::std::move(files));
+}
+void Packer::pack_files(::std::vector<::fgwsz::WalkedFile>&& files){
+    if(this->index_packed_){
+        FGWSZ_THROW_WHAT(
+            "package index is already packed: "+this->package_path_string_
+        );
+    }
+    bool const use_io_uring=this->thread_count_<=1
+        &&!this->direct_io_
+        &&::fgwsz::use_io_uring(this->io_backend_);
+    //按遍历顺序生成所有文件项(同时按相同顺序生成key),再打包
+    //文件项包含需要读取的总字节数(用于报告进度)
+    ::std::vector<Item> items;
+    items.reserve(files.size());
+    for(auto& file:files){
+        items.push_back(this->make_item(::std::move(file)));
     }
+    files.clear();
+    if(this->dedup_){
+        this->dedup_items(items);
+    }
+    ::std::uint64_t total_bytes=0;
+    for(auto const& item:items){
+        total_bytes+=item.content_bytes;
+    }
+    ::fgwsz::progress_add_total(total_bytes,items.size());
+    if(this->thread_count_>1){
+        this->pack_items_parallel(items);
+    }else if(use_io_uring){
+        this->pack_items_uring(items);
+    }else{
+        for(auto const& item:items){
+            this->pack_content(item);
+        }
+    }
+    //检查点:打包路径结束
+    this->package_.flush();
+}
+void Packer::pack_packages(
+    ::std::vector<::std::filesystem::path> const& package_paths
+    ,::fgwsz::DuplicatePolicy duplicates
+){
+    if(this->index_packed_){
+        FGWSZ_THROW_WHAT(
+            "package index is already packed: "+this->package_path_string_
+        );
+    }
+    //只读取每个包的索引区(没有索引区时扫描所有文件头),检查所有文件项的边界
+    ::std::vector<::std::unique_ptr<::fgwsz::Unpacker>> sources;
+    ::std::vector<::fgwsz::File> source_files(package_paths.size());
+    for(::std::size_t index=0;index<package_paths.size();++index){
+        if(::fgwsz::is_stream_path(package_paths[index])){
+            FGWSZ_THROW_WHAT("merged package can't be a stream");
+        }
+        sources.push_back(
+            ::std::make_unique<::fgwsz::Unpacker>(package_paths[index])
+        );
+        sources.back()->entries();
+        source_files[index].open(
+            package_paths[index]
+            ,::fgwsz::FileMode::read
+        );
+    }
+    //按duplicates选择每个相对路径保留的文件项(包的序号和文件项的序号)
+    ::std::unordered_map<
+        ::std::string_view
+        ,::std::pair<::std::size_t,::std::size_t>
+    > chosen_entries;
+    for(::std::size_t index=0;index<sources.size();++index){
+        auto const& entries=sources[index]->entries();
+        for(::std::size_t entry_index=0
+            ;entry_index<entries.size()
+            ;++entry_index
+        ){
+            auto const [iter,inserted]=chosen_entries.try_emplace(
+                entries[entry_index].header.relative_path_string
+                ,index
+                ,entry_index
+            );
+            if(inserted
+                ||::fgwsz::DuplicatePolicy::keep_first==duplicates
+            ){
+                continue;
+            }
+            if(::fgwsz::DuplicatePolicy::error==duplicates){
+                FGWSZ_THROW_WHAT(
+                    "duplicate relative path: "
+                    +entries[entry_index].header.relative_path_string
+                );
+            }
+            iter->second={index,entry_index};
+        }
+    }
+    ::std::vector<::std::vector<bool>> kept(sources.size());
+    for(::std::size_t index=0;index<sources.size();++index){
+        kept[index].resize(sources[index]->entries().size(),false);
+    }
+    ::std::uint64_t total_bytes=0;
+    for(auto const& [relative_path,position]:chosen_entries){
+        kept[position.first][position.second]=true;
+        auto const& entry=sources[position.first]->entries()[position.second];
+        total_bytes+=::fgwsz::record_end(entry)-entry.record_offset;
+    }
+    ::fgwsz::progress_add_total(total_bytes,chosen_entries.size());
+    chosen_entries.clear();
+    for(::std::size_t index=0;index<sources.size();++index){
+        auto& source=*sources[index];
+        auto const& entries=source.entries();
+        //文件项复制之后在entries_中的位置(用于改写引用文件项)
+        //(没有复制的文件项为entries.size())
+        ::std::vector<::std::size_t> packed_indexes(
+            entries.size()
+            ,entries.size()
+        );
+        //首尾相接的保留文件项[first,last)合并为一次复制
+        ::std::size_t first=0;
+        ::std::size_t last=0;
+        auto const pack_run=[&](void){
+            if(first==last){
+                return;
+            }
+            for(auto run_index=first;run_index<last;++run_index){
+                packed_indexes[run_index]=
+                    this->entries_.size()+(run_index-first);
+            }
+            this->pack_copied_entries(
+                source_files[index]
+                ,entries.data()+first
+                ,entries.data()+last
+            );
+            ::fgwsz::progress_add(
+                ::fgwsz::record_end(entries[last-1])
+                    -entries[first].record_offset
+                ,0
+            );
+            first=last;
+        };
+        for(::std::size_t entry_index=0
+            ;entry_index<entries.size()
+            ;++entry_index
+        ){
+            auto const& entry=entries[entry_index];
+            if(!kept[index][entry_index]){
+                pack_run();
+                continue;
+            }
+            if(!entry.header.reference){
+                //与上一个保留文件项不相接时开始新的一段
+                if(first==last
+                    ||::fgwsz::record_end(entries[last-1])!=entry.record_offset
+                ){
+                    pack_run();
+                    first=entry_index;
+                }
+                last=entry_index+1;
+                continue;
+            }
+            pack_run();
+            //被引用的文件项总是在引用文件项之前
+            auto const& target=source.resolve_entry(entry);
+            auto const target_index=
+                static_cast<::std::size_t>(&target-entries.data());
+            if(entries.size()!=packed_indexes[target_index]){
+                Item item={};
+                item.key=entry.header.key;
+                item.relative_path_string=entry.header.relative_path_string;
+                item.has_source=entry.has_source;
+                item.source_write_time=entry.source_write_time;
+                item.source_bytes=entry.source_bytes;
+                item.reference=true;
+                item.reference_index=packed_indexes[target_index];
+                this->pack_reference(item);
+            }else{
+                //之后引用同一个文件项的引用文件项引用这次复制的文件项
+                this->pack_resolved_entry(source_files[index],target,entry);
+                packed_indexes[target_index]=this->entries_.size()-1;
+                ::fgwsz::progress_add(
+                    ::fgwsz::record_end(this->entries_.back())
+                        -this->entries_.back().record_offset
+                    ,0
+                );
+            }
+            packed_indexes[entry_index]=this->entries_.size()-1;
+        }
+        pack_run();
+    }
+    //检查点:合并包结束
+    this->package_.flush();
+}
+void Packer::pack_memory(
+    ::std::string const& relative_path_string
+    ,void const* data
+    ,::std::uint64_t bytes
+){
+    if(this->index_packed_){
+        FGWSZ_THROW_WHAT(
+            "package index is already packed: "+this->package_path_string_
+        );
+    }
+    if(relative_path_string.empty()){
+        FGWSZ_THROW_WHAT("relative path is empty");
+    }
+    ::fgwsz::path_assert_is_safe_relative_path(relative_path_string);
+    Item item={};
+    //内存中的内容没有文件路径,抛出异常时显示相对路径
+    item.file_path_string=relative_path_string;
+    //空内容也使用非空指针,与需要读取的文件区分
+    item.data=nullptr!=data?static_cast<char const*>(data):"";
+    item.key=
+        static_cast<::std::uint8_t>(::fgwsz::random<unsigned short>(1,255));
+    item.relative_path_string=relative_path_string;
+    item.content_bytes=bytes;
+    ::fgwsz::progress_add_total(bytes,1);
+    this->pack_content(item);
+}
+void Packer::set_thread_count(::std::size_t thread_count){
+    this->thread_count_=0==thread_count
+        ?::fgwsz::default_thread_count():thread_count;
+}
+void Packer::set_memory_bytes(::std::uint64_t memory_bytes){
+    this->memory_bytes_=memory_bytes;
+}
+void Packer::set_io_backend(::fgwsz::IoBackend io_backend){
+    this->io_backend_=io_backend;
+}
+void Packer::set_direct_io(bool direct_io){
+    this->direct_io_=direct_io;
+    if(!this->streaming_){
+        this->package_.set_direct(direct_io);
+    }
+}
+void Packer::set_base(::std::filesystem::path const& base_path){
+    if(::fgwsz::is_stream_path(base_path)){
+        FGWSZ_THROW_WHAT("base package can't be a stream");
+    }
+    this->base_=::std::make_unique<::fgwsz::Unpacker>(base_path);
+    //包含索引区时只读取索引区,否则扫描所有文件头
+    this->base_->entries();
+    this->base_file_.open(base_path,::fgwsz::FileMode::read);
+}
+void Packer::set_dedup(bool dedup){
+    this->dedup_=dedup;
+}
+void Packer::pack_shard_head(
+    ::std::uint64_t shard_index
+    ,::std::uint64_t shard_count
+){
+    if(0!=this->package_count_bytes_||shard_index>=shard_count){
+        FGWSZ_THROW_WHAT(
+            "failed to pack shard head: "+this->package_path_string_
+        );
+    }
+    this->pack_control(::fgwsz::control_shard_head);
+    ::std::uint8_t const key=
+        static_cast<::std::uint8_t>(::fgwsz::random<unsigned short>(1,255));
+    //将shard index和shard count转换为网络序,使用key进行xor混淆之后写入包
+    ::std::uint64_t fields[2]={
+        ::fgwsz::host_to_net(shard_index)
+        ,::fgwsz::host_to_net(shard_count)
+    };
+    ::fgwsz::key_xor(fields,sizeof(fields),key);
+    this->package_write(&key,sizeof(key));
+    this->package_write(fields,sizeof(fields));
+}
+void Packer::set_codec(::std::uint8_t codec){
+    if(::fgwsz::codec_none!=codec&&nullptr==::fgwsz::find_codec(codec)){
+        FGWSZ_THROW_WHAT(::std::format("unsupported codec {}",codec));
+    }
+    this->codec_=codec;
+    if(::fgwsz::codec_none!=this->codec_&&nullptr==this->scratch_){
+        this->scratch_=::std::make_unique<char[]>(this->block_capacity_);
+    }
+}
+void Packer::pack_index(void){
+    if(this->index_packed_){
+        FGWSZ_THROW_WHAT(
+            "package index is already packed: "+this->package_path_string_
+        );
+    }
+    ::std::uint64_t const index_offset=this->package_count_bytes_;
+    //先在内存中拼接整个索引区,再一次性写入包
+    ::std::string index;
+    auto append_u8=[&index](::std::uint8_t value){
+        index.push_back(static_cast<char>(value));
+    };
+    auto append_u64=[&index](::std::uint64_t value){
+        value=::fgwsz::host_to_net(value);
+        char bytes[sizeof(value)];
+        ::std::memcpy(bytes,&value,sizeof(value));
+        index.append(bytes,sizeof(value));
+    };
+    //记录区结束标记
+    append_u8(::fgwsz::control_byte);
+    append_u8(::fgwsz::control_end_of_records);
+    //索引密钥
+    ::std::uint8_t const index_key=
+        static_cast<::std::uint8_t>(::fgwsz::random<unsigned short>(1,255));
+    append_u8(index_key);
+    ::std::uint64_t const mix_begin=index.size();
+    //索引项
+    append_u64(this->entries_.size());
+    for(auto const& entry:this->entries_){
+        append_u64(entry.record_offset);
+        //以控制序列开头的文件项在索引项中记录控制类型
+        bool const compressed=entry.header.framed;
+        if(compressed||entry.header.has_checksum){
+            append_u8(::fgwsz::control_byte);
+            append_u8(
+                (compressed?::fgwsz::control_compressed_record:0)
+                |(entry.header.has_checksum
+                    ?::fgwsz::control_checksum_record:0)
+                |(entry.header.reference
+                    ?::fgwsz::control_reference_record:0)
+            );
+        }
+        if(compressed){
+            append_u8(entry.header.codec);
+            append_u64(entry.header.original_bytes);
+        }
+        if(entry.header.reference){
+            append_u64(entry.header.reference_offset);
+            append_u64(entry.header.original_bytes);
+        }
+        append_u8(entry.header.key);
+        append_u64(entry.header.relative_path_bytes);
+        index.append(entry.header.relative_path_string);
+        append_u64(entry.header.content_bytes);
+    }
+    //源文件信息(增量打包时用于判断文件是否改变)
+    append_u64(this->entries_.size());
+    for(auto const& entry:this->entries_){
+        append_u64(static_cast<::std::uint64_t>(entry.has_source
+            ?entry.source_write_time: ::fgwsz::source_write_time_unknown
+        ));
+        append_u64(entry.has_source?entry.source_bytes:0);
+    }
+    //使用index key对索引项和源文件信息进行xor混淆
+    ::fgwsz::key_xor(
+        index.data()+mix_begin
+        ,index.size()-mix_begin
+        ,index_key
+    );
+    //索引区尾部(不混淆,用于定位索引区)
+    append_u64(index_offset);
+    index.append(::fgwsz::index_magic,sizeof(::fgwsz::index_magic));
+    this->package_write(index.data(),index.size());
+    //检查点:写入索引区结束
+    this->package_.flush();
+    this->index_packed_=true;
 }
 
 }//namespace fgwsz
@@ -1,53 +1,251 @@
 #ifndef FGWSZ_PACKER_H
 #define FGWSZ_PACKER_H
 
+#include<cstdint>   //::std::uint8_t ::std::int64_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
+
 #include<string>    //::std::string
 #include<filesystem>//::std::filesystem
-#include<fstream>   //::std::ofstream ::std::ifstream
 #include<vector>    //::std::vector
 #include<memory>    //::std::unique_ptr
+#include<unordered_map>//::std::unordered_map
 
 #include"fgwsz_header.h"
+#include"fgwsz_format.h"
+#include"fgwsz_writer.h"
+#include"fgwsz_uring.h"
+#include"fgwsz_file.h"
+#include"fgwsz_unpacker.h"
+#include"fgwsz_package_reader.h"
+#include"fgwsz_mmap.h"
+#include"fgwsz_walker.h"
+#include"fgwsz_stream.h"
 
 namespace fgwsz{
 
+//打开包的方式
+enum class PackMode{
+    create, //创建新包(包已存在时覆盖)
+    append  //在已有包的最后一个文件项之后追加新的文件项
+};
+//合并包时相对路径重复的文件项的处理方式
+enum class DuplicatePolicy{
+    keep_first, //只保留第一次出现的文件项
+    keep_last,  //只保留最后一次出现的文件项(与解包时保留的文件相同)
+    error       //抛出异常
+};
+
 class Packer{
 public:
-    //生命周期
-    Packer(::std::filesystem::path const& package_path);
+    //生命周期(包路径为"-"时写入标准输出)
+    //追加方式打开时先校验已有的包,再去掉包尾部的索引区,已有的文件项不会被重写
+    //追加过程中抛出异常时,析构函数把包恢复为追加之前的内容
+    Packer(
+        ::std::filesystem::path const& package_path
+        ,::fgwsz::PackMode mode=::fgwsz::PackMode::create
+    );
+    //写入已经打开的文件(例如文件描述符),与标准输出相同只顺序写入
+    explicit Packer(::fgwsz::File&& package);
+    //写入回调(例如追加到内存缓冲区),包内容按顺序分块传入
+    explicit Packer(::fgwsz::WriteFunction write);
     ~Packer(void);
     //打包多个路径(目录/文件)到包
     void pack_paths(::std::vector<::std::filesystem::path> const& paths);
+    //按顺序打包已经遍历的文件(例如分片打包时分配给这个包的文件)
+    void pack_files(::std::vector<::fgwsz::WalkedFile>&& files);
+    //打包内存中的内容为相对路径为relative_path_string的文件项
+    //(只在调用期间读取内容,不复制整个内容,只使用当前线程)
+    void pack_memory(
+        ::std::string const& relative_path_string
+        ,void const* data
+        ,::std::uint64_t bytes
+    );
+    //合并多个包:按顺序把每个包中的文件项原样复制到这个包,不解码文件内容
+    //(只读取文件头或者索引区,包内相邻的文件项一次复制,支持时使用copy_file_range)
+    //这些包中相对路径重复的文件项按duplicates处理;引用文件项改写为引用复制之后的位置,
+    //被引用的文件项没有保留时以引用文件项的相对路径复制被引用的文件项
+    //(包路径不能为"-")
+    void pack_packages(
+        ::std::vector<::std::filesystem::path> const& package_paths
+        ,::fgwsz::DuplicatePolicy duplicates=::fgwsz::DuplicatePolicy::keep_last
+    );
+    //在包尾部写入索引区(写入后不能再打包新的路径)
+    void pack_index(void);
+    //设置打包使用的读取线程数(0表示使用硬件并发线程数)
+    //多于1个线程时,多个读取线程并行读取和混淆文件内容,由当前线程按顺序写入包
+    //使用相同的随机数种子时,打包结果与单线程打包的结果逐字节相同
+    void set_thread_count(::std::size_t thread_count);
+    //设置多线程或io_uring打包时缓存文件内容的内存上限
+    //(0表示多线程时每个读取线程4个块,io_uring时32个块)
+    void set_memory_bytes(::std::uint64_t memory_bytes);
+    //设置单线程打包时的I/O后端
+    //使用io_uring时同时进行多个文件的打开,读取和关闭,在等待I/O的同时混淆已读取的块
+    void set_io_backend(::fgwsz::IoBackend io_backend);
+    //设置读写时是否绕过页缓存(不使用io_uring,流式写入的包忽略)
+    //包文件使用直接I/O(O_DIRECT)写入,不支持时按窗口回写并丢弃页缓存,
+    //不小于4MB的输入文件读取之后丢弃已读取部分的页缓存
+    void set_direct_io(bool direct_io);
+    //设置文件内容的压缩编码(codec_none表示不压缩,编号不存在时抛出异常)
+    //文件内容按帧独立压缩,多线程打包时多个读取线程并行压缩不同的帧
+    //单帧的文件压缩后不能变小时保存为不压缩的文件项,多帧的文件逐帧保存原始内容
+    //(稀疏文件不论是否压缩都按帧保存,空洞只保存帧头)
+    void set_codec(::std::uint8_t codec);
+    //设置增量打包的基准包(包路径不能为"-")
+    //文件的相对路径在基准包中存在,且修改时间和字节数与基准包索引区中记录的
+    //源文件信息都相同时,直接从基准包复制原来的文件项(不读取文件,保留原来的key和压缩编码)
+    //(基准包不含索引区或者索引区中没有源文件信息时,所有文件都重新读取打包)
+    void set_base(::std::filesystem::path const& base_path);
+    //设置是否对整个文件的内容去重
+    //内容字节数与其他文件相同的文件先计算内容的CRC32C,校验和相同时再逐字节比较,
+    //与之前打包的文件内容相同的文件保存为引用第一份文件的文件项(不读取和写入内容)
+    //只在这个Packer打包的文件之间去重(内存中的内容,稀疏文件和从基准包复制的文件除外),
+    //追加时还与包内已有的文件项去重(只解码内容字节数与新文件相同的已有文件项)
+    void set_dedup(bool dedup);
+    //写入分片头:包是shard_count个分片包中的第shard_index个(分片打包时使用)
+    //只能在写入任何文件项之前调用
+    void pack_shard_head(::std::uint64_t shard_index,::std::uint64_t shard_count);
     //禁止拷贝
     Packer(Packer const&)noexcept=delete;
     Packer& operator=(Packer const&)noexcept=delete;
 private:
+    //待打包的文件项
+    struct Item{
+        ::std::string file_path_string;
+        //内存中的文件内容(nullptr表示读取文件)
+        char const* data;
+        ::std::string relative_path_string;
+        ::std::uint8_t key;
+        ::std::uint64_t content_bytes;
+        //源文件的修改时间和字节数(记录在索引区中,内存中的内容没有源文件信息)
+        bool has_source;
+        ::std::int64_t source_write_time;
+        ::std::uint64_t source_bytes;
+        //基准包中可以直接复制的文件项(nullptr表示读取文件打包)
+        ::fgwsz::Entry const* base_entry;
+        //是否为至少有一整帧空洞的稀疏文件,以及文件中保存数据的范围
+        //稀疏文件总是保存为压缩文件项,完全位于空洞中的帧保存为空洞帧
+        bool sparse;
+        ::std::vector<::fgwsz::FileExtent> data_extents;
+        //是否保存为引用文件项,以及被引用的文件项在entries_中的位置
+        //(引用文件项不读取文件,只生成一个空的读取单元)
+        bool reference;
+        ::std::size_t reference_index;
+    };
+    //去重时已打包(或者即将打包)的文件:内容的校验和,文件路径和文件项在entries_中的位置
+    //(追加之前包内已有的文件项没有文件路径,从包内解码内容进行比较)
+    struct DedupFile{
+        ::std::uint32_t checksum;
+        ::std::string file_path_string;
+        ::std::size_t entry_index;
+        bool packaged;
+    };
+    //文件内容的读取单元(每个单元最多一个块,空文件也对应一个单元)
+    struct Unit{
+        ::std::size_t item_index;
+        ::std::uint64_t offset;
+        ::std::uint64_t bytes;
+        bool hole;  //单元完全位于稀疏文件的空洞中(不需要读取)
+    };
+    //读取单元编码之后写入包的内容
+    struct Encoded{
+        char const* data;
+        ::std::uint64_t bytes;
+        bool compressed;    //文件项是否保存为压缩文件项
+        ::std::uint32_t checksum;//编码之后内容的校验和
+    };
+    void init(void);
+    void open_append(::std::filesystem::path const& package_path);
+    void restore_append(void);
     void set_read_only(void);
     void package_write(void const* src,::std::uint64_t bytes);
-    void key_xor(void* ptr,::std::uint64_t bytes);
-    void pack_key(void);
-    void pack_relative_path(
-        ::std::filesystem::path const& file_path
-        ,::std::filesystem::path const& base_dir_path
-    );
-    void pack_content_bytes(::std::filesystem::path const& file_path);
-    void pack_header(
-        ::std::filesystem::path const& file_path
-        ,::std::filesystem::path const& base_dir_path
+    void record_write(void const* src,::std::uint64_t bytes);
+    void pack_control(::std::uint8_t control);
+    void pack_key(::std::uint8_t key);
+    void pack_relative_path(::std::string const& relative_path_string);
+    void pack_content_bytes(::std::uint64_t content_bytes);
+    void pack_codec(::std::uint8_t codec,::std::uint64_t original_bytes);
+    void pack_checksum(void);
+    void pack_header(Item const& item,bool compressed);
+    Encoded encode_unit(
+        Item const& item
+        ,Unit const& unit
+        ,char*& block
+        ,char*& scratch
+    )const;
+    void pack_unit(Item const& item,Unit const& unit,Encoded const& encoded);
+    void pack_base_entry(::fgwsz::Entry const& base_entry);
+    void pack_copied_entries(
+        ::fgwsz::File const& source
+        ,::fgwsz::Entry const* first
+        ,::fgwsz::Entry const* last
     );
-    void pack_content(::std::filesystem::path const& file_path);
-    void pack_file(
-        ::std::filesystem::path const& file_path
-        ,::std::filesystem::path const& base_dir_path
+    void pack_resolved_entry(
+        ::fgwsz::File const& source
+        ,::fgwsz::Entry const& target
+        ,::fgwsz::Entry const& reference
     );
-    void pack_dir(::std::filesystem::path const& dir_path);
-    void pack_path(::std::filesystem::path const& path);
-    ::std::ofstream package_;
+    void pack_reference(Item const& item);
+    void pack_content(Item const& item);
+    Item make_item(::fgwsz::WalkedFile&& file);
+    ::fgwsz::Entry const& append_entry(::std::size_t entry_index);
+    void dedup_items(::std::vector<Item>& items);
+    ::std::vector<Unit> make_units(::std::vector<Item> const& items)const;
+    ::std::size_t block_count(
+        ::std::size_t default_block_count
+        ,::std::size_t unit_count
+    )const;
+    void pack_items_parallel(::std::vector<Item> const& items);
+    void pack_items_uring(::std::vector<Item> const& items);
+    ::fgwsz::BufferedWriter package_;
+    //是否流式写入包(标准输出,已经打开的文件或者写入回调)
+    bool streaming_;
+    //追加方式打开时,已有文件项的结束位置和其后被去掉的内容(索引区)
+    bool appending_;
+    ::std::uint64_t append_offset_;
+    ::std::string append_tail_;
+    //构造时未捕获的异常数量(析构时用于判断追加是否因为异常而中断)
+    int uncaught_exceptions_;
     ::std::string package_path_string_;
+    ::std::uint64_t package_count_bytes_;
     ::fgwsz::Header header_;
-    ::std::uint64_t content_bytes_;
-    static constexpr ::std::uint64_t block_bytes_=1024*1024;//1MB
+    ::fgwsz::Entry entry_;
+    //正在写入的文件项的校验和
+    ::std::uint32_t checksum_;
+    ::std::vector<::fgwsz::Entry> entries_;
+    bool index_packed_;
+    ::std::size_t thread_count_;
+    ::std::uint64_t memory_bytes_;
+    ::fgwsz::IoBackend io_backend_;
+    bool direct_io_;
+    //绕过页缓存时输入文件不小于这个大小才丢弃页缓存(小文件仍然保留页缓存)
+    static constexpr ::std::uint64_t direct_min_bytes_=
+        ::fgwsz::BufferedWriter::default_buffer_bytes;
+    ::std::uint8_t codec_;
+    //读取单元的大小等于帧的大小,块的前frame_head_bytes字节预留给帧头
+    static constexpr ::std::uint64_t block_bytes_=::fgwsz::frame_bytes;
+    static constexpr ::std::uint64_t block_capacity_=
+        ::fgwsz::frame_head_bytes+block_bytes_;
     ::std::unique_ptr<char[]> block_;
+    //压缩输出块(与块交换使用)
+    ::std::unique_ptr<char[]> scratch_;
+    //增量打包的基准包(用于查找文件项)和复制文件项使用的基准包文件
+    ::std::unique_ptr<::fgwsz::Unpacker> base_;
+    ::fgwsz::File base_file_;
+    //是否去重,以及内容字节数到这个字节数的已打包文件的映射
+    //内容不多于dedup_min_bytes_的文件不去重(引用文件项不会比原来的文件项更小)
+    bool dedup_;
+    static constexpr ::std::uint64_t dedup_min_bytes_=
+        ::fgwsz::reference_header_fixed_bytes
+        -::fgwsz::control_bytes-::fgwsz::header_fixed_bytes;
+    ::std::unordered_map<::std::uint64_t,::std::vector<DedupFile>> dedup_files_;
+    //追加时包内已有的可以被引用的文件项:内容字节数到其在entries_中的位置的映射
+    //(某个字节数的文件项第一次需要比较时才计算校验和并移入dedup_files_)
+    ::std::unordered_map<::std::uint64_t,::std::vector<::std::size_t>>
+        append_dedup_entries_;
+    //读取已有文件项内容时只读映射的追加之前的记录区,以及记录区中的文件项起始位置到文件项的映射
+    ::fgwsz::MappedFile append_mapping_;
+    ::std::unique_ptr<::fgwsz::PackageReader> append_reader_;
+    ::std::unordered_map<::std::uint64_t,::fgwsz::Entry const*> append_entries_;
 };
 
 }//namespace fgwsz
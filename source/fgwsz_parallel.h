@@ -0,0 +1,78 @@
+#ifndef FGWSZ_PARALLEL_H
+#define FGWSZ_PARALLEL_H
+
+#include<cstddef>   //::std::size_t
+
+#include<atomic>    //::std::atomic
+#include<exception> //::std::exception_ptr ::std::current_exception
+                    //::std::rethrow_exception
+#include<mutex>     //::std::mutex ::std::lock_guard
+#include<thread>    //::std::thread
+#include<vector>    //::std::vector
+
+//============================================================================
+//多线程并行相关
+//============================================================================
+namespace fgwsz{
+//默认线程数(硬件并发线程数,获取失败时为1)
+inline ::std::size_t default_thread_count(void){
+    auto const count=::std::thread::hardware_concurrency();
+    return 0==count?1:static_cast<::std::size_t>(count);
+}
+//使用thread_count个线程并行执行function(task_index,thread_index)
+//task_index取值范围为[0,task_count),任务按照task_index从小到大的顺序被领取
+//任意任务抛出异常时停止领取新任务,等待所有线程结束后重新抛出第一个异常
+template<typename Function_>
+inline void parallel_for(
+    ::std::size_t task_count
+    ,::std::size_t thread_count
+    ,Function_&& function
+){
+    if(thread_count>task_count){
+        thread_count=task_count;
+    }
+    if(thread_count<=1){
+        for(::std::size_t task_index=0;task_index<task_count;++task_index){
+            function(task_index,static_cast<::std::size_t>(0));
+        }
+        return;
+    }
+    ::std::atomic<::std::size_t> next_task_index=0;
+    ::std::atomic<bool> failed=false;
+    ::std::exception_ptr exception=nullptr;
+    ::std::mutex exception_mutex;
+    auto worker=[&](::std::size_t thread_index){
+        while(!failed.load(::std::memory_order_relaxed)){
+            ::std::size_t const task_index=
+                next_task_index.fetch_add(1,::std::memory_order_relaxed);
+            if(task_index>=task_count){
+                break;
+            }
+            try{
+                function(task_index,thread_index);
+            }catch(...){
+                ::std::lock_guard<::std::mutex> lock(exception_mutex);
+                if(nullptr==exception){
+                    exception=::std::current_exception();
+                }
+                failed.store(true,::std::memory_order_relaxed);
+            }
+        }
+    };
+    ::std::vector<::std::thread> threads;
+    threads.reserve(thread_count-1);
+    for(::std::size_t thread_index=1;thread_index<thread_count;++thread_index){
+        threads.emplace_back(worker,thread_index);
+    }
+    //当前线程也参与执行任务
+    worker(0);
+    for(auto& thread:threads){
+        thread.join();
+    }
+    if(nullptr!=exception){
+        ::std::rethrow_exception(exception);
+    }
+}
+}//namespace fgwsz
+
+#endif//FGWSZ_PARALLEL_H
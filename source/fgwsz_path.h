@@ -4,37 +4,48 @@
 #include<filesystem>//::std::filesystem
 
 #include"fgwsz_except.h"
+#include"fgwsz_stats.h"
 
 //============================================================================
 //路径操作相关
 //============================================================================
 namespace fgwsz{
+//路径"-"表示标准输入或者标准输出(名为"-"的文件可以使用"./-"表示)
+inline bool is_stream_path(::std::filesystem::path const& path){
+    return path=="-";
+}
 inline void path_assert_exists(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(!::std::filesystem::exists(path)){
         FGWSZ_THROW_WHAT("path doesn't exist: "+path.generic_string());
     }
 }
 inline void path_assert_not_exists(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(::std::filesystem::exists(path)){
         FGWSZ_THROW_WHAT("path does exist: "+path.generic_string());
     }
 }
 inline void path_assert_is_directory(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(!::std::filesystem::is_directory(path)){
         FGWSZ_THROW_WHAT("path isn't directory: "+path.generic_string());
     }
 }
 inline void path_assert_is_not_directory(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(::std::filesystem::is_directory(path)){
         FGWSZ_THROW_WHAT("path is directory: "+path.generic_string());
     }
 }
 inline void path_assert_is_symlink(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(!::std::filesystem::is_symlink(path)){
         FGWSZ_THROW_WHAT("path isn't symlink: "+path.generic_string());
     }
 }
 inline void path_assert_is_not_symlink(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
     if(::std::filesystem::is_symlink(path)){
         FGWSZ_THROW_WHAT("path is symlink: "+path.generic_string());
     }
@@ -83,6 +94,7 @@ inline void path_assert_is_safe_relative_path(
 inline void try_create_directories(
     ::std::filesystem::path const& path
 ){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::mkdir);
     if(!::std::filesystem::exists(path)){
         ::std::filesystem::create_directories(path);
     }
@@ -0,0 +1,150 @@
+#include"fgwsz_progress.h"
+
+#include<cstdint>   //::std::uint64_t
+
+#include<atomic>    //::std::memory_order_relaxed
+#include<chrono>    //::std::chrono
+#include<format>    //::std::format
+#include<mutex>     //::std::unique_lock
+#include<string>    //::std::string
+#include<thread>    //::std::thread
+
+namespace fgwsz{
+
+ProgressReporter::ProgressReporter(
+    ::std::ostream& stream
+    ,bool json
+    ,::std::chrono::milliseconds interval
+)
+    :stream_(stream)
+    ,json_(json)
+    ,interval_(interval)
+    ,start_(::std::chrono::steady_clock::now())
+    ,last_time_(start_)
+    ,last_bytes_(0)
+    ,last_files_(0)
+    ,stopping_(false)
+{
+    //在启动任何工作线程之前开启,之后各线程只读取开关
+    ::fgwsz::detail::progress_enabled=true;
+    this->thread_=::std::thread([this](void){
+        ::std::unique_lock<::std::mutex> lock(this->mutex_);
+        while(!this->stop_condition_.wait_for(
+            lock
+            ,this->interval_
+            ,[this](void){return this->stopping_;}
+        )){
+            this->report(false);
+        }
+    });
+}
+ProgressReporter::~ProgressReporter(void){
+    {
+        ::std::lock_guard<::std::mutex> lock(this->mutex_);
+        this->stopping_=true;
+    }
+    this->stop_condition_.notify_one();
+    this->thread_.join();
+    //析构时无法报告错误,打印失败时忽略
+    try{
+        this->report(true);
+    }catch(...){}
+    ::fgwsz::detail::progress_enabled=false;
+}
+void ProgressReporter::report(bool last){
+    constexpr auto relaxed=::std::memory_order_relaxed;
+    ::std::uint64_t const bytes=::fgwsz::detail::progress_bytes.load(relaxed);
+    ::std::uint64_t const files=::fgwsz::detail::progress_files.load(relaxed);
+    ::std::uint64_t const total_bytes=
+        ::fgwsz::detail::progress_total_bytes.load(relaxed);
+    ::std::uint64_t const total_files=
+        ::fgwsz::detail::progress_total_files.load(relaxed);
+    auto const now=::std::chrono::steady_clock::now();
+    double const elapsed=
+        ::std::chrono::duration<double>(now-this->start_).count();
+    //速度:中间的进度使用最近一段时间的速度,最后一次进度使用平均速度
+    double const seconds=last?elapsed
+        : ::std::chrono::duration<double>(now-this->last_time_).count();
+    double const bytes_per_second=seconds<=0?0
+        :static_cast<double>(bytes-(last?0:this->last_bytes_))/seconds;
+    double const files_per_second=seconds<=0?0
+        :static_cast<double>(files-(last?0:this->last_files_))/seconds;
+    this->last_time_=now;
+    this->last_bytes_=bytes;
+    this->last_files_=files;
+    //完成百分比和预计剩余时间(按平均速度)在总数已知时计算,
+    //总字节数为0(例如只有空文件)时按文件数计算
+    double percent=-1;
+    double eta=-1;
+    if(total_bytes>0){
+        percent=100.0*static_cast<double>(bytes)
+            /static_cast<double>(total_bytes);
+        if(bytes>0&&bytes<=total_bytes){
+            eta=elapsed*static_cast<double>(total_bytes-bytes)
+                /static_cast<double>(bytes);
+        }
+    }else if(total_files>0){
+        percent=100.0*static_cast<double>(files)
+            /static_cast<double>(total_files);
+        if(files>0&&files<=total_files){
+            eta=elapsed*static_cast<double>(total_files-files)
+                /static_cast<double>(files);
+        }
+    }
+    if(last){
+        eta=0;
+    }
+    ::std::string text;
+    if(this->json_){
+        text=::std::format(
+            "{{\"elapsed_s\": {:.3f}, \"bytes\": {}, \"total_bytes\": {}"
+            ", \"files\": {}, \"total_files\": {}, \"percent\": {}"
+            ", \"mb_per_s\": {:.3f}, \"files_per_s\": {:.3f}, \"eta_s\": {}"
+            ", \"done\": {}}}\n"
+            ,elapsed
+            ,bytes
+            ,total_bytes
+            ,files
+            ,total_files
+            ,percent<0?"null": ::std::format("{:.2f}",percent)
+            ,bytes_per_second/1e6
+            ,files_per_second
+            ,eta<0?"null": ::std::format("{:.0f}",eta)
+            ,last?"true":"false"
+        );
+    }else{
+        text="progress:";
+        if(percent>=0){
+            text+=::std::format(" {:.1f}%",percent);
+        }
+        text+=::std::format(" {:.1f}",static_cast<double>(bytes)/1e6);
+        if(total_bytes>0){
+            text+=::std::format("/{:.1f}",static_cast<double>(total_bytes)/1e6);
+        }
+        text+=::std::format(" MB {}",files);
+        if(total_files>0){
+            text+=::std::format("/{}",total_files);
+        }
+        text+=::std::format(
+            " files, {:.1f} MB/s, {:.0f} files/s"
+            ,bytes_per_second/1e6
+            ,files_per_second
+        );
+        if(last){
+            text+=::std::format(", done in {:.1f} s",elapsed);
+        }else if(eta>=0){
+            auto const eta_seconds=static_cast<::std::uint64_t>(eta+0.5);
+            text+=::std::format(
+                ", ETA {:02}:{:02}:{:02}"
+                ,eta_seconds/3600
+                ,eta_seconds/60%60
+                ,eta_seconds%60
+            );
+        }
+        text+='\n';
+    }
+    this->stream_<<text;
+    this->stream_.flush();
+}
+
+}//namespace fgwsz
@@ -0,0 +1,91 @@
+#ifndef FGWSZ_PROGRESS_H
+#define FGWSZ_PROGRESS_H
+
+#include<cstdint>   //::std::uint64_t
+
+#include<atomic>    //::std::atomic ::std::memory_order_relaxed
+#include<chrono>    //::std::chrono
+#include<condition_variable>//::std::condition_variable
+#include<mutex>     //::std::mutex
+#include<ostream>   //::std::ostream
+#include<thread>    //::std::thread
+
+//============================================================================
+//打包/解包进度报告相关
+//============================================================================
+namespace fgwsz{
+namespace detail{
+//是否记录进度(默认关闭,关闭时更新进度只检查这个标志)
+inline bool progress_enabled=false;
+//已完成和总共的字节数与文件数(总数为0表示未知)
+inline ::std::atomic<::std::uint64_t> progress_bytes=0;
+inline ::std::atomic<::std::uint64_t> progress_files=0;
+inline ::std::atomic<::std::uint64_t> progress_total_bytes=0;
+inline ::std::atomic<::std::uint64_t> progress_total_files=0;
+}//namespace fgwsz::detail
+//更新已完成的字节数和文件数(不加锁,可以被多个线程同时调用)
+inline void progress_add(::std::uint64_t bytes,::std::uint64_t files)noexcept{
+    if(!::fgwsz::detail::progress_enabled){
+        return;
+    }
+    ::fgwsz::detail::progress_bytes.fetch_add(
+        bytes
+        ,::std::memory_order_relaxed
+    );
+    ::fgwsz::detail::progress_files.fetch_add(
+        files
+        ,::std::memory_order_relaxed
+    );
+}
+//增加总共的字节数和文件数(打包时来自遍历结果,解包时来自包的大小或者索引区)
+inline void progress_add_total(
+    ::std::uint64_t bytes
+    ,::std::uint64_t files
+)noexcept{
+    if(!::fgwsz::detail::progress_enabled){
+        return;
+    }
+    ::fgwsz::detail::progress_total_bytes.fetch_add(
+        bytes
+        ,::std::memory_order_relaxed
+    );
+    ::fgwsz::detail::progress_total_files.fetch_add(
+        files
+        ,::std::memory_order_relaxed
+    );
+}
+//是否记录进度(打包时用于决定是否先遍历所有文件得到总字节数)
+inline bool progress_enabled(void)noexcept{
+    return ::fgwsz::detail::progress_enabled;
+}
+//进度报告器:开启进度记录,由单独的线程每隔interval打印一次进度
+//(完成百分比,MB/s,files/s和预计剩余时间),析构时打印最后一次进度并结束线程
+//json为true时每次打印一行JSON
+class ProgressReporter{
+public:
+    ProgressReporter(
+        ::std::ostream& stream
+        ,bool json
+        ,::std::chrono::milliseconds interval=::std::chrono::seconds(1)
+    );
+    ~ProgressReporter(void);
+    ProgressReporter(ProgressReporter const&)noexcept=delete;
+    ProgressReporter& operator=(ProgressReporter const&)noexcept=delete;
+private:
+    void report(bool last);
+    ::std::ostream& stream_;
+    bool json_;
+    ::std::chrono::milliseconds interval_;
+    ::std::chrono::steady_clock::time_point start_;
+    //上一次打印时的时间和进度(用于计算最近一段时间的速度)
+    ::std::chrono::steady_clock::time_point last_time_;
+    ::std::uint64_t last_bytes_;
+    ::std::uint64_t last_files_;
+    ::std::mutex mutex_;
+    ::std::condition_variable stop_condition_;
+    bool stopping_;
+    ::std::thread thread_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_PROGRESS_H
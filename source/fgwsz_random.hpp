@@ -1,6 +1,8 @@
 #ifndef FGWSZ_RANDOM_HPP
 #define FGWSZ_RANDOM_HPP
 
+#include<cstdint>   //::std::uint32_t
+
 #include<random>    //::std::uniform_int_distribution ::std::random_device
                     //::std::mt19937
 
@@ -8,13 +10,23 @@
 //随机数生成相关
 //============================================================================
 namespace fgwsz{
+namespace detail{
+//当前线程的所有随机数共用的随机数引擎(默认使用随机设备生成种子)
+//每个线程使用各自的引擎,多个线程同时打包时不需要加锁
+inline ::std::mt19937& random_engine(void){
+    thread_local ::std::mt19937 gen(::std::random_device{}());
+    return gen;
+}
+}//namespace fgwsz::detail
+//设置当前线程的随机数种子(相同的种子生成相同的随机数序列)
+inline void random_seed(::std::uint32_t seed){
+    ::fgwsz::detail::random_engine().seed(seed);
+}
 //生成类型为NumberType_,取值范围为闭区间[begin,finish]的随机数
 template<typename NumberType_>
 inline NumberType_ random(NumberType_ const& begin,NumberType_ const& finish){
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<NumberType_> distrib(begin,finish);
-    return distrib(gen);
+    ::std::uniform_int_distribution<NumberType_> distrib(begin,finish);
+    return distrib(::fgwsz::detail::random_engine());
 }
 }//namespace fgwsz
 
@@ -0,0 +1,235 @@
+#include"fgwsz_reader.h"
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+#include<cstring>   //::std::memcpy
+
+#include<new>       //::operator new ::std::align_val_t
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<utility>   //::std::move
+
+namespace fgwsz{
+
+void BufferedReader::AlignedDelete::operator()(char* ptr)const noexcept{
+    ::operator delete[](
+        ptr
+        ,::std::align_val_t(::fgwsz::BufferedReader::buffer_alignment)
+    );
+}
+BufferedReader::BufferedReader(::std::uint64_t buffer_bytes)
+    :buffer_(
+        static_cast<char*>(::operator new[](
+            static_cast<::std::size_t>(buffer_bytes)
+            ,::std::align_val_t(::fgwsz::BufferedReader::buffer_alignment)
+        ))
+    )
+    ,buffer_bytes_(buffer_bytes)
+    ,begin_bytes_(0)
+    ,end_bytes_(0)
+    ,file_position_(0)
+    ,seekable_(false)
+    ,direct_(false)
+    ,drop_cache_(false)
+    ,cache_offset_(0)
+{}
+BufferedReader::~BufferedReader(void){
+    //析构时无法报告错误
+    try{
+        this->close();
+    }catch(...){}
+}
+void BufferedReader::open(::std::filesystem::path const& path){
+    this->open(::fgwsz::File(path,::fgwsz::FileMode::read));
+}
+void BufferedReader::open(::fgwsz::File&& file){
+    this->close();
+    this->read_path_string_.clear();
+    this->file_=::std::move(file);
+    this->seekable_=this->file_.is_seekable();
+}
+void BufferedReader::open(
+    ::fgwsz::ReadFunction read
+    ,::std::string path_string
+){
+    this->close();
+    this->read_=::std::move(read);
+    this->read_path_string_=::std::move(path_string);
+}
+void BufferedReader::close(void){
+    //丢弃剩余部分(到文件末尾)的页缓存
+    if(this->drop_cache_){
+        this->file_.drop_cache(this->cache_offset_,0);
+    }
+    this->direct_=false;
+    this->drop_cache_=false;
+    this->begin_bytes_=0;
+    this->end_bytes_=0;
+    this->file_position_=0;
+    this->seekable_=false;
+    this->read_=nullptr;
+    this->file_.close();
+}
+bool BufferedReader::is_open(void)const noexcept{
+    return this->file_.is_open()||nullptr!=this->read_;
+}
+::std::uint64_t BufferedReader::read_some(void* ptr,::std::uint64_t bytes){
+    return nullptr!=this->read_?this->read_(ptr,bytes)
+        :this->file_.read_some(ptr,bytes);
+}
+::std::uint64_t BufferedReader::read(void* ptr,::std::uint64_t bytes){
+    auto data=reinterpret_cast<char*>(ptr);
+    ::std::uint64_t count_bytes=0;
+    while(count_bytes<bytes){
+        //缓冲区为空且剩余内容不少于一个缓冲区时直接读取到目标内存
+        //(直接I/O只能读取到对齐的缓冲区)
+        if(this->begin_bytes_==this->end_bytes_
+            &&bytes-count_bytes>=this->buffer_bytes_
+            &&!this->direct_
+        ){
+            while(count_bytes<bytes){
+                ::std::uint64_t const read_bytes=
+                    this->read_some(data+count_bytes,bytes-count_bytes);
+                if(0==read_bytes){
+                    break;
+                }
+                this->file_position_+=read_bytes;
+                count_bytes+=read_bytes;
+            }
+            this->release_cache();
+            return count_bytes;
+        }
+        ::std::uint64_t available=0;
+        char const* block=this->fetch(available);
+        //到达文件末尾
+        if(0==available){
+            break;
+        }
+        ::std::uint64_t const copy_bytes=
+            available<(bytes-count_bytes)?available:(bytes-count_bytes);
+        ::std::memcpy(
+            data+count_bytes
+            ,block
+            ,static_cast<::std::size_t>(copy_bytes)
+        );
+        this->consume(copy_bytes);
+        count_bytes+=copy_bytes;
+    }
+    return count_bytes;
+}
+::std::uint64_t BufferedReader::skip(::std::uint64_t bytes){
+    //先跳过缓冲区中的内容
+    ::std::uint64_t count_bytes=
+        (this->end_bytes_-this->begin_bytes_)<bytes
+        ?(this->end_bytes_-this->begin_bytes_):bytes;
+    this->consume(count_bytes);
+    if(count_bytes==bytes){
+        return count_bytes;
+    }
+    //可以定位的文件直接定位到跳过之后的位置
+    if(this->seekable_){
+        this->seek(this->file_position_+(bytes-count_bytes));
+        return bytes;
+    }
+    //不能定位的文件通过缓冲区读取并丢弃
+    while(count_bytes<bytes){
+        ::std::uint64_t available=0;
+        this->fetch(available);
+        if(0==available){
+            break;
+        }
+        ::std::uint64_t const discard_bytes=
+            available<(bytes-count_bytes)?available:(bytes-count_bytes);
+        this->consume(discard_bytes);
+        count_bytes+=discard_bytes;
+    }
+    return count_bytes;
+}
+void BufferedReader::seek(::std::uint64_t offset){
+    //按位置跳转时丢弃已读取的全部内容的页缓存,从新的位置重新开始按窗口丢弃
+    if(this->drop_cache_){
+        if(this->file_position_>this->cache_offset_){
+            this->file_.drop_cache(
+                this->cache_offset_
+                ,this->file_position_-this->cache_offset_
+            );
+        }
+        this->cache_offset_=offset;
+    }
+    //直接I/O时从对齐的位置读取,跳过缓冲区中offset之前的内容
+    ::std::uint64_t const aligned_offset=!this->direct_?offset
+        :offset/::fgwsz::File::direct_alignment
+            *::fgwsz::File::direct_alignment;
+    this->file_.seek(aligned_offset);
+    this->begin_bytes_=0;
+    this->end_bytes_=0;
+    this->file_position_=aligned_offset;
+    if(aligned_offset<offset){
+        ::std::uint64_t available=0;
+        this->fetch(available);
+        this->consume(
+            (offset-aligned_offset)<available
+            ?(offset-aligned_offset):available
+        );
+    }
+}
+void BufferedReader::set_direct(bool direct){
+    if(nullptr!=this->read_||!this->seekable_){
+        return;
+    }
+    //从当前读取位置重新读取
+    ::std::uint64_t const offset=
+        this->file_position_-(this->end_bytes_-this->begin_bytes_);
+    this->begin_bytes_=0;
+    this->end_bytes_=0;
+    if(!direct){
+        if(this->direct_){
+            (void)this->file_.set_direct(false);
+        }
+        this->direct_=false;
+        this->drop_cache_=false;
+    }else if(!this->direct_&&!this->drop_cache_){
+        this->direct_=
+            0==this->buffer_bytes_% ::fgwsz::File::direct_alignment
+            &&this->file_.set_direct(true);
+        this->drop_cache_=!this->direct_;
+        this->cache_offset_=offset;
+    }
+    this->seek(offset);
+}
+void BufferedReader::release_cache(void)noexcept{
+    if(this->drop_cache_){
+        this->cache_offset_=this->file_.drop_cache_behind(
+            this->cache_offset_
+            ,this->file_position_
+        );
+    }
+}
+char const* BufferedReader::fetch(::std::uint64_t& available){
+    if(this->begin_bytes_==this->end_bytes_){
+        this->release_cache();
+        //管道中读取一次就返回,不等待缓冲区被填满
+        //直接I/O时填满缓冲区,读取到文件末尾之后位置不再对齐,不再读取
+        ::std::uint64_t const read_bytes=!this->direct_
+            ?this->read_some(this->buffer_.get(),this->buffer_bytes_)
+            :0!=this->file_position_% ::fgwsz::File::direct_alignment?0
+            :this->file_.read(this->buffer_.get(),this->buffer_bytes_);
+        this->begin_bytes_=0;
+        this->end_bytes_=read_bytes;
+        this->file_position_+=read_bytes;
+    }
+    available=this->end_bytes_-this->begin_bytes_;
+    return this->buffer_.get()+this->begin_bytes_;
+}
+void BufferedReader::consume(::std::uint64_t bytes){
+    this->begin_bytes_+=bytes;
+}
+bool BufferedReader::is_seekable(void)const noexcept{
+    return this->seekable_;
+}
+::std::string const& BufferedReader::path_string(void)const noexcept{
+    return this->read_path_string_.empty()?this->file_.path_string()
+        :this->read_path_string_;
+}
+
+}//namespace fgwsz
@@ -0,0 +1,91 @@
+#ifndef FGWSZ_READER_H
+#define FGWSZ_READER_H
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<memory>    //::std::unique_ptr
+
+#include"fgwsz_file.h"
+#include"fgwsz_stream.h"
+
+//============================================================================
+//缓冲读取相关
+//============================================================================
+namespace fgwsz{
+//带有对齐缓冲区的顺序读取器:
+//小块读取从缓冲区中拷贝,缓冲区为空时才从文件读取,文件可以是不能定位的管道
+//缓冲区为空时大块读取直接读取到目标内存,不经过缓冲区拷贝
+class BufferedReader{
+public:
+    //默认缓冲区大小
+    static constexpr ::std::uint64_t default_buffer_bytes=4*1024*1024;//4MB
+    //缓冲区对齐字节数
+    static constexpr ::std::size_t buffer_alignment=4096;
+    //生命周期(缓冲区在多次open/close之间复用)
+    explicit BufferedReader(
+        ::std::uint64_t buffer_bytes=default_buffer_bytes
+    );
+    ~BufferedReader(void);
+    //打开文件(已打开的文件会先被关闭)
+    void open(::std::filesystem::path const& path);
+    //关联已经打开的文件(例如标准输入)
+    void open(::fgwsz::File&& file);
+    //关联读取回调(与管道相同,不能定位)
+    //path_string只用于抛出异常时的信息显示
+    void open(::fgwsz::ReadFunction read,::std::string path_string);
+    void close(void);
+    bool is_open(void)const noexcept;
+    //从当前位置读取,返回实际读取的字节数(小于bytes时说明到达文件末尾)
+    ::std::uint64_t read(void* ptr,::std::uint64_t bytes);
+    //跳过bytes字节,返回实际跳过的字节数(小于bytes时说明到达文件末尾)
+    //可以定位的文件直接定位(不检查文件末尾),否则通过缓冲区读取并丢弃
+    ::std::uint64_t skip(::std::uint64_t bytes);
+    //修改当前位置(只能用于可以定位的文件)
+    void seek(::std::uint64_t offset);
+    //获取缓冲区中可以直接读取的内容(缓冲区为空时先从文件读取)
+    //available返回可读取的字节数(为0时说明到达文件末尾),
+    //读取之后调用consume提交实际读取的字节数
+    char const* fetch(::std::uint64_t& available);
+    void consume(::std::uint64_t bytes);
+    //当前打开的文件读取时是否绕过页缓存(之后打开的文件重新默认为不绕过)
+    //直接I/O时总是从对齐的位置读取整个缓冲区,不能直接I/O时改为
+    //重新填充缓冲区之前丢弃已读取内容的页缓存(读取回调和不能定位的文件忽略)
+    void set_direct(bool direct);
+    //文件是否可以定位
+    bool is_seekable(void)const noexcept;
+    //文件路径字符串(用于抛出异常时的信息显示)
+    ::std::string const& path_string(void)const noexcept;
+    //禁止拷贝
+    BufferedReader(BufferedReader const&)noexcept=delete;
+    BufferedReader& operator=(BufferedReader const&)noexcept=delete;
+private:
+    struct AlignedDelete{
+        void operator()(char* ptr)const noexcept;
+    };
+    //从文件或者读取回调读取一次
+    ::std::uint64_t read_some(void* ptr,::std::uint64_t bytes);
+    //按窗口丢弃页缓存时,丢弃已经读取的完整窗口的页缓存
+    void release_cache(void)noexcept;
+    ::fgwsz::File file_;
+    ::fgwsz::ReadFunction read_;
+    ::std::string read_path_string_;
+    ::std::unique_ptr<char[],AlignedDelete> buffer_;
+    ::std::uint64_t buffer_bytes_;
+    //缓冲区中未读取内容的范围[begin_bytes_,end_bytes_)
+    ::std::uint64_t begin_bytes_;
+    ::std::uint64_t end_bytes_;
+    //缓冲区内容结束位置对应的文件位置
+    ::std::uint64_t file_position_;
+    bool seekable_;
+    //是否直接I/O读取,是否按窗口丢弃页缓存(不能直接I/O时)
+    bool direct_;
+    bool drop_cache_;
+    //页缓存已丢弃部分的结束位置
+    ::std::uint64_t cache_offset_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_READER_H
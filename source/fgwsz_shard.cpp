@@ -0,0 +1,271 @@
+#include"fgwsz_shard.h"
+
+#include<cstdint>       //::std::uint32_t ::std::uint64_t
+#include<cstddef>       //::std::size_t
+
+#include<string>        //::std::string ::std::to_string
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<vector>        //::std::vector
+#include<unordered_map> //::std::unordered_map
+#include<algorithm>     //::std::stable_sort
+#include<limits>        //::std::numeric_limits
+#include<utility>       //::std::move
+#include<format>        //::std::format
+
+#include"fgwsz_except.h"
+#include"fgwsz_path.h"
+#include"fgwsz_random.hpp"
+#include"fgwsz_parallel.h"
+#include"fgwsz_cout.h"
+
+namespace fgwsz{
+namespace detail{
+//分配分片时每个文件额外计算的字节数(打开和创建文件的开销)
+inline constexpr ::std::uint64_t shard_file_bytes=4*1024;//4KB
+//分配分片时文件的字节数:稀疏文件的空洞打包为不占空间的空洞帧,
+//因此按分配的磁盘空间计算(不超过文件大小,分配按块向上取整)
+inline ::std::uint64_t shard_bytes(::fgwsz::WalkedFile const& file){
+    return file.allocated_bytes<file.bytes?file.allocated_bytes:file.bytes;
+}
+//检查分片数和包路径(分片包不能写入标准输出或者从标准输入读取)
+inline void shard_assert(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_count
+){
+    if(0==shard_count){
+        FGWSZ_THROW_WHAT("shard count is zero");
+    }
+    if(::fgwsz::is_stream_path(package_path)){
+        FGWSZ_THROW_WHAT(
+            "sharded package can't be a stream: "
+            +package_path.generic_string()
+        );
+    }
+}
+//检查分片包的分片头与分片序号和分片数一致
+inline void shard_assert_head(
+    ::fgwsz::Unpacker const& unpacker
+    ,::std::filesystem::path const& shard_path
+    ,::std::size_t shard_index
+    ,::std::size_t shard_count
+){
+    if(!unpacker.is_shard()){
+        FGWSZ_THROW_WHAT(
+            "package isn't a shard: "+shard_path.generic_string()
+        );
+    }
+    if(unpacker.shard_index()!=shard_index
+        ||unpacker.shard_count()!=shard_count
+    ){
+        FGWSZ_THROW_WHAT(::std::format(
+            "shard mismatch: {} is shard {} of {}, expected shard {} of {}"
+            ,shard_path.generic_string()
+            ,unpacker.shard_index()
+            ,unpacker.shard_count()
+            ,shard_index
+            ,shard_count
+        ));
+    }
+}
+//分片数为0时从第0个分片包的分片头读取分片数
+inline ::std::size_t resolve_shard_count(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_count
+){
+    if(0==shard_count&&!::fgwsz::is_stream_path(package_path)){
+        shard_count=::fgwsz::read_shard_count(package_path);
+    }
+    ::fgwsz::detail::shard_assert(package_path,shard_count);
+    return shard_count;
+}
+}//namespace detail
+
+::std::filesystem::path shard_path(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_index
+){
+    auto path=package_path;
+    path.replace_filename(
+        package_path.stem().string()
+        +"."+::std::to_string(shard_index)
+        +package_path.extension().string()
+    );
+    return path;
+}
+bool is_sharded(::std::filesystem::path const& package_path){
+    return !::fgwsz::is_stream_path(package_path)
+        &&!::std::filesystem::exists(package_path)
+        &&::std::filesystem::exists(::fgwsz::shard_path(package_path,0));
+}
+::std::size_t read_shard_count(::std::filesystem::path const& package_path){
+    auto const path=::fgwsz::shard_path(package_path,0);
+    ::fgwsz::Unpacker unpacker(path);
+    ::fgwsz::detail::shard_assert_head(
+        unpacker
+        ,path
+        ,0
+        ,static_cast<::std::size_t>(unpacker.shard_count())
+    );
+    return static_cast<::std::size_t>(unpacker.shard_count());
+}
+::std::vector<::std::vector<::fgwsz::WalkedFile>> balance_shards(
+    ::std::vector<::fgwsz::WalkedFile>&& files
+    ,::std::size_t shard_count
+){
+    if(0==shard_count){
+        FGWSZ_THROW_WHAT("shard count is zero");
+    }
+    //按字节数从大到小排序(字节数相同时保持遍历顺序,分配结果是确定的)
+    ::std::vector<::std::uint64_t> file_bytes(files.size());
+    ::std::vector<::std::size_t> order(files.size());
+    for(::std::size_t index=0;index<files.size();++index){
+        file_bytes[index]=::fgwsz::detail::shard_bytes(files[index]);
+        order[index]=index;
+    }
+    ::std::stable_sort(order.begin(),order.end(),
+        [&file_bytes](::std::size_t lhs,::std::size_t rhs){
+            return file_bytes[lhs]>file_bytes[rhs];
+        }
+    );
+    //依次分配给当前字节数最少的分片(分片数通常很少,直接线性查找)
+    ::std::vector<::std::uint64_t> shard_bytes(shard_count,0);
+    ::std::vector<::std::size_t> file_shards(files.size(),0);
+    ::std::unordered_map<::std::string_view,::std::size_t> path_shards;
+    for(auto const index:order){
+        auto const& file=files[index];
+        ::std::size_t shard_index=0;
+        if(auto const iter=path_shards.find(file.relative_path_string)
+            ;path_shards.end()!=iter
+        ){
+            shard_index=iter->second;
+        }else{
+            for(::std::size_t shard=1;shard<shard_count;++shard){
+                if(shard_bytes[shard]<shard_bytes[shard_index]){
+                    shard_index=shard;
+                }
+            }
+            path_shards.emplace(file.relative_path_string,shard_index);
+        }
+        file_shards[index]=shard_index;
+        shard_bytes[shard_index]+=
+            file_bytes[index]+::fgwsz::detail::shard_file_bytes;
+    }
+    path_shards.clear();
+    //各分片内按遍历顺序排列
+    ::std::vector<::std::vector<::fgwsz::WalkedFile>> shards(shard_count);
+    for(::std::size_t index=0;index<files.size();++index){
+        shards[file_shards[index]].push_back(::std::move(files[index]));
+    }
+    files.clear();
+    return shards;
+}
+void pack_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::vector<::std::filesystem::path> const& paths
+    ,::std::size_t shard_count
+    ,::std::function<void(::fgwsz::Packer&)> const& configure
+    ,bool pack_index
+){
+    ::fgwsz::detail::shard_assert(package_path,shard_count);
+    //所有分片共用一次遍历(分片线程同时并行读取同一层的目录)
+    ::std::vector<::fgwsz::WalkedFile> files;
+    for(auto const& path:paths){
+        for(auto& file: ::fgwsz::walk_path(path,shard_count)){
+            files.push_back(::std::move(file));
+        }
+    }
+    auto shards=::fgwsz::balance_shards(::std::move(files),shard_count);
+    //随机数引擎属于各个线程,由当前线程为每个分片依次生成种子
+    ::std::vector<::std::uint32_t> seeds(shard_count);
+    for(auto& seed:seeds){
+        seed=::fgwsz::random<::std::uint32_t>(
+            0
+            ,::std::numeric_limits<::std::uint32_t>::max()
+        );
+    }
+    ::fgwsz::parallel_for(shard_count,shard_count,
+        [&](::std::size_t shard_index,::std::size_t){
+            ::fgwsz::random_seed(seeds[shard_index]);
+            ::fgwsz::Packer packer(
+                ::fgwsz::shard_path(package_path,shard_index)
+            );
+            if(configure){
+                configure(packer);
+            }
+            packer.pack_shard_head(shard_index,shard_count);
+            packer.pack_files(::std::move(shards[shard_index]));
+            if(pack_index){
+                packer.pack_index();
+            }
+        }
+    );
+}
+void unpack_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::filesystem::path const& output_dir_path
+    ,::std::size_t shard_count
+    ,::std::vector<::std::string> const& patterns
+    ,::std::function<void(::fgwsz::Unpacker&)> const& configure
+){
+    shard_count=::fgwsz::detail::resolve_shard_count(package_path,shard_count);
+    //每个模式只需要在任意一个分片中匹配到文件
+    ::std::vector<::std::vector<bool>> matched_patterns(shard_count);
+    ::fgwsz::parallel_for(shard_count,shard_count,
+        [&](::std::size_t shard_index,::std::size_t){
+            auto const path=::fgwsz::shard_path(package_path,shard_index);
+            ::fgwsz::Unpacker unpacker(path);
+            ::fgwsz::detail::shard_assert_head(
+                unpacker
+                ,path
+                ,shard_index
+                ,shard_count
+            );
+            if(configure){
+                configure(unpacker);
+            }
+            unpacker.set_pattern_check(false);
+            unpacker.unpack_package(output_dir_path,patterns);
+            matched_patterns[shard_index]=unpacker.matched_patterns();
+        }
+    );
+    for(::std::size_t index=0;index<patterns.size();++index){
+        bool matched=false;
+        for(auto const& shard_matched:matched_patterns){
+            matched=matched||shard_matched[index];
+        }
+        if(!matched){
+            FGWSZ_THROW_WHAT("pattern matches nothing: "+patterns[index]);
+        }
+    }
+}
+bool verify_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_count
+    ,::std::function<void(::fgwsz::Unpacker&)> const& configure
+){
+    shard_count=::fgwsz::detail::resolve_shard_count(package_path,shard_count);
+    //依次校验各分片包(每个分片包的校验已经使用多个线程)
+    bool verified=true;
+    for(::std::size_t shard_index=0;shard_index<shard_count;++shard_index){
+        auto const path=::fgwsz::shard_path(package_path,shard_index);
+        ::fgwsz::Unpacker unpacker(path);
+        ::fgwsz::detail::shard_assert_head(
+            unpacker
+            ,path
+            ,shard_index
+            ,shard_count
+        );
+        if(configure){
+            configure(unpacker);
+        }
+        ::fgwsz::cout<<::std::format(
+            "shard {}: {}\n"
+            ,shard_index
+            ,path.generic_string()
+        );
+        verified=unpacker.verify_package()&&verified;
+    }
+    return verified;
+}
+}//namespace fgwsz
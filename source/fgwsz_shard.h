@@ -0,0 +1,70 @@
+#ifndef FGWSZ_SHARD_H
+#define FGWSZ_SHARD_H
+
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<vector>    //::std::vector
+#include<functional>//::std::function
+
+#include"fgwsz_walker.h"
+#include"fgwsz_packer.h"
+#include"fgwsz_unpacker.h"
+
+//============================================================================
+//分片打包/解包相关(一次打包生成多个可以独立解包的包)
+//============================================================================
+namespace fgwsz{
+//第shard_index个分片包的路径:在包路径的扩展名之前插入分片序号
+//(out.fgwsz的分片为out.0.fgwsz,out.1.fgwsz...,没有扩展名时为out.0,out.1...)
+::std::filesystem::path shard_path(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_index
+);
+//把遍历得到的文件分配到shard_count个分片,使各分片需要写入的字节数接近
+//每个文件按内容字节数(稀疏文件按分配的磁盘空间)加上4KB(打开和创建文件的开销)计算,
+//按从大到小的顺序依次分配给当前字节数最少的分片,各分片内保持遍历顺序
+//相对路径相同的文件分配到同一个分片,解包时仍然保留最后出现的文件
+//包路径是否指分片包:包路径本身不存在,而第0个分片包存在
+bool is_sharded(::std::filesystem::path const& package_path);
+//分片包的个数:读取第0个分片包的分片头(不是分片包时抛出异常)
+::std::size_t read_shard_count(::std::filesystem::path const& package_path);
+::std::vector<::std::vector<::fgwsz::WalkedFile>> balance_shards(
+    ::std::vector<::fgwsz::WalkedFile>&& files
+    ,::std::size_t shard_count
+);
+//遍历所有路径之后分片打包:每个分片由各自线程上的Packer写入各自的包
+//(分片包路径由shard_path得到,不能为"-")
+//configure在打包之前设置每个分片的Packer(例如线程数,压缩编码和去重)
+//各分片的key使用当前线程的随机数引擎依次生成的种子,相同种子的打包结果相同
+//任意分片失败时等待其他分片结束后重新抛出第一个异常
+void pack_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::vector<::std::filesystem::path> const& paths
+    ,::std::size_t shard_count
+    ,::std::function<void(::fgwsz::Packer&)> const& configure
+    ,bool pack_index=true
+);
+//分片解包:每个分片由各自线程上的Unpacker解包到同一个输出目录
+//shard_count为0时从第0个分片包的分片头读取分片数,
+//任意分片包的分片头与分片序号和分片数不一致时抛出异常
+//patterns不为空时每个分片只解包匹配的文件
+//configure在解包之前设置每个分片的Unpacker(例如线程数和I/O后端)
+void unpack_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::filesystem::path const& output_dir_path
+    ,::std::size_t shard_count
+    ,::std::vector<::std::string> const& patterns
+    ,::std::function<void(::fgwsz::Unpacker&)> const& configure
+);
+//依次校验所有分片包的校验和(分片数和分片头的检查与分片解包相同)
+//configure在校验之前设置每个分片的Unpacker,全部通过时返回true
+bool verify_shards(
+    ::std::filesystem::path const& package_path
+    ,::std::size_t shard_count
+    ,::std::function<void(::fgwsz::Unpacker&)> const& configure
+);
+}//namespace fgwsz
+
+#endif//FGWSZ_SHARD_H
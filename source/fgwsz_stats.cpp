@@ -0,0 +1,165 @@
+#include"fgwsz_stats.h"
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<atomic>    //::std::atomic ::std::memory_order_relaxed
+#include<bit>       //::std::bit_width
+#include<chrono>    //::std::chrono
+#include<format>    //::std::format
+#include<string>    //::std::string
+
+namespace fgwsz{
+namespace detail{
+//耗时直方图的桶数:第i个桶统计耗时小于2^i纳秒(且不小于2^(i-1)纳秒)的调用
+inline constexpr ::std::size_t stats_bucket_count=40;
+//一个阶段的统计信息(所有线程共享,使用原子操作累加)
+struct PhaseStats{
+    ::std::atomic<::std::uint64_t> calls;
+    ::std::atomic<::std::uint64_t> bytes;
+    ::std::atomic<::std::uint64_t> ns;
+    ::std::atomic<::std::uint64_t> max_ns;
+    ::std::atomic<::std::uint64_t> buckets[stats_bucket_count];
+};
+inline ::fgwsz::detail::PhaseStats phase_stats[
+    static_cast<::std::size_t>(::fgwsz::StatsPhase::count)
+]={};
+inline char const* const phase_names[
+    static_cast<::std::size_t>(::fgwsz::StatsPhase::count)
+]={
+    "walk","stat","open","read","write","flush","close","mkdir","copy"
+    ,"key_xor","checksum","compress","decompress","uring_wait"
+};
+//开启统计的时间(用于计算总耗时)
+inline ::std::chrono::steady_clock::time_point stats_start;
+//按直方图估计耗时的百分位数(返回所在桶的上限,不超过最大耗时)
+inline ::std::uint64_t stats_percentile(
+    ::fgwsz::detail::PhaseStats const& stats
+    ,double percentile
+){
+    ::std::uint64_t const calls=stats.calls.load(::std::memory_order_relaxed);
+    ::std::uint64_t const max_ns=stats.max_ns.load(::std::memory_order_relaxed);
+    ::std::uint64_t count=0;
+    for(::std::size_t index=0;index<stats_bucket_count;++index){
+        count+=stats.buckets[index].load(::std::memory_order_relaxed);
+        if(static_cast<double>(count)>=percentile*static_cast<double>(calls)){
+            ::std::uint64_t const bound=::std::uint64_t(1)<<index;
+            return bound<max_ns?bound:max_ns;
+        }
+    }
+    return max_ns;
+}
+}//namespace fgwsz::detail
+void stats_enable(void){
+    ::fgwsz::detail::stats_start=::std::chrono::steady_clock::now();
+    ::fgwsz::detail::stats_enabled=true;
+}
+void stats_record(
+    ::fgwsz::StatsPhase phase
+    ,::std::uint64_t bytes
+    ,::std::uint64_t ns
+)noexcept{
+    auto& stats=::fgwsz::detail::phase_stats[static_cast<::std::size_t>(phase)];
+    stats.calls.fetch_add(1,::std::memory_order_relaxed);
+    stats.bytes.fetch_add(bytes,::std::memory_order_relaxed);
+    stats.ns.fetch_add(ns,::std::memory_order_relaxed);
+    ::std::uint64_t max_ns=stats.max_ns.load(::std::memory_order_relaxed);
+    while(ns>max_ns
+        &&!stats.max_ns.compare_exchange_weak(
+            max_ns
+            ,ns
+            ,::std::memory_order_relaxed
+        )
+    ){}
+    ::std::size_t bucket=static_cast<::std::size_t>(::std::bit_width(ns));
+    if(bucket>=::fgwsz::detail::stats_bucket_count){
+        bucket=::fgwsz::detail::stats_bucket_count-1;
+    }
+    stats.buckets[bucket].fetch_add(1,::std::memory_order_relaxed);
+}
+void stats_print(::std::ostream& stream,bool json){
+    constexpr auto relaxed=::std::memory_order_relaxed;
+    ::std::uint64_t const wall_ns=static_cast<::std::uint64_t>(
+        ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+            ::std::chrono::steady_clock::now()-::fgwsz::detail::stats_start
+        ).count()
+    );
+    ::std::string text;
+    if(json){
+        text=::std::format("{{\"wall_ns\": {}, \"phases\": [",wall_ns);
+    }else{
+        text=::std::format(
+            "wall time: {:.3f} ms\n"
+            "{:<11}{:>10}{:>16}{:>12}{:>10}{:>10}{:>10}{:>12}\n"
+            ,static_cast<double>(wall_ns)/1e6
+            ,"phase","calls","bytes","total ms","avg us","p50 us","p99 us"
+            ,"max us"
+        );
+    }
+    bool first=true;
+    for(::std::size_t phase=0
+        ;phase<static_cast<::std::size_t>(::fgwsz::StatsPhase::count)
+        ;++phase
+    ){
+        auto const& stats=::fgwsz::detail::phase_stats[phase];
+        ::std::uint64_t const calls=stats.calls.load(relaxed);
+        if(0==calls){
+            continue;
+        }
+        ::std::uint64_t const ns=stats.ns.load(relaxed);
+        ::std::uint64_t const max_ns=stats.max_ns.load(relaxed);
+        if(!json){
+            text+=::std::format(
+                "{:<11}{:>10}{:>16}{:>12.3f}{:>10.3f}{:>10.3f}{:>10.3f}"
+                "{:>12.3f}\n"
+                ,::fgwsz::detail::phase_names[phase]
+                ,calls
+                ,stats.bytes.load(relaxed)
+                ,static_cast<double>(ns)/1e6
+                ,static_cast<double>(ns)/1e3/static_cast<double>(calls)
+                ,static_cast<double>(
+                    ::fgwsz::detail::stats_percentile(stats,0.5)
+                )/1e3
+                ,static_cast<double>(
+                    ::fgwsz::detail::stats_percentile(stats,0.99)
+                )/1e3
+                ,static_cast<double>(max_ns)/1e3
+            );
+            continue;
+        }
+        ::std::string histogram;
+        for(::std::size_t index=0
+            ;index<::fgwsz::detail::stats_bucket_count
+            ;++index
+        ){
+            ::std::uint64_t const count=stats.buckets[index].load(relaxed);
+            if(0==count){
+                continue;
+            }
+            histogram+=::std::format(
+                "{}{{\"lt_ns\": {}, \"count\": {}}}"
+                ,histogram.empty()?"":", "
+                ,::std::uint64_t(1)<<index
+                ,count
+            );
+        }
+        text+=::std::format(
+            "{}\n  {{\"name\": \"{}\", \"calls\": {}, \"bytes\": {}"
+            ", \"ns\": {}, \"max_ns\": {}, \"histogram\": [{}]}}"
+            ,first?"":","
+            ,::fgwsz::detail::phase_names[phase]
+            ,calls
+            ,stats.bytes.load(relaxed)
+            ,ns
+            ,max_ns
+            ,histogram
+        );
+        first=false;
+    }
+    if(json){
+        text+=first?"]}\n":"\n]}\n";
+    }
+    stream<<text;
+    stream.flush();
+}
+}//namespace fgwsz
@@ -0,0 +1,87 @@
+#ifndef FGWSZ_STATS_H
+#define FGWSZ_STATS_H
+
+#include<cstdint>   //::std::uint64_t
+
+#include<chrono>    //::std::chrono
+#include<ostream>   //::std::ostream
+
+//============================================================================
+//分阶段计时和计数统计相关
+//============================================================================
+namespace fgwsz{
+//统计的阶段(阶段之间可以嵌套,例如flush包含其中的write)
+enum class StatsPhase{
+    walk,       //遍历目录
+    stat,       //查询路径状态(exists,is_directory,file_size等)
+    open,       //打开文件
+    read,       //读取文件
+    write,      //写入文件
+    flush,      //合并写入器写出缓冲区
+    close,      //关闭文件
+    mkdir,      //创建目录
+    copy,       //从基准包复制文件项
+    key_xor,    //xor混淆(包括同时计算的校验和)
+    checksum,   //只计算校验和
+    compress,   //压缩帧
+    decompress, //解压帧
+    uring_wait, //提交io_uring请求并等待完成事件
+    count
+};
+namespace detail{
+//是否收集统计信息(默认关闭,关闭时计时器只检查这个标志)
+inline bool stats_enabled=false;
+}//namespace fgwsz::detail
+//开启统计(必须在启动任何工作线程之前调用)
+void stats_enable(void);
+//记录一次调用的字节数和耗时,可以被多个线程同时调用
+void stats_record(
+    ::fgwsz::StatsPhase phase
+    ,::std::uint64_t bytes
+    ,::std::uint64_t ns
+)noexcept;
+//打印所有调用过的阶段的调用次数,字节数,总耗时和耗时分布
+//json为true时以JSON格式打印(耗时分布为2的幂次纳秒上限的直方图)
+void stats_print(::std::ostream& stream,bool json);
+//作用域计时器:统计关闭时不读取时钟,析构时记录一次调用
+class StatsTimer{
+public:
+    explicit StatsTimer(
+        ::fgwsz::StatsPhase phase
+        ,::std::uint64_t bytes=0
+    )noexcept
+        :phase_(phase)
+        ,enabled_(::fgwsz::detail::stats_enabled)
+        ,bytes_(bytes){
+        if(this->enabled_){
+            this->start_=::std::chrono::steady_clock::now();
+        }
+    }
+    ~StatsTimer(void){
+        if(this->enabled_){
+            ::fgwsz::stats_record(
+                this->phase_
+                ,this->bytes_
+                ,static_cast<::std::uint64_t>(
+                    ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+                        ::std::chrono::steady_clock::now()-this->start_
+                    ).count()
+                )
+            );
+        }
+    }
+    //设置记录的字节数(例如实际读取的字节数)
+    void set_bytes(::std::uint64_t bytes)noexcept{
+        this->bytes_=bytes;
+    }
+    StatsTimer(StatsTimer const&)noexcept=delete;
+    StatsTimer& operator=(StatsTimer const&)noexcept=delete;
+private:
+    ::fgwsz::StatsPhase phase_;
+    bool enabled_;
+    ::std::uint64_t bytes_;
+    ::std::chrono::steady_clock::time_point start_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_STATS_H
@@ -0,0 +1,33 @@
+#ifndef FGWSZ_STREAM_H
+#define FGWSZ_STREAM_H
+
+#include<cstdint>   //::std::uint64_t
+
+#include<functional>//::std::function
+
+#include"fgwsz_header.h"
+
+//============================================================================
+//读写回调相关(嵌入其他程序时在内存中打包和解包,不需要临时文件)
+//============================================================================
+namespace fgwsz{
+//写入回调:写入全部bytes字节(写入失败时抛出异常)
+using WriteFunction=::std::function<void(
+    void const* src
+    ,::std::uint64_t bytes
+)>;
+//读取回调:最多读取bytes字节,返回实际读取的字节数(为0时说明到达末尾)
+//(读取失败时抛出异常)
+using ReadFunction=::std::function<::std::uint64_t(
+    void* ptr
+    ,::std::uint64_t bytes
+)>;
+//解包到回调时为每个文件项创建输出:
+//参数为文件头信息(包含相对路径和解码之后的字节数),
+//返回的写入回调按顺序接收这个文件的全部内容(空文件不会调用写入回调)
+using CreateFunction=::std::function<::fgwsz::WriteFunction(
+    ::fgwsz::Header const& header
+)>;
+}//namespace fgwsz
+
+#endif//FGWSZ_STREAM_H
@@ -1,77 +1,645 @@
 #include"fgwsz_unpacker.h"
 
 #include<cstdint>   //::std::uint8_t ::std::uint64_t
+#include<cstring>   //::std::memcpy ::std::memcmp
+#include<cerrno>    //EEXIST EIO
 
 #include<string>        //::std::string
 #include<filesystem>    //::std::filesystem
-#include<ios>           //::std::ios
-#include<fstream>       //::std::ofstream ::std::ifstream
+#include<limits>        //::std::numeric_limits
+#include<stdexcept>     //::std::runtime_error
 #include<vector>        //::std::vector
 #include<memory>        //::std::unique_ptr
 #include<type_traits>   //::std::remove_cvref_t
 #include<format>        //::std::format
+#include<string_view>   //::std::string_view
+#include<unordered_set> //::std::unordered_set
+#include<algorithm>     //::std::stable_sort
+#include<atomic>        //::std::atomic
+#include<utility>       //::std::move
 
 #include"fgwsz_endian.hpp"
 #include"fgwsz_except.h"
 #include"fgwsz_path.h"
-#include"fgwsz_fstream.h"
+#include"fgwsz_xor.h"
+#include"fgwsz_codec.h"
 #include"fgwsz_cout.h"
+#include"fgwsz_format.h"
+#include"fgwsz_glob.h"
+#include"fgwsz_file.h"
+#include"fgwsz_parallel.h"
+#include"fgwsz_checksum.h"
+#include"fgwsz_stats.h"
+#include"fgwsz_progress.h"
 
 namespace fgwsz{
 
 Unpacker::Unpacker(::std::filesystem::path const& package_path){
+    this->init();
+    if(::fgwsz::is_stream_path(package_path)){
+        this->package_.open(::fgwsz::File::standard_input());
+        this->open_stream();
+        return;
+    }
     //检查包路径是否存在
     ::fgwsz::path_assert_exists(package_path);
     //检查包路径不为目录路径
     ::fgwsz::path_assert_is_not_directory(package_path);
     //初始化包文件路径字符串(用于抛出异常时的信息显示)
     this->package_path_string_=package_path.generic_string();
-    //二进制方式打开包文件
-    this->package_.open(package_path,::std::ios::binary);
-    //包文件打开失败
-    if(!(this->package_.is_open())){
-        FGWSZ_THROW_WHAT(
-            "failed to open package file: "+this->package_path_string_
-        );
+    //优先内存映射包文件,无法映射时使用缓冲读取器读取包文件
+    if(this->mapping_.map(package_path)){
+        this->open_mapping();
+        return;
     }
+    //打开失败时抛出异常
+    this->package_.open(package_path);
     //包文件的大小
-    this->package_bytes_=::std::filesystem::file_size(package_path);
+    {
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
+        this->package_bytes_=::std::filesystem::file_size(package_path);
+    }
+    //包含有效索引区时,记录区到索引区起始位置为止
+    this->records_bytes_=this->package_bytes_;
+    this->unpack_shard_head();
+    this->has_index_=this->unpack_index();
+}
+Unpacker::Unpacker(void const* data,::std::uint64_t bytes){
+    this->init();
+    this->package_path_string_="<memory>";
+    this->mapping_.wrap(data,bytes);
+    this->open_mapping();
+}
+Unpacker::Unpacker(::fgwsz::File&& package){
+    this->init();
+    this->package_path_string_=package.path_string();
+    //普通文件映射之后直接从映射内存解码,否则流式读取
+    if(this->mapping_.map(package)){
+        //保留文件句柄,绕过页缓存时用于丢弃映射的包文件的页缓存
+        this->cache_file_=::std::move(package);
+        this->open_mapping();
+        return;
+    }
+    this->package_.open(::std::move(package));
+    this->open_stream();
+}
+Unpacker::Unpacker(::fgwsz::ReadFunction read){
+    this->init();
+    this->package_.open(::std::move(read),"<callback>");
+    this->open_stream();
 }
 Unpacker::~Unpacker(void){
-    if(this->package_.is_open()){
+    //析构时无法报告错误
+    try{
         this->package_.close();
-    }
+    }catch(...){}
+}
+void Unpacker::init(void){
+    this->streaming_=false;
+    this->package_count_bytes_=0;
+    this->released_bytes_=0;
+    this->direct_io_=false;
+    this->progress_offset_=0;
+    this->package_bytes_=0;
+    this->records_bytes_=0;
+    this->entries_loaded_=false;
+    this->has_index_=false;
+    this->shard_index_=0;
+    this->shard_count_=0;
+    this->checksum_=0;
+    this->checksumming_=false;
+    this->thread_count_=1;
+    this->io_backend_=::fgwsz::IoBackend::automatic;
+    this->record_offset_=0;
+    this->hardlink_=false;
+    this->pattern_check_=true;
+}
+void Unpacker::open_stream(void){
+    //流式读取包:不能定位,读取之前也不知道包的大小
+    //包在记录区结束标记或者记录边界处的流末尾结束
+    this->streaming_=true;
+    this->package_path_string_=this->package_.path_string();
+    this->package_bytes_=::std::numeric_limits<::std::uint64_t>::max();
+    this->records_bytes_=this->package_bytes_;
+}
+void Unpacker::open_mapping(void){
+    this->mapping_.advise_sequential();
+    this->package_bytes_=this->mapping_.size();
+    //包含有效索引区时,记录区到索引区起始位置为止
+    this->records_bytes_=this->package_bytes_;
+    this->unpack_shard_head();
+    this->has_index_=this->unpack_index();
 }
 void Unpacker::reset_package(void){
-    //重置包文件流位置到文件头
-    this->package_.seekg(0);
-    if(!this->package_.good()){
+    //重置包文件流位置到文件头和重置用于记录已读取包内容字节数的计数器
+    this->package_seek(0);
+}
+void Unpacker::package_seek(::std::uint64_t offset){
+    if(this->mapping_.is_mapped()){
+        if(offset>this->package_bytes_){
+            FGWSZ_THROW_WHAT(
+                "failed to jump package position: "+this->package_path_string_
+            );
+        }
+        this->released_bytes_=offset;
+    }else if(this->streaming_){
+        //流式读取时只能从当前位置继续读取
+        if(offset!=this->package_count_bytes_){
+            FGWSZ_THROW_WHAT(
+                "failed to jump package position: "+this->package_path_string_
+            );
+        }
+    }else{
+        this->package_.seek(offset);
+    }
+    this->package_count_bytes_=offset;
+    this->progress_offset_=offset;
+}
+bool Unpacker::package_read_at(
+    void* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+){
+    //不改变顺序读取的计数器,之后顺序读取之前需要先调用package_seek
+    if(this->streaming_
+        ||offset>this->package_bytes_
+        ||this->package_bytes_-offset<bytes
+    ){
+        return false;
+    }
+    if(this->mapping_.is_mapped()){
+        ::std::memcpy(ptr,this->mapping_.data()+offset,bytes);
+        return true;
+    }
+    this->package_.seek(offset);
+    return bytes==this->package_.read(ptr,bytes);
+}
+void Unpacker::release_package(void){
+    //顺序读取时每读完一个窗口就释放已经解码完成的映射页面
+    if(this->package_count_bytes_>this->released_bytes_
+        &&this->package_count_bytes_-this->released_bytes_
+            >=::fgwsz::MappedFile::release_window_bytes
+    ){
+        this->release_range(
+            this->released_bytes_
+            ,this->package_count_bytes_
+            ,this->cache_file_
+        );
+        this->released_bytes_=this->package_count_bytes_;
+    }
+}
+void Unpacker::release_range(
+    ::std::uint64_t begin
+    ,::std::uint64_t end
+    ,::fgwsz::File const& package
+)noexcept{
+    //释放已解码范围的映射页面,绕过页缓存时同时丢弃包文件这个范围内
+    //完整窗口的页缓存(其余部分在解包或校验结束时丢弃)
+    this->mapping_.release(begin,end);
+    constexpr ::std::uint64_t window=::fgwsz::File::cache_window_bytes;
+    begin=begin/window*window;
+    end=end/window*window;
+    if(this->direct_io_&&begin<end){
+        (this->mapping_.is_mapped()?this->cache_file_:package)
+            .drop_cache(begin,end-begin);
+    }
+}
+void Unpacker::drop_package_cache(::fgwsz::File const& package)noexcept{
+    if(!this->direct_io_){
+        return;
+    }
+    //映射的页面先解除映射才能丢弃页缓存
+    this->mapping_.release(0,this->mapping_.size());
+    auto const& file=this->mapping_.is_mapped()?this->cache_file_:package;
+    if(file.is_open()){
+        file.drop_cache(0,0);
+    }
+}
+void Unpacker::report_progress(::std::uint64_t files){
+    //报告从上次报告的位置到当前位置之间的包内容字节数
+    ::fgwsz::progress_add(
+        this->package_count_bytes_-this->progress_offset_
+        ,files
+    );
+    this->progress_offset_=this->package_count_bytes_;
+}
+void Unpacker::unpack_shard_head(void){
+    //分片头只能位于包的起始位置,不以分片头开始的包不是分片包
+    char head[::fgwsz::shard_head_bytes];
+    if(!this->package_read_at(head,sizeof(head),0)
+        ||static_cast<char>(::fgwsz::control_byte)!=head[0]
+        ||static_cast<char>(::fgwsz::control_shard_head)!=head[1]
+    ){
+        return;
+    }
+    this->parse_shard_head(head+::fgwsz::control_bytes);
+}
+void Unpacker::parse_shard_head(char* fields){
+    //fields为控制序列之后的[key][shard index][shard count]
+    ::std::uint64_t values[2]={};
+    ::fgwsz::key_xor(
+        fields+1
+        ,sizeof(values)
+        ,static_cast<::std::uint8_t>(fields[0])
+    );
+    ::std::memcpy(values,fields+1,sizeof(values));
+    ::std::uint64_t const shard_index=::fgwsz::net_to_host(values[0]);
+    ::std::uint64_t const shard_count=::fgwsz::net_to_host(values[1]);
+    if(shard_index>=shard_count){
+        FGWSZ_THROW_WHAT("invalid shard head: "+this->package_path_string_);
+    }
+    this->shard_index_=shard_index;
+    this->shard_count_=shard_count;
+}
+bool Unpacker::unpack_index(void){
+    auto const min_bytes=::fgwsz::index_head_bytes+::fgwsz::index_trailer_bytes;
+    if(this->package_bytes_<min_bytes){
+        return false;
+    }
+    //读取索引区尾部
+    char trailer[::fgwsz::index_trailer_bytes];
+    if(!this->package_read_at(
+        trailer
+        ,sizeof(trailer)
+        ,this->package_bytes_-sizeof(trailer)
+    )){
+        return false;
+    }
+    //没有索引区魔数的包为不含索引区的旧格式包
+    if(0!=::std::memcmp(
+        trailer+sizeof(::std::uint64_t)
+        ,::fgwsz::index_magic
+        ,sizeof(::fgwsz::index_magic)
+    )){
+        return false;
+    }
+    ::std::uint64_t index_offset=0;
+    ::std::memcpy(&index_offset,trailer,sizeof(index_offset));
+    index_offset=::fgwsz::net_to_host(index_offset);
+    if(index_offset>this->package_bytes_-min_bytes){
+        return false;
+    }
+    //一次性读取整个索引区
+    ::std::string index;
+    index.resize(
+        this->package_bytes_-::fgwsz::index_trailer_bytes-index_offset
+    );
+    if(!this->package_read_at(index.data(),index.size(),index_offset)){
+        return false;
+    }
+    //检查记录区结束标记
+    if(static_cast<char>(::fgwsz::control_byte)!=index[0]
+        ||static_cast<char>(::fgwsz::control_end_of_records)!=index[1]
+    ){
+        return false;
+    }
+    //解码索引项的xor混淆
+    ::fgwsz::key_xor(
+        index.data()+3
+        ,index.size()-3
+        ,static_cast<::std::uint8_t>(index[2])
+    );
+    //逐项解析索引项,任何越界都视为索引区无效
+    ::std::uint64_t position=3;
+    auto read_u8=[&index,&position](::std::uint8_t& value){
+        if(index.size()-position<sizeof(value)){
+            return false;
+        }
+        value=static_cast<::std::uint8_t>(index[position]);
+        position+=sizeof(value);
+        return true;
+    };
+    auto read_u64=[&index,&position](::std::uint64_t& value){
+        if(index.size()-position<sizeof(value)){
+            return false;
+        }
+        ::std::memcpy(&value,index.data()+position,sizeof(value));
+        value=::fgwsz::net_to_host(value);
+        position+=sizeof(value);
+        return true;
+    };
+    ::std::uint64_t entry_count=0;
+    if(!read_u64(entry_count)){
+        return false;
+    }
+    ::std::vector<::fgwsz::Entry> entries;
+    ::fgwsz::Entry entry={};
+    for(::std::uint64_t id=0;id<entry_count;++id){
+        auto& header=entry.header;
+        if(!read_u64(entry.record_offset)||!read_u8(header.key)){
+            return false;
+        }
+        //以控制序列开头的文件项的索引项在key之前有[0x00][控制类型],
+        //压缩文件项之后还有[codec][original bytes],
+        //引用文件项之后还有[reference offset][original bytes]
+        ::std::uint64_t header_fixed_bytes=::fgwsz::header_fixed_bytes;
+        header.codec=::fgwsz::codec_none;
+        header.framed=false;
+        header.has_checksum=false;
+        header.reference=false;
+        header.reference_offset=0;
+        if(::fgwsz::control_byte==header.key){
+            ::std::uint8_t control=0;
+            if(!read_u8(control)||!::fgwsz::Unpacker::is_record_control(control)){
+                return false;
+            }
+            header_fixed_bytes+=::fgwsz::control_bytes;
+            if(0!=(control&::fgwsz::control_compressed_record)){
+                //不压缩的稀疏文件的codec为codec_none
+                if(!read_u8(header.codec)
+                    ||(::fgwsz::codec_none!=header.codec
+                        &&nullptr==::fgwsz::find_codec(header.codec))
+                    ||!read_u64(header.original_bytes)
+                ){
+                    return false;
+                }
+                header.framed=true;
+                header_fixed_bytes=::fgwsz::compressed_header_fixed_bytes;
+            }
+            if(0!=(control&::fgwsz::control_reference_record)){
+                if(!read_u64(header.reference_offset)
+                    ||!read_u64(header.original_bytes)
+                ){
+                    return false;
+                }
+                header.reference=true;
+                header_fixed_bytes=::fgwsz::reference_header_fixed_bytes;
+            }
+            header.has_checksum=
+                0!=(control&::fgwsz::control_checksum_record);
+            if(!read_u8(header.key)){
+                return false;
+            }
+        }
+        if(!read_u64(header.relative_path_bytes)
+            ||index.size()-position<header.relative_path_bytes
+        ){
+            return false;
+        }
+        header.relative_path_string.assign(
+            index.data()+position
+            ,header.relative_path_bytes
+        );
+        position+=header.relative_path_bytes;
+        if(!read_u64(header.content_bytes)){
+            return false;
+        }
+        if(!header.framed&&!header.reference){
+            header.original_bytes=header.content_bytes;
+        }
+        //引用文件项不保存内容,被引用的文件项必须在引用文件项之前
+        if(header.reference
+            &&(0!=header.content_bytes
+                ||header.reference_offset>=entry.record_offset)
+        ){
+            return false;
+        }
+        //文件项必须完整地位于记录区内
+        if(entry.record_offset>index_offset
+            ||index_offset-entry.record_offset
+                <header_fixed_bytes+header.relative_path_bytes
+        ){
+            return false;
+        }
+        entry.content_offset=entry.record_offset
+            +header_fixed_bytes+header.relative_path_bytes;
+        if(index_offset-entry.content_offset<header.content_bytes
+            ||(header.has_checksum
+                &&index_offset-entry.content_offset-header.content_bytes
+                    <::fgwsz::checksum_bytes
+            )
+        ){
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    //源文件信息与索引项一一对应(不含源文件信息的索引区在索引项之后结束)
+    if(position!=index.size()){
+        ::std::uint64_t source_count=0;
+        if(!read_u64(source_count)||entry_count!=source_count){
+            return false;
+        }
+        for(auto& source_entry:entries){
+            ::std::uint64_t write_time=0;
+            if(!read_u64(write_time)||!read_u64(source_entry.source_bytes)){
+                return false;
+            }
+            source_entry.source_write_time=
+                static_cast<::std::int64_t>(write_time);
+            source_entry.has_source=
+                ::fgwsz::source_write_time_unknown
+                    !=source_entry.source_write_time;
+            if(!source_entry.has_source){
+                source_entry.source_bytes=0;
+            }
+        }
+    }
+    if(position!=index.size()){
+        return false;
+    }
+    this->entries_=::std::move(entries);
+    this->entries_loaded_=true;
+    this->records_bytes_=index_offset;
+    this->map_entries();
+    return true;
+}
+void Unpacker::load_entries(void){
+    //不含索引区时扫描所有文件头并跳过文件内容
+    this->reset_package();
+    ::fgwsz::Entry entry={};
+    while(this->unpack_header()){
+        entry.record_offset=this->record_offset_;
+        entry.content_offset=this->package_count_bytes_;
+        //文件内容信息跳过阶段(压缩文件项跳过之后才能得到内容在包内的字节数)
+        this->skip_content();
+        entry.header=this->header_;
+        this->entries_.push_back(entry);
+    }
+    if(this->package_count_bytes_!=this->records_bytes_){
         FGWSZ_THROW_WHAT(
-            "failed to jump package head: "+this->package_path_string_
+            "package read incomplete: "+this->package_path_string_
+        );
+    }
+    this->entries_loaded_=true;
+    this->map_entries();
+}
+void Unpacker::map_entries(void){
+    //建立相对路径到文件项的映射和文件项起始位置到文件项的映射
+    this->entry_indexes_.clear();
+    this->entry_indexes_.reserve(this->entries_.size());
+    this->record_indexes_.clear();
+    this->record_indexes_.reserve(this->entries_.size());
+    for(::std::size_t index=0;index<this->entries_.size();++index){
+        auto const& entry=this->entries_[index];
+        this->entry_indexes_.insert_or_assign(
+            ::std::string_view(entry.header.relative_path_string)
+            ,index
+        );
+        this->record_indexes_.insert_or_assign(entry.record_offset,index);
+    }
+    //引用文件项必须引用之前的一个不是引用文件项的文件项,且内容大小相同
+    for(auto const& entry:this->entries_){
+        if(!entry.header.reference){
+            continue;
+        }
+        auto const iter=
+            this->record_indexes_.find(entry.header.reference_offset);
+        if(this->record_indexes_.end()==iter
+            ||this->entries_[iter->second].header.reference
+            ||this->entries_[iter->second].header.original_bytes
+                !=entry.header.original_bytes
+        ){
+            FGWSZ_THROW_WHAT(
+                "invalid file item reference: "
+                +entry.header.relative_path_string
+            );
+        }
+    }
+}
+::std::vector<::fgwsz::Entry> const& Unpacker::entries(void){
+    if(!this->entries_loaded_){
+        this->load_entries();
+    }
+    return this->entries_;
+}
+::fgwsz::Entry const* Unpacker::find_entry(::std::string_view relative_path){
+    this->entries();
+    auto iter=this->entry_indexes_.find(relative_path);
+    if(this->entry_indexes_.end()==iter){
+        return nullptr;
+    }
+    return &(this->entries_[iter->second]);
+}
+::fgwsz::Entry const& Unpacker::resolve_entry(
+    ::fgwsz::Entry const& entry
+)const{
+    if(!entry.header.reference){
+        return entry;
+    }
+    //引用关系在读取文件项信息时已经检查过
+    auto const iter=this->record_indexes_.find(entry.header.reference_offset);
+    if(this->record_indexes_.end()==iter){
+        FGWSZ_THROW_WHAT(
+            "invalid file item reference: "+entry.header.relative_path_string
+        );
+    }
+    return this->entries_[iter->second];
+}
+bool Unpacker::has_index(void)const noexcept{
+    return this->has_index_;
+}
+::std::uint64_t Unpacker::records_bytes(void)const noexcept{
+    return this->records_bytes_;
+}
+bool Unpacker::is_shard(void)const noexcept{
+    return 0!=this->shard_count_;
+}
+::std::uint64_t Unpacker::shard_index(void)const noexcept{
+    return this->shard_index_;
+}
+::std::uint64_t Unpacker::shard_count(void)const noexcept{
+    return this->shard_count_;
+}
+bool Unpacker::prepare_random_access(void){
+    if(this->streaming_){
+        return false;
+    }
+    //构造时的顺序访问提示会加大预读,对按位置读取的少量字节反而浪费I/O
+    this->mapping_.advise_random();
+    return true;
+}
+::std::string const& Unpacker::package_path_string(void)const noexcept{
+    return this->package_path_string_;
+}
+char const* Unpacker::mapped_data(void)const noexcept{
+    return this->mapping_.is_mapped()?this->mapping_.data():nullptr;
+}
+void Unpacker::set_thread_count(::std::size_t thread_count){
+    this->thread_count_=0==thread_count
+        ?::fgwsz::default_thread_count():thread_count;
+}
+void Unpacker::set_io_backend(::fgwsz::IoBackend io_backend){
+    this->io_backend_=io_backend;
+}
+void Unpacker::set_hardlink(bool hardlink){
+    this->hardlink_=hardlink;
+}
+void Unpacker::set_pattern_check(bool pattern_check){
+    this->pattern_check_=pattern_check;
+}
+::std::vector<bool> const& Unpacker::matched_patterns(void)const noexcept{
+    return this->matched_patterns_;
+}
+void Unpacker::set_direct_io(bool direct_io){
+    this->direct_io_=direct_io;
+    if(this->streaming_){
+        return;
+    }
+    if(!this->mapping_.is_mapped()){
+        this->package_.set_direct(direct_io);
+    }else if(direct_io
+        &&this->mapping_.is_owned()
+        &&!this->cache_file_.is_open()
+    ){
+        this->cache_file_.open(
+            this->package_path_string_
+            ,::fgwsz::FileMode::read
         );
     }
-    //重置用于记录已读取包内容字节数的计数器
-    this->package_count_bytes_=0;
 }
 ::std::uint64_t Unpacker::package_read(void* ptr,::std::uint64_t bytes){
-    ::std::uint64_t read_bytes=::fgwsz::std_ifstream_read(
-        this->package_
-        ,reinterpret_cast<char*>(ptr)
-        ,bytes
-        ,this->package_path_string_
-    );
-    if(bytes!=read_bytes){
+    if(this->mapping_.is_mapped()){
+        if(this->package_bytes_-this->package_count_bytes_<bytes){
+            FGWSZ_THROW_WHAT(
+                "failed to read key: "+this->package_path_string_
+            );
+        }
+        ::std::memcpy(
+            ptr
+            ,this->mapping_.data()+this->package_count_bytes_
+            ,bytes
+        );
+    }else if(bytes!=this->package_.read(ptr,bytes)){
         FGWSZ_THROW_WHAT(
             "failed to read key: "+this->package_path_string_
         );
     }
-    this->package_count_bytes_+=read_bytes;
-    return read_bytes;
+    //读取的是包内保存的形式,直接参与文件项校验和的计算
+    if(this->checksumming_){
+        this->checksum_=::fgwsz::crc32c(this->checksum_,ptr,bytes);
+    }
+    this->package_count_bytes_+=bytes;
+    return bytes;
 }
-void Unpacker::key_xor(void* ptr,::std::uint64_t bytes){
-    for(::std::uint64_t index=0;index<bytes;++index){
-        reinterpret_cast<::std::uint8_t*>(ptr)[index]^=this->header_.key;
+void Unpacker::package_decode(void* ptr,::std::uint64_t bytes){
+    if(this->mapping_.is_mapped()){
+        //从映射内存解码,只读取和写入一遍内存
+        if(this->package_bytes_-this->package_count_bytes_<bytes){
+            FGWSZ_THROW_WHAT(
+                "failed to read content: "+this->header_.relative_path_string
+            );
+        }
+        if(this->checksumming_){
+            this->checksum_=::fgwsz::crc32c_key_xor_copy(
+                ptr
+                ,this->mapping_.data()+this->package_count_bytes_
+                ,bytes
+                ,this->header_.key
+                ,this->checksum_
+            );
+        }else{
+            ::fgwsz::key_xor_copy(
+                ptr
+                ,this->mapping_.data()+this->package_count_bytes_
+                ,bytes
+                ,this->header_.key
+            );
+        }
+        this->package_count_bytes_+=bytes;
+        return;
     }
+    this->package_read(ptr,bytes);
+    ::fgwsz::key_xor(ptr,bytes,this->header_.key);
 }
 void Unpacker::unpack_key(void){
     this->package_read(&(this->header_.key),sizeof(this->header_.key));
@@ -85,12 +653,33 @@ void Unpacker::unpack_relative_path_bytes(void){
     this->header_.relative_path_bytes=
         ::fgwsz::net_to_host(this->header_.relative_path_bytes);
     //解码relative path bytes的文件密钥xor混淆
-    this->key_xor(
+    ::fgwsz::key_xor(
         &(this->header_.relative_path_bytes)
         ,sizeof(this->header_.relative_path_bytes)
+        ,this->header_.key
     );
 }
+void Unpacker::assert_header_bytes(
+    ::std::uint64_t bytes
+    ,::std::uint64_t max_bytes
+)const{
+    //大小字段超过记录区剩余的字节数(流式读取时不知道记录区的大小)
+    //或者max_bytes时文件头已经损坏,不能按其分配内存或者磁盘空间
+    if(bytes>max_bytes
+        ||bytes>this->records_bytes_-this->package_count_bytes_
+    ){
+        FGWSZ_THROW_WHAT(::std::format(
+            "corrupted file item: {} (offset {})"
+            ,this->package_path_string_
+            ,this->record_offset_
+        ));
+    }
+}
 void Unpacker::unpack_relative_path_string(void){
+    this->assert_header_bytes(
+        this->header_.relative_path_bytes
+        ,::fgwsz::max_relative_path_bytes
+    );
     this->header_.relative_path_string
         .resize(this->header_.relative_path_bytes);
     this->package_read(
@@ -98,9 +687,10 @@ void Unpacker::unpack_relative_path_string(void){
         ,this->header_.relative_path_bytes
     );
     //解码relative path的文件密钥xor混淆
-    this->key_xor(
+    ::fgwsz::key_xor(
         this->header_.relative_path_string.data()
         ,this->header_.relative_path_bytes
+        ,this->header_.key
     );
 }
 void Unpacker::unpack_content_bytes(void){
@@ -112,132 +702,1889 @@ void Unpacker::unpack_content_bytes(void){
     this->header_.content_bytes=
         ::fgwsz::net_to_host(this->header_.content_bytes);
     //解码content bytes的文件密钥xor混淆
-    this->key_xor(
+    ::fgwsz::key_xor(
         &(this->header_.content_bytes)
         ,sizeof(this->header_.content_bytes)
+        ,this->header_.key
+    );
+    this->assert_header_bytes(
+        this->header_.content_bytes
+        ,::std::numeric_limits<::std::uint64_t>::max()
     );
 }
-void Unpacker::unpack_header(void){
-    this->unpack_key();
+void Unpacker::unpack_codec(void){
+    char fields[
+        sizeof(this->header_.codec)+sizeof(this->header_.original_bytes)
+    ];
+    this->package_decode(fields,sizeof(fields));
+    ::std::memcpy(&(this->header_.codec),fields,sizeof(this->header_.codec));
+    ::std::memcpy(
+        &(this->header_.original_bytes)
+        ,fields+sizeof(this->header_.codec)
+        ,sizeof(this->header_.original_bytes)
+    );
+    //将网络序转换为主机序,得到original bytes
+    this->header_.original_bytes=
+        ::fgwsz::net_to_host(this->header_.original_bytes);
+    //每一帧在包内至少有帧头
+    ::std::uint64_t const frame_count=0==this->header_.original_bytes
+        ?0:(this->header_.original_bytes-1)/::fgwsz::frame_bytes+1;
+    this->assert_header_bytes(
+        frame_count*::fgwsz::frame_head_bytes
+        ,::std::numeric_limits<::std::uint64_t>::max()
+    );
+    //不压缩的稀疏文件的codec为codec_none
+    if(::fgwsz::codec_none!=this->header_.codec
+        &&nullptr==::fgwsz::find_codec(this->header_.codec)
+    ){
+        FGWSZ_THROW_WHAT(
+            ::std::format("unsupported codec {}: ",this->header_.codec)
+            +this->header_.relative_path_string
+        );
+    }
+    this->header_.framed=true;
+    //压缩文件项内容在包内的字节数在跳过或者解码所有帧之后才能得到
+    this->header_.content_bytes=0;
+}
+void Unpacker::unpack_reference_fields(void){
+    ::std::uint64_t fields[2]={};
+    this->package_decode(fields,sizeof(fields));
+    //将网络序转换为主机序,得到reference offset和original bytes
+    this->header_.reference_offset=::fgwsz::net_to_host(fields[0]);
+    this->header_.original_bytes=::fgwsz::net_to_host(fields[1]);
+    //被引用的文件项必须在引用文件项之前
+    if(this->header_.reference_offset>=this->record_offset_){
+        FGWSZ_THROW_WHAT(
+            "invalid file item reference: "
+            +this->header_.relative_path_string
+        );
+    }
+    this->header_.reference=true;
+    this->header_.codec=::fgwsz::codec_none;
+    this->header_.framed=false;
+    //包内不保存内容
+    this->header_.content_bytes=0;
+}
+bool Unpacker::unpack_header(void){
+    //到达记录区末尾
+    if(this->package_count_bytes_>=this->records_bytes_){
+        return false;
+    }
+    this->record_offset_=this->package_count_bytes_;
+    if(this->streaming_){
+        //流式读取时读取不到key说明包在记录边界处结束(不含索引区的包)
+        if(0==this->package_.read(
+            &(this->header_.key)
+            ,sizeof(this->header_.key)
+        )){
+            this->records_bytes_=this->package_count_bytes_;
+            return false;
+        }
+        this->package_count_bytes_+=sizeof(this->header_.key);
+    }else{
+        this->unpack_key();
+    }
+    //控制序列
+    bool compressed=false;
+    bool reference=false;
+    this->header_.has_checksum=false;
+    this->header_.reference=false;
+    this->header_.reference_offset=0;
+    this->checksumming_=false;
+    if(::fgwsz::control_byte==this->header_.key){
+        ::std::uint8_t control=0;
+        this->package_read(&control,sizeof(control));
+        if(::fgwsz::Unpacker::is_record_control(control)){
+            //压缩文件项或者带校验和的文件项:控制序列之后为key
+            compressed=0!=(control&::fgwsz::control_compressed_record);
+            reference=0!=(control&::fgwsz::control_reference_record);
+            //校验和从key开始计算
+            this->header_.has_checksum=
+                0!=(control&::fgwsz::control_checksum_record);
+            this->checksumming_=this->header_.has_checksum;
+            this->checksum_=0;
+            this->unpack_key();
+        }else if(::fgwsz::control_shard_head==control
+            &&0==this->record_offset_
+        ){
+            //分片头之后才是第一个文件项
+            char fields[::fgwsz::shard_head_bytes-::fgwsz::control_bytes];
+            this->package_read(fields,sizeof(fields));
+            this->parse_shard_head(fields);
+            return this->unpack_header();
+        }else if(::fgwsz::control_end_of_records==control){
+            //记录区到此结束,其后为索引区
+            this->records_bytes_=this->package_count_bytes_;
+            //流式读取时读取并丢弃索引区,避免写入端在写完之前因为管道关闭而失败
+            if(this->streaming_){
+                this->package_.skip(
+                    ::std::numeric_limits<::std::uint64_t>::max()
+                );
+            }
+            return false;
+        }else{
+            FGWSZ_THROW_WHAT(
+                ::std::format("unsupported control type {}: ",control)
+                +this->package_path_string_
+            );
+        }
+    }
     this->unpack_relative_path_bytes();
     this->unpack_relative_path_string();
-    this->unpack_content_bytes();
+    if(compressed){
+        this->unpack_codec();
+    }else if(reference){
+        this->unpack_reference_fields();
+    }else{
+        this->unpack_content_bytes();
+        this->header_.codec=::fgwsz::codec_none;
+        this->header_.framed=false;
+        this->header_.original_bytes=this->header_.content_bytes;
+    }
+    return true;
 }
-void Unpacker::unpack_content(
-    ::std::filesystem::path const& output_dir_path
-    ,char* block
-    ,::std::uint64_t block_bytes
+void Unpacker::package_skip(::std::uint64_t bytes){
+    //映射时只需要移动计数器,不会访问被跳过的内容
+    if(this->mapping_.is_mapped()){
+        if(this->package_bytes_-this->package_count_bytes_<bytes){
+            FGWSZ_THROW_WHAT(
+                "failed to skip content bytes: "
+                +this->header_.relative_path_string
+            );
+        }
+        if(this->checksumming_){
+            this->checksum_=::fgwsz::crc32c(
+                this->checksum_
+                ,this->mapping_.data()+this->package_count_bytes_
+                ,bytes
+            );
+        }
+        this->package_count_bytes_+=bytes;
+        return;
+    }
+    if(this->checksumming_){
+        //校验时通过缓冲区读取并计算校验和
+        if(this->package_bytes_-this->package_count_bytes_<bytes){
+            FGWSZ_THROW_WHAT(
+                "failed to skip content bytes: "
+                +this->header_.relative_path_string
+            );
+        }
+        for(::std::uint64_t count_bytes=0;count_bytes<bytes;){
+            ::std::uint64_t fetched_bytes=0;
+            char const* data=this->package_.fetch(fetched_bytes);
+            if(0==fetched_bytes){
+                FGWSZ_THROW_WHAT(
+                    "failed to skip content bytes: "
+                    +this->header_.relative_path_string
+                );
+            }
+            ::std::uint64_t const read_bytes=
+                (bytes-count_bytes)<fetched_bytes
+                ?(bytes-count_bytes):fetched_bytes;
+            this->checksum_=::fgwsz::crc32c(this->checksum_,data,read_bytes);
+            this->package_.consume(read_bytes);
+            count_bytes+=read_bytes;
+        }
+        this->package_count_bytes_+=bytes;
+        return;
+    }
+    //不能定位时通过缓冲区读取并丢弃
+    if(this->package_bytes_-this->package_count_bytes_<bytes
+        ||this->package_.skip(bytes)!=bytes
+    ){
+        FGWSZ_THROW_WHAT(
+            "failed to skip content bytes: "
+            +this->header_.relative_path_string
+        );
+    }
+    this->package_count_bytes_+=bytes;
+}
+void Unpacker::skip_content(void){
+    //跳过的文件内容不计算校验和
+    this->checksumming_=false;
+    this->skip_stored();
+    this->skip_checksum();
+}
+void Unpacker::skip_stored(void){
+    //计算校验和时,被跳过的内容(包括帧头)同时参与计算
+    if(!this->header_.framed){
+        this->package_skip(this->header_.content_bytes);
+        return;
+    }
+    //压缩文件项逐帧跳过,只读取帧头,同时得到文件项内容在包内的字节数
+    ::std::uint64_t const content_offset=this->package_count_bytes_;
+    bool raw=false;
+    for(::std::uint64_t count_bytes=0
+        ;count_bytes<this->header_.original_bytes
+        ;count_bytes+=::fgwsz::frame_bytes
+    ){
+        this->package_skip(this->unpack_frame_head(
+            (this->header_.original_bytes-count_bytes)<::fgwsz::frame_bytes
+            ?(this->header_.original_bytes-count_bytes): ::fgwsz::frame_bytes
+            ,raw
+        ));
+    }
+    this->header_.content_bytes=this->package_count_bytes_-content_offset;
+}
+void Unpacker::skip_checksum(void){
+    this->checksumming_=false;
+    if(this->header_.has_checksum){
+        this->package_skip(::fgwsz::checksum_bytes);
+    }
+}
+bool Unpacker::unpack_checksum(void){
+    //读取文件项保存的校验和,与读取过程中计算的校验和比较
+    this->checksumming_=false;
+    if(!this->header_.has_checksum){
+        return true;
+    }
+    ::std::uint32_t checksum=0;
+    this->package_decode(&checksum,sizeof(checksum));
+    return ::fgwsz::net_to_host(checksum)==this->checksum_;
+}
+bool Unpacker::is_record_control(::std::uint8_t control){
+    //压缩文件项和带校验和的文件项的控制类型可以组合,引用文件项只能带校验和
+    return (0!=control
+            &&0==(control&~(::fgwsz::control_compressed_record
+                |::fgwsz::control_checksum_record)))
+        ||(::fgwsz::control_reference_record
+            |::fgwsz::control_checksum_record)==control;
+}
+bool Unpacker::parse_frame_head(
+    ::std::uint32_t head
+    ,::std::uint64_t bytes
+    ,::std::uint64_t& data_bytes
+    ,bool& raw
 ){
+    raw=0!=(head&::fgwsz::frame_raw_flag);
+    data_bytes=head&~::fgwsz::frame_raw_flag;
+    //原始内容的帧数据等于解码之后的大小,压缩内容的帧数据总是更少
+    //(为0时是空洞帧)
+    return raw?data_bytes==bytes:data_bytes<bytes;
+}
+::std::uint64_t Unpacker::unpack_frame_head(::std::uint64_t bytes,bool& raw){
+    ::std::uint32_t head=0;
+    this->package_decode(&head,sizeof(head));
+    ::std::uint64_t data_bytes=0;
+    if(!::fgwsz::Unpacker::parse_frame_head(
+        ::fgwsz::net_to_host(head)
+        ,bytes
+        ,data_bytes
+        ,raw
+    )){
+        FGWSZ_THROW_WHAT(
+            "corrupted compressed content: "
+            +this->header_.relative_path_string
+        );
+    }
+    return data_bytes;
+}
+::std::uint64_t Unpacker::decode_frame_at(
+    ::fgwsz::Header const& header
+    ,::std::uint64_t offset
+    ,::std::uint64_t bytes
+    ,::fgwsz::File const& package
+    ,char* dst
+    ,char* scratch
+    ,::std::uint32_t& checksum
+)const{
+    //从映射内存或者包文件的指定位置读取并解码文件密钥xor混淆(帧不能超出记录区)
+    //同时把读取的帧接在checksum之后计算校验和
+    auto read=[&](void* ptr,::std::uint64_t count,::std::uint64_t position){
+        if(position>this->records_bytes_
+            ||this->records_bytes_-position<count
+        ){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "+header.relative_path_string
+            );
+        }
+        if(this->mapping_.is_mapped()){
+            checksum=::fgwsz::crc32c_key_xor_copy(
+                ptr
+                ,this->mapping_.data()+position
+                ,count
+                ,header.key
+                ,checksum
+            );
+            return;
+        }
+        if(count!=package.read_at(ptr,count,position)){
+            FGWSZ_THROW_WHAT(
+                "package read incomplete: "+this->package_path_string_
+            );
+        }
+        checksum=::fgwsz::crc32c_key_xor_copy(
+            ptr
+            ,ptr
+            ,count
+            ,header.key
+            ,checksum
+        );
+    };
+    ::std::uint32_t head=0;
+    read(&head,sizeof(head),offset);
+    ::std::uint64_t data_bytes=0;
+    bool raw=false;
+    if(!::fgwsz::Unpacker::parse_frame_head(
+        ::fgwsz::net_to_host(head)
+        ,bytes
+        ,data_bytes
+        ,raw
+    )){
+        FGWSZ_THROW_WHAT(
+            "corrupted compressed content: "+header.relative_path_string
+        );
+    }
+    //空洞帧不写入dst,返回值为帧头的字节数(调用者跳过或者填充0)
+    if(0==data_bytes){
+        return sizeof(head);
+    }
+    if(raw){
+        read(dst,bytes,offset+sizeof(head));
+    }else{
+        auto const* codec=::fgwsz::find_codec(header.codec);
+        if(nullptr==codec){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "+header.relative_path_string
+            );
+        }
+        read(scratch,data_bytes,offset+sizeof(head));
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::decompress,bytes);
+        if(!codec->decompress(
+            dst
+            ,bytes
+            ,scratch
+            ,data_bytes
+        )){
+            FGWSZ_THROW_WHAT(
+                "corrupted compressed content: "+header.relative_path_string
+            );
+        }
+    }
+    return sizeof(head)+data_bytes;
+}
+void Unpacker::read_records_at(
+    void* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+    ,::fgwsz::File const& package
+)const{
+    //从映射内存或者包文件的指定位置读取记录区的内容,可以被多个线程同时调用
+    if(offset>this->records_bytes_||this->records_bytes_-offset<bytes){
+        FGWSZ_THROW_WHAT(
+            "package read incomplete: "+this->package_path_string_
+        );
+    }
+    if(this->mapping_.is_mapped()){
+        ::std::memcpy(ptr,this->mapping_.data()+offset,bytes);
+    }else if(bytes!=package.read_at(ptr,bytes,offset)){
+        FGWSZ_THROW_WHAT(
+            "package read incomplete: "+this->package_path_string_
+        );
+    }
+}
+::std::uint32_t Unpacker::header_checksum(
+    ::fgwsz::Entry const& entry
+    ,::fgwsz::File const& package
+)const{
+    //文件头部分(控制序列之后到文件内容起始位置)的校验和
+    ::std::uint64_t offset=::fgwsz::checksum_offset(entry);
+    ::std::uint64_t bytes=entry.content_offset-offset;
+    if(this->mapping_.is_mapped()
+        &&offset<=this->records_bytes_
+        &&this->records_bytes_-offset>=bytes
+    ){
+        return ::fgwsz::crc32c(0,this->mapping_.data()+offset,bytes);
+    }
+    ::std::string buffer(bytes,'\0');
+    this->read_records_at(buffer.data(),bytes,offset,package);
+    return ::fgwsz::crc32c(0,buffer.data(),bytes);
+}
+::std::uint32_t Unpacker::stored_checksum(
+    ::fgwsz::Entry const& entry
+    ,::fgwsz::File const& package
+)const{
+    ::std::uint32_t checksum=0;
+    this->read_records_at(
+        &checksum
+        ,sizeof(checksum)
+        ,entry.content_offset+entry.header.content_bytes
+        ,package
+    );
+    ::fgwsz::key_xor(&checksum,sizeof(checksum),entry.header.key);
+    return ::fgwsz::net_to_host(checksum);
+}
+void Unpacker::unpack_content(OpenFunction const& open){
     //判断相对路径是否是安全路径
     ::fgwsz::path_assert_is_safe_relative_path(
         this->header_.relative_path_string
     );
-    //创建文件父目录
-    ::std::filesystem::path file_path=::std::filesystem::absolute(
-        output_dir_path/this->header_.relative_path_string
-    );
-    ::fgwsz::try_create_directories(
-        ::fgwsz::parent_path(file_path)
-    );
-    //文件输出流关联文件路径
-    ::std::ofstream file(file_path,::std::ios::binary|::std::ios::trunc);
-    ::std::string file_path_string=file_path.generic_string();
-    if(!file.is_open()){
-        FGWSZ_THROW_WHAT("file isn't open: "+file_path_string);
+    //合并写入器关联输出文件或者写入回调(打开失败时抛出异常)
+    open(this->file_,this->header_);
+    if(this->direct_io_
+        &&this->header_.original_bytes>=this->direct_min_bytes_
+    ){
+        this->file_.set_direct(true);
+    }
+    //不压缩的大文件预分配磁盘空间(压缩文件项可能是稀疏文件,不预分配)
+    //流式读取时内容字节数在读取完之前无法检查,不按其预分配
+    if(!this->header_.framed
+        &&!this->streaming_
+        &&this->header_.original_bytes>=this->preallocate_min_bytes_
+    ){
+        this->file_.preallocate(this->header_.original_bytes);
+    }
+    ::std::uint64_t const file_count_bytes=!this->header_.framed
+        ?this->unpack_stored(this->header_.content_bytes)
+        :this->unpack_frames();
+    //将剩余内容写入文件并关闭文件
+    this->file_.close();
+    if(file_count_bytes!=this->header_.original_bytes){
+        FGWSZ_THROW_WHAT(
+            "file write incomplete: "+this->file_.path_string()
+        );
     }
-    //分块读取content
+    if(!this->unpack_checksum()){
+        FGWSZ_THROW_WHAT(
+            "checksum mismatch: "+this->header_.relative_path_string
+        );
+    }
+    this->report_progress(1);
+}
+void Unpacker::decode_stored(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+){
+    //带校验和的文件项在解码的同时计算校验和,只读取和写入一遍内存
+    if(this->checksumming_){
+        this->checksum_=::fgwsz::crc32c_key_xor_copy(
+            dst
+            ,src
+            ,bytes
+            ,this->header_.key
+            ,this->checksum_
+        );
+    }else{
+        ::fgwsz::key_xor_copy(dst,src,bytes,this->header_.key);
+    }
+}
+::std::uint64_t Unpacker::unpack_stored(::std::uint64_t bytes){
+    //分块读取content,直接读取到合并写入器的缓冲区中
     ::std::uint64_t file_count_bytes=0;
     ::std::uint64_t read_bytes=0;
-    while(file_count_bytes<this->header_.content_bytes){
-        read_bytes=::fgwsz::std_ifstream_read(
-            this->package_
-            ,&(block[0])
-            ,((block_bytes>(this->header_.content_bytes-file_count_bytes)
-                ?(this->header_.content_bytes-file_count_bytes)
-                :block_bytes))
-            ,this->package_path_string_
-        );
+    ::std::uint64_t available_bytes=0;
+    while(file_count_bytes<bytes){
+        char* block=this->file_.prepare(available_bytes);
+        ::std::uint64_t const request=
+            available_bytes>(bytes-file_count_bytes)
+            ?(bytes-file_count_bytes)
+            :available_bytes;
+        if(this->mapping_.is_mapped()){
+            //从映射内存解码content的文件密钥xor混淆到缓冲区中
+            read_bytes=
+                (this->package_bytes_-this->package_count_bytes_)<request
+                ?(this->package_bytes_-this->package_count_bytes_):request;
+            this->decode_stored(
+                block
+                ,this->mapping_.data()+this->package_count_bytes_
+                ,read_bytes
+            );
+        }else{
+            //从读取器的缓冲区解码content的文件密钥xor混淆到写入器的缓冲区中
+            ::std::uint64_t fetched_bytes=0;
+            char const* data=this->package_.fetch(fetched_bytes);
+            read_bytes=fetched_bytes<request?fetched_bytes:request;
+            this->decode_stored(block,data,read_bytes);
+            this->package_.consume(read_bytes);
+        }
+        //包内容提前结束
+        if(0==read_bytes){
+            break;
+        }
         this->package_count_bytes_+=read_bytes;
-        //解码content的文件密钥xor混淆
-        this->key_xor(block,read_bytes);
-        //将分块读取的content写入文件
-        ::fgwsz::std_ofstream_write(
-            file
-            ,&(block[0])
-            ,static_cast<::std::streamsize>(read_bytes)
-            ,file_path_string
-        );
+        //提交到合并写入器,缓冲区写满时写入文件
+        this->file_.commit(read_bytes);
         file_count_bytes+=read_bytes;
+        this->release_package();
+        this->report_progress(0);
     }
-    if(file_count_bytes!=this->header_.content_bytes){
-        FGWSZ_THROW_WHAT("file write incomplete: "+file_path_string);
+    return file_count_bytes;
+}
+::std::uint64_t Unpacker::unpack_frames(void){
+    auto const* codec=::fgwsz::find_codec(this->header_.codec);
+    if(nullptr==this->frame_){
+        this->frame_=::std::make_unique<char[]>(::fgwsz::frame_bytes);
+        this->block_=::std::make_unique<char[]>(::fgwsz::frame_bytes);
     }
+    ::std::uint64_t const content_offset=this->package_count_bytes_;
+    ::std::uint64_t file_count_bytes=0;
+    ::std::uint64_t available_bytes=0;
+    bool raw=false;
+    while(file_count_bytes<this->header_.original_bytes){
+        ::std::uint64_t const bytes=
+            (this->header_.original_bytes-file_count_bytes)<::fgwsz::frame_bytes
+            ?(this->header_.original_bytes-file_count_bytes)
+            : ::fgwsz::frame_bytes;
+        ::std::uint64_t const data_bytes=this->unpack_frame_head(bytes,raw);
+        if(0==data_bytes){
+            //空洞帧:写入文件时跳过(成为输出文件的空洞)
+            this->file_.skip(bytes);
+        }else if(raw){
+            //原始内容的帧与不压缩的文件内容相同
+            if(bytes!=this->unpack_stored(bytes)){
+                break;
+            }
+        }else{
+            if(nullptr==codec){
+                FGWSZ_THROW_WHAT(
+                    "corrupted compressed content: "
+                    +this->header_.relative_path_string
+                );
+            }
+            this->package_decode(this->frame_.get(),data_bytes);
+            //写入器缓冲区的空间足够时直接解压到写入器的缓冲区中
+            char* block=this->file_.prepare(available_bytes);
+            bool const direct=available_bytes>=bytes;
+            if(!direct){
+                block=this->block_.get();
+            }
+            bool decompressed=false;
+            {
+                ::fgwsz::StatsTimer timer(
+                    ::fgwsz::StatsPhase::decompress
+                    ,bytes
+                );
+                decompressed=codec->decompress(
+                    block,bytes,this->frame_.get(),data_bytes
+                );
+            }
+            if(!decompressed){
+                FGWSZ_THROW_WHAT(
+                    "corrupted compressed content: "
+                    +this->header_.relative_path_string
+                );
+            }
+            if(direct){
+                this->file_.commit(bytes);
+            }else{
+                this->file_.write(block,bytes);
+            }
+            this->release_package();
+            this->report_progress(0);
+        }
+        file_count_bytes+=bytes;
+    }
+    this->header_.content_bytes=this->package_count_bytes_-content_offset;
+    return file_count_bytes;
 }
 void Unpacker::unpack_package(::std::filesystem::path const& output_dir_path){
+    this->unpack_package(output_dir_path,{});
+}
+void Unpacker::unpack_package(
+    ::std::filesystem::path const& output_dir_path
+    ,::std::vector<::std::string> const& patterns
+){
+    //多线程解包(流式读取时只能顺序解包)
+    if(this->thread_count_>1&&!this->streaming_){
+        this->unpack_parallel(output_dir_path,patterns);
+        return;
+    }
+    //io_uring解包
+    if(!this->streaming_
+        &&!this->direct_io_
+        &&::fgwsz::use_io_uring(this->io_backend_)
+    ){
+        this->unpack_uring(output_dir_path,patterns);
+        return;
+    }
     //输入参数检查阶段
     ::fgwsz::try_create_directories(output_dir_path);
     ::fgwsz::path_assert_is_directory(output_dir_path);
-    //重置包文件流到头部和重置包读取字节计数器为0
-    this->reset_package();
-    //用于读取文件内容信息的内存块
-    //MSVC中栈全部内存默认1MB,直接分配在栈上会导致栈溢出,改为分配在堆上
-    constexpr ::std::uint64_t block_bytes=1024*1024;//1MB
-    auto block=::std::make_unique<char[]>(block_bytes);
-    //文件头信息变量
-    while(this->package_count_bytes_<this->package_bytes_){
+    ::fgwsz::OutputDirectory output_dir(output_dir_path);
+    this->linked_paths_.clear();
+    this->unpack_sequential(
+        patterns
+        ,[this,&output_dir](
+            ::fgwsz::BufferedWriter& file
+            ,::fgwsz::Header const& header
+        ){
+            this->open_output(output_dir,file,header);
+        }
+        ,[this,&output_dir](
+            ::fgwsz::BufferedWriter& file
+            ,::fgwsz::Header const& header
+            ,::std::string const& target_path_string
+        ){
+            this->link_output(output_dir,file,header,target_path_string);
+        }
+    );
+    this->drop_package_cache(this->cache_file_);
+}
+void Unpacker::unpack_package(::fgwsz::CreateFunction const& create){
+    this->unpack_package(create,{});
+}
+void Unpacker::unpack_package(
+    ::fgwsz::CreateFunction const& create
+    ,::std::vector<::std::string> const& patterns
+){
+    //引用文件项从包内重新解码被引用的文件项(流式读取时不支持)
+    this->unpack_sequential(
+        patterns
+        ,[&create](
+            ::fgwsz::BufferedWriter& file
+            ,::fgwsz::Header const& header
+        ){
+            auto write=create(header);
+            //空的写入回调丢弃文件内容(仍然解码和校验)
+            if(nullptr==write){
+                write=[](void const*,::std::uint64_t){};
+            }
+            file.open(::std::move(write),header.relative_path_string);
+        }
+        ,nullptr
+    );
+    this->drop_package_cache(this->cache_file_);
+}
+void Unpacker::unpack_sequential(
+    ::std::vector<::std::string> const& patterns
+    ,OpenFunction const& open
+    ,LinkFunction const& link
+){
+    UnpackedFiles unpacked;
+    if(patterns.empty()){
+        //重置包文件流到头部和重置包读取字节计数器为0
+        this->reset_package();
+        //流式读取时总字节数未知,不含索引区时总文件数未知
+        ::fgwsz::progress_add_total(
+            this->streaming_?0:this->records_bytes_
+            ,this->has_index_?this->entries_.size():0
+        );
         //文件头信息处理阶段
-        this->unpack_header();
-        //文件内容信息处理阶段
-        this->unpack_content(
-            output_dir_path
-            ,block.get()
-            ,block_bytes
+        while(this->unpack_header()){
+            //文件内容信息处理阶段
+            this->unpack_entry(open,link,unpacked);
+        }
+        if(this->package_count_bytes_!=this->records_bytes_){
+            FGWSZ_THROW_WHAT(
+                "package read incomplete: "+this->package_path_string_
+            );
+        }
+        return;
+    }
+    ::fgwsz::PathFilter filter(patterns);
+    if(this->has_index_){
+        //包含索引区时直接跳转到匹配文件的文件项起始位置
+        //重新读取文件头(同时计算文件头部分的校验和)之后解包文件内容
+        for(auto const& entry:this->entries_){
+            if(filter.match(entry.header.relative_path_string)){
+                ::fgwsz::progress_add_total(
+                    ::fgwsz::record_end(entry)-entry.record_offset
+                    ,1
+                );
+            }
+        }
+        for(auto const& entry:this->entries_){
+            if(!filter.match(entry.header.relative_path_string)){
+                continue;
+            }
+            this->package_seek(entry.record_offset);
+            if(!this->unpack_header()
+                ||this->package_count_bytes_!=entry.content_offset
+                ||this->header_.relative_path_string
+                    !=entry.header.relative_path_string
+            ){
+                FGWSZ_THROW_WHAT(
+                    "package index doesn't match file item: "
+                    +entry.header.relative_path_string
+                );
+            }
+            this->unpack_entry(open,link,unpacked);
+        }
+    }else{
+        //不含索引区时扫描所有文件头,跳过不匹配文件的内容
+        this->reset_package();
+        ::fgwsz::progress_add_total(
+            this->streaming_?0:this->records_bytes_
+            ,0
         );
+        while(this->unpack_header()){
+            if(filter.match(this->header_.relative_path_string)){
+                this->unpack_entry(open,link,unpacked);
+            }else{
+                this->skip_content();
+                this->report_progress(0);
+            }
+        }
+        if(this->package_count_bytes_!=this->records_bytes_){
+            FGWSZ_THROW_WHAT(
+                "package read incomplete: "+this->package_path_string_
+            );
+        }
+    }
+    this->matched_patterns_=filter.matched();
+    if(this->pattern_check_){
+        filter.assert_all_matched();
+    }
+}
+void Unpacker::UnpackedFiles::add(
+    ::std::uint64_t record_offset
+    ,::std::string const& path
+){
+    //路径被覆盖时,之前解包到这个路径的文件项不再保留
+    auto const [iter,inserted]=this->records.try_emplace(path,record_offset);
+    if(!inserted){
+        this->paths.erase(iter->second);
+        iter->second=record_offset;
     }
-    if(this->package_count_bytes_!=this->package_bytes_){
+    this->paths.insert_or_assign(record_offset,path);
+}
+void Unpacker::unpack_entry(
+    OpenFunction const& open
+    ,LinkFunction const& link
+    ,UnpackedFiles& unpacked
+){
+    if(this->header_.reference){
+        this->unpack_reference(open,link,unpacked);
+        return;
+    }
+    this->unpack_content(open);
+    //解包到输出目录时记录已解包的文件,之后的引用文件项从中链接或者复制
+    if(nullptr!=link){
+        unpacked.add(this->record_offset_,this->header_.relative_path_string);
+    }
+}
+void Unpacker::unpack_reference(
+    OpenFunction const& open
+    ,LinkFunction const& link
+    ,UnpackedFiles& unpacked
+){
+    ::fgwsz::path_assert_is_safe_relative_path(
+        this->header_.relative_path_string
+    );
+    //引用文件项只有文件头和校验和
+    if(!this->unpack_checksum()){
         FGWSZ_THROW_WHAT(
-            "package read incomplete: "+this->package_path_string_
+            "checksum mismatch: "+this->header_.relative_path_string
+        );
+    }
+    ::fgwsz::Header const reference=this->header_;
+    ::std::uint64_t const record_offset=this->record_offset_;
+    //被引用的文件项已经解包到输出目录时链接或者复制已解包的文件
+    if(nullptr!=link){
+        auto const iter=unpacked.paths.find(reference.reference_offset);
+        if(unpacked.paths.end()!=iter){
+            link(this->file_,reference,iter->second);
+            unpacked.add(record_offset,reference.relative_path_string);
+            this->report_progress(1);
+            return;
+        }
+    }
+    //否则从包内重新解码被引用的文件项到这个文件(流式读取时不能回到之前的位置)
+    if(this->streaming_){
+        FGWSZ_THROW_WHAT(
+            "referenced file item isn't unpacked from the stream: "
+            +reference.relative_path_string
+        );
+    }
+    this->report_progress(0);
+    ::std::uint64_t const record_end=this->package_count_bytes_;
+    this->package_seek(reference.reference_offset);
+    if(!this->unpack_header()
+        ||this->header_.reference
+        ||this->header_.original_bytes!=reference.original_bytes
+    ){
+        FGWSZ_THROW_WHAT(
+            "invalid file item reference: "+reference.relative_path_string
+        );
+    }
+    this->header_.relative_path_bytes=reference.relative_path_bytes;
+    this->header_.relative_path_string=reference.relative_path_string;
+    this->unpack_content(open);
+    //重新解码的字节数不在解包开始时的总字节数中
+    ::fgwsz::progress_add_total(
+        this->package_count_bytes_-reference.reference_offset
+        ,0
+    );
+    this->package_seek(record_end);
+    this->header_=reference;
+    this->record_offset_=record_offset;
+    if(nullptr!=link){
+        unpacked.add(record_offset,reference.relative_path_string);
+    }
+}
+void Unpacker::open_output(
+    ::fgwsz::OutputDirectory& output_dir
+    ,::fgwsz::BufferedWriter& file
+    ,::fgwsz::Header const& header
+){
+    //本次解包中创建了硬链接的文件先删除,不修改与之共享内容的其他文件
+    if(this->linked_paths_.erase(header.relative_path_string)>0){
+        output_dir.remove_file(header.relative_path_string);
+    }
+    //创建文件父目录(已创建的目录直接使用缓存的目录句柄),
+    //关联相对于父目录打开的文件
+    file.open(output_dir.create_file(header.relative_path_string));
+}
+void Unpacker::link_output(
+    ::fgwsz::OutputDirectory& output_dir
+    ,::fgwsz::BufferedWriter& file
+    ,::fgwsz::Header const& header
+    ,::std::string const& target_path_string
+){
+    //被引用的文件就是这个文件时内容已经相同
+    if(target_path_string==header.relative_path_string){
+        return;
+    }
+    if(this->hardlink_
+        &&output_dir.link_file(target_path_string,header.relative_path_string)
+    ){
+        this->linked_paths_.insert(target_path_string);
+        this->linked_paths_.insert(header.relative_path_string);
+        return;
+    }
+    //复制已解包的文件(由内核完成复制,文件系统支持时共享磁盘块)
+    auto const source=output_dir.open_file(
+        target_path_string
+        ,::fgwsz::FileMode::read
+    );
+    this->open_output(output_dir,file,header);
+    file.copy_from(source,header.original_bytes,0);
+    file.close();
+}
+void Unpacker::unpack_references(
+    ::std::filesystem::path const& output_dir_path
+    ,::std::vector<::fgwsz::Entry const*> const& references
+    ,::std::vector<::fgwsz::Entry const*> const& selected_entries
+){
+    //其他文件项全部解包之后,按包内顺序链接或者复制引用文件项
+    if(references.empty()){
+        return;
+    }
+    UnpackedFiles unpacked;
+    for(auto const* entry:selected_entries){
+        unpacked.add(entry->record_offset,entry->header.relative_path_string);
+    }
+    ::fgwsz::OutputDirectory output_dir(output_dir_path);
+    this->linked_paths_.clear();
+    OpenFunction const open=[this,&output_dir](
+        ::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+    ){
+        this->open_output(output_dir,file,header);
+    };
+    LinkFunction const link=[this,&output_dir](
+        ::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+        ,::std::string const& target_path_string
+    ){
+        this->link_output(output_dir,file,header,target_path_string);
+    };
+    for(auto const* entry:references){
+        this->package_seek(entry->record_offset);
+        if(!this->unpack_header()
+            ||this->package_count_bytes_!=entry->content_offset
+            ||this->header_.relative_path_string
+                !=entry->header.relative_path_string
+        ){
+            FGWSZ_THROW_WHAT(
+                "package index doesn't match file item: "
+                +entry->header.relative_path_string
+            );
+        }
+        this->unpack_reference(open,link,unpacked);
+    }
+}
+void Unpacker::select_entries(
+    ::std::vector<::std::string> const& patterns
+    ,::std::vector<::fgwsz::Entry const*>& selected_entries
+    ,::std::vector<::fgwsz::Entry const*>& references
+){
+    //文件头预扫描阶段(包含索引区时只读取索引区)
+    //同一路径出现多次时只解包最后一次出现的文件项,与单线程解包的结果一致
+    //引用文件项单独选出
+    auto const& entries=this->entries();
+    ::fgwsz::PathFilter filter(patterns);
+    for(::std::size_t index=0;index<entries.size();++index){
+        auto const& header=entries[index].header;
+        if(!filter.match(header.relative_path_string)
+            ||this->entry_indexes_.at(header.relative_path_string)!=index
+        ){
+            continue;
+        }
+        ::fgwsz::path_assert_is_safe_relative_path(
+            header.relative_path_string
+        );
+        //引用文件项在其他文件项解包之后再链接或者复制
+        (header.reference?references:selected_entries)
+            .push_back(&(entries[index]));
+        ::fgwsz::progress_add_total(
+            ::fgwsz::record_end(entries[index])-entries[index].record_offset
+            ,1
+        );
+    }
+    this->matched_patterns_=filter.matched();
+    if(this->pattern_check_){
+        filter.assert_all_matched();
+    }
+}
+void Unpacker::unpack_uring(
+    ::std::filesystem::path const& output_dir_path
+    ,::std::vector<::std::string> const& patterns
+){
+    //输入参数检查阶段
+    ::fgwsz::try_create_directories(output_dir_path);
+    ::fgwsz::path_assert_is_directory(output_dir_path);
+    ::std::vector<::fgwsz::Entry const*> selected_entries;
+    ::std::vector<::fgwsz::Entry const*> references;
+    this->select_entries(patterns,selected_entries,references);
+    //同时打开的输出文件数上限和块的数量(同时进行的读取和写入请求数上限)
+    constexpr ::std::size_t max_open_files=32;
+    constexpr ::std::size_t block_count=32;
+    //块的大小等于帧的大小,压缩文件项的一帧解码到一个块中
+    constexpr ::std::uint64_t block_bytes=::fgwsz::frame_bytes;
+    //每个文件同时只有打开或关闭中的一个请求,另加包文件的打开和关闭请求
+    ::fgwsz::IoRing ring;
+    if(!ring.init(static_cast<unsigned>(max_open_files+block_count+1))){
+        FGWSZ_THROW_WHAT("failed to initialize io_uring");
+    }
+    ::fgwsz::IoCompletion completion={};
+    constexpr ::std::uint8_t mkdir_operation=1;
+    constexpr ::std::uint8_t open_operation=2;
+    constexpr ::std::uint8_t read_operation=3;
+    constexpr ::std::uint8_t write_operation=4;
+    constexpr ::std::uint8_t close_operation=5;
+    constexpr ::std::uint8_t open_package_operation=6;
+    constexpr ::std::uint8_t close_package_operation=7;
+    //输出文件相对于缓存的父目录句柄打开,父目录由输出目录创建
+    ::fgwsz::OutputDirectory output_dir(output_dir_path);
+    auto const absolute_output_dir_path=
+        ::std::filesystem::absolute(output_dir_path);
+    //输出文件的完整路径字符串(用于抛出异常时的信息显示)
+    auto file_path_string=[&](::std::size_t index){
+        return (absolute_output_dir_path
+            /selected_entries[index]->header.relative_path_string).string();
+    };
+    //按目录深度逐层批量创建所有父目录(同一层的目录之间没有依赖),
+    //不支持mkdirat操作时由输出目录在打开文件时同步创建
+    ::std::vector<::std::vector<::std::string>> dir_path_levels;
+    ::std::unordered_set<::std::string> dir_path_strings;
+    if(ring.supports_mkdirat()){
+        for(auto const* entry:selected_entries){
+            auto const& relative_path_string=entry->header.relative_path_string;
+            ::std::size_t depth=0;
+            for(auto slash=relative_path_string.find('/')
+                ;::std::string::npos!=slash
+                ;slash=relative_path_string.find('/',slash+1)
+            ){
+                auto dir_path_string=relative_path_string.substr(0,slash);
+                if(dir_path_strings.insert(dir_path_string).second){
+                    if(dir_path_levels.size()<=depth){
+                        dir_path_levels.resize(depth+1);
+                    }
+                    dir_path_levels[depth].push_back(
+                        ::std::move(dir_path_string)
+                    );
+                }
+                ++depth;
+            }
+        }
+    }
+    for(auto const& dir_path_level:dir_path_levels){
+        for(::std::size_t index=0;index<dir_path_level.size();){
+            while(index<dir_path_level.size()&&ring.space()>0){
+                ring.prepare_mkdirat(
+                    output_dir.handle()
+                    ,dir_path_level[index].c_str()
+                    ,::fgwsz::io_user_data(mkdir_operation,index)
+                );
+                ++index;
+            }
+            while(ring.in_flight()>0){
+                ring.submit(1);
+                while(ring.peek(completion)){
+                    if(completion.result<0&&-EEXIST!=completion.result){
+                        FGWSZ_THROW_WHAT(
+                            "failed to create directory: "
+                            +(absolute_output_dir_path
+                                /dir_path_level[completion.index()]).string()
+                            +": "+::fgwsz::io_error_message(completion.result)
+                        );
+                    }
+                }
+            }
+        }
+        for(auto const& dir_path_string:dir_path_level){
+            output_dir.add_created_directory(dir_path_string);
+        }
+    }
+    //输出文件的状态
+    struct FileState{
+        int fd;                     //文件描述符(打开完成之前为-1)
+        ::std::uint64_t submitted;  //已提交读取或写入请求的字节数
+        ::std::size_t in_flight;    //进行中的读取和写入请求数
+        bool closing;               //是否已提交关闭请求
+        ::std::uint64_t position;   //下一帧在包内的位置(压缩文件项)
+        //文件内容的校验和:压缩文件项按帧顺序连续计算,
+        //否则各块的校验和移动到文件内容结束位置之后xor合并(块的读取完成顺序不确定)
+        ::std::uint32_t checksum;
+    };
+    ::std::vector<FileState> files;
+    files.reserve(selected_entries.size());
+    bool has_compressed=false;
+    for(auto const* entry:selected_entries){
+        files.push_back(FileState{-1,0,0,false,entry->content_offset,0});
+        has_compressed=has_compressed
+            ||entry->header.framed;
+    }
+    //块的状态:一个块对应一个文件的一段内容
+    struct Block{
+        ::std::unique_ptr<char[]> data;
+        ::std::size_t file_index;
+        ::std::uint64_t offset;     //在文件中的位置
+        ::std::uint64_t bytes;      //内容字节数
+        ::std::uint64_t written;    //已写入的字节数
+        ::std::uint64_t stored_bytes;//在包内对应的字节数(用于报告进度)
+    };
+    ::std::vector<Block> blocks(block_count);
+    ::std::vector<::std::size_t> free_blocks;
+    for(::std::size_t index=0;index<block_count;++index){
+        blocks[index].data=::std::make_unique<char[]>(block_bytes);
+        free_blocks.push_back(block_count-1-index);
+    }
+    //包文件已映射时直接从映射内存解码,否则使用io_uring按位置读取包文件
+    //压缩文件项逐帧同步解码(未映射时同步读取包文件),在解码的同时之前的写入请求仍在进行
+    bool const mapped=this->mapping_.is_mapped();
+    //未映射时同步读取的包文件也用于读取文件头和校验和
+    ::fgwsz::File package;
+    ::std::unique_ptr<char[]> scratch;
+    if(!mapped&&!selected_entries.empty()){
+        package.open(this->package_path_string_,::fgwsz::FileMode::read);
+    }
+    if(has_compressed){
+        scratch=::std::make_unique<char[]>(block_bytes);
+    }
+    //把一个块的校验和合并到文件内容的校验和中
+    auto merge_checksum=[&](
+        ::std::size_t block_index
+        ,::std::uint32_t checksum
+    ){
+        auto const& block=blocks[block_index];
+        auto const& entry=*(selected_entries[block.file_index]);
+        files[block.file_index].checksum^=::fgwsz::crc32c_shift(
+            checksum
+            ,entry.header.original_bytes-(block.offset+block.bytes)
+        );
+    };
+    int package_fd=-1;
+    ::std::string const package_path_string=
+        ::std::filesystem::path(this->package_path_string_).string();
+    ::std::size_t finished_count=0;
+    ::std::size_t open_count=0;
+    //进行中的打开请求数(关闭缓存的目录句柄之前必须等待这些请求完成)
+    ::std::size_t opening_count=0;
+    ::std::size_t next_open_index=0;
+    ::std::size_t next_submit_index=0;
+    auto prepare_close=[&](::std::size_t file_index){
+        auto& file=files[file_index];
+        file.closing=true;
+        ring.prepare_close(
+            file.fd
+            ,::fgwsz::io_user_data(close_operation,file_index)
+        );
+    };
+    auto prepare_write=[&](::std::size_t block_index){
+        auto const& block=blocks[block_index];
+        ring.prepare_write(
+            files[block.file_index].fd
+            ,block.data.get()+block.written
+            ,static_cast<::std::uint32_t>(block.bytes-block.written)
+            ,block.offset+block.written
+            ,::fgwsz::io_user_data(write_operation,block_index)
         );
+    };
+    //块的内容已经写入(或者是不需要写入的空洞)
+    auto finish_block=[&](::std::size_t block_index){
+        auto const& block=blocks[block_index];
+        auto& file=files[block.file_index];
+        --file.in_flight;
+        free_blocks.push_back(block_index);
+        ::fgwsz::progress_add(block.stored_bytes,0);
+        //文件内容已经全部写入,关闭文件
+        if(0==file.in_flight&&file.submitted
+            ==selected_entries[block.file_index]->header.original_bytes
+        ){
+            prepare_close(block.file_index);
+        }
+    };
+    auto handle=[&](::fgwsz::IoCompletion const& event){
+        ::std::size_t const index=
+            static_cast<::std::size_t>(event.index());
+        switch(event.operation()){
+        case open_package_operation:
+            if(event.result<0){
+                FGWSZ_THROW_WHAT(
+                    "failed to open package file: "+this->package_path_string_
+                    +": "+::fgwsz::io_error_message(event.result)
+                );
+            }
+            package_fd=event.result;
+            break;
+        case open_operation:
+            --opening_count;
+            if(event.result<0){
+                FGWSZ_THROW_WHAT(
+                    "failed to open file: "+file_path_string(index)
+                    +": "+::fgwsz::io_error_message(event.result)
+                );
+            }
+            files[index].fd=event.result;
+            //空文件打开之后直接关闭
+            if(0==selected_entries[index]->header.original_bytes){
+                prepare_close(index);
+            }else if(!selected_entries[index]->header.framed
+                &&selected_entries[index]->header.original_bytes
+                    >=this->preallocate_min_bytes_
+            ){
+                ::fgwsz::io_preallocate(
+                    event.result
+                    ,selected_entries[index]->header.original_bytes
+                );
+            }
+            break;
+        case read_operation:{
+            auto const& block=blocks[index];
+            auto const& entry=*(selected_entries[block.file_index]);
+            if(event.result<0){
+                FGWSZ_THROW_WHAT(
+                    "package read error: "+this->package_path_string_
+                    +": "+::fgwsz::io_error_message(event.result)
+                );
+            }
+            if(static_cast<::std::uint64_t>(event.result)!=block.bytes){
+                FGWSZ_THROW_WHAT(
+                    "package read incomplete: "+this->package_path_string_
+                );
+            }
+            //在其他请求进行的同时解码已读取的块,同时计算块的校验和
+            merge_checksum(index,::fgwsz::crc32c_key_xor_copy(
+                block.data.get()
+                ,block.data.get()
+                ,block.bytes
+                ,entry.header.key
+                ,0
+            ));
+            prepare_write(index);
+            break;
+        }
+        case write_operation:{
+            auto& block=blocks[index];
+            if(event.result<=0){
+                FGWSZ_THROW_WHAT(
+                    "file write error: "+file_path_string(block.file_index)
+                    +": "+::fgwsz::io_error_message(
+                        0==event.result?-EIO:event.result
+                    )
+                );
+            }
+            block.written+=static_cast<::std::uint64_t>(event.result);
+            //部分写入时继续写入剩余的内容
+            if(block.written<block.bytes){
+                prepare_write(index);
+                break;
+            }
+            finish_block(index);
+            break;
+        }
+        case close_operation:
+            if(event.result<0){
+                FGWSZ_THROW_WHAT(
+                    "failed to close file: "+file_path_string(index)
+                    +": "+::fgwsz::io_error_message(event.result)
+                );
+            }
+            files[index].fd=-1;
+            --open_count;
+            ++finished_count;
+            //文件头和校验和的字节数
+            ::fgwsz::progress_add(
+                ::fgwsz::record_end(*(selected_entries[index]))
+                    -selected_entries[index]->record_offset
+                    -selected_entries[index]->header.content_bytes
+                ,1
+            );
+            break;
+        default:
+            break;
+        }
+    };
+    auto wait=[&](void){
+        ring.submit(1);
+        while(ring.peek(completion)){
+            handle(completion);
+        }
+    };
+    try{
+        if(!mapped&&!selected_entries.empty()){
+            ring.prepare_openat(
+                package_path_string.c_str()
+                ,::fgwsz::FileMode::read
+                ,::fgwsz::io_user_data(open_package_operation,0)
+            );
+            while(package_fd<0){
+                wait();
+            }
+        }
+        this->package_seek(0);
+        while(finished_count<selected_entries.size()){
+            //提前打开后续的输出文件
+            while(next_open_index<selected_entries.size()
+                &&open_count<max_open_files
+            ){
+                auto const& relative_path_string=
+                    selected_entries[next_open_index]
+                        ->header.relative_path_string;
+                if(opening_count>0
+                    &&output_dir.parent_handle_evicts(relative_path_string)
+                ){
+                    break;
+                }
+                //相对于父目录句柄只需要传入文件名
+                ::std::size_t name_offset=0;
+                int const dir_fd=
+                    output_dir.parent_handle(relative_path_string,name_offset);
+                ring.prepare_openat(
+                    dir_fd
+                    ,relative_path_string.c_str()+name_offset
+                    ,::fgwsz::FileMode::write_truncate
+                    ,::fgwsz::io_user_data(open_operation,next_open_index)
+                );
+                ++next_open_index;
+                ++open_count;
+                ++opening_count;
+            }
+            //按文件顺序把文件内容分块,为每个块提交读取或写入请求
+            while(next_submit_index<next_open_index&&!free_blocks.empty()){
+                auto& file=files[next_submit_index];
+                auto const& entry=*(selected_entries[next_submit_index]);
+                if(file.submitted==entry.header.original_bytes){
+                    ++next_submit_index;
+                    continue;
+                }
+                if(file.fd<0){
+                    break;
+                }
+                ::std::size_t const block_index=free_blocks.back();
+                free_blocks.pop_back();
+                auto& block=blocks[block_index];
+                block.file_index=next_submit_index;
+                block.offset=file.submitted;
+                block.bytes=
+                    (entry.header.original_bytes-file.submitted)<block_bytes
+                    ?(entry.header.original_bytes-file.submitted):block_bytes;
+                block.written=0;
+                block.stored_bytes=block.bytes;
+                file.submitted+=block.bytes;
+                ++file.in_flight;
+                ::std::uint64_t const offset=entry.content_offset+block.offset;
+                if(entry.header.framed){
+                    block.stored_bytes=this->decode_frame_at(
+                        entry.header
+                        ,file.position
+                        ,block.bytes
+                        ,package
+                        ,block.data.get()
+                        ,scratch.get()
+                        ,file.checksum
+                    );
+                    file.position+=block.stored_bytes;
+                    if(mapped){
+                        this->package_count_bytes_=file.position;
+                        this->release_package();
+                    }
+                    if(::fgwsz::frame_head_bytes!=block.stored_bytes){
+                        prepare_write(block_index);
+                    }else if(file.submitted==entry.header.original_bytes){
+                        //以空洞结束的文件只写入最后一个字节,使文件达到完整的大小
+                        block.data[0]=0;
+                        block.offset+=block.bytes-1;
+                        block.bytes=1;
+                        prepare_write(block_index);
+                    }else{
+                        //空洞帧不写入,跳过的部分成为输出文件的空洞
+                        finish_block(block_index);
+                    }
+                }else if(mapped){
+                    //从映射内存解码到块中,在解码的同时之前的写入请求仍在进行
+                    merge_checksum(block_index,::fgwsz::crc32c_key_xor_copy(
+                        block.data.get()
+                        ,this->mapping_.data()+offset
+                        ,block.bytes
+                        ,entry.header.key
+                        ,0
+                    ));
+                    this->package_count_bytes_=offset+block.bytes;
+                    this->release_package();
+                    prepare_write(block_index);
+                }else{
+                    ring.prepare_read(
+                        package_fd
+                        ,block.data.get()
+                        ,static_cast<::std::uint32_t>(block.bytes)
+                        ,offset
+                        ,::fgwsz::io_user_data(read_operation,block_index)
+                    );
+                }
+            }
+            wait();
+        }
+        //所有文件写入完成之后,合并文件头的校验和并与文件项保存的校验和比较
+        for(::std::size_t index=0;index<selected_entries.size();++index){
+            auto const& entry=*(selected_entries[index]);
+            if(entry.header.has_checksum
+                &&(::fgwsz::crc32c_shift(
+                    this->header_checksum(entry,package)
+                    ,entry.header.content_bytes
+                )^files[index].checksum)
+                    !=this->stored_checksum(entry,package)
+            ){
+                FGWSZ_THROW_WHAT(
+                    "checksum mismatch: "+entry.header.relative_path_string
+                );
+            }
+        }
+        if(package_fd>=0){
+            ring.prepare_close(
+                package_fd
+                ,::fgwsz::io_user_data(close_package_operation,0)
+            );
+            package_fd=-1;
+            while(ring.in_flight()>0){
+                wait();
+            }
+        }
+        this->unpack_references(output_dir_path,references,selected_entries);
+    }catch(...){
+        //等待所有进行中的请求完成之后才能释放块,并关闭已打开的文件
+        try{
+            auto drain=[&](void){
+                while(ring.in_flight()>0){
+                    ring.submit(1);
+                    while(ring.peek(completion)){
+                        if(completion.result<0){
+                            continue;
+                        }
+                        if(open_operation==completion.operation()){
+                            files[completion.index()].fd=completion.result;
+                        }else if(open_package_operation
+                            ==completion.operation()
+                        ){
+                            package_fd=completion.result;
+                        }else if(close_operation==completion.operation()){
+                            files[completion.index()].fd=-1;
+                        }
+                    }
+                }
+            };
+            drain();
+            for(::std::size_t index=0;index<files.size();++index){
+                if(files[index].fd>=0){
+                    if(0==ring.space()){
+                        drain();
+                    }
+                    ring.prepare_close(
+                        files[index].fd
+                        ,::fgwsz::io_user_data(close_operation,index)
+                    );
+                }
+            }
+            if(package_fd>=0){
+                if(0==ring.space()){
+                    drain();
+                }
+                ring.prepare_close(
+                    package_fd
+                    ,::fgwsz::io_user_data(close_package_operation,0)
+                );
+            }
+            drain();
+        }catch(...){}
+        throw;
+    }
+}
+void Unpacker::unpack_parallel(
+    ::std::filesystem::path const& output_dir_path
+    ,::std::vector<::std::string> const& patterns
+){
+    //输入参数检查阶段
+    ::fgwsz::try_create_directories(output_dir_path);
+    ::fgwsz::path_assert_is_directory(output_dir_path);
+    ::std::vector<::fgwsz::Entry const*> selected_entries;
+    ::std::vector<::fgwsz::Entry const*> references;
+    this->select_entries(patterns,selected_entries,references);
+    //在工作线程启动之前创建所有父目录,避免多个线程同时创建同一目录
+    //之后各线程相对于输出目录的句柄打开文件
+    ::fgwsz::OutputDirectory output_dir(output_dir_path);
+    for(auto const* entry:selected_entries){
+        output_dir.create_parent_directories(entry->header.relative_path_string);
+    }
+    //生成解包任务:小文件整体作为一个任务,大文件切分为多个分块任务
+    //大文件预先创建并设置为最终大小,各分块任务按位置写入
+    constexpr ::std::uint64_t chunk_bytes=16*1024*1024;//16MB
+    struct Task{
+        ::std::size_t entry_index;
+        ::std::uint64_t offset;
+        ::std::uint64_t bytes;
+        bool whole_file;
+    };
+    ::std::vector<Task> tasks;
+    for(::std::size_t index=0;index<selected_entries.size();++index){
+        auto const& header=selected_entries[index]->header;
+        ::std::uint64_t const content_bytes=header.original_bytes;
+        //压缩文件项的帧只能从头开始逐帧定位,整体作为一个任务
+        if(content_bytes<=chunk_bytes||header.framed){
+            tasks.push_back({index,0,content_bytes,true});
+            continue;
+        }
+        auto file=output_dir.open_file(
+            selected_entries[index]->header.relative_path_string
+            ,::fgwsz::FileMode::write_truncate
+        );
+        file.preallocate(content_bytes);
+        file.resize(content_bytes);
+        file.close();
+        for(::std::uint64_t offset=0;offset<content_bytes;offset+=chunk_bytes){
+            tasks.push_back({
+                index
+                ,offset
+                ,(content_bytes-offset)<chunk_bytes
+                    ?(content_bytes-offset):chunk_bytes
+                ,false
+            });
+        }
+    }
+    //大任务优先,减少最后只剩少数线程在工作的时间
+    ::std::stable_sort(tasks.begin(),tasks.end(),
+        [](Task const& lhs,Task const& rhs){
+            return lhs.bytes>rhs.bytes;
+        }
+    );
+    //包文件已映射时各线程直接从映射内存解码,否则共享同一个包文件句柄按位置读取
+    ::fgwsz::File package;
+    if(!this->mapping_.is_mapped()){
+        package.open(this->package_path_string_,::fgwsz::FileMode::read);
     }
+    //块的大小等于帧的大小,压缩文件项的一帧解码到一个块中
+    constexpr ::std::uint64_t block_bytes=::fgwsz::frame_bytes;
+    ::std::vector<::std::unique_ptr<char[]>> blocks(this->thread_count_);
+    ::std::vector<::std::unique_ptr<char[]>> scratches(this->thread_count_);
+    //各文件内容的校验和:各任务的校验和移动到文件内容结束位置之后xor合并
+    ::std::vector<::std::atomic<::std::uint32_t>> checksums(
+        selected_entries.size()
+    );
+    ::fgwsz::parallel_for(tasks.size(),this->thread_count_,
+        [&](::std::size_t task_index,::std::size_t thread_index){
+            auto const& task=tasks[task_index];
+            auto const& entry=*(selected_entries[task.entry_index]);
+            ::std::uint32_t checksum=0;
+            if(nullptr==blocks[thread_index]){
+                blocks[thread_index]=::std::make_unique<char[]>(block_bytes);
+            }
+            char* block=blocks[thread_index].get();
+            auto file=output_dir.open_file(
+                entry.header.relative_path_string
+                ,task.whole_file
+                    ?::fgwsz::FileMode::write_truncate
+                    : ::fgwsz::FileMode::write
+            );
+            if(task.whole_file
+                &&!entry.header.framed
+                &&task.bytes>=this->preallocate_min_bytes_
+            ){
+                file.preallocate(task.bytes);
+            }
+            //绕过页缓存时大文件每写入一块就开始写回,
+            //之前写入的完整窗口写回完成之后丢弃页缓存,任务结束时丢弃剩余部分
+            bool const drop_cache=this->direct_io_
+                &&entry.header.original_bytes>=this->direct_min_bytes_;
+            ::std::uint64_t cache_offset=task.offset;
+            auto written=[&](::std::uint64_t offset,::std::uint64_t bytes){
+                if(drop_cache){
+                    file.start_writeback(offset,bytes);
+                    cache_offset=file.drop_cache_behind(cache_offset,offset);
+                }
+            };
+            auto drop_rest=[&](void){
+                ::std::uint64_t const end=task.offset+task.bytes;
+                if(drop_cache){
+                    file.drop_cache(
+                        cache_offset
+                        ,end==entry.header.original_bytes?0:end-cache_offset
+                    );
+                }
+            };
+            if(entry.header.framed){
+                if(nullptr==scratches[thread_index]){
+                    scratches[thread_index]=
+                        ::std::make_unique<char[]>(block_bytes);
+                }
+                //逐帧解码压缩文件项,跳过空洞帧(文件以空洞结束时最后设置文件大小)
+                ::std::uint64_t position=entry.content_offset;
+                bool hole_end=false;
+                for(::std::uint64_t count_bytes=0
+                    ;count_bytes<task.bytes
+                    ;count_bytes+=block_bytes
+                ){
+                    ::std::uint64_t const bytes=
+                        (task.bytes-count_bytes)<block_bytes
+                        ?(task.bytes-count_bytes):block_bytes;
+                    ::std::uint64_t const stored_bytes=this->decode_frame_at(
+                        entry.header
+                        ,position
+                        ,bytes
+                        ,package
+                        ,block
+                        ,scratches[thread_index].get()
+                        ,checksum
+                    );
+                    position+=stored_bytes;
+                    hole_end=::fgwsz::frame_head_bytes==stored_bytes;
+                    if(hole_end){
+                        file.skip(bytes);
+                    }else{
+                        file.write(block,bytes);
+                        written(count_bytes,bytes);
+                    }
+                }
+                if(hole_end){
+                    file.resize(task.bytes);
+                }
+                drop_rest();
+                file.close();
+                checksums[task.entry_index].fetch_xor(checksum);
+                this->release_range(entry.content_offset,position,package);
+                ::fgwsz::progress_add(
+                    ::fgwsz::record_end(entry)-entry.record_offset
+                    ,1
+                );
+                return;
+            }
+            ::std::uint64_t count_bytes=0;
+            while(count_bytes<task.bytes){
+                ::std::uint64_t const request=
+                    (task.bytes-count_bytes)<block_bytes
+                    ?(task.bytes-count_bytes):block_bytes;
+                ::std::uint64_t const offset=
+                    entry.content_offset+task.offset+count_bytes;
+                ::std::uint64_t read_bytes=0;
+                if(this->mapping_.is_mapped()){
+                    //文件项的范围在生成文件项信息时已经检查过
+                    checksum=::fgwsz::crc32c_key_xor_copy(
+                        block
+                        ,this->mapping_.data()+offset
+                        ,request
+                        ,entry.header.key
+                        ,checksum
+                    );
+                    read_bytes=request;
+                }else{
+                    read_bytes=package.read_at(block,request,offset);
+                    if(request!=read_bytes){
+                        FGWSZ_THROW_WHAT(
+                            "package read incomplete: "
+                            +this->package_path_string_
+                        );
+                    }
+                    //解码content的文件密钥xor混淆,同时计算校验和
+                    checksum=::fgwsz::crc32c_key_xor_copy(
+                        block
+                        ,block
+                        ,read_bytes
+                        ,entry.header.key
+                        ,checksum
+                    );
+                }
+                if(task.whole_file){
+                    file.write(block,read_bytes);
+                }else{
+                    file.write_at(block,read_bytes,task.offset+count_bytes);
+                }
+                written(task.offset+count_bytes,read_bytes);
+                count_bytes+=read_bytes;
+            }
+            drop_rest();
+            file.close();
+            checksums[task.entry_index].fetch_xor(::fgwsz::crc32c_shift(
+                checksum
+                ,entry.header.content_bytes-(task.offset+task.bytes)
+            ));
+            //释放该任务已解码完成的映射页面
+            this->release_range(
+                entry.content_offset+task.offset
+                ,entry.content_offset+task.offset+task.bytes
+                ,package
+            );
+            //文件的最后一个分块同时报告文件头和校验和的字节数
+            bool const last_task=
+                task.offset+task.bytes==entry.header.content_bytes;
+            ::fgwsz::progress_add(
+                task.bytes+(last_task
+                    ?::fgwsz::record_end(entry)-entry.record_offset
+                        -entry.header.content_bytes
+                    :0)
+                ,last_task?1:0
+            );
+        }
+    );
+    //合并文件头的校验和并与文件项保存的校验和比较
+    for(::std::size_t index=0;index<selected_entries.size();++index){
+        auto const& entry=*(selected_entries[index]);
+        if(entry.header.has_checksum
+            &&(::fgwsz::crc32c_shift(
+                this->header_checksum(entry,package)
+                ,entry.header.content_bytes
+            )^checksums[index].load())
+                !=this->stored_checksum(entry,package)
+        ){
+            FGWSZ_THROW_WHAT(
+                "checksum mismatch: "+entry.header.relative_path_string
+            );
+        }
+    }
+    this->unpack_references(output_dir_path,references,selected_entries);
+    //读取文件头和校验和之后再丢弃(之后访问映射内存会重新预读)
+    this->drop_package_cache(package);
 }
 void Unpacker::list_package(void){
-    //重置包文件流到头部和重置包读取字节计数器为0
-    this->reset_package();
     //文件id
     ::std::uint64_t file_id=0;
-    while(this->package_count_bytes_<this->package_bytes_){
-        //文件头信息处理阶段
-        this->unpack_header();
+    for(auto const& entry:this->entries()){
+        //压缩文件项额外显示压缩编码和内容在包内的字节数
+        ::std::string details;
+        if(entry.header.framed){
+            details=::std::format(
+                "\tcodec: {}\n"
+                "\tstored bytes: {}\n"
+                ,::fgwsz::codec_none==entry.header.codec?"none"
+                    : ::fgwsz::find_codec(entry.header.codec)->name
+                ,entry.header.content_bytes
+            );
+        }
+        //引用文件项额外显示被引用文件项的相对路径
+        if(entry.header.reference){
+            details=::std::format(
+                "\treference: {}\n"
+                ,this->resolve_entry(entry).header.relative_path_string
+            );
+        }
         ::fgwsz::cout<<::std::format(
             "file[{}]: {{\n"
             "\tkey: {}\n"
             "\trelative path bytes: {}\n"
             "\trelative path string: {}\n"
             "\tcontent bytes: {}\n"
+            "{}"
             "}}\n"
             ,file_id
-            ,static_cast<unsigned>(this->header_.key)
-            ,this->header_.relative_path_bytes
-            ,this->header_.relative_path_string
-            ,this->header_.content_bytes
+            ,static_cast<unsigned>(entry.header.key)
+            ,entry.header.relative_path_bytes
+            ,entry.header.relative_path_string
+            ,entry.header.original_bytes
+            ,details
         );
-        //文件内容信息跳过阶段
-        this->package_.seekg(this->header_.content_bytes,::std::ios::cur);
-        if(!this->package_.good()){
-            FGWSZ_THROW_WHAT(
-                "failed to skip content bytes: "
-                +this->header_.relative_path_string
-            );
-        }
-        this->package_count_bytes_+=this->header_.content_bytes;
         //更新文件id
         ++file_id;
     }
-    if(this->package_count_bytes_!=this->package_bytes_){
+}
+bool Unpacker::verify_header(::std::uint64_t& corrupted_count){
+    //文件头损坏时之后的文件项无法定位:计为损坏的文件项并结束校验
+    try{
+        return this->unpack_header();
+    }catch(::std::runtime_error const&){
+        ++corrupted_count;
+        ::fgwsz::cout<<::std::format(
+            "corrupted file item at offset {}\n"
+            ,this->record_offset_
+        );
+        this->records_bytes_=this->record_offset_;
+        this->package_count_bytes_=this->record_offset_;
+        return false;
+    }
+}
+bool Unpacker::verify_package(void){
+    if(this->streaming_){
+        return this->verify_stream();
+    }
+    //不含索引区时扫描文件头,损坏的文件头之前的文件项仍然校验
+    ::std::uint64_t corrupted_count=0;
+    if(!this->entries_loaded_){
+        this->reset_package();
+        ::fgwsz::Entry entry={};
+        while(this->verify_header(corrupted_count)){
+            entry.record_offset=this->record_offset_;
+            entry.content_offset=this->package_count_bytes_;
+            this->skip_content();
+            entry.header=this->header_;
+            this->entries_.push_back(entry);
+        }
+        this->entries_loaded_=true;
+        this->map_entries();
+    }
+    //生成校验任务:文件项的校验范围(控制序列之后到内容结束)切分为多个分块任务
+    constexpr ::std::uint64_t chunk_bytes=16*1024*1024;//16MB
+    struct Task{
+        ::std::size_t entry_index;
+        ::std::uint64_t offset;     //在包内的位置
+        ::std::uint64_t bytes;
+    };
+    auto const& entries=this->entries();
+    ::std::vector<Task> tasks;
+    ::std::uint64_t unchecked_count=0;
+    for(::std::size_t index=0;index<entries.size();++index){
+        auto const& entry=entries[index];
+        if(!entry.header.has_checksum){
+            ++unchecked_count;
+            continue;
+        }
+        ::std::uint64_t const end=
+            entry.content_offset+entry.header.content_bytes;
+        ::std::uint64_t offset=::fgwsz::checksum_offset(entry);
+        do{
+            ::std::uint64_t const bytes=
+                (end-offset)<chunk_bytes?(end-offset):chunk_bytes;
+            tasks.push_back({index,offset,bytes});
+            offset+=bytes;
+        }while(offset<end);
+    }
+    //包文件已映射时直接计算映射内存的校验和,否则各线程按位置读取到各自的块中
+    ::fgwsz::File package;
+    if(!this->mapping_.is_mapped()){
+        package.open(this->package_path_string_,::fgwsz::FileMode::read);
+    }
+    constexpr ::std::uint64_t block_bytes=1024*1024;//1MB
+    ::std::vector<::std::unique_ptr<char[]>> blocks(this->thread_count_);
+    //各文件项的校验和:各任务的校验和移动到内容结束位置之后xor合并
+    ::std::vector<::std::atomic<::std::uint32_t>> checksums(entries.size());
+    ::fgwsz::parallel_for(tasks.size(),this->thread_count_,
+        [&](::std::size_t task_index,::std::size_t thread_index){
+            auto const& task=tasks[task_index];
+            auto const& entry=entries[task.entry_index];
+            ::std::uint32_t checksum=0;
+            if(this->mapping_.is_mapped()){
+                checksum=::fgwsz::crc32c(
+                    0
+                    ,this->mapping_.data()+task.offset
+                    ,task.bytes
+                );
+                this->release_range(task.offset,task.offset+task.bytes,package);
+            }else{
+                if(nullptr==blocks[thread_index]){
+                    blocks[thread_index]=
+                        ::std::make_unique<char[]>(block_bytes);
+                }
+                char* block=blocks[thread_index].get();
+                for(::std::uint64_t count_bytes=0;count_bytes<task.bytes;){
+                    ::std::uint64_t const bytes=
+                        (task.bytes-count_bytes)<block_bytes
+                        ?(task.bytes-count_bytes):block_bytes;
+                    this->read_records_at(
+                        block
+                        ,bytes
+                        ,task.offset+count_bytes
+                        ,package
+                    );
+                    checksum=::fgwsz::crc32c(checksum,block,bytes);
+                    count_bytes+=bytes;
+                }
+            }
+            checksums[task.entry_index].fetch_xor(::fgwsz::crc32c_shift(
+                checksum
+                ,entry.content_offset+entry.header.content_bytes
+                    -(task.offset+task.bytes)
+            ));
+        }
+    );
+    //与文件项保存的校验和比较,打印所有损坏的文件项
+    for(::std::size_t index=0;index<entries.size();++index){
+        auto const& entry=entries[index];
+        if(entry.header.has_checksum
+            &&checksums[index].load()!=this->stored_checksum(entry,package)
+        ){
+            ++corrupted_count;
+            ::fgwsz::cout<<::std::format(
+                "checksum mismatch: {}\n"
+                ,entry.header.relative_path_string
+            );
+        }
+    }
+    this->drop_package_cache(package);
+    ::fgwsz::cout<<::std::format(
+        "verified file items: {}\n"
+        "file items without checksum: {}\n"
+        "corrupted file items: {}\n"
+        ,entries.size()-unchecked_count
+        ,unchecked_count
+        ,corrupted_count
+    );
+    return 0==corrupted_count;
+}
+bool Unpacker::verify_stream(void){
+    //流式读取时只能顺序校验:读取文件项内容的同时计算校验和,不解码
+    ::std::uint64_t checked_count=0;
+    ::std::uint64_t unchecked_count=0;
+    ::std::uint64_t corrupted_count=0;
+    //已读取的不是引用文件项的文件项起始位置和内容大小(用于检查引用文件项)
+    ::std::unordered_map<::std::uint64_t,::std::uint64_t> original_bytes;
+    this->reset_package();
+    while(this->verify_header(corrupted_count)){
+        if(!this->header_.reference){
+            original_bytes.insert_or_assign(
+                this->record_offset_
+                ,this->header_.original_bytes
+            );
+        }
+        if(!this->header_.has_checksum){
+            ++unchecked_count;
+            this->skip_content();
+            continue;
+        }
+        ++checked_count;
+        this->skip_stored();
+        if(!this->unpack_checksum()){
+            ++corrupted_count;
+            ::fgwsz::cout<<::std::format(
+                "checksum mismatch: {}\n"
+                ,this->header_.relative_path_string
+            );
+            continue;
+        }
+        auto const iter=original_bytes.find(this->header_.reference_offset);
+        if(this->header_.reference
+            &&(original_bytes.end()==iter
+                ||iter->second!=this->header_.original_bytes)
+        ){
+            ++corrupted_count;
+            ::fgwsz::cout<<::std::format(
+                "invalid file item reference: {}\n"
+                ,this->header_.relative_path_string
+            );
+        }
+    }
+    if(this->package_count_bytes_!=this->records_bytes_){
         FGWSZ_THROW_WHAT(
             "package read incomplete: "+this->package_path_string_
         );
     }
+    ::fgwsz::cout<<::std::format(
+        "verified file items: {}\n"
+        "file items without checksum: {}\n"
+        "corrupted file items: {}\n"
+        ,checked_count
+        ,unchecked_count
+        ,corrupted_count
+    );
+    return 0==corrupted_count;
 }
 
 }//namespace fgwsz
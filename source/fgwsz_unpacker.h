@@ -1,46 +1,308 @@
 #ifndef FGWSZ_UNPACKER_H
 #define FGWSZ_UNPACKER_H
 
-#include<cstdint>   //::std::uint8_t ::std::uint64_t
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
 
 #include<string>    //::std::string
-#include<fstream>   //::std::ifstream
 #include<filesystem>//::std::filesystem
+#include<vector>    //::std::vector
+#include<unordered_map>//::std::unordered_map
+#include<unordered_set>//::std::unordered_set
+#include<string_view>//::std::string_view
+#include<memory>    //::std::unique_ptr
+#include<functional>//::std::function
 
 #include"fgwsz_header.h"
+#include"fgwsz_writer.h"
+#include"fgwsz_reader.h"
+#include"fgwsz_mmap.h"
+#include"fgwsz_file.h"
+#include"fgwsz_uring.h"
+#include"fgwsz_directory.h"
+#include"fgwsz_stream.h"
 
 namespace fgwsz{
 
+class PackageReader;
+
+//包文件能够被内存映射时直接从映射内存解码,否则使用缓冲读取器读取
 class Unpacker{
 public:
+    //包路径为"-"时从标准输入流式读取包(只能顺序解包和显示,不使用索引区)
     Unpacker(::std::filesystem::path const& package_path);
+    //从内存中的包读取(直接从内存解码,不复制,内存在Unpacker销毁之前必须保持有效)
+    Unpacker(void const* data,::std::uint64_t bytes);
+    //从已经打开的文件读取(例如文件描述符),普通文件被内存映射,否则流式读取
+    explicit Unpacker(::fgwsz::File&& package);
+    //从读取回调流式读取包
+    explicit Unpacker(::fgwsz::ReadFunction read);
     ~Unpacker(void);
     //解包到指定的输出目录下
     void unpack_package(::std::filesystem::path const& output_dir_path);
+    //只解包相对路径匹配任意模式(通配符或目录前缀)的文件到指定的输出目录下
+    //不匹配的文件内容直接跳过,不会被读取和解码
+    void unpack_package(
+        ::std::filesystem::path const& output_dir_path
+        ,::std::vector<::std::string> const& patterns
+    );
+    //解包到回调:按包内顺序为每个文件项调用create,文件内容写入返回的写入回调
+    //(create返回空的写入回调时丢弃这个文件的内容),只使用当前线程
+    void unpack_package(::fgwsz::CreateFunction const& create);
+    void unpack_package(
+        ::fgwsz::CreateFunction const& create
+        ,::std::vector<::std::string> const& patterns
+    );
     //显示包内的文件信息
     void list_package(void);
+    //校验包内所有文件项的校验和,不写入任何输出文件
+    //按文件项和内容分块由多个线程同时校验,打印损坏的文件项,全部通过时返回true
+    bool verify_package(void);
+    //包内所有文件项信息(包含索引区时只读取索引区,否则扫描所有文件头)
+    ::std::vector<::fgwsz::Entry> const& entries(void);
+    //根据相对路径查找文件项(同一路径出现多次时返回最后一次出现的文件项)
+    ::fgwsz::Entry const* find_entry(::std::string_view relative_path);
+    //引用文件项被引用的文件项,其他文件项返回自身(文件项信息读取之后才能调用)
+    ::fgwsz::Entry const& resolve_entry(::fgwsz::Entry const& entry)const;
+    //包是否包含索引区
+    bool has_index(void)const noexcept;
+    //记录区的结束位置(包含索引区时为索引区的起始位置,扫描文件头之后才能确定)
+    ::std::uint64_t records_bytes(void)const noexcept;
+    //包是否以分片头开始(分片打包生成的分片包),以及分片序号和分片数
+    //(流式读取时读取第一个文件头之后才能确定)
+    bool is_shard(void)const noexcept;
+    ::std::uint64_t shard_index(void)const noexcept;
+    ::std::uint64_t shard_count(void)const noexcept;
+    //设置解包使用的线程数(0表示使用硬件并发线程数)
+    //多于1个线程时,各线程按位置读取包文件并同时写入不同的输出文件
+    void set_thread_count(::std::size_t thread_count);
+    //设置单线程解包时的I/O后端
+    //使用io_uring时批量创建目录,同时进行多个输出文件的打开,写入和关闭
+    void set_io_backend(::fgwsz::IoBackend io_backend);
+    //设置读写时是否绕过页缓存(不使用io_uring,读取回调和写入回调时忽略)
+    //未映射的包文件和不小于4MB的输出文件使用直接I/O(O_DIRECT),不支持时
+    //与映射的包文件和多线程写入的输出文件相同,按窗口丢弃页缓存
+    void set_direct_io(bool direct_io);
+    //设置解包到输出目录时是否把引用文件项创建为被引用文件的硬链接
+    //(默认复制已解包的文件,不支持硬链接时也复制)
+    void set_hardlink(bool hardlink);
+    //设置带模式解包时是否要求每个模式都匹配到文件(默认要求,否则抛出异常)
+    //不要求时由调用者检查matched_patterns(例如分片解包时合并所有分片的结果)
+    void set_pattern_check(bool pattern_check);
+    //上一次带模式解包时每个模式是否匹配到了文件
+    ::std::vector<bool> const& matched_patterns(void)const noexcept;
     //禁止拷贝
     Unpacker(Unpacker const&)noexcept=delete;
     Unpacker& operator=(Unpacker const&)noexcept=delete;
 private:
+    //随机访问读取器复用文件项信息和按位置解码帧的实现
+    //(以下按位置读取记录区的函数可以被多个线程同时调用)
+    friend class ::fgwsz::PackageReader;
+    //以随机访问方式使用包:映射内存改为随机访问提示,流式读取的包返回false
+    bool prepare_random_access(void);
+    //包路径字符串(用于打开按位置读取的包文件和抛出异常时的信息显示)
+    ::std::string const& package_path_string(void)const noexcept;
+    //包文件映射内存的起始地址(没有映射时为nullptr,不需要通过package读取)
+    char const* mapped_data(void)const noexcept;
+    //从记录区的offset位置读取bytes字节(没有映射时从package按位置读取),越界时抛出异常
+    void read_records_at(
+        void* ptr
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+        ,::fgwsz::File const& package
+    )const;
+    //文件项的文件头部分(控制序列之后到文件内容起始位置)的校验和
+    ::std::uint32_t header_checksum(
+        ::fgwsz::Entry const& entry
+        ,::fgwsz::File const& package
+    )const;
+    //文件项内容之后保存的校验和(已解码为主机序)
+    ::std::uint32_t stored_checksum(
+        ::fgwsz::Entry const& entry
+        ,::fgwsz::File const& package
+    )const;
+    //解析帧头:bytes为这一帧解码之后的字节数,帧头无效时返回false
+    static bool parse_frame_head(
+        ::std::uint32_t head
+        ,::std::uint64_t bytes
+        ,::std::uint64_t& data_bytes
+        ,bool& raw
+    );
+    //解码offset处的一帧(bytes为解码之后的字节数)到dst,返回这一帧在包内的字节数
+    //同时把包内的帧接在checksum之后计算校验和,空洞帧不写入dst
+    ::std::uint64_t decode_frame_at(
+        ::fgwsz::Header const& header
+        ,::std::uint64_t offset
+        ,::std::uint64_t bytes
+        ,::fgwsz::File const& package
+        ,char* dst
+        ,char* scratch
+        ,::std::uint32_t& checksum
+    )const;
+    //顺序解包时关联输出文件或者写入回调到合并写入器
+    using OpenFunction=::std::function<void(
+        ::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+    )>;
+    //顺序解包时把引用文件项链接或者复制为已经解包的被引用文件(相对路径)
+    using LinkFunction=::std::function<void(
+        ::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+        ,::std::string const& target_path_string
+    )>;
+    //已经解包到输出目录并且内容仍然保留的文件项
+    //(同一路径被之后的文件项覆盖时,之前的文件项不再保留)
+    struct UnpackedFiles{
+        //文件项起始位置到相对路径
+        ::std::unordered_map<::std::uint64_t,::std::string> paths;
+        //相对路径到文件项起始位置
+        ::std::unordered_map<::std::string,::std::uint64_t> records;
+        void add(::std::uint64_t record_offset,::std::string const& path);
+    };
+    void init(void);
+    void open_stream(void);
+    void open_mapping(void);
     void reset_package(void);
+    void package_seek(::std::uint64_t offset);
+    bool package_read_at(
+        void* ptr
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+    );
+    void release_package(void);
+    void release_range(
+        ::std::uint64_t begin
+        ,::std::uint64_t end
+        ,::fgwsz::File const& package
+    )noexcept;
+    void drop_package_cache(::fgwsz::File const& package)noexcept;
+    void report_progress(::std::uint64_t files);
+    void unpack_shard_head(void);
+    void parse_shard_head(char* fields);
+    bool unpack_index(void);
+    void load_entries(void);
+    void map_entries(void);
     ::std::uint64_t package_read(void* ptr,::std::uint64_t bytes);
-    void key_xor(void* ptr,::std::uint64_t bytes);
+    void package_decode(void* ptr,::std::uint64_t bytes);
+    void package_skip(::std::uint64_t bytes);
     void unpack_key(void);
     void unpack_relative_path_bytes(void);
+    void assert_header_bytes(
+        ::std::uint64_t bytes
+        ,::std::uint64_t max_bytes
+    )const;
     void unpack_relative_path_string(void);
     void unpack_content_bytes(void);
-    void unpack_header(void);
-    void unpack_content(
+    void unpack_codec(void);
+    void unpack_reference_fields(void);
+    bool unpack_header(void);
+    void skip_content(void);
+    void skip_stored(void);
+    void skip_checksum(void);
+    bool unpack_checksum(void);
+    static bool is_record_control(::std::uint8_t control);
+    bool verify_header(::std::uint64_t& corrupted_count);
+    bool verify_stream(void);
+    ::std::uint64_t unpack_frame_head(::std::uint64_t bytes,bool& raw);
+    void select_entries(
+        ::std::vector<::std::string> const& patterns
+        ,::std::vector<::fgwsz::Entry const*>& selected_entries
+        ,::std::vector<::fgwsz::Entry const*>& references
+    );
+    void open_output(
+        ::fgwsz::OutputDirectory& output_dir
+        ,::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+    );
+    void link_output(
+        ::fgwsz::OutputDirectory& output_dir
+        ,::fgwsz::BufferedWriter& file
+        ,::fgwsz::Header const& header
+        ,::std::string const& target_path_string
+    );
+    void unpack_references(
+        ::std::filesystem::path const& output_dir_path
+        ,::std::vector<::fgwsz::Entry const*> const& references
+        ,::std::vector<::fgwsz::Entry const*> const& selected_entries
+    );
+    void unpack_uring(
+        ::std::filesystem::path const& output_dir_path
+        ,::std::vector<::std::string> const& patterns
+    );
+    void unpack_parallel(
         ::std::filesystem::path const& output_dir_path
-        ,char* block
-        ,::std::uint64_t block_bytes
+        ,::std::vector<::std::string> const& patterns
+    );
+    void unpack_sequential(
+        ::std::vector<::std::string> const& patterns
+        ,OpenFunction const& open
+        ,LinkFunction const& link
+    );
+    void unpack_entry(
+        OpenFunction const& open
+        ,LinkFunction const& link
+        ,UnpackedFiles& unpacked
+    );
+    void unpack_reference(
+        OpenFunction const& open
+        ,LinkFunction const& link
+        ,UnpackedFiles& unpacked
     );
-    ::std::ifstream package_;
+    void unpack_content(OpenFunction const& open);
+    void decode_stored(void* dst,void const* src,::std::uint64_t bytes);
+    ::std::uint64_t unpack_stored(::std::uint64_t bytes);
+    ::std::uint64_t unpack_frames(void);
+    //不压缩的输出文件不小于这个大小时写入之前预分配磁盘空间(一次写入的文件不需要)
+    static constexpr ::std::uint64_t preallocate_min_bytes_=
+        ::fgwsz::BufferedWriter::default_buffer_bytes;
+    //绕过页缓存时输出文件不小于这个大小才绕过(小文件仍然经过页缓存写入)
+    static constexpr ::std::uint64_t direct_min_bytes_=
+        ::fgwsz::BufferedWriter::default_buffer_bytes;
+    ::fgwsz::BufferedReader package_;
+    //是否流式读取包(标准输入,管道或者读取回调)
+    bool streaming_;
+    //包文件的只读内存映射或者关联的内存(映射成功时不打开读取器)
+    ::fgwsz::MappedFile mapping_;
+    //映射内存中已释放页面的结束位置
+    ::std::uint64_t released_bytes_;
+    //是否绕过页缓存读写,以及绕过时用于丢弃映射的包文件页缓存的文件句柄
+    bool direct_io_;
+    ::fgwsz::File cache_file_;
+    //顺序解包时已报告进度的位置
+    ::std::uint64_t progress_offset_;
     ::std::string package_path_string_;
     ::std::uint64_t package_bytes_;
     ::std::uint64_t package_count_bytes_;
+    ::std::uint64_t records_bytes_;
     ::fgwsz::Header header_;
+    //当前文件项的起始位置
+    ::std::uint64_t record_offset_;
+    bool has_index_;
+    //分片头中的分片序号和分片数(不是分片包时分片数为0)
+    ::std::uint64_t shard_index_;
+    ::std::uint64_t shard_count_;
+    ::std::size_t thread_count_;
+    ::fgwsz::IoBackend io_backend_;
+    bool entries_loaded_;
+    ::std::vector<::fgwsz::Entry> entries_;
+    ::std::unordered_map<::std::string_view,::std::size_t> entry_indexes_;
+    //文件项起始位置到文件项的映射(用于查找被引用的文件项)
+    ::std::unordered_map<::std::uint64_t,::std::size_t> record_indexes_;
+    //是否把引用文件项创建为硬链接,以及本次解包中创建了硬链接的相对路径
+    //(之后覆盖这些路径时先删除文件,不修改与之共享内容的其他文件)
+    bool hardlink_;
+    ::std::unordered_set<::std::string> linked_paths_;
+    //是否要求每个模式都匹配到文件,以及上一次带模式解包时每个模式的匹配结果
+    bool pattern_check_;
+    ::std::vector<bool> matched_patterns_;
+    //解包输出文件的合并写入器(缓冲区在所有输出文件之间复用)
+    ::fgwsz::BufferedWriter file_;
+    //解码压缩文件项时的帧数据和解压输出块(第一次解码压缩文件项时分配)
+    ::std::unique_ptr<char[]> frame_;
+    ::std::unique_ptr<char[]> block_;
+    //当前文件项的校验和(读取带校验和的文件项时计算)
+    ::std::uint32_t checksum_;
+    bool checksumming_;
 };
 
 }//namespace fgwsz
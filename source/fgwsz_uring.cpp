@@ -0,0 +1,500 @@
+#include"fgwsz_uring.h"
+
+#include<cstdint>   //::std::uint32_t ::std::uint64_t ::std::uintptr_t
+#include<cstddef>   //::std::size_t
+#include<cstring>   //::std::memset
+
+#include<atomic>    //::std::atomic ::std::atomic_ref ::std::memory_order
+#include<memory>    //::std::unique_ptr ::std::make_unique
+#include<string>    //::std::string
+#include<vector>    //::std::vector
+#include<chrono>    //::std::chrono
+#include<system_error>//::std::generic_category ::std::system_category
+
+#if defined(__linux__)&&__has_include(<linux/io_uring.h>)
+    #define FGWSZ_URING 1
+    #include<cerrno>        //errno EINTR EAGAIN EBUSY
+    #include<fcntl.h>       //AT_FDCWD O_RDONLY O_WRONLY O_CREAT O_TRUNC
+    #include<unistd.h>      //::syscall ::close
+    #include<sys/syscall.h> //__NR_io_uring_setup __NR_io_uring_enter
+                            //__NR_io_uring_register
+    #include<sys/mman.h>    //::mmap ::munmap
+    #include<linux/io_uring.h>
+#else
+    #define FGWSZ_URING 0
+#endif
+
+#include"fgwsz_except.h"
+#include"fgwsz_stats.h"
+
+namespace fgwsz{
+
+namespace detail{
+//所有io_uring队列累计的计数(多个线程可以同时使用各自的队列)
+inline ::std::atomic<::std::uint64_t> uring_enters{0};
+inline ::std::atomic<::std::uint64_t> uring_submitted{0};
+}//namespace fgwsz::detail
+bool use_io_uring(::fgwsz::IoBackend backend){
+    if(::fgwsz::IoBackend::sync==backend){
+        return false;
+    }
+    bool const available=::fgwsz::IoRing::available();
+    if(::fgwsz::IoBackend::uring==backend&&!available){
+        FGWSZ_THROW_WHAT("io_uring is not available on this system");
+    }
+    return available;
+}
+::fgwsz::IoUringCounts io_uring_counts(void)noexcept{
+    return {
+        ::fgwsz::detail::uring_enters.load(::std::memory_order_relaxed)
+        ,::fgwsz::detail::uring_submitted.load(::std::memory_order_relaxed)
+    };
+}
+::std::string io_error_message(int result){
+    return ::std::generic_category().message(-result);
+}
+void io_preallocate(int fd,::std::uint64_t bytes)noexcept{
+#if FGWSZ_URING
+    ::fgwsz::File::preallocate(fd,bytes);
+#else
+    (void)fd;(void)bytes;
+#endif
+}
+
+#if FGWSZ_URING
+//内核共享的提交队列和完成队列
+struct IoRing::Ring{
+    int fd=-1;
+    unsigned sq_entries=0;
+    void* sq_ring=nullptr;
+    ::std::size_t sq_ring_bytes=0;
+    void* cq_ring=nullptr;
+    ::std::size_t cq_ring_bytes=0;
+    ::io_uring_sqe* sqes=nullptr;
+    ::std::size_t sqes_bytes=0;
+    unsigned* sq_tail=nullptr;
+    unsigned* sq_mask=nullptr;
+    unsigned* sq_array=nullptr;
+    unsigned* cq_head=nullptr;
+    unsigned* cq_tail=nullptr;
+    unsigned* cq_mask=nullptr;
+    ::io_uring_cqe* cqes=nullptr;
+    //本地维护的提交队列尾部(提交时才发布给内核)
+    unsigned local_sq_tail=0;
+    //已准备还未提交给内核的请求数
+    unsigned to_submit=0;
+    ::std::size_t in_flight=0;
+    bool mkdirat_supported=false;
+    //未完成的请求:调用者的用户数据,统计的阶段和提交时间
+    //提交给内核的用户数据是请求在slots中的位置,取出完成事件时换回调用者的用户数据
+    struct Slot{
+        ::std::uint64_t user_data;
+        ::fgwsz::StatsPhase phase;
+        bool timed;
+        ::std::chrono::steady_clock::time_point start;
+    };
+    ::std::vector<Slot> slots;
+    ::std::vector<unsigned> free_slots;
+    //已准备还未提交的请求所在的位置(统计开启时提交时记录提交时间)
+    ::std::vector<unsigned> pending_slots;
+    //取得下一个提交队列项
+    //同时进行的请求数不超过队列长度,从而保证完成队列不会溢出
+    ::io_uring_sqe* next_sqe(
+        ::fgwsz::StatsPhase phase
+        ,::std::uint64_t user_data
+    ){
+        if(this->in_flight>=this->sq_entries){
+            FGWSZ_THROW_WHAT("io_uring submission queue is full");
+        }
+        unsigned const index=this->local_sq_tail&*(this->sq_mask);
+        this->sq_array[index]=index;
+        ++(this->local_sq_tail);
+        ++(this->to_submit);
+        ++(this->in_flight);
+        ::io_uring_sqe* sqe=this->sqes+index;
+        ::std::memset(sqe,0,sizeof(*sqe));
+        unsigned const slot=this->free_slots.back();
+        this->free_slots.pop_back();
+        this->slots[slot]={user_data,phase,false,{}};
+        this->pending_slots.push_back(slot);
+        sqe->user_data=slot;
+        return sqe;
+    }
+    ~Ring(void){
+        if(nullptr!=this->sqes){
+            ::munmap(this->sqes,this->sqes_bytes);
+        }
+        if(nullptr!=this->cq_ring&&this->cq_ring!=this->sq_ring){
+            ::munmap(this->cq_ring,this->cq_ring_bytes);
+        }
+        if(nullptr!=this->sq_ring){
+            ::munmap(this->sq_ring,this->sq_ring_bytes);
+        }
+        if(-1!=this->fd){
+            ::close(this->fd);
+        }
+    }
+};
+namespace detail{
+inline unsigned load_acquire(unsigned* ptr){
+    return ::std::atomic_ref<unsigned>(*ptr).load(::std::memory_order_acquire);
+}
+inline void store_release(unsigned* ptr,unsigned value){
+    ::std::atomic_ref<unsigned>(*ptr).store(value,::std::memory_order_release);
+}
+inline ::std::string uring_error_message(int error){
+    return ::std::system_category().message(error);
+}
+}//namespace fgwsz::detail
+#else
+struct IoRing::Ring{};
+#endif//FGWSZ_URING
+
+IoRing::IoRing(void)noexcept=default;
+IoRing::~IoRing(void)=default;
+bool IoRing::available(void){
+    static bool const result=[](void){
+        ::fgwsz::IoRing ring;
+        return ring.init(8);
+    }();
+    return result;
+}
+bool IoRing::init(unsigned entries){
+    this->ring_.reset();
+#if FGWSZ_URING
+    auto ring=::std::make_unique<Ring>();
+    ::io_uring_params params;
+    ::std::memset(&params,0,sizeof(params));
+    ring->fd=static_cast<int>(::syscall(__NR_io_uring_setup,entries,&params));
+    //ENOSYS(内核不支持)或EPERM(被禁用)
+    if(ring->fd<0){
+        ring->fd=-1;
+        return false;
+    }
+    //需要内核保证完成事件不会丢失
+    if(0==(params.features&IORING_FEAT_NODROP)){
+        return false;
+    }
+    ring->sq_entries=params.sq_entries;
+    ring->sq_ring_bytes=params.sq_off.array+params.sq_entries*sizeof(unsigned);
+    ring->cq_ring_bytes=
+        params.cq_off.cqes+params.cq_entries*sizeof(::io_uring_cqe);
+    bool const single_mmap=0!=(params.features&IORING_FEAT_SINGLE_MMAP);
+    if(single_mmap){
+        if(ring->cq_ring_bytes>ring->sq_ring_bytes){
+            ring->sq_ring_bytes=ring->cq_ring_bytes;
+        }
+        ring->cq_ring_bytes=ring->sq_ring_bytes;
+    }
+    void* sq_ring=::mmap(
+        nullptr,ring->sq_ring_bytes,PROT_READ|PROT_WRITE
+        ,MAP_SHARED|MAP_POPULATE,ring->fd,IORING_OFF_SQ_RING
+    );
+    if(MAP_FAILED==sq_ring){
+        return false;
+    }
+    ring->sq_ring=sq_ring;
+    if(single_mmap){
+        ring->cq_ring=sq_ring;
+    }else{
+        void* cq_ring=::mmap(
+            nullptr,ring->cq_ring_bytes,PROT_READ|PROT_WRITE
+            ,MAP_SHARED|MAP_POPULATE,ring->fd,IORING_OFF_CQ_RING
+        );
+        if(MAP_FAILED==cq_ring){
+            return false;
+        }
+        ring->cq_ring=cq_ring;
+    }
+    ring->sqes_bytes=params.sq_entries*sizeof(::io_uring_sqe);
+    void* sqes=::mmap(
+        nullptr,ring->sqes_bytes,PROT_READ|PROT_WRITE
+        ,MAP_SHARED|MAP_POPULATE,ring->fd,IORING_OFF_SQES
+    );
+    if(MAP_FAILED==sqes){
+        return false;
+    }
+    ring->sqes=static_cast<::io_uring_sqe*>(sqes);
+    auto sq_base=static_cast<char*>(ring->sq_ring);
+    auto cq_base=static_cast<char*>(ring->cq_ring);
+    ring->sq_tail=reinterpret_cast<unsigned*>(sq_base+params.sq_off.tail);
+    ring->sq_mask=reinterpret_cast<unsigned*>(sq_base+params.sq_off.ring_mask);
+    ring->sq_array=reinterpret_cast<unsigned*>(sq_base+params.sq_off.array);
+    ring->cq_head=reinterpret_cast<unsigned*>(cq_base+params.cq_off.head);
+    ring->cq_tail=reinterpret_cast<unsigned*>(cq_base+params.cq_off.tail);
+    ring->cq_mask=reinterpret_cast<unsigned*>(cq_base+params.cq_off.ring_mask);
+    ring->cqes=reinterpret_cast<::io_uring_cqe*>(cq_base+params.cq_off.cqes);
+    ring->local_sq_tail=*(ring->sq_tail);
+    //检查内核支持的操作
+    constexpr unsigned probe_ops=256;
+    ::std::size_t const probe_bytes=
+        sizeof(::io_uring_probe)+probe_ops*sizeof(::io_uring_probe_op);
+    auto probe_buffer=::std::make_unique<unsigned char[]>(probe_bytes);
+    auto probe=reinterpret_cast<::io_uring_probe*>(probe_buffer.get());
+    if(0!=::syscall(
+        __NR_io_uring_register,ring->fd,IORING_REGISTER_PROBE,probe,probe_ops
+    )){
+        return false;
+    }
+    auto supported=[probe](unsigned op){
+        return op<=probe->last_op
+            &&0!=(probe->ops[op].flags&IO_URING_OP_SUPPORTED);
+    };
+    if(!supported(IORING_OP_READ)
+        ||!supported(IORING_OP_WRITE)
+        ||!supported(IORING_OP_OPENAT)
+        ||!supported(IORING_OP_CLOSE)
+    ){
+        return false;
+    }
+    ring->mkdirat_supported=supported(IORING_OP_MKDIRAT);
+    ring->slots.resize(ring->sq_entries);
+    ring->free_slots.reserve(ring->sq_entries);
+    for(unsigned slot=ring->sq_entries;slot>0;--slot){
+        ring->free_slots.push_back(slot-1);
+    }
+    ring->pending_slots.reserve(ring->sq_entries);
+    this->ring_=::std::move(ring);
+    return true;
+#else
+    (void)entries;
+    return false;
+#endif
+}
+bool IoRing::is_initialized(void)const noexcept{
+    return nullptr!=this->ring_;
+}
+bool IoRing::supports_mkdirat(void)const noexcept{
+#if FGWSZ_URING
+    return this->is_initialized()&&this->ring_->mkdirat_supported;
+#else
+    return false;
+#endif
+}
+::std::size_t IoRing::in_flight(void)const noexcept{
+#if FGWSZ_URING
+    return this->is_initialized()?this->ring_->in_flight:0;
+#else
+    return 0;
+#endif
+}
+::std::size_t IoRing::space(void)const noexcept{
+#if FGWSZ_URING
+    return this->is_initialized()
+        ?this->ring_->sq_entries-this->ring_->in_flight:0;
+#else
+    return 0;
+#endif
+}
+void IoRing::prepare_read(
+    int fd
+    ,void* ptr
+    ,::std::uint32_t bytes
+    ,::std::uint64_t offset
+    ,::std::uint64_t user_data
+){
+#if FGWSZ_URING
+    auto sqe=this->ring_->next_sqe(::fgwsz::StatsPhase::read,user_data);
+    sqe->opcode=IORING_OP_READ;
+    sqe->fd=fd;
+    sqe->addr=reinterpret_cast<::std::uintptr_t>(ptr);
+    sqe->len=bytes;
+    sqe->off=offset;
+#else
+    (void)fd;(void)ptr;(void)bytes;(void)offset;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_write(
+    int fd
+    ,void const* src
+    ,::std::uint32_t bytes
+    ,::std::uint64_t offset
+    ,::std::uint64_t user_data
+){
+#if FGWSZ_URING
+    auto sqe=this->ring_->next_sqe(::fgwsz::StatsPhase::write,user_data);
+    sqe->opcode=IORING_OP_WRITE;
+    sqe->fd=fd;
+    sqe->addr=reinterpret_cast<::std::uintptr_t>(src);
+    sqe->len=bytes;
+    sqe->off=offset;
+#else
+    (void)fd;(void)src;(void)bytes;(void)offset;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_openat(
+    char const* path
+    ,::fgwsz::FileMode mode
+    ,::std::uint64_t user_data
+){
+#if FGWSZ_URING
+    this->prepare_openat(AT_FDCWD,path,mode,user_data);
+#else
+    (void)path;(void)mode;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_openat(
+    int dir_fd
+    ,char const* path
+    ,::fgwsz::FileMode mode
+    ,::std::uint64_t user_data
+){
+#if FGWSZ_URING
+    //与::fgwsz::File::open使用相同的打开方式
+    int flags=O_RDONLY;
+    if(::fgwsz::FileMode::write==mode){
+        flags=O_WRONLY|O_CREAT;
+    }else if(::fgwsz::FileMode::write_truncate==mode){
+        flags=O_WRONLY|O_CREAT|O_TRUNC;
+    }
+    auto sqe=this->ring_->next_sqe(::fgwsz::StatsPhase::open,user_data);
+    sqe->opcode=IORING_OP_OPENAT;
+    sqe->fd=dir_fd;
+    sqe->addr=reinterpret_cast<::std::uintptr_t>(path);
+    sqe->len=0666;
+    sqe->open_flags=static_cast<::std::uint32_t>(flags|O_CLOEXEC);
+#else
+    (void)dir_fd;(void)path;(void)mode;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_close(int fd,::std::uint64_t user_data){
+#if FGWSZ_URING
+    auto sqe=this->ring_->next_sqe(::fgwsz::StatsPhase::close,user_data);
+    sqe->opcode=IORING_OP_CLOSE;
+    sqe->fd=fd;
+#else
+    (void)fd;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_mkdirat(char const* path,::std::uint64_t user_data){
+#if FGWSZ_URING
+    this->prepare_mkdirat(AT_FDCWD,path,user_data);
+#else
+    (void)path;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::prepare_mkdirat(
+    int dir_fd
+    ,char const* path
+    ,::std::uint64_t user_data
+){
+#if FGWSZ_URING
+    auto sqe=this->ring_->next_sqe(::fgwsz::StatsPhase::mkdir,user_data);
+    sqe->opcode=IORING_OP_MKDIRAT;
+    sqe->fd=dir_fd;
+    sqe->addr=reinterpret_cast<::std::uintptr_t>(path);
+    sqe->len=0777;
+#else
+    (void)dir_fd;(void)path;(void)user_data;
+    FGWSZ_THROW_WHAT("io_uring is not available on this system");
+#endif
+}
+void IoRing::submit(unsigned wait_count){
+#if FGWSZ_URING
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::uring_wait);
+    auto& ring=*(this->ring_);
+    //统计开启时记录请求的提交时间,完成事件取出时按操作类型记录耗时
+    if(::fgwsz::detail::stats_enabled){
+        auto const now=::std::chrono::steady_clock::now();
+        for(auto const slot:ring.pending_slots){
+            ring.slots[slot].timed=true;
+            ring.slots[slot].start=now;
+        }
+    }
+    ring.pending_slots.clear();
+    //发布提交队列尾部,内核从这里开始消费请求
+    ::fgwsz::detail::store_release(ring.sq_tail,ring.local_sq_tail);
+    if(wait_count>ring.in_flight){
+        wait_count=static_cast<unsigned>(ring.in_flight);
+    }
+    while(ring.to_submit>0||wait_count>0){
+        long const result=::syscall(
+            __NR_io_uring_enter
+            ,ring.fd
+            ,ring.to_submit
+            ,wait_count
+            ,wait_count>0?IORING_ENTER_GETEVENTS:0u
+            ,nullptr
+            ,0
+        );
+        ::fgwsz::detail::uring_enters.fetch_add(1,::std::memory_order_relaxed);
+        if(result<0){
+            if(EINTR==errno){
+                continue;
+            }
+            //内核暂时无法接收更多请求,先处理已有的完成事件
+            if((EAGAIN==errno||EBUSY==errno)
+                &&::fgwsz::detail::load_acquire(ring.cq_tail)
+                    !=*(ring.cq_head)
+            ){
+                return;
+            }
+            FGWSZ_THROW_WHAT(
+                "io_uring submit error: "
+                +::fgwsz::detail::uring_error_message(errno)
+            );
+        }
+        ring.to_submit-=static_cast<unsigned>(result);
+        ::fgwsz::detail::uring_submitted.fetch_add(
+            static_cast<::std::uint64_t>(result)
+            ,::std::memory_order_relaxed
+        );
+        //等待的完成事件已经到达(或无需等待)
+        if(0==ring.to_submit){
+            return;
+        }
+        if(0==result){
+            FGWSZ_THROW_WHAT("io_uring submit error: no request submitted");
+        }
+    }
+#else
+    (void)wait_count;
+#endif
+}
+bool IoRing::peek(::fgwsz::IoCompletion& completion){
+#if FGWSZ_URING
+    if(!this->is_initialized()){
+        return false;
+    }
+    auto& ring=*(this->ring_);
+    unsigned const head=*(ring.cq_head);
+    if(head==::fgwsz::detail::load_acquire(ring.cq_tail)){
+        return false;
+    }
+    auto const& cqe=ring.cqes[head&*(ring.cq_mask)];
+    auto const slot=static_cast<unsigned>(cqe.user_data);
+    auto const& request=ring.slots[slot];
+    completion.user_data=request.user_data;
+    completion.result=cqe.res;
+    ::fgwsz::detail::store_release(ring.cq_head,head+1);
+    --ring.in_flight;
+    //与同步I/O相同按阶段统计(字节数为读写成功的字节数,耗时从提交到取出完成事件)
+    if(request.timed){
+        ::fgwsz::stats_record(
+            request.phase
+            ,(::fgwsz::StatsPhase::read==request.phase
+                ||::fgwsz::StatsPhase::write==request.phase)
+                &&completion.result>0
+                ?static_cast<::std::uint64_t>(completion.result):0
+            ,static_cast<::std::uint64_t>(
+                ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+                    ::std::chrono::steady_clock::now()-request.start
+                ).count()
+            )
+        );
+    }
+    ring.free_slots.push_back(slot);
+    return true;
+#else
+    (void)completion;
+    return false;
+#endif
+}
+
+}//namespace fgwsz
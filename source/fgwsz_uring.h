@@ -0,0 +1,123 @@
+#ifndef FGWSZ_URING_H
+#define FGWSZ_URING_H
+
+#include<cstdint>   //::std::uint32_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<memory>    //::std::unique_ptr
+#include<string>    //::std::string
+
+#include"fgwsz_file.h"
+
+//============================================================================
+//io_uring异步I/O相关(只在Linux上可用,其他平台和不支持的内核上使用同步I/O)
+//============================================================================
+namespace fgwsz{
+//I/O后端
+enum class IoBackend{
+    automatic,  //内核支持时使用io_uring,否则使用同步I/O
+    sync,       //同步I/O
+    uring       //io_uring(内核不支持时抛出异常)
+};
+//根据I/O后端设置和内核支持情况判断是否使用io_uring
+bool use_io_uring(::fgwsz::IoBackend backend);
+//合并请求的操作类型和编号作为用户数据(高8位为操作类型,低56位为编号)
+inline constexpr ::std::uint64_t io_user_data(
+    ::std::uint8_t operation
+    ,::std::uint64_t index
+){
+    return (static_cast<::std::uint64_t>(operation)<<56)|index;
+}
+//完成事件
+struct IoCompletion{
+    ::std::uint64_t user_data;  //提交请求时的用户数据
+    int result;                 //系统调用的返回值(失败时为负的错误码)
+    //用户数据中的操作类型和编号
+    ::std::uint8_t operation(void)const noexcept{
+        return static_cast<::std::uint8_t>(this->user_data>>56);
+    }
+    ::std::uint64_t index(void)const noexcept{
+        return this->user_data&0x00FFFFFFFFFFFFFFull;
+    }
+};
+//完成事件失败时(result为负的错误码)的错误描述信息
+::std::string io_error_message(int result);
+//进程内所有io_uring队列累计的io_uring_enter系统调用次数和内核已接收的请求数
+//(例如基准测试用于补充/proc/self/io中不包括的io_uring读写)
+struct IoUringCounts{
+    ::std::uint64_t enters;
+    ::std::uint64_t submitted;
+};
+::fgwsz::IoUringCounts io_uring_counts(void)noexcept;
+//为io_uring打开的文件预分配磁盘空间(同步fallocate,不改变文件大小,失败时忽略)
+void io_preallocate(int fd,::std::uint64_t bytes)noexcept;
+//基于原始系统调用的最小io_uring封装:
+//先准备多个请求,再一次系统调用提交并等待完成事件,完成事件的顺序与提交顺序无关
+//统计开启时每个完成事件按操作类型记录到open,read,write,close和mkdir阶段
+class IoRing{
+public:
+    //生命周期
+    IoRing(void)noexcept;
+    ~IoRing(void);
+    //当前内核是否可以使用io_uring(只检测一次)
+    static bool available(void);
+    //创建队列,entries为同时进行的请求数上限
+    //内核不支持io_uring或缺少所需的操作时返回false
+    bool init(unsigned entries);
+    bool is_initialized(void)const noexcept;
+    //内核是否支持mkdirat操作(不支持时调用者应同步创建目录)
+    bool supports_mkdirat(void)const noexcept;
+    //已准备和已提交但还未取出完成事件的请求数
+    ::std::size_t in_flight(void)const noexcept;
+    //还可以准备的请求数
+    ::std::size_t space(void)const noexcept;
+    //准备请求(没有空间时抛出异常),路径和缓冲区在完成之前必须保持有效
+    void prepare_read(
+        int fd
+        ,void* ptr
+        ,::std::uint32_t bytes
+        ,::std::uint64_t offset
+        ,::std::uint64_t user_data
+    );
+    void prepare_write(
+        int fd
+        ,void const* src
+        ,::std::uint32_t bytes
+        ,::std::uint64_t offset
+        ,::std::uint64_t user_data
+    );
+    //打开文件,完成事件的结果为文件描述符
+    //(指定dir_fd时path是相对于目录句柄dir_fd的路径,目录句柄在完成之前必须保持打开)
+    void prepare_openat(
+        char const* path
+        ,::fgwsz::FileMode mode
+        ,::std::uint64_t user_data
+    );
+    void prepare_openat(
+        int dir_fd
+        ,char const* path
+        ,::fgwsz::FileMode mode
+        ,::std::uint64_t user_data
+    );
+    void prepare_close(int fd,::std::uint64_t user_data);
+    //创建单层目录,目录已存在时完成事件的结果为-EEXIST
+    void prepare_mkdirat(char const* path,::std::uint64_t user_data);
+    void prepare_mkdirat(
+        int dir_fd
+        ,char const* path
+        ,::std::uint64_t user_data
+    );
+    //提交所有已准备的请求,并等待至少wait_count个完成事件
+    void submit(unsigned wait_count);
+    //取出一个完成事件,没有完成事件时返回false
+    bool peek(::fgwsz::IoCompletion& completion);
+    //禁止拷贝
+    IoRing(IoRing const&)noexcept=delete;
+    IoRing& operator=(IoRing const&)noexcept=delete;
+private:
+    struct Ring;
+    ::std::unique_ptr<Ring> ring_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_URING_H
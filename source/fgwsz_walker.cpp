@@ -0,0 +1,341 @@
+#include"fgwsz_walker.h"
+
+#include<cstdint>       //::std::int64_t ::std::uint64_t
+#include<cstddef>       //::std::size_t
+#include<cerrno>        //errno EINTR ENOENT
+
+#include<string>        //::std::string
+#include<string_view>   //::std::string_view
+#include<filesystem>    //::std::filesystem
+#include<vector>        //::std::vector
+#include<utility>       //::std::move
+#include<system_error>  //::std::system_category
+
+#if defined(_WIN32)
+    #include<chrono>        //::std::chrono
+#else
+    #include<fcntl.h>       //::open ::fstatat O_DIRECTORY AT_SYMLINK_NOFOLLOW
+    #include<unistd.h>      //::close
+    #include<dirent.h>      //::fdopendir ::readdir ::closedir ::dirfd DT_*
+    #include<sys/stat.h>    //::stat S_ISDIR S_ISLNK S_ISREG
+#endif
+
+#include"fgwsz_except.h"
+#include"fgwsz_parallel.h"
+#include"fgwsz_stats.h"
+
+namespace fgwsz{
+namespace detail{
+//目录中的一项(文件或者子目录)
+struct WalkedChild{
+    ::std::string name;
+    bool is_directory;
+    ::std::uint64_t bytes;
+    ::std::int64_t write_time;
+    ::std::uint64_t allocated_bytes;
+    bool sparse;
+    //子目录在遍历结果中的下标
+    ::std::size_t dir_index;
+};
+//遍历到的目录
+struct WalkedDirectory{
+    ::std::string path_string;          //以'/'结尾的完整路径
+    ::std::string relative_path_string; //以'/'结尾的相对路径(可能为空)
+    //按目录读取顺序排列的文件和子目录
+    ::std::vector<::fgwsz::detail::WalkedChild> children;
+};
+#if defined(_WIN32)
+inline ::std::int64_t write_time(::std::filesystem::file_time_type time){
+    return ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+        time.time_since_epoch()
+    ).count();
+}
+//读取目录中的所有文件和子目录(跳过符号链接)
+inline void read_directory(::fgwsz::detail::WalkedDirectory& dir){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::walk);
+    for(auto const& dir_entry
+        : ::std::filesystem::directory_iterator(dir.path_string)
+    ){
+        auto const status=dir_entry.symlink_status();
+        if(::std::filesystem::is_symlink(status)){
+            continue;
+        }
+        ::fgwsz::detail::WalkedChild child={};
+        child.name=dir_entry.path().filename().generic_string();
+        child.is_directory=::std::filesystem::is_directory(status);
+        if(!child.is_directory){
+            child.bytes=dir_entry.file_size();
+            child.allocated_bytes=child.bytes;
+            child.write_time=
+                ::fgwsz::detail::write_time(dir_entry.last_write_time());
+        }
+        dir.children.push_back(::std::move(child));
+    }
+}
+#else
+inline ::std::int64_t write_time(struct ::stat const& status){
+    return static_cast<::std::int64_t>(status.st_mtim.tv_sec)*1000000000
+        +static_cast<::std::int64_t>(status.st_mtim.tv_nsec);
+}
+//分配的磁盘空间(st_blocks以512字节为单位)
+inline ::std::uint64_t allocated_bytes(struct ::stat const& status){
+    return static_cast<::std::uint64_t>(status.st_blocks)*512;
+}
+//分配的磁盘空间少于文件大小时文件可能有空洞
+inline bool is_sparse(struct ::stat const& status){
+    return ::fgwsz::detail::allocated_bytes(status)
+        <static_cast<::std::uint64_t>(status.st_size);
+}
+//读取目录中的所有文件和子目录(跳过符号链接)
+//目录项的类型已知时只对文件查询状态(相对于目录句柄,不解析完整路径)
+inline void read_directory(::fgwsz::detail::WalkedDirectory& dir){
+    int handle=-1;
+    {
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::walk);
+        do{
+            handle=::open(
+                dir.path_string.c_str()
+                ,O_RDONLY|O_DIRECTORY|O_CLOEXEC
+            );
+        }while(-1==handle&&EINTR==errno);
+    }
+    if(-1==handle){
+        FGWSZ_THROW_WHAT(
+            "failed to open directory: "+dir.path_string
+            +": "+::std::system_category().message(errno)
+        );
+    }
+    ::DIR* const stream=::fdopendir(handle);
+    if(nullptr==stream){
+        auto const message=::std::system_category().message(errno);
+        ::close(handle);
+        FGWSZ_THROW_WHAT(
+            "failed to open directory: "+dir.path_string+": "+message
+        );
+    }
+    struct Closer{
+        ::DIR* stream;
+        ~Closer(void){
+            ::closedir(this->stream);
+        }
+    }const closer={stream};
+    while(true){
+        ::dirent const* dir_entry=nullptr;
+        {
+            ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::walk);
+            errno=0;
+            dir_entry=::readdir(stream);
+        }
+        if(nullptr==dir_entry){
+            if(0!=errno){
+                FGWSZ_THROW_WHAT(
+                    "failed to read directory: "+dir.path_string
+                    +": "+::std::system_category().message(errno)
+                );
+            }
+            break;
+        }
+        ::std::string_view const name=dir_entry->d_name;
+        if("."==name||".."==name||DT_LNK==dir_entry->d_type){
+            continue;
+        }
+        ::fgwsz::detail::WalkedChild child={};
+        child.name=name;
+        if(DT_DIR==dir_entry->d_type){
+            child.is_directory=true;
+            dir.children.push_back(::std::move(child));
+            continue;
+        }
+        //普通文件需要字节数和修改时间,类型未知的目录项需要确定类型
+        struct ::stat status={};
+        int result=0;
+        {
+            ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
+            result=::fstatat(
+                ::dirfd(stream)
+                ,dir_entry->d_name
+                ,&status
+                ,AT_SYMLINK_NOFOLLOW
+            );
+        }
+        if(0!=result){
+            FGWSZ_THROW_WHAT(
+                "failed to get file status: "+dir.path_string+child.name
+                +": "+::std::system_category().message(errno)
+            );
+        }
+        if(S_ISLNK(status.st_mode)){
+            continue;
+        }
+        if(S_ISDIR(status.st_mode)){
+            child.is_directory=true;
+        }else if(S_ISREG(status.st_mode)){
+            child.bytes=static_cast<::std::uint64_t>(status.st_size);
+            child.write_time=::fgwsz::detail::write_time(status);
+            child.allocated_bytes=::fgwsz::detail::allocated_bytes(status);
+            child.sparse=::fgwsz::detail::is_sparse(status);
+        }else{
+            FGWSZ_THROW_WHAT(
+                "path isn't regular file: "+dir.path_string+child.name
+            );
+        }
+        dir.children.push_back(::std::move(child));
+    }
+}
+#endif
+}//namespace fgwsz::detail
+
+::std::int64_t file_write_time(::std::filesystem::path const& path){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
+#if defined(_WIN32)
+    return ::fgwsz::detail::write_time(
+        ::std::filesystem::last_write_time(path)
+    );
+#else
+    struct ::stat status={};
+    if(0!=::stat(path.c_str(),&status)){
+        FGWSZ_THROW_WHAT(
+            "failed to get file status: "+path.generic_string()
+            +": "+::std::system_category().message(errno)
+        );
+    }
+    return ::fgwsz::detail::write_time(status);
+#endif
+}
+::std::vector<::fgwsz::WalkedFile> walk_path(
+    ::std::filesystem::path const& path
+    ,::std::size_t thread_count
+){
+    //扩展为规范的绝对路径:相对路径和"."/".."都在这里处理一次,
+    //之后所有文件的路径都由字符串拼接得到
+    ::std::string const path_string=
+        ::std::filesystem::absolute(path).lexically_normal().generic_string();
+    //检查路径类型(追踪最上层路径的符号链接,与之前的行为一致)
+    bool is_directory=false;
+    ::std::vector<::fgwsz::WalkedFile> files;
+    {
+        ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::stat);
+#if defined(_WIN32)
+        if(!::std::filesystem::exists(path_string)){
+            FGWSZ_THROW_WHAT("path doesn't exist: "+path.generic_string());
+        }
+        is_directory=::std::filesystem::is_directory(path_string);
+        if(!is_directory){
+            if(::std::filesystem::is_symlink(path_string)){
+                FGWSZ_THROW_WHAT("path is symlink: "+path.generic_string());
+            }
+            ::fgwsz::WalkedFile file={};
+            file.bytes=::std::filesystem::file_size(path_string);
+            file.allocated_bytes=file.bytes;
+            file.write_time=::fgwsz::detail::write_time(
+                ::std::filesystem::last_write_time(path_string)
+            );
+            files.push_back(::std::move(file));
+        }
+#else
+        struct ::stat status={};
+        if(0!=::stat(path_string.c_str(),&status)){
+            if(ENOENT==errno){
+                FGWSZ_THROW_WHAT("path doesn't exist: "+path.generic_string());
+            }
+            FGWSZ_THROW_WHAT(
+                "failed to get file status: "+path.generic_string()
+                +": "+::std::system_category().message(errno)
+            );
+        }
+        is_directory=S_ISDIR(status.st_mode);
+        if(!is_directory){
+            if(0==::lstat(path_string.c_str(),&status)
+                &&S_ISLNK(status.st_mode)
+            ){
+                FGWSZ_THROW_WHAT("path is symlink: "+path.generic_string());
+            }
+            if(!S_ISREG(status.st_mode)){
+                FGWSZ_THROW_WHAT(
+                    "path isn't regular file: "+path.generic_string()
+                );
+            }
+            ::fgwsz::WalkedFile file={};
+            file.bytes=static_cast<::std::uint64_t>(status.st_size);
+            file.write_time=::fgwsz::detail::write_time(status);
+            file.allocated_bytes=::fgwsz::detail::allocated_bytes(status);
+            file.sparse=::fgwsz::detail::is_sparse(status);
+            files.push_back(::std::move(file));
+        }
+#endif
+    }
+    auto const slash=path_string.rfind('/');
+    if(!is_directory){//文件路径:相对路径为文件名
+        files.back().path_string=path_string;
+        files.back().relative_path_string=path_string.substr(slash+1);
+        return files;
+    }
+    //目录路径a/b/c:相对路径以c/开始,目录路径a/b/c/:相对路径以c的子项开始
+    ::std::vector<::fgwsz::detail::WalkedDirectory> dirs(1);
+    dirs[0].path_string=path_string;
+    if('/'!=path_string.back()){
+        dirs[0].path_string+='/';
+        dirs[0].relative_path_string=path_string.substr(slash+1)+'/';
+    }
+    //逐层读取目录,同一层的目录可以并行读取
+    //(读取期间不修改dirs,读取完成后按顺序登记下一层的子目录)
+    for(::std::size_t level_begin=0;level_begin<dirs.size();){
+        ::std::size_t const level_end=dirs.size();
+        ::fgwsz::parallel_for(
+            level_end-level_begin
+            ,thread_count
+            ,[&dirs,level_begin](::std::size_t task_index,::std::size_t){
+                ::fgwsz::detail::read_directory(dirs[level_begin+task_index]);
+            }
+        );
+        for(::std::size_t index=level_begin;index<level_end;++index){
+            for(::std::size_t child_index=0
+                ;child_index<dirs[index].children.size()
+                ;++child_index
+            ){
+                auto& child=dirs[index].children[child_index];
+                if(!child.is_directory){
+                    continue;
+                }
+                child.dir_index=dirs.size();
+                ::fgwsz::detail::WalkedDirectory sub_dir={};
+                sub_dir.path_string=dirs[index].path_string+child.name+'/';
+                sub_dir.relative_path_string=
+                    dirs[index].relative_path_string+child.name+'/';
+                dirs.push_back(::std::move(sub_dir));
+            }
+        }
+        level_begin=level_end;
+    }
+    //按目录读取顺序深度优先输出所有文件(子目录在出现的位置展开)
+    struct Frame{
+        ::std::size_t dir_index;
+        ::std::size_t child_index;
+    };
+    ::std::vector<Frame> frames={{0,0}};
+    while(!frames.empty()){
+        auto const dir_index=frames.back().dir_index;
+        auto const child_index=frames.back().child_index++;
+        auto& dir=dirs[dir_index];
+        if(child_index>=dir.children.size()){
+            frames.pop_back();
+            continue;
+        }
+        auto& child=dir.children[child_index];
+        if(child.is_directory){
+            frames.push_back({child.dir_index,0});
+            continue;
+        }
+        ::fgwsz::WalkedFile file={};
+        file.path_string=dir.path_string+child.name;
+        file.relative_path_string=dir.relative_path_string+child.name;
+        file.bytes=child.bytes;
+        file.write_time=child.write_time;
+        file.allocated_bytes=child.allocated_bytes;
+        file.sparse=child.sparse;
+        files.push_back(::std::move(file));
+    }
+    return files;
+}
+
+}//namespace fgwsz
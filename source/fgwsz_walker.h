@@ -0,0 +1,38 @@
+#ifndef FGWSZ_WALKER_H
+#define FGWSZ_WALKER_H
+
+#include<cstdint>   //::std::int64_t ::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<vector>    //::std::vector
+
+//============================================================================
+//打包时遍历目录相关
+//============================================================================
+namespace fgwsz{
+//遍历得到的文件
+struct WalkedFile{
+    ::std::string path_string;          //文件路径(用于打开文件)
+    ::std::string relative_path_string; //打包之后的相对路径(以'/'分隔)
+    ::std::uint64_t bytes;              //文件内容字节数
+    ::std::int64_t write_time;          //修改时间(纳秒)
+    ::std::uint64_t allocated_bytes;    //分配的磁盘空间字节数(Windows上与bytes相同)
+    bool sparse;                        //分配的磁盘空间少于文件大小(可能有空洞)
+};
+//文件的修改时间(纳秒,与WalkedFile::write_time使用相同的时间基准)
+::std::int64_t file_write_time(::std::filesystem::path const& path);
+//遍历路径下的所有文件(跳过符号链接),按目录读取顺序深度优先排列,
+//与::std::filesystem::recursive_directory_iterator的遍历顺序相同
+//每个目录只打开和读取一次(getdents64),每个文件只查询一次状态(fstatat)
+//相对路径由父目录的相对路径和文件名拼接得到,不再对每个文件解析绝对路径
+//目录路径a/b/c打包为c/...,目录路径a/b/c/只打包c下的所有子目录/文件
+//thread_count大于1时同一层的多个目录由多个线程并行读取,结果的顺序不变
+::std::vector<::fgwsz::WalkedFile> walk_path(
+    ::std::filesystem::path const& path
+    ,::std::size_t thread_count=1
+);
+}//namespace fgwsz
+
+#endif//FGWSZ_WALKER_H
@@ -0,0 +1,306 @@
+#include"fgwsz_writer.h"
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+#include<cstring>   //::std::memcpy ::std::memset ::std::memmove
+
+#include<new>       //::operator new ::std::align_val_t
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<utility>   //::std::move
+
+#include"fgwsz_except.h"
+#include"fgwsz_stats.h"
+
+namespace fgwsz{
+
+void BufferedWriter::AlignedDelete::operator()(char* ptr)const noexcept{
+    ::operator delete[](
+        ptr
+        ,::std::align_val_t(::fgwsz::BufferedWriter::buffer_alignment)
+    );
+}
+BufferedWriter::BufferedWriter(::std::uint64_t buffer_bytes)
+    :buffer_(
+        static_cast<char*>(::operator new[](
+            static_cast<::std::size_t>(buffer_bytes)
+            ,::std::align_val_t(::fgwsz::BufferedWriter::buffer_alignment)
+        ))
+    )
+    ,buffer_bytes_(buffer_bytes)
+    ,used_bytes_(0)
+    ,hole_end_(0)
+    ,direct_(false)
+    ,drop_cache_(false)
+    ,file_offset_(0)
+    ,cache_offset_(0)
+{}
+BufferedWriter::~BufferedWriter(void){
+    //析构时无法报告错误,正常流程应在析构之前调用close
+    try{
+        this->close();
+    }catch(...){}
+}
+void BufferedWriter::open(
+    ::std::filesystem::path const& path
+    ,::fgwsz::FileMode mode
+){
+    this->close();
+    this->write_path_string_.clear();
+    this->file_.open(path,mode);
+}
+void BufferedWriter::open(::fgwsz::File&& file){
+    this->close();
+    this->write_path_string_.clear();
+    this->file_=::std::move(file);
+}
+void BufferedWriter::open(
+    ::fgwsz::WriteFunction write
+    ,::std::string path_string
+){
+    this->close();
+    this->write_=::std::move(write);
+    this->write_path_string_=::std::move(path_string);
+}
+void BufferedWriter::write_through(void const* src,::std::uint64_t bytes){
+    if(nullptr!=this->write_){
+        this->write_(src,bytes);
+    }else{
+        this->file_.write(src,bytes);
+        this->hole_end_=0;
+        this->advance(bytes);
+    }
+}
+void BufferedWriter::advance(::std::uint64_t bytes)noexcept{
+    if(this->drop_cache_){
+        //开始写回刚写入的范围,之前写入的完整窗口写回完成之后丢弃其页缓存
+        this->file_.start_writeback(this->file_offset_,bytes);
+        this->cache_offset_=this->file_.drop_cache_behind(
+            this->cache_offset_
+            ,this->file_offset_
+        );
+    }
+    this->file_offset_+=bytes;
+}
+void BufferedWriter::write(void const* src,::std::uint64_t bytes){
+    auto data=reinterpret_cast<char const*>(src);
+    while(bytes>0){
+        //缓冲区为空且剩余内容不少于一个缓冲区时直接写入文件
+        //(直接I/O只能从对齐的缓冲区写入)
+        if(0==this->used_bytes_
+            &&bytes>=this->buffer_bytes_
+            &&!this->direct_
+        ){
+            this->write_through(data,bytes);
+            return;
+        }
+        ::std::uint64_t const copy_bytes=
+            (this->buffer_bytes_-this->used_bytes_)<bytes
+            ?(this->buffer_bytes_-this->used_bytes_):bytes;
+        ::std::memcpy(
+            this->buffer_.get()+this->used_bytes_
+            ,data
+            ,static_cast<::std::size_t>(copy_bytes)
+        );
+        this->used_bytes_+=copy_bytes;
+        data+=copy_bytes;
+        bytes-=copy_bytes;
+        if(this->used_bytes_==this->buffer_bytes_){
+            this->flush();
+        }
+    }
+}
+char* BufferedWriter::prepare(::std::uint64_t& available){
+    if(this->used_bytes_==this->buffer_bytes_){
+        this->flush();
+    }
+    available=this->buffer_bytes_-this->used_bytes_;
+    return this->buffer_.get()+this->used_bytes_;
+}
+void BufferedWriter::commit(::std::uint64_t bytes){
+    this->used_bytes_+=bytes;
+    if(this->used_bytes_==this->buffer_bytes_){
+        this->flush();
+    }
+}
+void BufferedWriter::copy_from(
+    ::fgwsz::File const& src
+    ,::std::uint64_t bytes
+    ,::std::uint64_t offset
+){
+    //内核复制的字节数不一定对齐,复制之前停止直接I/O
+    if(this->direct_){
+        this->leave_direct();
+    }
+    this->flush();
+    if(bytes>0){
+        this->hole_end_=0;
+    }
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::copy,bytes);
+    ::std::uint64_t count_bytes=nullptr!=this->write_?0
+        :this->file_.copy_from(src,bytes,offset);
+    this->advance(count_bytes);
+    while(count_bytes<bytes){
+        ::std::uint64_t available=0;
+        char* data=this->prepare(available);
+        ::std::uint64_t const request=
+            (bytes-count_bytes)<available?(bytes-count_bytes):available;
+        if(request!=src.read_at(data,request,offset+count_bytes)){
+            FGWSZ_THROW_WHAT("file read incomplete: "+src.path_string());
+        }
+        this->commit(request);
+        count_bytes+=request;
+    }
+}
+void BufferedWriter::skip(::std::uint64_t bytes){
+    if(0==bytes){
+        return;
+    }
+    if(nullptr==this->write_&&this->file_.is_seekable()){
+        this->flush();
+        //跳过之后的位置不对齐时停止直接I/O
+        if(this->direct_
+            &&(this->used_bytes_>0
+                ||0!=bytes% ::fgwsz::File::direct_alignment)
+        ){
+            this->leave_direct();
+        }
+        this->hole_end_=this->file_.skip(bytes);
+        this->file_offset_=this->hole_end_;
+        return;
+    }
+    while(bytes>0){
+        ::std::uint64_t available=0;
+        char* data=this->prepare(available);
+        ::std::uint64_t const zero_bytes=bytes<available?bytes:available;
+        ::std::memset(data,0,static_cast<::std::size_t>(zero_bytes));
+        this->commit(zero_bytes);
+        bytes-=zero_bytes;
+    }
+}
+void BufferedWriter::preallocate(::std::uint64_t bytes)noexcept{
+    if(nullptr==this->write_&&this->file_.is_open()){
+        this->file_.preallocate(bytes);
+    }
+}
+void BufferedWriter::set_direct(bool direct){
+    if(nullptr!=this->write_||!this->file_.is_open()){
+        return;
+    }
+    if(!direct){
+        if(this->direct_){
+            this->leave_direct();
+        }
+        this->flush();
+        this->drop_cache_=false;
+        return;
+    }
+    if(this->direct_||this->drop_cache_||!this->file_.is_seekable()){
+        return;
+    }
+    this->flush();
+    //从当前位置开始,位置和缓冲区大小都对齐时才能直接I/O写入
+    this->file_offset_=this->file_.skip(0);
+    this->cache_offset_=this->file_offset_;
+    this->direct_=0==this->file_offset_% ::fgwsz::File::direct_alignment
+        &&0==this->buffer_bytes_% ::fgwsz::File::direct_alignment
+        &&this->file_.set_direct(true);
+    this->drop_cache_=!this->direct_;
+}
+void BufferedWriter::leave_direct(void){
+    this->flush();
+    this->direct_=false;
+    this->drop_cache_=true;
+    this->cache_offset_=this->file_offset_;
+    (void)this->file_.set_direct(false);
+    //重新写入补0写入的结尾块,并去掉补0的部分
+    if(this->used_bytes_>0){
+        this->flush();
+        this->file_.resize(this->file_offset_);
+    }
+}
+void BufferedWriter::flush(void){
+    if(0==this->used_bytes_){
+        return;
+    }
+    //先清空缓冲区计数,写入失败时不会在close中重复写入
+    ::std::uint64_t const used_bytes=this->used_bytes_;
+    this->used_bytes_=0;
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::flush,used_bytes);
+    constexpr ::std::uint64_t alignment=::fgwsz::File::direct_alignment;
+    ::std::uint64_t const tail_bytes=used_bytes%alignment;
+    if(!this->direct_||0==tail_bytes){
+        this->write_through(this->buffer_.get(),used_bytes);
+        return;
+    }
+    //直接I/O只能写入完整的对齐块:不足一块的结尾补0写入,
+    //结尾保留在缓冲区头部,之后与后续内容合并再次写入这一块
+    ::std::uint64_t const aligned_bytes=used_bytes-tail_bytes;
+    ::std::memset(
+        this->buffer_.get()+used_bytes
+        ,0
+        ,static_cast<::std::size_t>(alignment-tail_bytes)
+    );
+    this->write_through(this->buffer_.get(),aligned_bytes+alignment);
+    this->file_offset_-=alignment;
+    this->file_.seek(this->file_offset_);
+    ::std::memmove(
+        this->buffer_.get()
+        ,this->buffer_.get()+aligned_bytes
+        ,static_cast<::std::size_t>(tail_bytes)
+    );
+    this->used_bytes_=tail_bytes;
+}
+void BufferedWriter::close(void){
+    if(!this->is_open()){
+        this->used_bytes_=0;
+        this->hole_end_=0;
+        this->direct_=false;
+        this->drop_cache_=false;
+        return;
+    }
+    if(nullptr!=this->write_){
+        //写入失败时同样不再关联写入回调
+        struct Reset{
+            ::fgwsz::WriteFunction& write;
+            ~Reset(void){
+                this->write=nullptr;
+            }
+        }const reset={this->write_};
+        this->flush();
+        return;
+    }
+    //关闭(包括失败)之后重新默认为不绕过页缓存
+    struct Reset{
+        bool& direct;
+        bool& drop_cache;
+        ~Reset(void){
+            this->direct=false;
+            this->drop_cache=false;
+        }
+    }const reset={this->direct_,this->drop_cache_};
+    this->flush();
+    //文件以空洞结束,或者直接I/O补0写入了结尾时设置文件大小
+    ::std::uint64_t const end=this->direct_&&this->used_bytes_>0
+        ?this->file_offset_+this->used_bytes_
+        :this->hole_end_;
+    this->used_bytes_=0;
+    this->hole_end_=0;
+    if(0!=end){
+        this->file_.resize(end);
+    }
+    //丢弃剩余部分(到文件末尾)的页缓存
+    if(this->drop_cache_){
+        this->file_.drop_cache(this->cache_offset_,0);
+    }
+    this->file_.close();
+}
+bool BufferedWriter::is_open(void)const noexcept{
+    return this->file_.is_open()||nullptr!=this->write_;
+}
+::std::string const& BufferedWriter::path_string(void)const noexcept{
+    return this->write_path_string_.empty()?this->file_.path_string()
+        :this->write_path_string_;
+}
+
+}//namespace fgwsz
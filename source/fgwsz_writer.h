@@ -0,0 +1,102 @@
+#ifndef FGWSZ_WRITER_H
+#define FGWSZ_WRITER_H
+
+#include<cstdint>   //::std::uint64_t
+#include<cstddef>   //::std::size_t
+
+#include<string>    //::std::string
+#include<filesystem>//::std::filesystem
+#include<memory>    //::std::unique_ptr
+
+#include"fgwsz_file.h"
+#include"fgwsz_stream.h"
+
+//============================================================================
+//合并写入相关
+//============================================================================
+namespace fgwsz{
+//带有对齐缓冲区的合并写入器:
+//小块写入先合并到缓冲区中,只在缓冲区写满,显式flush或close时才真正写入文件
+//缓冲区为空时大块写入直接写入文件,不经过缓冲区拷贝
+class BufferedWriter{
+public:
+    //默认缓冲区大小
+    static constexpr ::std::uint64_t default_buffer_bytes=4*1024*1024;//4MB
+    //缓冲区对齐字节数
+    static constexpr ::std::size_t buffer_alignment=4096;
+    //生命周期(缓冲区在多次open/close之间复用)
+    explicit BufferedWriter(
+        ::std::uint64_t buffer_bytes=default_buffer_bytes
+    );
+    ~BufferedWriter(void);
+    //打开文件(已打开的文件会先被关闭)
+    void open(
+        ::std::filesystem::path const& path
+        ,::fgwsz::FileMode mode=::fgwsz::FileMode::write_truncate
+    );
+    //关联已经打开的文件(例如标准输出)
+    void open(::fgwsz::File&& file);
+    //关联写入回调(缓冲区写满,flush或close时调用,不支持内核复制)
+    //path_string只用于抛出异常时的信息显示
+    void open(::fgwsz::WriteFunction write,::std::string path_string);
+    //写入缓冲区(缓冲区写满时写入文件)
+    void write(void const* src,::std::uint64_t bytes);
+    //获取缓冲区中可以直接填充的空间(缓冲区已满时先写入文件)
+    //available返回可填充的字节数,填充之后调用commit提交实际填充的字节数
+    char* prepare(::std::uint64_t& available);
+    void commit(::std::uint64_t bytes);
+    //从src的指定位置复制bytes字节(先写入缓冲区中的内容,再尽量由内核直接复制)
+    //内核不支持复制的部分(以及写入回调时的全部内容)经过缓冲区读取和写入
+    void copy_from(
+        ::fgwsz::File const& src
+        ,::std::uint64_t bytes
+        ,::std::uint64_t offset
+    );
+    //跳过bytes字节:写入文件时先写入缓冲区中的内容再向后定位,跳过的部分成为空洞
+    //(文件以空洞结束时在close中设置文件大小),写入回调或者不能定位时写入0
+    void skip(::std::uint64_t bytes);
+    //为文件预分配bytes字节的磁盘空间(写入回调时忽略)
+    void preallocate(::std::uint64_t bytes)noexcept;
+    //当前打开的文件写入时是否绕过页缓存(之后打开的文件重新默认为不绕过)
+    //当前位置对齐时从缓冲区直接I/O写入完整的对齐块,不足一块的结尾补0写入,
+    //在close中截断;不能直接I/O时改为写入之后按缓冲区窗口回写并丢弃页缓存
+    //(写入回调和不能定位的文件忽略)
+    void set_direct(bool direct);
+    //把缓冲区中的内容写入文件
+    void flush(void);
+    //把缓冲区中的内容写入文件并关闭文件
+    void close(void);
+    bool is_open(void)const noexcept;
+    //文件路径字符串(用于抛出异常时的信息显示)
+    ::std::string const& path_string(void)const noexcept;
+    //禁止拷贝
+    BufferedWriter(BufferedWriter const&)noexcept=delete;
+    BufferedWriter& operator=(BufferedWriter const&)noexcept=delete;
+private:
+    struct AlignedDelete{
+        void operator()(char* ptr)const noexcept;
+    };
+    //写入文件或者写入回调
+    void write_through(void const* src,::std::uint64_t bytes);
+    //文件位置向后移动已写入的bytes字节(按窗口丢弃页缓存时回写并丢弃之前的窗口)
+    void advance(::std::uint64_t bytes)noexcept;
+    //停止直接I/O,缓冲区中补0写入的结尾重新按缓冲I/O写入
+    void leave_direct(void);
+    ::fgwsz::File file_;
+    ::fgwsz::WriteFunction write_;
+    ::std::string write_path_string_;
+    ::std::unique_ptr<char[],AlignedDelete> buffer_;
+    ::std::uint64_t buffer_bytes_;
+    ::std::uint64_t used_bytes_;
+    //文件以跳过的空洞结束时的文件大小(之后没有写入时为非0)
+    ::std::uint64_t hole_end_;
+    //是否直接I/O写入,是否按窗口丢弃页缓存(不能直接I/O时)
+    bool direct_;
+    bool drop_cache_;
+    //缓冲区起始内容在文件中的位置,以及页缓存已丢弃部分的结束位置
+    ::std::uint64_t file_offset_;
+    ::std::uint64_t cache_offset_;
+};
+}//namespace fgwsz
+
+#endif//FGWSZ_WRITER_H
@@ -0,0 +1,416 @@
+#include"fgwsz_xor.h"
+
+#include<cstdint>   //::std::uint8_t ::std::uint32_t ::std::uint64_t
+#include<cstring>   //::std::memcpy
+
+#include<vector>    //::std::vector
+
+#include"fgwsz_stats.h"
+
+#if defined(__x86_64__)||defined(_M_X64)||defined(__i386__)||defined(_M_IX86)
+    #define FGWSZ_XOR_X86 1
+    #include<immintrin.h>   //SSE2 AVX2 AVX-512
+    #if defined(_MSC_VER)
+        #include<intrin.h>  //__cpuid __cpuidex _xgetbv
+    #else
+        #include<cpuid.h>   //__cpuid_count
+    #endif
+#else
+    #define FGWSZ_XOR_X86 0
+#endif
+
+//GCC/Clang需要为使用更高指令集的函数单独指定目标,MSVC不需要
+#if FGWSZ_XOR_X86&&!defined(_MSC_VER)
+    #define FGWSZ_TARGET_SSE2    __attribute__((target("sse2")))
+    #define FGWSZ_TARGET_AVX2    __attribute__((target("avx2")))
+    #define FGWSZ_TARGET_AVX512F __attribute__((target("avx512f")))
+#else
+    #define FGWSZ_TARGET_SSE2
+    #define FGWSZ_TARGET_AVX2
+    #define FGWSZ_TARGET_AVX512F
+#endif
+
+namespace fgwsz{
+namespace detail{
+//逐字节处理(各内核的尾部处理)
+inline void key_xor_bytes(
+    ::std::uint8_t* ptr
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    for(::std::uint64_t index=0;index<bytes;++index){
+        ptr[index]^=key;
+    }
+}
+inline void key_xor_copy_bytes(
+    ::std::uint8_t* dst
+    ,::std::uint8_t const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    for(::std::uint64_t index=0;index<bytes;++index){
+        dst[index]=src[index]^key;
+    }
+}
+//可移植内核:按64位字处理
+void key_xor_word64(void* ptr,::std::uint64_t bytes,::std::uint8_t key){
+    auto data=reinterpret_cast<::std::uint8_t*>(ptr);
+    ::std::uint64_t const word_key=
+        static_cast<::std::uint64_t>(key)*0x0101010101010101ull;
+    ::std::uint64_t word[4];
+    ::std::uint64_t index=0;
+    //每次处理32字节,使用memcpy避免未对齐访问和严格别名问题
+    for(;index+sizeof(word)<=bytes;index+=sizeof(word)){
+        ::std::memcpy(word,data+index,sizeof(word));
+        word[0]^=word_key;
+        word[1]^=word_key;
+        word[2]^=word_key;
+        word[3]^=word_key;
+        ::std::memcpy(data+index,word,sizeof(word));
+    }
+    for(;index+sizeof(word[0])<=bytes;index+=sizeof(word[0])){
+        ::std::memcpy(word,data+index,sizeof(word[0]));
+        word[0]^=word_key;
+        ::std::memcpy(data+index,word,sizeof(word[0]));
+    }
+    ::fgwsz::detail::key_xor_bytes(data+index,bytes-index,key);
+}
+void key_xor_copy_word64(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    ::std::uint64_t const word_key=
+        static_cast<::std::uint64_t>(key)*0x0101010101010101ull;
+    ::std::uint64_t word[4];
+    ::std::uint64_t index=0;
+    for(;index+sizeof(word)<=bytes;index+=sizeof(word)){
+        ::std::memcpy(word,from+index,sizeof(word));
+        word[0]^=word_key;
+        word[1]^=word_key;
+        word[2]^=word_key;
+        word[3]^=word_key;
+        ::std::memcpy(to+index,word,sizeof(word));
+    }
+    for(;index+sizeof(word[0])<=bytes;index+=sizeof(word[0])){
+        ::std::memcpy(word,from+index,sizeof(word[0]));
+        word[0]^=word_key;
+        ::std::memcpy(to+index,word,sizeof(word[0]));
+    }
+    ::fgwsz::detail::key_xor_copy_bytes(to+index,from+index,bytes-index,key);
+}
+#if FGWSZ_XOR_X86
+//SSE2内核:每次处理64字节
+FGWSZ_TARGET_SSE2
+void key_xor_sse2(void* ptr,::std::uint64_t bytes,::std::uint8_t key){
+    auto data=reinterpret_cast<::std::uint8_t*>(ptr);
+    __m128i const vector_key=_mm_set1_epi8(static_cast<char>(key));
+    ::std::uint64_t index=0;
+    for(;index+64<=bytes;index+=64){
+        auto p=reinterpret_cast<__m128i*>(data+index);
+        __m128i v0=_mm_loadu_si128(p+0);
+        __m128i v1=_mm_loadu_si128(p+1);
+        __m128i v2=_mm_loadu_si128(p+2);
+        __m128i v3=_mm_loadu_si128(p+3);
+        _mm_storeu_si128(p+0,_mm_xor_si128(v0,vector_key));
+        _mm_storeu_si128(p+1,_mm_xor_si128(v1,vector_key));
+        _mm_storeu_si128(p+2,_mm_xor_si128(v2,vector_key));
+        _mm_storeu_si128(p+3,_mm_xor_si128(v3,vector_key));
+    }
+    for(;index+16<=bytes;index+=16){
+        auto p=reinterpret_cast<__m128i*>(data+index);
+        _mm_storeu_si128(p,_mm_xor_si128(_mm_loadu_si128(p),vector_key));
+    }
+    ::fgwsz::detail::key_xor_bytes(data+index,bytes-index,key);
+}
+FGWSZ_TARGET_SSE2
+void key_xor_copy_sse2(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    __m128i const vector_key=_mm_set1_epi8(static_cast<char>(key));
+    ::std::uint64_t index=0;
+    for(;index+64<=bytes;index+=64){
+        auto s=reinterpret_cast<__m128i const*>(from+index);
+        auto d=reinterpret_cast<__m128i*>(to+index);
+        __m128i v0=_mm_loadu_si128(s+0);
+        __m128i v1=_mm_loadu_si128(s+1);
+        __m128i v2=_mm_loadu_si128(s+2);
+        __m128i v3=_mm_loadu_si128(s+3);
+        _mm_storeu_si128(d+0,_mm_xor_si128(v0,vector_key));
+        _mm_storeu_si128(d+1,_mm_xor_si128(v1,vector_key));
+        _mm_storeu_si128(d+2,_mm_xor_si128(v2,vector_key));
+        _mm_storeu_si128(d+3,_mm_xor_si128(v3,vector_key));
+    }
+    for(;index+16<=bytes;index+=16){
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(to+index)
+            ,_mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(from+index))
+                ,vector_key
+            )
+        );
+    }
+    ::fgwsz::detail::key_xor_copy_bytes(to+index,from+index,bytes-index,key);
+}
+//AVX2内核:每次处理128字节
+FGWSZ_TARGET_AVX2
+void key_xor_avx2(void* ptr,::std::uint64_t bytes,::std::uint8_t key){
+    auto data=reinterpret_cast<::std::uint8_t*>(ptr);
+    __m256i const vector_key=_mm256_set1_epi8(static_cast<char>(key));
+    ::std::uint64_t index=0;
+    for(;index+128<=bytes;index+=128){
+        auto p=reinterpret_cast<__m256i*>(data+index);
+        __m256i v0=_mm256_loadu_si256(p+0);
+        __m256i v1=_mm256_loadu_si256(p+1);
+        __m256i v2=_mm256_loadu_si256(p+2);
+        __m256i v3=_mm256_loadu_si256(p+3);
+        _mm256_storeu_si256(p+0,_mm256_xor_si256(v0,vector_key));
+        _mm256_storeu_si256(p+1,_mm256_xor_si256(v1,vector_key));
+        _mm256_storeu_si256(p+2,_mm256_xor_si256(v2,vector_key));
+        _mm256_storeu_si256(p+3,_mm256_xor_si256(v3,vector_key));
+    }
+    for(;index+32<=bytes;index+=32){
+        auto p=reinterpret_cast<__m256i*>(data+index);
+        _mm256_storeu_si256(
+            p,_mm256_xor_si256(_mm256_loadu_si256(p),vector_key)
+        );
+    }
+    //避免AVX到SSE的状态切换惩罚
+    _mm256_zeroupper();
+    ::fgwsz::detail::key_xor_bytes(data+index,bytes-index,key);
+}
+FGWSZ_TARGET_AVX2
+void key_xor_copy_avx2(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    __m256i const vector_key=_mm256_set1_epi8(static_cast<char>(key));
+    ::std::uint64_t index=0;
+    for(;index+128<=bytes;index+=128){
+        auto s=reinterpret_cast<__m256i const*>(from+index);
+        auto d=reinterpret_cast<__m256i*>(to+index);
+        __m256i v0=_mm256_loadu_si256(s+0);
+        __m256i v1=_mm256_loadu_si256(s+1);
+        __m256i v2=_mm256_loadu_si256(s+2);
+        __m256i v3=_mm256_loadu_si256(s+3);
+        _mm256_storeu_si256(d+0,_mm256_xor_si256(v0,vector_key));
+        _mm256_storeu_si256(d+1,_mm256_xor_si256(v1,vector_key));
+        _mm256_storeu_si256(d+2,_mm256_xor_si256(v2,vector_key));
+        _mm256_storeu_si256(d+3,_mm256_xor_si256(v3,vector_key));
+    }
+    for(;index+32<=bytes;index+=32){
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(to+index)
+            ,_mm256_xor_si256(
+                _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(from+index)
+                )
+                ,vector_key
+            )
+        );
+    }
+    _mm256_zeroupper();
+    ::fgwsz::detail::key_xor_copy_bytes(to+index,from+index,bytes-index,key);
+}
+//AVX-512内核:每次处理256字节
+FGWSZ_TARGET_AVX512F
+void key_xor_avx512(void* ptr,::std::uint64_t bytes,::std::uint8_t key){
+    auto data=reinterpret_cast<::std::uint8_t*>(ptr);
+    __m512i const vector_key=_mm512_set1_epi32(
+        static_cast<int>(static_cast<::std::uint32_t>(key)*0x01010101u)
+    );
+    ::std::uint64_t index=0;
+    for(;index+256<=bytes;index+=256){
+        auto p=reinterpret_cast<__m512i*>(data+index);
+        __m512i v0=_mm512_loadu_si512(p+0);
+        __m512i v1=_mm512_loadu_si512(p+1);
+        __m512i v2=_mm512_loadu_si512(p+2);
+        __m512i v3=_mm512_loadu_si512(p+3);
+        _mm512_storeu_si512(p+0,_mm512_xor_si512(v0,vector_key));
+        _mm512_storeu_si512(p+1,_mm512_xor_si512(v1,vector_key));
+        _mm512_storeu_si512(p+2,_mm512_xor_si512(v2,vector_key));
+        _mm512_storeu_si512(p+3,_mm512_xor_si512(v3,vector_key));
+    }
+    for(;index+64<=bytes;index+=64){
+        auto p=reinterpret_cast<__m512i*>(data+index);
+        _mm512_storeu_si512(
+            p,_mm512_xor_si512(_mm512_loadu_si512(p),vector_key)
+        );
+    }
+    _mm256_zeroupper();
+    ::fgwsz::detail::key_xor_bytes(data+index,bytes-index,key);
+}
+FGWSZ_TARGET_AVX512F
+void key_xor_copy_avx512(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    auto to=reinterpret_cast<::std::uint8_t*>(dst);
+    auto from=reinterpret_cast<::std::uint8_t const*>(src);
+    __m512i const vector_key=_mm512_set1_epi32(
+        static_cast<int>(static_cast<::std::uint32_t>(key)*0x01010101u)
+    );
+    ::std::uint64_t index=0;
+    for(;index+256<=bytes;index+=256){
+        auto s=reinterpret_cast<__m512i const*>(from+index);
+        auto d=reinterpret_cast<__m512i*>(to+index);
+        __m512i v0=_mm512_loadu_si512(s+0);
+        __m512i v1=_mm512_loadu_si512(s+1);
+        __m512i v2=_mm512_loadu_si512(s+2);
+        __m512i v3=_mm512_loadu_si512(s+3);
+        _mm512_storeu_si512(d+0,_mm512_xor_si512(v0,vector_key));
+        _mm512_storeu_si512(d+1,_mm512_xor_si512(v1,vector_key));
+        _mm512_storeu_si512(d+2,_mm512_xor_si512(v2,vector_key));
+        _mm512_storeu_si512(d+3,_mm512_xor_si512(v3,vector_key));
+    }
+    for(;index+64<=bytes;index+=64){
+        _mm512_storeu_si512(
+            to+index
+            ,_mm512_xor_si512(_mm512_loadu_si512(from+index),vector_key)
+        );
+    }
+    _mm256_zeroupper();
+    ::fgwsz::detail::key_xor_copy_bytes(to+index,from+index,bytes-index,key);
+}
+//x86 CPU特性检测
+struct CpuFeatures{
+    bool sse2=false;
+    bool avx2=false;
+    bool avx512f=false;
+};
+inline void cpuid(
+    ::std::uint32_t leaf
+    ,::std::uint32_t subleaf
+    ,::std::uint32_t (&regs)[4]
+){
+#if defined(_MSC_VER)
+    int info[4]={};
+    __cpuidex(info,static_cast<int>(leaf),static_cast<int>(subleaf));
+    for(int index=0;index<4;++index){
+        regs[index]=static_cast<::std::uint32_t>(info[index]);
+    }
+#else
+    unsigned int a=0,b=0,c=0,d=0;
+    __cpuid_count(leaf,subleaf,a,b,c,d);
+    regs[0]=a;regs[1]=b;regs[2]=c;regs[3]=d;
+#endif
+}
+inline ::std::uint64_t xgetbv0(void){
+#if defined(_MSC_VER)
+    return static_cast<::std::uint64_t>(_xgetbv(0));
+#else
+    ::std::uint32_t eax=0,edx=0;
+    __asm__ volatile("xgetbv":"=a"(eax),"=d"(edx):"c"(0));
+    return (static_cast<::std::uint64_t>(edx)<<32)|eax;
+#endif
+}
+inline ::fgwsz::detail::CpuFeatures cpu_features(void){
+    ::fgwsz::detail::CpuFeatures features;
+    ::std::uint32_t regs[4]={};
+    ::fgwsz::detail::cpuid(0,0,regs);
+    ::std::uint32_t const max_leaf=regs[0];
+    if(max_leaf<1){
+        return features;
+    }
+    ::fgwsz::detail::cpuid(1,0,regs);
+    features.sse2=(regs[3]>>26)&1u;
+    //OSXSAVE为1时才能用xgetbv确认操作系统是否保存了YMM/ZMM寄存器状态
+    bool const osxsave=(regs[2]>>27)&1u;
+    bool const avx=(regs[2]>>28)&1u;
+    if(!osxsave||!avx||max_leaf<7){
+        return features;
+    }
+    ::std::uint64_t const xcr0=::fgwsz::detail::xgetbv0();
+    bool const ymm_enabled=(xcr0&0x06u)==0x06u;   //XMM|YMM
+    bool const zmm_enabled=(xcr0&0xE6u)==0xE6u;   //XMM|YMM|OPMASK|ZMM
+    ::fgwsz::detail::cpuid(7,0,regs);
+    features.avx2=ymm_enabled&&((regs[1]>>5)&1u);
+    features.avx512f=zmm_enabled&&((regs[1]>>16)&1u);
+    return features;
+}
+#endif//FGWSZ_XOR_X86
+inline ::std::vector<::fgwsz::XorKernel> make_key_xor_kernels(void){
+    //按性能从低到高排列,最后一个受支持的内核即为默认内核
+    ::std::vector<::fgwsz::XorKernel> kernels;
+    kernels.push_back({
+        "word64"
+        ,&::fgwsz::detail::key_xor_word64
+        ,&::fgwsz::detail::key_xor_copy_word64
+        ,true
+    });
+#if FGWSZ_XOR_X86
+    auto const features=::fgwsz::detail::cpu_features();
+    kernels.push_back({
+        "sse2"
+        ,&::fgwsz::detail::key_xor_sse2
+        ,&::fgwsz::detail::key_xor_copy_sse2
+        ,features.sse2
+    });
+    kernels.push_back({
+        "avx2"
+        ,&::fgwsz::detail::key_xor_avx2
+        ,&::fgwsz::detail::key_xor_copy_avx2
+        ,features.avx2
+    });
+    kernels.push_back({
+        "avx512"
+        ,&::fgwsz::detail::key_xor_avx512
+        ,&::fgwsz::detail::key_xor_copy_avx512
+        ,features.avx512f
+    });
+#endif
+    return kernels;
+}
+inline ::fgwsz::XorKernel select_key_xor_kernel(void){
+    ::fgwsz::XorKernel selected={};
+    for(auto const& kernel : ::fgwsz::detail::make_key_xor_kernels()){
+        if(kernel.supported){
+            selected=kernel;
+        }
+    }
+    return selected;
+}
+//第一次调用时选择一次内核,之后每次调用只需一次间接跳转
+//(函数内静态变量保证其他翻译单元的静态初始化中调用时内核也已经选择好)
+inline ::fgwsz::XorKernel const& key_xor_kernel(void){
+    static ::fgwsz::XorKernel const kernel=
+        ::fgwsz::detail::select_key_xor_kernel();
+    return kernel;
+}
+}//namespace fgwsz::detail
+
+void key_xor(void* ptr,::std::uint64_t bytes,::std::uint8_t key){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::key_xor,bytes);
+    ::fgwsz::detail::key_xor_kernel().function(ptr,bytes,key);
+}
+void key_xor_copy(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+){
+    ::fgwsz::StatsTimer timer(::fgwsz::StatsPhase::key_xor,bytes);
+    ::fgwsz::detail::key_xor_kernel().copy_function(dst,src,bytes,key);
+}
+char const* key_xor_kernel_name(void){
+    return ::fgwsz::detail::key_xor_kernel().name;
+}
+::std::vector<::fgwsz::XorKernel> key_xor_kernels(void){
+    return ::fgwsz::detail::make_key_xor_kernels();
+}
+
+}//namespace fgwsz
@@ -0,0 +1,45 @@
+#ifndef FGWSZ_XOR_H
+#define FGWSZ_XOR_H
+
+#include<cstdint>   //::std::uint8_t ::std::uint64_t
+
+#include<vector>    //::std::vector
+
+//============================================================================
+//密钥xor混淆相关
+//============================================================================
+namespace fgwsz{
+//xor混淆内核函数类型
+using XorFunction=void(*)(void* ptr,::std::uint64_t bytes,::std::uint8_t key);
+//xor混淆拷贝内核函数类型
+using XorCopyFunction=void(*)(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+);
+//xor混淆内核描述信息
+struct XorKernel{
+    char const* name;               //内核名称
+    XorFunction function;           //原地混淆内核函数
+    XorCopyFunction copy_function;  //混淆拷贝内核函数
+    bool supported;                 //当前CPU是否支持该内核
+};
+//使用单字节密钥对内存块进行原地xor混淆
+//(程序启动时根据CPUID选择当前CPU支持的最快内核)
+void key_xor(void* ptr,::std::uint64_t bytes,::std::uint8_t key);
+//使用单字节密钥对src进行xor混淆并写入dst(只读取和写入一遍内存)
+//dst和src可以相同,但不能部分重叠
+void key_xor_copy(
+    void* dst
+    ,void const* src
+    ,::std::uint64_t bytes
+    ,::std::uint8_t key
+);
+//当前选中的xor混淆内核名称
+char const* key_xor_kernel_name(void);
+//所有xor混淆内核(用于基准测试和正确性校验)
+::std::vector<::fgwsz::XorKernel> key_xor_kernels(void);
+}//namespace fgwsz
+
+#endif//FGWSZ_XOR_H